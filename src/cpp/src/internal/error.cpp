@@ -83,6 +83,9 @@ std::string_view MyErrorDomain::MessageFor(score::result::ErrorCode const& code)
         case ErrorCode::InvalidValueType:
             msg = "Invalid value type";
             break;
+        case ErrorCode::ReadOnly:
+            msg = "KVS instance is read-only";
+            break;
         default:
             msg = "Unknown Error!";
             break;
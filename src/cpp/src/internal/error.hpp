@@ -81,6 +81,9 @@ enum class ErrorCode : score::result::ErrorCode {
 
     /* Invalid value type*/
     InvalidValueType,
+
+    /* KVS instance is read-only*/
+    ReadOnly,
 };
 
 class MyErrorDomain final : public score::result::ErrorDomain
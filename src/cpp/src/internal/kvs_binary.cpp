@@ -0,0 +1,533 @@
+/********************************************************************************
+* Copyright (c) 2025 Contributors to the Eclipse Foundation
+*
+* See the NOTICE file(s) distributed with this work for additional
+* information regarding copyright ownership.
+*
+* This program and the accompanying materials are made available under the
+* terms of the Apache License Version 2.0 which is available at
+* https://www.apache.org/licenses/LICENSE-2.0
+*
+* SPDX-License-Identifier: Apache-2.0
+********************************************************************************/
+#include <cstring>
+#include <limits>
+#include "kvs_binary.hpp"
+
+namespace score::mw::per::kvs {
+
+namespace {
+
+/* Magic bytes at the beginning of every binary KVS file */
+constexpr char KVS_BINARY_MAGIC[4] = {'K', 'V', 'S', 'B'};
+
+/* Size of the file header (magic, version, reserved, entry count) */
+constexpr size_t KVS_BINARY_HEADER_SIZE = 12;
+
+/*********************** Little-Endian Helper Functions *********************/
+
+void put_u8(std::string& out, uint8_t value) {
+    out.push_back(static_cast<char>(value));
+}
+
+void put_u16(std::string& out, uint16_t value) {
+    out.push_back(static_cast<char>(value & 0xFF));
+    out.push_back(static_cast<char>((value >> 8) & 0xFF));
+}
+
+void put_u64(std::string& out, uint64_t value) {
+    for (size_t i = 0; i < 8; ++i) {
+        out.push_back(static_cast<char>((value >> (8 * i)) & 0xFF));
+    }
+}
+
+/* Read from data at offset and advance offset, fail if the data is truncated */
+bool get_u8(std::string_view data, size_t& offset, uint8_t& value) {
+    bool result = false;
+    if (data.size() - offset >= 1) {
+        value = static_cast<uint8_t>(data[offset]);
+        offset += 1;
+        result = true;
+    }
+
+    return result;
+}
+
+bool get_u16(std::string_view data, size_t& offset, uint16_t& value) {
+    bool result = false;
+    if (data.size() - offset >= 2) {
+        value = static_cast<uint16_t>(static_cast<uint8_t>(data[offset])
+              | (static_cast<uint16_t>(static_cast<uint8_t>(data[offset + 1])) << 8));
+        offset += 2;
+        result = true;
+    }
+
+    return result;
+}
+
+bool get_u64(std::string_view data, size_t& offset, uint64_t& value) {
+    bool result = false;
+    if (data.size() - offset >= 8) {
+        value = 0;
+        for (size_t i = 0; i < 8; ++i) {
+            value |= static_cast<uint64_t>(static_cast<uint8_t>(data[offset + i])) << (8 * i);
+        }
+        offset += 8;
+        result = true;
+    }
+
+    return result;
+}
+
+} /* namespace */
+
+/*********************** Little-Endian Primitives *********************/
+
+void binary_put_u32(std::string& out, uint32_t value) {
+    for (size_t i = 0; i < 4; ++i) {
+        out.push_back(static_cast<char>((value >> (8 * i)) & 0xFF));
+    }
+}
+
+/* Write a length-prefixed string, fails if the length doesn't fit into the u32 prefix */
+bool binary_put_string(std::string& out, std::string_view value) {
+    bool result = false;
+    if (value.size() <= std::numeric_limits<uint32_t>::max()) {
+        binary_put_u32(out, static_cast<uint32_t>(value.size()));
+        out.append(value.data(), value.size());
+        result = true;
+    }
+
+    return result;
+}
+
+bool binary_get_u32(std::string_view data, size_t& offset, uint32_t& value) {
+    bool result = false;
+    if (data.size() - offset >= 4) {
+        value = 0;
+        for (size_t i = 0; i < 4; ++i) {
+            value |= static_cast<uint32_t>(static_cast<uint8_t>(data[offset + i])) << (8 * i);
+        }
+        offset += 4;
+        result = true;
+    }
+
+    return result;
+}
+
+bool binary_get_string(std::string_view data, size_t& offset, std::string& value) {
+    bool result = false;
+    uint32_t len = 0;
+    if (binary_get_u32(data, offset, len) && (data.size() - offset >= len)) {
+        value.assign(data.data() + offset, len);
+        offset += len;
+        result = true;
+    }
+
+    return result;
+}
+
+/*********************** Encoding *********************/
+
+/* Append the binary encoding of a KvsValue (type tag + payload) to out */
+score::ResultBlank binary_encode_value(const KvsValue& value, std::string& out) {
+    score::ResultBlank result = score::ResultBlank{};
+    switch (value.getType()) {
+        case KvsValue::Type::i32: {
+            put_u8(out, static_cast<uint8_t>(BinaryTag::I32));
+            binary_put_u32(out, static_cast<uint32_t>(std::get<int32_t>(value.getValue())));
+            break;
+        }
+        case KvsValue::Type::u32: {
+            put_u8(out, static_cast<uint8_t>(BinaryTag::U32));
+            binary_put_u32(out, std::get<uint32_t>(value.getValue()));
+            break;
+        }
+        case KvsValue::Type::i64: {
+            put_u8(out, static_cast<uint8_t>(BinaryTag::I64));
+            put_u64(out, static_cast<uint64_t>(std::get<int64_t>(value.getValue())));
+            break;
+        }
+        case KvsValue::Type::u64: {
+            put_u8(out, static_cast<uint8_t>(BinaryTag::U64));
+            put_u64(out, std::get<uint64_t>(value.getValue()));
+            break;
+        }
+        case KvsValue::Type::f64: {
+            uint64_t bits = 0;
+            const double number = std::get<double>(value.getValue());
+            std::memcpy(&bits, &number, sizeof(bits));
+            put_u8(out, static_cast<uint8_t>(BinaryTag::F64));
+            put_u64(out, bits);
+            break;
+        }
+        case KvsValue::Type::Boolean: {
+            put_u8(out, static_cast<uint8_t>(BinaryTag::Boolean));
+            put_u8(out, std::get<bool>(value.getValue()) ? 1 : 0);
+            break;
+        }
+        case KvsValue::Type::String: {
+            put_u8(out, static_cast<uint8_t>(BinaryTag::String));
+            if (!binary_put_string(out, std::get<std::string>(value.getValue()))) {
+                result = score::MakeUnexpected(ErrorCode::SerializationFailed);
+            }
+            break;
+        }
+        case KvsValue::Type::Null: {
+            put_u8(out, static_cast<uint8_t>(BinaryTag::Null));
+            break;
+        }
+        case KvsValue::Type::Array: {
+            const KvsValue::Array* arr = value.getIf<KvsValue::Array>();
+            if (nullptr == arr) {
+                result = score::MakeUnexpected(ErrorCode::InvalidValueType);
+            }else if (arr->size() > std::numeric_limits<uint32_t>::max()) {
+                result = score::MakeUnexpected(ErrorCode::SerializationFailed);
+            }else{
+                put_u8(out, static_cast<uint8_t>(BinaryTag::Array));
+                binary_put_u32(out, static_cast<uint32_t>(arr->size()));
+                for (const auto& elem : *arr) {
+                    result = binary_encode_value(*elem, out);
+                    if (!result) {
+                        break;
+                    }
+                }
+            }
+            break;
+        }
+        case KvsValue::Type::Object: {
+            const KvsValue::Object* obj = value.getIf<KvsValue::Object>();
+            if (nullptr == obj) {
+                result = score::MakeUnexpected(ErrorCode::InvalidValueType);
+            }else if (obj->size() > std::numeric_limits<uint32_t>::max()) {
+                result = score::MakeUnexpected(ErrorCode::SerializationFailed);
+            }else{
+                put_u8(out, static_cast<uint8_t>(BinaryTag::Object));
+                binary_put_u32(out, static_cast<uint32_t>(obj->size()));
+                for (const auto& [key, elem] : *obj) {
+                    if (!binary_put_string(out, key)) {
+                        result = score::MakeUnexpected(ErrorCode::SerializationFailed);
+                        break;
+                    }
+                    result = binary_encode_value(*elem, out);
+                    if (!result) {
+                        break;
+                    }
+                }
+            }
+            break;
+        }
+        default: {
+            result = score::MakeUnexpected(ErrorCode::InvalidValueType);
+            break;
+        }
+    }
+
+    return result;
+}
+
+/* Encode a complete key-value map including the file header */
+score::Result<std::string> binary_encode_map(const KvsMap& map) {
+    score::Result<std::string> result = score::MakeUnexpected(ErrorCode::UnmappedError);
+    if (map.size() > std::numeric_limits<uint32_t>::max()) {
+        result = score::MakeUnexpected(ErrorCode::SerializationFailed);
+    }else{
+        std::string out;
+        bool error = false;
+        out.append(KVS_BINARY_MAGIC, sizeof(KVS_BINARY_MAGIC));
+        put_u16(out, KVS_BINARY_VERSION);
+        put_u16(out, 0); /* Reserved */
+        binary_put_u32(out, static_cast<uint32_t>(map.size()));
+        for (const auto& [key, value] : map) {
+            if (!binary_put_string(out, key)) {
+                result = score::MakeUnexpected(ErrorCode::SerializationFailed);
+                error = true;
+                break;
+            }
+            auto enc = binary_encode_value(value, out);
+            if (!enc) {
+                result = score::MakeUnexpected(static_cast<ErrorCode>(*enc.error()));
+                error = true;
+                break;
+            }
+        }
+        if (!error) {
+            result = std::move(out);
+        }
+    }
+
+    return result;
+}
+
+/*********************** Decoding *********************/
+
+/* Decode a KvsValue (type tag + payload) starting at offset, offset is advanced behind the value */
+score::Result<KvsValue> binary_decode_value(std::string_view data, size_t& offset, const KvsElementAllocator& alloc) {
+    score::Result<KvsValue> result = score::MakeUnexpected(ErrorCode::SerializationFailed); /* Truncated data, if not overwritten */
+    uint8_t tag = 0;
+    if (get_u8(data, offset, tag)) {
+        switch (static_cast<BinaryTag>(tag)) {
+            case BinaryTag::I32: {
+                uint32_t raw = 0;
+                if (binary_get_u32(data, offset, raw)) {
+                    result = KvsValue(static_cast<int32_t>(raw));
+                }
+                break;
+            }
+            case BinaryTag::U32: {
+                uint32_t raw = 0;
+                if (binary_get_u32(data, offset, raw)) {
+                    result = KvsValue(raw);
+                }
+                break;
+            }
+            case BinaryTag::I64: {
+                uint64_t raw = 0;
+                if (get_u64(data, offset, raw)) {
+                    result = KvsValue(static_cast<int64_t>(raw));
+                }
+                break;
+            }
+            case BinaryTag::U64: {
+                uint64_t raw = 0;
+                if (get_u64(data, offset, raw)) {
+                    result = KvsValue(raw);
+                }
+                break;
+            }
+            case BinaryTag::F64: {
+                uint64_t raw = 0;
+                if (get_u64(data, offset, raw)) {
+                    double number = 0.0;
+                    std::memcpy(&number, &raw, sizeof(number));
+                    result = KvsValue(number);
+                }
+                break;
+            }
+            case BinaryTag::Boolean: {
+                uint8_t raw = 0;
+                if (get_u8(data, offset, raw)) {
+                    if (raw <= 1) {
+                        result = KvsValue(1 == raw);
+                    }else{
+                        result = score::MakeUnexpected(ErrorCode::InvalidValueType);
+                    }
+                }
+                break;
+            }
+            case BinaryTag::String: {
+                std::string str;
+                if (binary_get_string(data, offset, str)) {
+                    result = KvsValue(str);
+                }
+                break;
+            }
+            case BinaryTag::Null: {
+                result = KvsValue(nullptr);
+                break;
+            }
+            case BinaryTag::Array: {
+                uint32_t count = 0;
+                /* Every element needs at least its type tag, reject impossible counts before reserving */
+                if (binary_get_u32(data, offset, count) && (data.size() - offset >= count)) {
+                    KvsValue::Array arr;
+                    bool error = false;
+                    arr.reserve(count);
+                    for (uint32_t i = 0; i < count; ++i) {
+                        auto conv = binary_decode_value(data, offset, alloc);
+                        if (!conv) {
+                            result = score::MakeUnexpected(static_cast<ErrorCode>(*conv.error()));
+                            error = true;
+                            break;
+                        }
+                        arr.emplace_back(std::allocate_shared<KvsValue>(alloc, std::move(conv.value())));
+                    }
+                    if (!error) {
+                        result = KvsValue(std::move(arr));
+                    }
+                }
+                break;
+            }
+            case BinaryTag::Object: {
+                uint32_t count = 0;
+                /* Every member needs at least its key length and type tag */
+                if (binary_get_u32(data, offset, count) && ((data.size() - offset) / 5 >= count)) {
+                    KvsValue::Object obj;
+                    bool error = false;
+                    for (uint32_t i = 0; i < count; ++i) {
+                        std::string key;
+                        if (!binary_get_string(data, offset, key)) {
+                            error = true;
+                            break;
+                        }
+                        auto conv = binary_decode_value(data, offset, alloc);
+                        if (!conv) {
+                            result = score::MakeUnexpected(static_cast<ErrorCode>(*conv.error()));
+                            error = true;
+                            break;
+                        }
+                        obj.emplace(std::move(key), std::allocate_shared<KvsValue>(alloc, std::move(conv.value())));
+                    }
+                    if (!error) {
+                        result = KvsValue(std::move(obj));
+                    }
+                }
+                break;
+            }
+            default: {
+                result = score::MakeUnexpected(ErrorCode::InvalidValueType);
+                break;
+            }
+        }
+    }
+
+    return result;
+}
+
+/* Decode a complete binary KVS file (header + entries) */
+score::Result<KvsMap> binary_decode_map(std::string_view data, const KvsElementAllocator& alloc) {
+    score::Result<KvsMap> result = score::MakeUnexpected(ErrorCode::UnmappedError);
+    size_t offset = 0;
+    uint16_t version = 0;
+    uint16_t reserved = 0;
+    uint32_t count = 0;
+
+    if ((data.size() < KVS_BINARY_HEADER_SIZE)
+        || (0 != std::memcmp(data.data(), KVS_BINARY_MAGIC, sizeof(KVS_BINARY_MAGIC)))) {
+        result = score::MakeUnexpected(ErrorCode::SerializationFailed);
+    }else{
+        offset = sizeof(KVS_BINARY_MAGIC);
+        (void)get_u16(data, offset, version);
+        (void)get_u16(data, offset, reserved);
+        (void)binary_get_u32(data, offset, count);
+        if (KVS_BINARY_VERSION != version) {
+            result = score::MakeUnexpected(ErrorCode::SerializationFailed);
+        }else{
+            KvsMap map{KvsMap::allocator_type(alloc)};
+            bool error = false;
+            for (uint32_t i = 0; i < count; ++i) {
+                std::string key;
+                if (!binary_get_string(data, offset, key)) {
+                    result = score::MakeUnexpected(ErrorCode::SerializationFailed);
+                    error = true;
+                    break;
+                }
+                auto conv = binary_decode_value(data, offset, alloc);
+                if (!conv) {
+                    result = score::MakeUnexpected(static_cast<ErrorCode>(*conv.error()));
+                    error = true;
+                    break;
+                }
+                /* Entries are written in key order, so appending at the end is constant time */
+                (void)map.emplace_hint(map.end(), std::move(key), std::move(conv.value()));
+            }
+            if (!error) {
+                if (offset != data.size()) {
+                    result = score::MakeUnexpected(ErrorCode::SerializationFailed); /* Trailing bytes */
+                }else{
+                    result = std::move(map);
+                }
+            }
+        }
+    }
+
+    return result;
+}
+
+/* Advance offset behind an encoded value without decoding it (checks the extent, not the content) */
+bool binary_skip_value(std::string_view data, size_t& offset) {
+    bool result = false;
+    uint8_t tag = 0;
+    uint32_t count = 0;
+    if (get_u8(data, offset, tag)) {
+        switch (static_cast<BinaryTag>(tag)) {
+            case BinaryTag::I32:
+            case BinaryTag::U32: {
+                result = (data.size() - offset >= 4);
+                offset += result ? 4 : 0;
+                break;
+            }
+            case BinaryTag::I64:
+            case BinaryTag::U64:
+            case BinaryTag::F64: {
+                result = (data.size() - offset >= 8);
+                offset += result ? 8 : 0;
+                break;
+            }
+            case BinaryTag::Boolean: {
+                result = (data.size() - offset >= 1);
+                offset += result ? 1 : 0;
+                break;
+            }
+            case BinaryTag::String: {
+                result = binary_get_u32(data, offset, count) && (data.size() - offset >= count);
+                offset += result ? count : 0;
+                break;
+            }
+            case BinaryTag::Null: {
+                result = true;
+                break;
+            }
+            case BinaryTag::Array: {
+                result = binary_get_u32(data, offset, count);
+                for (uint32_t i = 0; result && (i < count); ++i) {
+                    result = binary_skip_value(data, offset);
+                }
+                break;
+            }
+            case BinaryTag::Object: {
+                result = binary_get_u32(data, offset, count);
+                for (uint32_t i = 0; result && (i < count); ++i) {
+                    uint32_t len = 0;
+                    result = binary_get_u32(data, offset, len) && (data.size() - offset >= len);
+                    offset += result ? len : 0;
+                    result = result && binary_skip_value(data, offset);
+                }
+                break;
+            }
+            default: {
+                break;
+            }
+        }
+    }
+
+    return result;
+}
+
+/* Index a complete binary KVS file (key -> encoded value), the values are decoded on access */
+score::Result<KvsLazyMap> binary_index_map(std::string_view data) {
+    score::Result<KvsLazyMap> result = score::MakeUnexpected(ErrorCode::SerializationFailed);
+    size_t offset = 0;
+    uint16_t version = 0;
+    uint16_t reserved = 0;
+    uint32_t count = 0;
+
+    if ((data.size() >= KVS_BINARY_HEADER_SIZE)
+        && (0 == std::memcmp(data.data(), KVS_BINARY_MAGIC, sizeof(KVS_BINARY_MAGIC)))) {
+        offset = sizeof(KVS_BINARY_MAGIC);
+        (void)get_u16(data, offset, version);
+        (void)get_u16(data, offset, reserved);
+        (void)binary_get_u32(data, offset, count);
+        if (KVS_BINARY_VERSION == version) {
+            KvsLazyMap map;
+            bool valid = true;
+            for (uint32_t i = 0; valid && (i < count); ++i) {
+                std::string key;
+                valid = binary_get_string(data, offset, key);
+                const size_t start = offset;
+                if (valid && binary_skip_value(data, offset)) {
+                    (void)map.emplace_hint(map.end(), std::move(key), KvsLazyValue{data.substr(start, offset - start), std::nullopt});
+                }else{
+                    valid = false;
+                }
+            }
+            if (valid && (offset == data.size())) {
+                result = std::move(map);
+            }
+        }
+    }
+
+    return result;
+}
+
+} /* namespace score::mw::per::kvs */
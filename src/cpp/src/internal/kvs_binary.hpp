@@ -0,0 +1,73 @@
+/********************************************************************************
+* Copyright (c) 2025 Contributors to the Eclipse Foundation
+*
+* See the NOTICE file(s) distributed with this work for additional
+* information regarding copyright ownership.
+*
+* This program and the accompanying materials are made available under the
+* terms of the Apache License Version 2.0 which is available at
+* https://www.apache.org/licenses/LICENSE-2.0
+*
+* SPDX-License-Identifier: Apache-2.0
+********************************************************************************/
+#ifndef SCORE_LIB_KVS_INTERNAL_KVS_BINARY_HPP
+#define SCORE_LIB_KVS_INTERNAL_KVS_BINARY_HPP
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include "error.hpp"
+#include "kvs_lazy.hpp"
+#include "kvsvalue.hpp"
+
+/*
+ * This header defines the binary encoding of the KVS files (alternative to the typed JSON format).
+ * Kvs::write_data uses it with KvsStorageFormat::Binary, open_file decodes it and the lazy index
+ * decodes single values from it (binary_decode_value).
+ *
+ * Layout (all integers little-endian):
+ *   File:   magic "KVSB" | version (u16) | reserved (u16, 0) | entry count (u32) | entries
+ *   Entry:  key length (u32) | key bytes | value
+ *   Value:  type tag (u8) | payload
+ *           i32/u32: 4 bytes, i64/u64/f64 (IEEE 754): 8 bytes, bool: 1 byte, null: no payload,
+ *           str: length (u32) | bytes,
+ *           arr: element count (u32) | values,
+ *           obj: member count (u32) | (key length (u32) | key bytes | value)*
+ */
+namespace score::mw::per::kvs {
+
+/* Current version of the binary format */
+constexpr uint16_t KVS_BINARY_VERSION = 1;
+
+/* Type tags of the binary format (stable on disk, independent of KvsValue::Type) */
+enum class BinaryTag : uint8_t {
+    I32 = 0,
+    U32 = 1,
+    I64 = 2,
+    U64 = 3,
+    F64 = 4,
+    Boolean = 5,
+    String = 6,
+    Null = 7,
+    Array = 8,
+    Object = 9
+};
+
+/* Little-endian primitives, shared with the other binary files of the KVS (get functions advance offset) */
+void binary_put_u32(std::string& out, uint32_t value);
+bool binary_put_string(std::string& out, std::string_view value);
+bool binary_get_u32(std::string_view data, size_t& offset, uint32_t& value);
+bool binary_get_string(std::string_view data, size_t& offset, std::string& value);
+
+score::ResultBlank binary_encode_value(const KvsValue& value, std::string& out);
+score::Result<std::string> binary_encode_map(const KvsMap& map);
+/* The map nodes and the shared elements of Arrays and Objects are allocated with alloc (from the heap by default) */
+score::Result<KvsValue> binary_decode_value(std::string_view data, size_t& offset,
+                                            const KvsElementAllocator& alloc = KvsElementAllocator());
+score::Result<KvsMap> binary_decode_map(std::string_view data, const KvsElementAllocator& alloc = KvsElementAllocator());
+bool binary_skip_value(std::string_view data, size_t& offset);
+score::Result<KvsLazyMap> binary_index_map(std::string_view data);
+
+} /* namespace score::mw::per::kvs */
+
+#endif // SCORE_LIB_KVS_INTERNAL_KVS_BINARY_HPP
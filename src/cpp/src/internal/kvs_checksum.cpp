@@ -0,0 +1,275 @@
+/********************************************************************************
+* Copyright (c) 2025 Contributors to the Eclipse Foundation
+*
+* See the NOTICE file(s) distributed with this work for additional
+* information regarding copyright ownership.
+*
+* This program and the accompanying materials are made available under the
+* terms of the Apache License Version 2.0 which is available at
+* https://www.apache.org/licenses/LICENSE-2.0
+*
+* SPDX-License-Identifier: Apache-2.0
+********************************************************************************/
+#include <array>
+#include <cstring>
+#include "kvs_checksum.hpp"
+#ifdef KVS_CHECKSUM_X86
+#include <immintrin.h>
+#endif
+
+namespace score::mw::per::kvs {
+
+namespace {
+
+/* Largest n such that 255n(n+1)/2 + (n+1)(BASE-1) fits in 32 bits (no modulo needed within n bytes) */
+constexpr size_t ADLER32_NMAX = 5552;
+constexpr uint32_t ADLER32_BASE = 65521;
+
+/* Reflected CRC-32C polynomial */
+constexpr uint32_t CRC32C_POLY = 0x82F63B78;
+
+using UpdateFunction = uint32_t (*)(uint32_t, const char*, size_t);
+
+struct Implementation {
+    UpdateFunction update;
+    const char* name;
+};
+
+constexpr std::array<uint32_t, 256> make_crc32c_table() {
+    std::array<uint32_t, 256> table{};
+    for (uint32_t i = 0; i < 256; ++i) {
+        uint32_t crc = i;
+        for (int32_t bit = 0; bit < 8; ++bit) {
+            crc = (crc & 1U) ? ((crc >> 1) ^ CRC32C_POLY) : (crc >> 1);
+        }
+        table[i] = crc;
+    }
+    return table;
+}
+
+constexpr std::array<uint32_t, 256> CRC32C_TABLE = make_crc32c_table();
+
+/* Scalar tail of the Adler-32 implementations (len < ADLER32_NMAX) */
+uint32_t adler32_tail(uint32_t a, uint32_t b, const unsigned char* data, size_t len) {
+    for (size_t i = 0; i < len; ++i) {
+        a += data[i];
+        b += a;
+    }
+    a %= ADLER32_BASE;
+    b %= ADLER32_BASE;
+    return (b << 16) | a;
+}
+
+Implementation select_adler32() {
+    Implementation impl{adler32_update_scalar, "scalar"};
+#ifdef KVS_CHECKSUM_X86
+    if (checksum_cpu_supports("avx2")) {
+        impl = Implementation{adler32_update_avx2, "avx2"};
+    }else if (checksum_cpu_supports("ssse3")) {
+        impl = Implementation{adler32_update_ssse3, "ssse3"};
+    }
+#endif
+    return impl;
+}
+
+Implementation select_crc32c() {
+    Implementation impl{crc32c_update_scalar, "scalar"};
+#ifdef KVS_CHECKSUM_X86
+    if (checksum_cpu_supports("sse4.2")) {
+        impl = Implementation{crc32c_update_sse42, "sse4.2"};
+    }
+#endif
+    return impl;
+}
+
+/* Selected once, the CPU features don't change at runtime */
+const Implementation& get_implementation(KvsHashAlgorithm algorithm) {
+    static const Implementation adler32 = select_adler32();
+    static const Implementation crc32c = select_crc32c();
+    return (KvsHashAlgorithm::Crc32c == algorithm) ? crc32c : adler32;
+}
+
+} /* namespace */
+
+/* Initial value of a rolling checksum */
+uint32_t hash_init(KvsHashAlgorithm algorithm) {
+    return (KvsHashAlgorithm::Crc32c == algorithm) ? 0U : 1U;
+}
+
+/* Update a rolling checksum with the fastest implementation of the CPU */
+uint32_t hash_update(KvsHashAlgorithm algorithm, uint32_t hash, const char* data, size_t len) {
+    return get_implementation(algorithm).update(hash, data, len);
+}
+
+/* Name of the selected implementation (e.g. for logging and benchmarks) */
+const char* hash_implementation(KvsHashAlgorithm algorithm) {
+    return get_implementation(algorithm).name;
+}
+
+/* Adler-32: processes blocks of ADLER32_NMAX bytes between the modulo operations */
+uint32_t adler32_update_scalar(uint32_t hash, const char* data, size_t len) {
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(data);
+    uint32_t a = hash & 0xFFFF;
+    uint32_t b = (hash >> 16) & 0xFFFF;
+    while (len >= ADLER32_NMAX) {
+        const uint32_t block = adler32_tail(a, b, bytes, ADLER32_NMAX);
+        a = block & 0xFFFF;
+        b = block >> 16;
+        bytes += ADLER32_NMAX;
+        len -= ADLER32_NMAX;
+    }
+    return adler32_tail(a, b, bytes, len);
+}
+
+/* CRC-32C: byte-wise table lookup */
+uint32_t crc32c_update_scalar(uint32_t hash, const char* data, size_t len) {
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(data);
+    uint32_t crc = ~hash;
+    for (size_t i = 0; i < len; ++i) {
+        crc = CRC32C_TABLE[(crc ^ bytes[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+#ifdef KVS_CHECKSUM_X86
+
+bool checksum_cpu_supports(const char* feature) {
+    __builtin_cpu_init();
+    bool result = false;
+    if (0 == std::strcmp(feature, "avx2")) {
+        result = __builtin_cpu_supports("avx2");
+    }else if (0 == std::strcmp(feature, "ssse3")) {
+        result = __builtin_cpu_supports("ssse3");
+    }else if (0 == std::strcmp(feature, "sse4.2")) {
+        result = __builtin_cpu_supports("sse4.2");
+    }
+    return result;
+}
+
+/*
+ * Vectorized Adler-32 on blocks of 32 bytes: for a block x[0..31]
+ *   a' = a + sum(x[i]),  b' = b + 32a + sum((32 - i) * x[i])
+ * The sums are accumulated in 32-bit lanes for up to ADLER32_NMAX bytes before the modulo.
+ */
+__attribute__((target("ssse3")))
+uint32_t adler32_update_ssse3(uint32_t hash, const char* data, size_t len) {
+    constexpr size_t BLOCK = 32;
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(data);
+    uint32_t a = hash & 0xFFFF;
+    uint32_t b = (hash >> 16) & 0xFFFF;
+    size_t blocks = len / BLOCK;
+    len -= blocks * BLOCK;
+
+    const __m128i weights_1 = _mm_setr_epi8(32, 31, 30, 29, 28, 27, 26, 25, 24, 23, 22, 21, 20, 19, 18, 17);
+    const __m128i weights_2 = _mm_setr_epi8(16, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1);
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i ones = _mm_set1_epi16(1);
+
+    while (blocks > 0) {
+        size_t n = ADLER32_NMAX / BLOCK;
+        if (n > blocks) {
+            n = blocks;
+        }
+        blocks -= n;
+
+        __m128i v_prefix = _mm_set_epi32(0, 0, 0, static_cast<int32_t>(a * n)); /* Sum of a before each block */
+        __m128i v_b = _mm_set_epi32(0, 0, 0, static_cast<int32_t>(b));
+        __m128i v_a = _mm_setzero_si128();
+        for (size_t i = 0; i < n; ++i) {
+            const __m128i bytes_1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bytes));
+            const __m128i bytes_2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bytes + 16));
+            v_prefix = _mm_add_epi32(v_prefix, v_a);
+            v_a = _mm_add_epi32(v_a, _mm_sad_epu8(bytes_1, zero));
+            v_b = _mm_add_epi32(v_b, _mm_madd_epi16(_mm_maddubs_epi16(bytes_1, weights_1), ones));
+            v_a = _mm_add_epi32(v_a, _mm_sad_epu8(bytes_2, zero));
+            v_b = _mm_add_epi32(v_b, _mm_madd_epi16(_mm_maddubs_epi16(bytes_2, weights_2), ones));
+            bytes += BLOCK;
+        }
+        v_b = _mm_add_epi32(v_b, _mm_slli_epi32(v_prefix, 5)); /* 32 * prefix sums */
+
+        /* Horizontal sums */
+        v_a = _mm_add_epi32(v_a, _mm_shuffle_epi32(v_a, _MM_SHUFFLE(2, 3, 0, 1)));
+        v_a = _mm_add_epi32(v_a, _mm_shuffle_epi32(v_a, _MM_SHUFFLE(1, 0, 3, 2)));
+        a += static_cast<uint32_t>(_mm_cvtsi128_si32(v_a));
+        v_b = _mm_add_epi32(v_b, _mm_shuffle_epi32(v_b, _MM_SHUFFLE(2, 3, 0, 1)));
+        v_b = _mm_add_epi32(v_b, _mm_shuffle_epi32(v_b, _MM_SHUFFLE(1, 0, 3, 2)));
+        b = static_cast<uint32_t>(_mm_cvtsi128_si32(v_b));
+        a %= ADLER32_BASE;
+        b %= ADLER32_BASE;
+    }
+
+    return adler32_tail(a, b, bytes, len);
+}
+
+/* Same as adler32_update_ssse3, with one 32-byte block per 256-bit register */
+__attribute__((target("avx2")))
+uint32_t adler32_update_avx2(uint32_t hash, const char* data, size_t len) {
+    constexpr size_t BLOCK = 32;
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(data);
+    uint32_t a = hash & 0xFFFF;
+    uint32_t b = (hash >> 16) & 0xFFFF;
+    size_t blocks = len / BLOCK;
+    len -= blocks * BLOCK;
+
+    const __m256i weights = _mm256_setr_epi8(32, 31, 30, 29, 28, 27, 26, 25, 24, 23, 22, 21, 20, 19, 18, 17,
+                                             16, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1);
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i ones = _mm256_set1_epi16(1);
+
+    while (blocks > 0) {
+        size_t n = ADLER32_NMAX / BLOCK;
+        if (n > blocks) {
+            n = blocks;
+        }
+        blocks -= n;
+
+        __m256i v_prefix = _mm256_set_epi32(0, 0, 0, 0, 0, 0, 0, static_cast<int32_t>(a * n));
+        __m256i v_b = _mm256_set_epi32(0, 0, 0, 0, 0, 0, 0, static_cast<int32_t>(b));
+        __m256i v_a = _mm256_setzero_si256();
+        for (size_t i = 0; i < n; ++i) {
+            const __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(bytes));
+            v_prefix = _mm256_add_epi32(v_prefix, v_a);
+            v_a = _mm256_add_epi32(v_a, _mm256_sad_epu8(block, zero));
+            v_b = _mm256_add_epi32(v_b, _mm256_madd_epi16(_mm256_maddubs_epi16(block, weights), ones));
+            bytes += BLOCK;
+        }
+        v_b = _mm256_add_epi32(v_b, _mm256_slli_epi32(v_prefix, 5));
+
+        /* Horizontal sums (both 128-bit halves, then the four lanes) */
+        __m128i s_a = _mm_add_epi32(_mm256_castsi256_si128(v_a), _mm256_extracti128_si256(v_a, 1));
+        s_a = _mm_add_epi32(s_a, _mm_shuffle_epi32(s_a, _MM_SHUFFLE(2, 3, 0, 1)));
+        s_a = _mm_add_epi32(s_a, _mm_shuffle_epi32(s_a, _MM_SHUFFLE(1, 0, 3, 2)));
+        a += static_cast<uint32_t>(_mm_cvtsi128_si32(s_a));
+        __m128i s_b = _mm_add_epi32(_mm256_castsi256_si128(v_b), _mm256_extracti128_si256(v_b, 1));
+        s_b = _mm_add_epi32(s_b, _mm_shuffle_epi32(s_b, _MM_SHUFFLE(2, 3, 0, 1)));
+        s_b = _mm_add_epi32(s_b, _mm_shuffle_epi32(s_b, _MM_SHUFFLE(1, 0, 3, 2)));
+        b = static_cast<uint32_t>(_mm_cvtsi128_si32(s_b));
+        a %= ADLER32_BASE;
+        b %= ADLER32_BASE;
+    }
+
+    return adler32_tail(a, b, bytes, len);
+}
+
+/* CRC-32C with the SSE4.2 crc32 instruction, 8 bytes per instruction */
+__attribute__((target("sse4.2")))
+uint32_t crc32c_update_sse42(uint32_t hash, const char* data, size_t len) {
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(data);
+    uint64_t crc = static_cast<uint32_t>(~hash);
+    while (len >= sizeof(uint64_t)) {
+        uint64_t word = 0;
+        std::memcpy(&word, bytes, sizeof(word)); /* Unaligned load */
+        crc = _mm_crc32_u64(crc, word);
+        bytes += sizeof(word);
+        len -= sizeof(word);
+    }
+    uint32_t crc32 = static_cast<uint32_t>(crc);
+    for (size_t i = 0; i < len; ++i) {
+        crc32 = _mm_crc32_u8(crc32, bytes[i]);
+    }
+    return ~crc32;
+}
+
+#endif /* KVS_CHECKSUM_X86 */
+
+} /* namespace score::mw::per::kvs */
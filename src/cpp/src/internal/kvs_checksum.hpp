@@ -0,0 +1,52 @@
+/********************************************************************************
+* Copyright (c) 2025 Contributors to the Eclipse Foundation
+*
+* See the NOTICE file(s) distributed with this work for additional
+* information regarding copyright ownership.
+*
+* This program and the accompanying materials are made available under the
+* terms of the Apache License Version 2.0 which is available at
+* https://www.apache.org/licenses/LICENSE-2.0
+*
+* SPDX-License-Identifier: Apache-2.0
+********************************************************************************/
+#ifndef SCORE_LIB_KVS_INTERNAL_KVS_CHECKSUM_HPP
+#define SCORE_LIB_KVS_INTERNAL_KVS_CHECKSUM_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+/*
+ * This header defines the checksum algorithms of the KVS files and their accelerated implementations.
+ * The implementation is selected once at runtime from the CPU features (x86-64: SSSE3/AVX2 for
+ * Adler-32, SSE4.2 for CRC32C), other platforms use the portable implementations.
+ *
+ * All update functions are rolling: hash_update over consecutive chunks, started with hash_init,
+ * gives the same checksum as one call over the complete data.
+ */
+namespace score::mw::per::kvs {
+
+/* Checksum algorithm of the hash files (value is stored as tag in tagged hash files) */
+enum class KvsHashAlgorithm : uint8_t {
+    Adler32 = 0, /* Adler-32 (zlib), default and only algorithm of the legacy 4-byte hash files */
+    Crc32c = 1   /* CRC-32C (Castagnoli), hardware accelerated on most CPUs */
+};
+
+uint32_t hash_init(KvsHashAlgorithm algorithm);
+uint32_t hash_update(KvsHashAlgorithm algorithm, uint32_t hash, const char* data, size_t len);
+const char* hash_implementation(KvsHashAlgorithm algorithm);
+
+/* Single implementations, used by the dispatch (exposed for tests and benchmarks) */
+uint32_t adler32_update_scalar(uint32_t hash, const char* data, size_t len);
+uint32_t crc32c_update_scalar(uint32_t hash, const char* data, size_t len);
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define KVS_CHECKSUM_X86
+bool checksum_cpu_supports(const char* feature);
+uint32_t adler32_update_ssse3(uint32_t hash, const char* data, size_t len);
+uint32_t adler32_update_avx2(uint32_t hash, const char* data, size_t len);
+uint32_t crc32c_update_sse42(uint32_t hash, const char* data, size_t len);
+#endif
+
+} /* namespace score::mw::per::kvs */
+
+#endif // SCORE_LIB_KVS_INTERNAL_KVS_CHECKSUM_HPP
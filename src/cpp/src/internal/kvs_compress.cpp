@@ -0,0 +1,352 @@
+/********************************************************************************
+* Copyright (c) 2025 Contributors to the Eclipse Foundation
+*
+* See the NOTICE file(s) distributed with this work for additional
+* information regarding copyright ownership.
+*
+* This program and the accompanying materials are made available under the
+* terms of the Apache License Version 2.0 which is available at
+* https://www.apache.org/licenses/LICENSE-2.0
+*
+* SPDX-License-Identifier: Apache-2.0
+********************************************************************************/
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <sstream>
+#include "kvs_binary.hpp"
+#include "kvs_compress.hpp"
+
+namespace score::mw::per::kvs {
+
+namespace {
+
+/* Magic bytes at the beginning of every compressed KVS file */
+constexpr char KVS_COMPRESS_MAGIC[4] = {'K', 'V', 'S', 'Z'};
+
+/* Current version of the compressed format */
+constexpr uint8_t KVS_COMPRESS_VERSION = 1;
+
+/* Size of the file header (magic, version, codec, reserved) */
+constexpr size_t KVS_COMPRESS_HEADER_SIZE = 8;
+
+/* Bit of the stored size of a block that is stored uncompressed */
+constexpr uint32_t KVS_COMPRESS_STORED_RAW = 0x80000000U;
+
+/* Limits of the LZ4 block format: minimum match, literals at the end, last match start before the end */
+constexpr size_t LZ4_MIN_MATCH = 4;
+constexpr size_t LZ4_LAST_LITERALS = 5;
+constexpr size_t LZ4_MF_LIMIT = 12;
+constexpr size_t LZ4_MAX_OFFSET = 65535;
+constexpr size_t LZ4_HASH_BITS = 12;
+
+uint32_t read_u32(const char* data) {
+    uint32_t value = 0;
+    std::memcpy(&value, data, sizeof(value));
+    return value;
+}
+
+uint32_t lz4_hash(uint32_t sequence) {
+    return (sequence * 2654435761U) >> (32U - LZ4_HASH_BITS);
+}
+
+/* Length above the 4 bits of the token: 255 per byte until a byte smaller than 255 */
+void put_length(std::string& out, size_t length) {
+    while (length >= 255) {
+        out.push_back(static_cast<char>(255));
+        length -= 255;
+    }
+    out.push_back(static_cast<char>(length));
+}
+
+bool get_length(std::string_view data, size_t& offset, size_t limit, size_t& length) {
+    bool result = true;
+    uint8_t byte = 255;
+    while (result && (255 == byte)) {
+        if ((offset >= data.size()) || (length > limit)) {
+            result = false;
+        }else{
+            byte = static_cast<uint8_t>(data[offset]);
+            length += byte;
+            ++offset;
+        }
+    }
+
+    return result && (length <= limit);
+}
+
+/* One sequence: token | literal length | literals | offset | match length (no match for the last sequence) */
+void put_sequence(std::string& out, std::string_view literals, size_t offset, size_t match) {
+    const size_t literal_length = literals.size();
+    const size_t match_code = (0 == match) ? 0 : (match - LZ4_MIN_MATCH);
+    const uint8_t token = static_cast<uint8_t>((std::min<size_t>(literal_length, 15) << 4) | std::min<size_t>(match_code, 15));
+    out.push_back(static_cast<char>(token));
+    if (literal_length >= 15) {
+        put_length(out, literal_length - 15);
+    }
+    out.append(literals.data(), literals.size());
+    if (0 != match) {
+        out.push_back(static_cast<char>(offset & 0xFF));
+        out.push_back(static_cast<char>((offset >> 8) & 0xFF));
+        if (match_code >= 15) {
+            put_length(out, match_code - 15);
+        }
+    }
+}
+
+} /* namespace */
+
+/* Greedy LZ4 compression of one block (hash table of the last position of every 4-byte sequence) */
+void lz4_compress_block(std::string_view data, std::string& out) {
+    const char* base = data.data();
+    const size_t size = data.size();
+    size_t anchor = 0;
+    if (size > LZ4_MF_LIMIT) {
+        std::array<uint32_t, (1U << LZ4_HASH_BITS)> table{};
+        const size_t match_limit = size - LZ4_LAST_LITERALS;
+        size_t pos = 1; /* Position 0 is the initial value of the table entries */
+        size_t misses = 0;
+        while (pos + LZ4_MF_LIMIT <= size) {
+            const uint32_t sequence = read_u32(base + pos);
+            const uint32_t hash = lz4_hash(sequence);
+            const size_t candidate = table[hash];
+            table[hash] = static_cast<uint32_t>(pos);
+            if ((pos - candidate <= LZ4_MAX_OFFSET) && (read_u32(base + candidate) == sequence)) {
+                size_t match = LZ4_MIN_MATCH;
+                while ((pos + match < match_limit) && (base[candidate + match] == base[pos + match])) {
+                    ++match;
+                }
+                put_sequence(out, data.substr(anchor, pos - anchor), pos - candidate, match);
+                pos += match;
+                anchor = pos;
+                misses = 0;
+            }else{
+                /* Skip faster through data without matches */
+                ++misses;
+                pos += 1 + (misses >> 5);
+            }
+        }
+    }
+    put_sequence(out, data.substr(anchor), 0, 0);
+}
+
+/* Safe LZ4 decompression of one block, every length and offset is checked against the input and the output */
+bool lz4_decompress_block(std::string_view data, char* out, size_t size) {
+    bool result = true;
+    size_t in_pos = 0;
+    size_t out_pos = 0;
+    bool last = false;
+    while (result && (!last)) {
+        if (in_pos >= data.size()) {
+            result = false;
+            break;
+        }
+        const uint8_t token = static_cast<uint8_t>(data[in_pos]);
+        ++in_pos;
+        size_t literal_length = token >> 4;
+        if ((15 == literal_length) && (!get_length(data, in_pos, size, literal_length))) {
+            result = false;
+        }else if ((literal_length > data.size() - in_pos) || (literal_length > size - out_pos)) {
+            result = false;
+        }else{
+            std::memcpy(out + out_pos, data.data() + in_pos, literal_length);
+            in_pos += literal_length;
+            out_pos += literal_length;
+            if (in_pos == data.size()) {
+                last = true; /* The last sequence has no match */
+            }else if (data.size() - in_pos < 2) {
+                result = false;
+            }else{
+                const size_t offset = static_cast<uint8_t>(data[in_pos])
+                                    | (static_cast<size_t>(static_cast<uint8_t>(data[in_pos + 1])) << 8);
+                in_pos += 2;
+                size_t match = token & 0x0F;
+                if ((15 == match) && (!get_length(data, in_pos, size, match))) {
+                    result = false;
+                }else if ((0 == offset) || (offset > out_pos) || (match + LZ4_MIN_MATCH > size - out_pos)) {
+                    result = false;
+                }else{
+                    match += LZ4_MIN_MATCH;
+                    if (offset >= match) {
+                        std::memcpy(out + out_pos, out + out_pos - offset, match);
+                    }else{
+                        /* Overlapping match (repeats the last offset bytes) */
+                        for (size_t idx = 0; idx < match; ++idx) {
+                            out[out_pos + idx] = out[out_pos - offset + idx];
+                        }
+                    }
+                    out_pos += match;
+                }
+            }
+        }
+    }
+
+    return result && (out_pos == size);
+}
+
+/* Check the magic of a compressed file */
+bool is_compressed(std::string_view data) {
+    return (data.size() >= KVS_COMPRESS_HEADER_SIZE)
+        && (0 == std::memcmp(data.data(), KVS_COMPRESS_MAGIC, sizeof(KVS_COMPRESS_MAGIC)));
+}
+
+/* Compress data into a complete compressed file */
+std::string compress_data(std::string_view data, KvsCompression compression) {
+    std::string result;
+    if (KvsCompression::None == compression) {
+        result = std::string(data);
+    }else{
+        std::ostringstream out;
+        KvsCompressBuffer buffer(out, compression);
+        (void)buffer.sputn(data.data(), static_cast<std::streamsize>(data.size()));
+        (void)buffer.finish();
+        result = out.str();
+    }
+
+    return result;
+}
+
+/* Decompress a complete compressed file */
+score::Result<std::string> decompress_data(std::string_view data) {
+    score::Result<std::string> result = score::MakeUnexpected(ErrorCode::UnmappedError);
+    std::string raw;
+    bool valid = is_compressed(data)
+              && (KVS_COMPRESS_VERSION == static_cast<uint8_t>(data[4]))
+              && (static_cast<uint8_t>(KvsCompression::Lz4) == static_cast<uint8_t>(data[5]));
+    size_t offset = KVS_COMPRESS_HEADER_SIZE;
+    bool end = false;
+    while (valid && (!end)) {
+        uint32_t raw_size = 0;
+        uint32_t stored_size = 0;
+        if (!binary_get_u32(data, offset, raw_size)) {
+            valid = false;
+        }else if (0 == raw_size) {
+            end = true;
+        }else if ((raw_size > KVS_COMPRESS_BLOCK_SIZE) || (!binary_get_u32(data, offset, stored_size))) {
+            valid = false;
+        }else{
+            const bool stored_raw = (0 != (stored_size & KVS_COMPRESS_STORED_RAW));
+            stored_size &= ~KVS_COMPRESS_STORED_RAW;
+            if (stored_size > data.size() - offset) {
+                valid = false;
+            }else if (stored_raw) {
+                valid = (stored_size == raw_size);
+                raw.append(data.data() + offset, stored_size);
+            }else{
+                const size_t previous = raw.size();
+                raw.resize(previous + raw_size);
+                valid = lz4_decompress_block(data.substr(offset, stored_size), &raw[previous], raw_size);
+            }
+            offset += stored_size;
+        }
+    }
+
+    if (valid && (offset == data.size())) {
+        result = std::move(raw);
+    }else{
+        result = score::MakeUnexpected(ErrorCode::IntegrityCorrupted);
+    }
+
+    return result;
+}
+
+/*********************** KvsCompressBuffer *********************/
+KvsCompressBuffer::KvsCompressBuffer(std::ostream& out, KvsCompression compression, KvsHashAlgorithm algorithm)
+    : out(out)
+    , compression(compression)
+    , algorithm(algorithm)
+    , checksum(hash_init(algorithm))
+    , total(0)
+    , header_written(false)
+    , failed(false)
+{
+    block.reserve(KVS_COMPRESS_BLOCK_SIZE);
+}
+
+KvsCompressBuffer::int_type KvsCompressBuffer::overflow(int_type ch) {
+    if (!traits_type::eq_int_type(ch, traits_type::eof())) {
+        const char byte = traits_type::to_char_type(ch);
+        (void)xsputn(&byte, 1);
+    }
+
+    return traits_type::not_eof(ch);
+}
+
+/* Collect the bytes, full blocks are compressed and written */
+std::streamsize KvsCompressBuffer::xsputn(const char* data, std::streamsize count) {
+    std::string_view remaining(data, static_cast<size_t>(count));
+    while (!remaining.empty()) {
+        const size_t len = std::min(KVS_COMPRESS_BLOCK_SIZE - block.size(), remaining.size());
+        block.append(remaining.data(), len);
+        remaining.remove_prefix(len);
+        if (block.size() >= KVS_COMPRESS_BLOCK_SIZE) {
+            write_block();
+        }
+    }
+
+    return count;
+}
+
+/* Write the last block and the end marker */
+bool KvsCompressBuffer::finish() {
+    write_block();
+    if (!header_written) {
+        write_block(); /* Header of an empty file */
+    }
+    std::string end;
+    binary_put_u32(end, 0);
+    write_bytes(end);
+    if (!out.flush()) {
+        failed = true;
+    }
+
+    return !failed;
+}
+
+uint32_t KvsCompressBuffer::hash() const {
+    return checksum;
+}
+
+size_t KvsCompressBuffer::size() const {
+    return total;
+}
+
+/* Compress the collected bytes, writes the header before the first block */
+void KvsCompressBuffer::write_block() {
+    stored.clear();
+    if (!header_written) {
+        stored.append(KVS_COMPRESS_MAGIC, sizeof(KVS_COMPRESS_MAGIC));
+        stored.push_back(static_cast<char>(KVS_COMPRESS_VERSION));
+        stored.push_back(static_cast<char>(compression));
+        stored.append(2, '\0');
+        header_written = true;
+    }
+    if (!block.empty()) {
+        binary_put_u32(stored, static_cast<uint32_t>(block.size()));
+        const size_t size_offset = stored.size();
+        binary_put_u32(stored, 0);
+        lz4_compress_block(block, stored);
+        uint32_t stored_size = static_cast<uint32_t>(stored.size() - size_offset - sizeof(uint32_t));
+        if (stored_size >= block.size()) {
+            /* Incompressible block, stored as is */
+            stored.resize(size_offset + sizeof(uint32_t));
+            stored.append(block);
+            stored_size = static_cast<uint32_t>(block.size()) | KVS_COMPRESS_STORED_RAW;
+        }
+        std::string size_bytes;
+        binary_put_u32(size_bytes, stored_size);
+        stored.replace(size_offset, sizeof(uint32_t), size_bytes);
+        block.clear();
+    }
+    write_bytes(stored);
+}
+
+void KvsCompressBuffer::write_bytes(std::string_view data) {
+    checksum = hash_update(algorithm, checksum, data.data(), data.size());
+    total += data.size();
+    if ((!failed) && (!out.write(data.data(), static_cast<std::streamsize>(data.size())))) {
+        failed = true;
+    }
+}
+
+} /* namespace score::mw::per::kvs */
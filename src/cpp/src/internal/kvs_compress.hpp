@@ -0,0 +1,103 @@
+/********************************************************************************
+* Copyright (c) 2025 Contributors to the Eclipse Foundation
+*
+* See the NOTICE file(s) distributed with this work for additional
+* information regarding copyright ownership.
+*
+* This program and the accompanying materials are made available under the
+* terms of the Apache License Version 2.0 which is available at
+* https://www.apache.org/licenses/LICENSE-2.0
+*
+* SPDX-License-Identifier: Apache-2.0
+********************************************************************************/
+#ifndef SCORE_LIB_KVS_INTERNAL_KVS_COMPRESS_HPP
+#define SCORE_LIB_KVS_INTERNAL_KVS_COMPRESS_HPP
+
+#include <cstdint>
+#include <ostream>
+#include <streambuf>
+#include <string>
+#include <string_view>
+#include "error.hpp"
+#include "kvs_checksum.hpp"
+
+/*
+ * This header defines the block compression of the KVS files (KvsOptions::compression).
+ * KvsCompression is an option of KvsOptions, so this header is included by kvs.hpp.
+ *
+ * Layout (all integers little-endian):
+ *   File:   magic "KVSZ" | version (u8) | codec (u8) | reserved (u16, 0) | blocks | end marker (u32, 0)
+ *   Block:  raw size (u32, 1..KVS_COMPRESS_BLOCK_SIZE) | stored size (u32) | stored bytes
+ *           Bit 31 of the stored size marks a block stored uncompressed (data that doesn't get smaller).
+ *
+ * Every block is compressed on its own in the LZ4 block format (tokens with 4-bit literal and match
+ * lengths, 2-byte offsets up to 64 KiB), so a file is written and read block by block. The compressed
+ * file replaces the JSON or binary data in its file, the hash file covers the compressed bytes.
+ */
+namespace score::mw::per::kvs {
+
+/* Compression of the KVS files written by flush (value is stored as codec in the file header) */
+enum class KvsCompression : uint8_t {
+    None = 0, /* Files contain the JSON or binary data */
+    Lz4 = 1   /* Blocks in the LZ4 block format, fast to decompress */
+};
+
+/* Maximum number of uncompressed bytes per block */
+constexpr size_t KVS_COMPRESS_BLOCK_SIZE = 64 * 1024;
+
+/* Single block in the LZ4 block format, appended to out (decompression fails unless exactly size bytes result) */
+void lz4_compress_block(std::string_view data, std::string& out);
+bool lz4_decompress_block(std::string_view data, char* out, size_t size);
+
+/* Whether data starts with the header of a compressed file */
+bool is_compressed(std::string_view data);
+
+/* Complete compressed file of data, data itself with KvsCompression::None */
+std::string compress_data(std::string_view data, KvsCompression compression);
+
+/* Data of a compressed file, ErrorCode::IntegrityCorrupted if the file is malformed */
+score::Result<std::string> decompress_data(std::string_view data);
+
+/**
+ * @class KvsCompressBuffer
+ * @brief Output buffer that compresses the written bytes block by block into a stream.
+ *
+ * The header is written by the first block, finish() writes the last block and the end marker.
+ * The checksum and size cover the compressed bytes written to the stream, so they equal calculate_hash
+ * and size of the complete file. Only one block is kept in memory.
+ *
+ * Public Methods:
+ * - `finish`: Writes the remaining bytes and the end marker, returns false if any write failed.
+ * - `hash`: Retrieves the checksum of the compressed file (complete after finish).
+ * - `size`: Retrieves the size of the compressed file.
+ */
+class KvsCompressBuffer final : public std::streambuf {
+public:
+    KvsCompressBuffer(std::ostream& out, KvsCompression compression, KvsHashAlgorithm algorithm = KvsHashAlgorithm::Adler32);
+
+    bool finish();
+    uint32_t hash() const;
+    size_t size() const;
+
+protected:
+    int_type overflow(int_type ch) override;
+    std::streamsize xsputn(const char* data, std::streamsize count) override;
+
+private:
+    void write_block();
+    void write_bytes(std::string_view data);
+
+    std::ostream& out;
+    KvsCompression compression;
+    KvsHashAlgorithm algorithm;
+    std::string block;      /* Bytes not compressed yet */
+    std::string stored;     /* Output of the current block */
+    uint32_t checksum;      /* Rolling checksum of the written bytes */
+    size_t total;           /* Number of written bytes */
+    bool header_written;
+    bool failed;            /* A write to the stream failed */
+};
+
+} /* namespace score::mw::per::kvs */
+
+#endif // SCORE_LIB_KVS_INTERNAL_KVS_COMPRESS_HPP
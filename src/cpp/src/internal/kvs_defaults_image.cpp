@@ -0,0 +1,312 @@
+/********************************************************************************
+* Copyright (c) 2025 Contributors to the Eclipse Foundation
+*
+* See the NOTICE file(s) distributed with this work for additional
+* information regarding copyright ownership.
+*
+* This program and the accompanying materials are made available under the
+* terms of the Apache License Version 2.0 which is available at
+* https://www.apache.org/licenses/LICENSE-2.0
+*
+* SPDX-License-Identifier: Apache-2.0
+********************************************************************************/
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <limits>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "kvs_binary.hpp"
+#include "kvs_defaults_image.hpp"
+
+namespace score::mw::per::kvs {
+
+namespace {
+
+/* Magic bytes at the beginning of every defaults image */
+constexpr char KVS_DEFAULTS_IMAGE_MAGIC[4] = {'K', 'V', 'S', 'D'};
+
+/* Size of the header (magic, version, reserved, source hash, entry count) */
+constexpr size_t KVS_DEFAULTS_IMAGE_HEADER_SIZE = 16;
+
+/* Size of one index entry (key offset, key length, value offset, value length) */
+constexpr size_t KVS_DEFAULTS_IMAGE_ENTRY_SIZE = 16;
+
+void set_u32(std::string& out, size_t offset, uint32_t value) {
+    for (size_t i = 0; i < 4; ++i) {
+        out[offset + i] = static_cast<char>((value >> (8 * i)) & 0xFF);
+    }
+}
+
+uint32_t read_u32(const char* ptr) {
+    uint32_t value = 0;
+    for (size_t i = 0; i < 4; ++i) {
+        value |= static_cast<uint32_t>(static_cast<uint8_t>(ptr[i])) << (8 * i);
+    }
+    return value;
+}
+
+uint16_t read_u16(const char* ptr) {
+    return static_cast<uint16_t>(static_cast<uint8_t>(ptr[0]) | (static_cast<uint16_t>(static_cast<uint8_t>(ptr[1])) << 8));
+}
+
+/* Key and value of an index entry, fails if they are outside of the image */
+bool read_entry(std::string_view image, size_t index, std::string_view& key, std::string_view& value) {
+    bool result = false;
+    const char* entry = image.data() + KVS_DEFAULTS_IMAGE_HEADER_SIZE + (index * KVS_DEFAULTS_IMAGE_ENTRY_SIZE);
+    const size_t key_offset = read_u32(entry);
+    const size_t key_len = read_u32(entry + 4);
+    const size_t value_offset = read_u32(entry + 8);
+    const size_t value_len = read_u32(entry + 12);
+    if ((key_offset <= image.size()) && (key_len <= image.size() - key_offset)
+        && (value_offset <= image.size()) && (value_len <= image.size() - value_offset)) {
+        key = image.substr(key_offset, key_len);
+        value = image.substr(value_offset, value_len);
+        result = true;
+    }
+
+    return result;
+}
+
+/* Number of index entries, 0 if the header is invalid or the index doesn't fit into the image */
+size_t read_count(std::string_view image) {
+    size_t result = 0;
+    if (image.size() >= KVS_DEFAULTS_IMAGE_HEADER_SIZE) {
+        const size_t count = read_u32(image.data() + 12);
+        if ((image.size() - KVS_DEFAULTS_IMAGE_HEADER_SIZE) / KVS_DEFAULTS_IMAGE_ENTRY_SIZE >= count) {
+            result = count;
+        }
+    }
+
+    return result;
+}
+
+} /* namespace */
+
+/* Encode a map into an image (header, sorted index and data) */
+score::Result<std::string> image_encode(const KvsMap& map, uint32_t source_hash) {
+    score::Result<std::string> result = score::MakeUnexpected(ErrorCode::UnmappedError);
+    std::string out;
+    bool error = false;
+
+    if (map.size() > std::numeric_limits<uint32_t>::max()) {
+        result = score::MakeUnexpected(ErrorCode::SerializationFailed);
+        error = true;
+    }else{
+        /* Header and index (offsets are set while the data is appended) */
+        out.append(KVS_DEFAULTS_IMAGE_MAGIC, sizeof(KVS_DEFAULTS_IMAGE_MAGIC));
+        out.push_back(static_cast<char>(KVS_DEFAULTS_IMAGE_VERSION & 0xFF));
+        out.push_back(static_cast<char>((KVS_DEFAULTS_IMAGE_VERSION >> 8) & 0xFF));
+        out.append(2, '\0'); /* Reserved */
+        binary_put_u32(out, source_hash);
+        binary_put_u32(out, static_cast<uint32_t>(map.size()));
+        out.append(map.size() * KVS_DEFAULTS_IMAGE_ENTRY_SIZE, '\0');
+
+        /* KvsMap iterates in key order, so the index is sorted */
+        size_t entry = KVS_DEFAULTS_IMAGE_HEADER_SIZE;
+        for (const auto& [key, value] : map) {
+            const size_t key_offset = out.size();
+            out.append(key);
+            const size_t value_offset = out.size();
+            auto enc = binary_encode_value(value, out);
+            if (!enc) {
+                result = score::MakeUnexpected(static_cast<ErrorCode>(*enc.error()));
+                error = true;
+                break;
+            }
+            if (out.size() > std::numeric_limits<uint32_t>::max()) {
+                result = score::MakeUnexpected(ErrorCode::SerializationFailed);
+                error = true;
+                break;
+            }
+            set_u32(out, entry, static_cast<uint32_t>(key_offset));
+            set_u32(out, entry + 4, static_cast<uint32_t>(key.size()));
+            set_u32(out, entry + 8, static_cast<uint32_t>(value_offset));
+            set_u32(out, entry + 12, static_cast<uint32_t>(out.size() - value_offset));
+            entry += KVS_DEFAULTS_IMAGE_ENTRY_SIZE;
+        }
+    }
+    if (!error) {
+        result = std::move(out);
+    }
+
+    return result;
+}
+
+/* Binary search for the encoded value of a key (every offset is checked, the image may be corrupted) */
+score::Result<std::string_view> image_find(std::string_view image, const std::string_view key) {
+    score::Result<std::string_view> result = score::MakeUnexpected(ErrorCode::KeyNotFound);
+    size_t low = 0;
+    size_t high = read_count(image);
+    while (low < high) {
+        const size_t mid = low + ((high - low) / 2);
+        std::string_view entry_key;
+        std::string_view entry_value;
+        if (!read_entry(image, mid, entry_key, entry_value)) {
+            result = score::MakeUnexpected(ErrorCode::SerializationFailed);
+            break;
+        }
+        const int32_t cmp = entry_key.compare(key);
+        if (cmp < 0) {
+            low = mid + 1;
+        }else if (cmp > 0) {
+            high = mid;
+        }else{
+            result = entry_value;
+            break;
+        }
+    }
+
+    return result;
+}
+
+/* Visit the encoded entries of all keys with a prefix in key order */
+score::ResultBlank image_scan(std::string_view image, const std::string_view prefix,
+                              const std::function<void(std::string_view, std::string_view)>& visitor) {
+    score::ResultBlank result = score::ResultBlank{};
+    const size_t count = read_count(image);
+    std::string_view entry_key;
+    std::string_view entry_value;
+
+    /* First entry not less than the prefix */
+    size_t low = 0;
+    size_t high = count;
+    while (result && (low < high)) {
+        const size_t mid = low + ((high - low) / 2);
+        if (!read_entry(image, mid, entry_key, entry_value)) {
+            result = score::MakeUnexpected(ErrorCode::SerializationFailed);
+        }else if (entry_key < prefix) {
+            low = mid + 1;
+        }else{
+            high = mid;
+        }
+    }
+    for (size_t index = low; result && (index < count); ++index) {
+        if (!read_entry(image, index, entry_key, entry_value)) {
+            result = score::MakeUnexpected(ErrorCode::SerializationFailed);
+        }else if (0 != entry_key.compare(0, prefix.size(), prefix)) {
+            break;
+        }else{
+            visitor(entry_key, entry_value);
+        }
+    }
+
+    return result;
+}
+
+DefaultsImage::DefaultsImage(const char* data, size_t data_size, uint32_t count)
+    : data(data)
+    , data_size(data_size)
+    , count(count)
+{
+}
+
+DefaultsImage::~DefaultsImage() {
+    (void)munmap(const_cast<char*>(data), data_size);
+}
+
+/* Map a defaults image and check its header */
+score::Result<std::shared_ptr<const DefaultsImage>> DefaultsImage::open(const std::string& path, uint32_t source_hash) {
+    score::Result<std::shared_ptr<const DefaultsImage>> result = score::MakeUnexpected(ErrorCode::UnmappedError);
+
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (0 > fd) {
+        result = score::MakeUnexpected((ENOENT == errno) ? ErrorCode::FileNotFound : ErrorCode::KvsFileReadError);
+    }else{
+        struct stat file_stat{};
+        if ((0 != fstat(fd, &file_stat)) || (static_cast<size_t>(file_stat.st_size) < KVS_DEFAULTS_IMAGE_HEADER_SIZE)) {
+            result = score::MakeUnexpected(ErrorCode::SerializationFailed);
+        }else{
+            const size_t size = static_cast<size_t>(file_stat.st_size);
+            void* addr = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+            if (MAP_FAILED == addr) {
+                result = score::MakeUnexpected(ErrorCode::KvsFileReadError);
+            }else{
+                const char* data = static_cast<const char*>(addr);
+                const uint32_t count = read_u32(data + 12);
+                if ((0 != std::memcmp(data, KVS_DEFAULTS_IMAGE_MAGIC, sizeof(KVS_DEFAULTS_IMAGE_MAGIC)))
+                    || (KVS_DEFAULTS_IMAGE_VERSION != read_u16(data + 4))
+                    || ((size - KVS_DEFAULTS_IMAGE_HEADER_SIZE) / KVS_DEFAULTS_IMAGE_ENTRY_SIZE < count)) {
+                    (void)munmap(addr, size);
+                    result = score::MakeUnexpected(ErrorCode::SerializationFailed);
+                }else if (source_hash != read_u32(data + 8)) {
+                    (void)munmap(addr, size);
+                    result = score::MakeUnexpected(ErrorCode::ValidationFailed); /* Built from other defaults */
+                }else{
+                    /* The image takes ownership of the mapping */
+                    result = std::shared_ptr<const DefaultsImage>(new DefaultsImage(data, size, count));
+                }
+            }
+        }
+        (void)close(fd); /* The mapping stays valid after closing the file */
+    }
+
+    return result;
+}
+
+/* Build a defaults image from a map of default values */
+score::ResultBlank DefaultsImage::write(const std::string& path, const KvsMap& defaults, uint32_t source_hash) {
+    score::ResultBlank result = score::MakeUnexpected(ErrorCode::UnmappedError);
+    auto image_res = image_encode(defaults, source_hash);
+
+    if (!image_res) {
+        result = score::MakeUnexpected(static_cast<ErrorCode>(*image_res.error()));
+    }else{
+        const std::string& out = image_res.value();
+        /* Write to a temporary file and rename it, so other processes never map a partial image */
+        const std::string tmp_path = path + ".tmp" + std::to_string(getpid());
+        std::ofstream file(tmp_path, std::ios::binary);
+        if (!file.write(out.data(), out.size())) {
+            result = score::MakeUnexpected(ErrorCode::PhysicalStorageFailure);
+        }else{
+            file.close();
+            if (0 != std::rename(tmp_path.c_str(), path.c_str())) {
+                result = score::MakeUnexpected(ErrorCode::PhysicalStorageFailure);
+            }else{
+                result = score::ResultBlank{};
+            }
+        }
+        if (!result) {
+            (void)std::remove(tmp_path.c_str());
+        }
+    }
+
+    return result;
+}
+
+/* Binary search for the encoded value of a key */
+score::Result<std::string_view> DefaultsImage::find_value_data(const std::string_view key) const {
+    return image_find(std::string_view(data, data_size), key);
+}
+
+/* Check if a key is available in the image */
+bool DefaultsImage::contains(const std::string_view key) const {
+    return find_value_data(key).has_value();
+}
+
+/* Decode the value of a key */
+score::Result<KvsValue> DefaultsImage::find(const std::string_view key) const {
+    score::Result<KvsValue> result = score::MakeUnexpected(ErrorCode::UnmappedError);
+    auto value_res = find_value_data(key);
+    if (!value_res) {
+        result = score::MakeUnexpected(static_cast<ErrorCode>(*value_res.error()));
+    }else{
+        size_t offset = 0;
+        result = binary_decode_value(value_res.value(), offset);
+        if (result && (offset != value_res.value().size())) {
+            result = score::MakeUnexpected(ErrorCode::SerializationFailed);
+        }
+    }
+
+    return result;
+}
+
+/* Number of entries */
+size_t DefaultsImage::size() const {
+    return count;
+}
+
+} /* namespace score::mw::per::kvs */
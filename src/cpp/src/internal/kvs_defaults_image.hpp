@@ -0,0 +1,91 @@
+/********************************************************************************
+* Copyright (c) 2025 Contributors to the Eclipse Foundation
+*
+* See the NOTICE file(s) distributed with this work for additional
+* information regarding copyright ownership.
+*
+* This program and the accompanying materials are made available under the
+* terms of the Apache License Version 2.0 which is available at
+* https://www.apache.org/licenses/LICENSE-2.0
+*
+* SPDX-License-Identifier: Apache-2.0
+********************************************************************************/
+#ifndef SCORE_LIB_KVS_INTERNAL_KVS_DEFAULTS_IMAGE_HPP
+#define SCORE_LIB_KVS_INTERNAL_KVS_DEFAULTS_IMAGE_HPP
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include "error.hpp"
+#include "kvsvalue.hpp"
+
+/*
+ * This header defines the read-only, memory-mapped image of the default values (kvs_<id>_default.img).
+ * Kvs builds it from the JSON defaults and maps it instead of parsing them on the next open
+ * (KvsOptions::mapped_defaults, always for KvsSharing::Reader). The image is a cache: an image
+ * whose source hash doesn't match the hash file is ignored and rebuilt.
+ *
+ * Layout (all integers little-endian):
+ *   Header: magic "KVSD" | version (u16) | reserved (u16, 0) | source hash (u32) | entry count (u32)
+ *   Index:  entry count * (key offset (u32) | key length (u32) | value offset (u32) | value length (u32)),
+ *           sorted by key
+ *   Data:   key bytes and values (binary encoding of internal/kvs_binary.hpp)
+ *
+ * The source hash is the hash of the defaults JSON file the image was built from (content of
+ * kvs_<id>_default.hash), so a changed JSON file makes the image stale without reading the JSON file.
+ * The same layout is used for the data published in shared memory (see internal/kvs_shared.hpp).
+ */
+namespace score::mw::per::kvs {
+
+/* Current version of the defaults image format */
+constexpr uint16_t KVS_DEFAULTS_IMAGE_VERSION = 1;
+
+score::Result<std::string> image_encode(const KvsMap& map, uint32_t source_hash);
+score::Result<std::string_view> image_find(std::string_view image, const std::string_view key);
+score::ResultBlank image_scan(std::string_view image, const std::string_view prefix,
+                              const std::function<void(std::string_view, std::string_view)>& visitor);
+
+/**
+ * @class DefaultsImage
+ * @brief Lazy lookup of default values in a memory-mapped defaults image.
+ *
+ * Opening the image only maps the file and checks the header, keys are found by a binary search
+ * over the index and only the requested value is decoded. The mapping is read-only and shared,
+ * so all processes using the same defaults share the pages via the page cache.
+ *
+ * Public Methods:
+ * - `open`: Maps an image file, fails if it doesn't exist, is invalid or was built from another source.
+ * - `write`: Builds an image file from a map of default values (written to a temporary file and renamed).
+ * - `contains`: Checks if a key is available in the image.
+ * - `find`: Decodes the value of a key.
+ * - `size`: Retrieves the number of entries.
+ *
+ * The image is not copyable, it is shared via std::shared_ptr<const DefaultsImage>.
+ */
+class DefaultsImage final {
+public:
+    ~DefaultsImage();
+    DefaultsImage(const DefaultsImage&) = delete;
+    DefaultsImage& operator=(const DefaultsImage&) = delete;
+
+    static score::Result<std::shared_ptr<const DefaultsImage>> open(const std::string& path, uint32_t source_hash);
+    static score::ResultBlank write(const std::string& path, const KvsMap& defaults, uint32_t source_hash);
+
+    bool contains(const std::string_view key) const;
+    score::Result<KvsValue> find(const std::string_view key) const;
+    size_t size() const;
+
+private:
+    DefaultsImage(const char* data, size_t data_size, uint32_t count);
+    score::Result<std::string_view> find_value_data(const std::string_view key) const;
+
+    const char* data;  /* Start of the mapping */
+    size_t data_size;  /* Size of the mapping */
+    uint32_t count;    /* Number of entries */
+};
+
+} /* namespace score::mw::per::kvs */
+
+#endif // SCORE_LIB_KVS_INTERNAL_KVS_DEFAULTS_IMAGE_HPP
@@ -0,0 +1,98 @@
+/********************************************************************************
+* Copyright (c) 2025 Contributors to the Eclipse Foundation
+*
+* See the NOTICE file(s) distributed with this work for additional
+* information regarding copyright ownership.
+*
+* This program and the accompanying materials are made available under the
+* terms of the Apache License Version 2.0 which is available at
+* https://www.apache.org/licenses/LICENSE-2.0
+*
+* SPDX-License-Identifier: Apache-2.0
+********************************************************************************/
+#include "kvs_delta.hpp"
+#include "kvs_log.hpp"
+
+namespace score::mw::per::kvs {
+
+/* Encode the changes from base to target (both maps are sorted, so they are walked once) */
+score::Result<std::string> delta_encode(const KvsMap& base, const KvsMap& target, uint32_t base_hash) {
+    score::Result<std::string> result = score::MakeUnexpected(ErrorCode::UnmappedError);
+    std::string out = log_encode_header(base_hash);
+    score::ResultBlank enc = score::ResultBlank{};
+    auto base_it = base.begin();
+    auto target_it = target.begin();
+    while (enc && ((base_it != base.end()) || (target_it != target.end()))) {
+        if ((target_it == target.end()) || ((base_it != base.end()) && (base_it->first < target_it->first))) {
+            enc = log_encode_remove(out, base_it->first);
+            ++base_it;
+        }else if ((base_it == base.end()) || (target_it->first < base_it->first)) {
+            enc = log_encode_set(out, target_it->first, target_it->second);
+            ++target_it;
+        }else{
+            if (base_it->second != target_it->second) {
+                enc = log_encode_set(out, target_it->first, target_it->second);
+            }
+            ++base_it;
+            ++target_it;
+        }
+    }
+    if (!enc) {
+        result = score::MakeUnexpected(static_cast<ErrorCode>(*enc.error()));
+    }else{
+        result = std::move(out);
+    }
+
+    return result;
+}
+
+/* Apply a delta to the map of its base snapshot */
+score::ResultBlank delta_apply(std::string_view data, uint32_t base_hash, KvsMap& map) {
+    score::ResultBlank result = score::MakeUnexpected(ErrorCode::UnmappedError);
+    auto replay_res = log_replay(data, base_hash, map);
+    if (!replay_res) {
+        result = score::MakeUnexpected(ErrorCode::ValidationFailed);
+    }else if (replay_res.value() != data.size()) {
+        /* A delta is written at once, a torn record means it is corrupted */
+        result = score::MakeUnexpected(ErrorCode::ValidationFailed);
+    }else{
+        result = score::ResultBlank{};
+    }
+
+    return result;
+}
+
+/* Collect the changes of a delta by key (applied after the changes of the newer deltas) */
+score::ResultBlank delta_changes(std::string_view data, uint32_t base_hash, KvsChanges& changes) {
+    score::ResultBlank result = score::MakeUnexpected(ErrorCode::UnmappedError);
+    auto replay_res = log_replay_changes(data, base_hash, changes);
+    if ((!replay_res) || (replay_res.value() != data.size())) {
+        result = score::MakeUnexpected(ErrorCode::ValidationFailed);
+    }else{
+        result = score::ResultBlank{};
+    }
+
+    return result;
+}
+
+/* Make map equal to source, only the changed entries are copied (values are shared) */
+void delta_update(KvsMap& map, const KvsMap& source) {
+    auto map_it = map.begin();
+    auto source_it = source.begin();
+    while ((map_it != map.end()) || (source_it != source.end())) {
+        if ((source_it == source.end()) || ((map_it != map.end()) && (map_it->first < source_it->first))) {
+            map_it = map.erase(map_it);
+        }else if ((map_it == map.end()) || (source_it->first < map_it->first)) {
+            (void)map.emplace_hint(map_it, source_it->first, source_it->second);
+            ++source_it;
+        }else{
+            if (map_it->second != source_it->second) {
+                map_it->second = source_it->second;
+            }
+            ++map_it;
+            ++source_it;
+        }
+    }
+}
+
+} /* namespace score::mw::per::kvs */
@@ -0,0 +1,45 @@
+/********************************************************************************
+* Copyright (c) 2025 Contributors to the Eclipse Foundation
+*
+* See the NOTICE file(s) distributed with this work for additional
+* information regarding copyright ownership.
+*
+* This program and the accompanying materials are made available under the
+* terms of the Apache License Version 2.0 which is available at
+* https://www.apache.org/licenses/LICENSE-2.0
+*
+* SPDX-License-Identifier: Apache-2.0
+********************************************************************************/
+#ifndef SCORE_LIB_KVS_INTERNAL_KVS_DELTA_HPP
+#define SCORE_LIB_KVS_INTERNAL_KVS_DELTA_HPP
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include "error.hpp"
+#include "kvs_log.hpp"
+#include "kvsvalue.hpp"
+
+/*
+ * This header defines the delta snapshots (kvs_<id>_<n>.delta, KvsOptions::delta_snapshots).
+ * A flush encodes the delta to the previous KVS file, open_snapshot applies the deltas to rebuild
+ * an older snapshot.
+ *
+ * A delta snapshot contains the changes from the next newer snapshot to it (reverse delta), so the
+ * current KVS file stays complete and only the rotated out snapshot is rewritten. The delta uses the
+ * format of the write-ahead log (see internal/kvs_log.hpp), its base hash is the hash of the newer snapshot.
+ * The hash file of a delta snapshot keeps the hash of the complete snapshot, the base of the next older delta.
+ */
+namespace score::mw::per::kvs {
+
+/* Extension of a snapshot that is stored as delta */
+constexpr const char* KVS_DELTA_EXTENSION = ".delta";
+
+score::Result<std::string> delta_encode(const KvsMap& base, const KvsMap& target, uint32_t base_hash);
+score::ResultBlank delta_apply(std::string_view data, uint32_t base_hash, KvsMap& map);
+score::ResultBlank delta_changes(std::string_view data, uint32_t base_hash, KvsChanges& changes);
+void delta_update(KvsMap& map, const KvsMap& source);
+
+} /* namespace score::mw::per::kvs */
+
+#endif // SCORE_LIB_KVS_INTERNAL_KVS_DELTA_HPP
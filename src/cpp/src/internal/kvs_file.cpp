@@ -0,0 +1,94 @@
+/********************************************************************************
+* Copyright (c) 2025 Contributors to the Eclipse Foundation
+*
+* See the NOTICE file(s) distributed with this work for additional
+* information regarding copyright ownership.
+*
+* This program and the accompanying materials are made available under the
+* terms of the Apache License Version 2.0 which is available at
+* https://www.apache.org/licenses/LICENSE-2.0
+*
+* SPDX-License-Identifier: Apache-2.0
+********************************************************************************/
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <fcntl.h>
+#include <unistd.h>
+#include "kvs_file.hpp"
+
+namespace score::mw::per::kvs {
+
+/* Write (replace) a file, with sync the data is on the storage when the function returns */
+bool file_write(const std::string& path, std::string_view content, bool sync) {
+    bool result = false;
+    const int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0666);
+    if (fd >= 0) {
+        size_t offset = 0;
+        bool error = false;
+        while ((!error) && (offset < content.size())) {
+            const ssize_t written = ::write(fd, content.data() + offset, content.size() - offset);
+            if (written > 0) {
+                offset += static_cast<size_t>(written);
+            }else if ((written < 0) && (EINTR == errno)) {
+                /* Interrupted, retry */
+            }else{
+                error = true;
+            }
+        }
+        if ((!error) && sync && (0 != ::fdatasync(fd))) {
+            error = true;
+        }
+        if ((0 == ::close(fd)) && (!error)) {
+            result = true;
+        }
+    }
+
+    return result;
+}
+
+/* Wait until the data of a written file is on the storage */
+bool file_sync(const std::string& path) {
+    bool result = false;
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd >= 0) {
+        result = (0 == ::fdatasync(fd));
+        (void)::close(fd);
+    }
+
+    return result;
+}
+
+/* Wait until the directory entries (created or renamed files) of the directory of path are on the storage */
+bool dir_sync(const std::string& path) {
+    bool result = false;
+    const size_t pos = path.find_last_of('/');
+    const std::string dir = (std::string::npos == pos) ? std::string(".") : ((0 == pos) ? std::string("/") : path.substr(0, pos));
+    const int fd = ::open(dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd >= 0) {
+        /* Some filesystems don't support syncing a directory, their entries are written synchronously */
+        result = (0 == ::fsync(fd)) || (EINVAL == errno);
+        (void)::close(fd);
+    }
+
+    return result;
+}
+
+/* Make a file available under a second name and keep it (moved if the filesystem has no hard links),
+   an existing file with the new name is replaced. Fails with errno ENOENT if the file doesn't exist. */
+bool file_link(const std::string& from, const std::string& to) {
+    bool result = false;
+    int32_t link_res = ::link(from.c_str(), to.c_str());
+    if ((0 != link_res) && (EEXIST == errno) && (0 == std::remove(to.c_str()))) {
+        link_res = ::link(from.c_str(), to.c_str());
+    }
+    if (0 == link_res) {
+        result = true;
+    }else if ((ENOENT != errno) && (EEXIST != errno)) {
+        result = (0 == std::rename(from.c_str(), to.c_str())); /* No hard links (e.g. EPERM on FAT) */
+    }
+
+    return result;
+}
+
+} /* namespace score::mw::per::kvs */
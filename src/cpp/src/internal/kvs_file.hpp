@@ -0,0 +1,33 @@
+/********************************************************************************
+* Copyright (c) 2025 Contributors to the Eclipse Foundation
+*
+* See the NOTICE file(s) distributed with this work for additional
+* information regarding copyright ownership.
+*
+* This program and the accompanying materials are made available under the
+* terms of the Apache License Version 2.0 which is available at
+* https://www.apache.org/licenses/LICENSE-2.0
+*
+* SPDX-License-Identifier: Apache-2.0
+********************************************************************************/
+#ifndef SCORE_LIB_KVS_INTERNAL_KVS_FILE_HPP
+#define SCORE_LIB_KVS_INTERNAL_KVS_FILE_HPP
+
+#include <string>
+#include <string_view>
+
+/*
+ * This header defines the file operations of the crash-safe flush: files are written under a
+ * temporary name, optionally synced to the storage and then renamed over the current file.
+ * They implement KvsFileBackend (kvs_backend.hpp), other backends don't need them.
+ */
+namespace score::mw::per::kvs {
+
+bool file_write(const std::string& path, std::string_view content, bool sync);
+bool file_sync(const std::string& path);
+bool dir_sync(const std::string& path);
+bool file_link(const std::string& from, const std::string& to);
+
+} /* namespace score::mw::per::kvs */
+
+#endif // SCORE_LIB_KVS_INTERNAL_KVS_FILE_HPP
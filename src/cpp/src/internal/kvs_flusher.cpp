@@ -0,0 +1,90 @@
+/********************************************************************************
+* Copyright (c) 2025 Contributors to the Eclipse Foundation
+*
+* See the NOTICE file(s) distributed with this work for additional
+* information regarding copyright ownership.
+*
+* This program and the accompanying materials are made available under the
+* terms of the Apache License Version 2.0 which is available at
+* https://www.apache.org/licenses/LICENSE-2.0
+*
+* SPDX-License-Identifier: Apache-2.0
+********************************************************************************/
+#include "kvs_flusher.hpp"
+
+namespace score::mw::per::kvs {
+
+KvsFlusher::KvsFlusher(Job job)
+    : job(std::move(job))
+    , pending(false)
+    , running(false)
+    , stopping(false)
+{
+}
+
+KvsFlusher::~KvsFlusher() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    cv.notify_one();
+    if (thread.joinable()) {
+        thread.join();
+    }
+}
+
+/* Request a run of the job, joins the pending run if there is one */
+std::shared_future<score::ResultBlank> KvsFlusher::request(Callback callback) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!pending) {
+        promise = std::promise<score::ResultBlank>();
+        future = promise.get_future().share();
+        pending = true;
+    }
+    if (callback) {
+        callbacks.push_back(std::move(callback));
+    }
+    if (!thread.joinable()) {
+        thread = std::thread(&KvsFlusher::run, this); /* Lazy start */
+    }
+    cv.notify_one();
+
+    return future;
+}
+
+/* Wait until no job is pending or running */
+void KvsFlusher::wait() {
+    std::unique_lock<std::mutex> lock(mutex);
+    idle_cv.wait(lock, [this] { return (!pending) && (!running); });
+}
+
+/* Loop of the background thread, a pending job is finished before stopping */
+void KvsFlusher::run() {
+    std::unique_lock<std::mutex> lock(mutex);
+    bool active = true;
+    while (active) {
+        cv.wait(lock, [this] { return pending || stopping; });
+        if (pending) {
+            std::promise<score::ResultBlank> done = std::move(promise);
+            std::vector<Callback> done_callbacks = std::move(callbacks);
+            callbacks.clear();
+            pending = false;
+            running = true;
+            lock.unlock();
+
+            const score::ResultBlank result = job();
+            for (const auto& callback : done_callbacks) {
+                callback(result);
+            }
+            done.set_value(result);
+
+            lock.lock();
+            running = false;
+            idle_cv.notify_all();
+        }else{
+            active = false;
+        }
+    }
+}
+
+} /* namespace score::mw::per::kvs */
@@ -0,0 +1,83 @@
+/********************************************************************************
+* Copyright (c) 2025 Contributors to the Eclipse Foundation
+*
+* See the NOTICE file(s) distributed with this work for additional
+* information regarding copyright ownership.
+*
+* This program and the accompanying materials are made available under the
+* terms of the Apache License Version 2.0 which is available at
+* https://www.apache.org/licenses/LICENSE-2.0
+*
+* SPDX-License-Identifier: Apache-2.0
+********************************************************************************/
+#ifndef SCORE_LIB_KVS_INTERNAL_KVS_FLUSHER_HPP
+#define SCORE_LIB_KVS_INTERNAL_KVS_FLUSHER_HPP
+
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "error.hpp"
+
+/*
+ * This header defines the background thread of the asynchronous flush (KvsOptions::background_flush).
+ * Kvs starts it on the first flush and hands it the write of the serialized data, so the caller
+ * doesn't wait for the I/O. Kvs::sync and the snapshot operations wait for the pending write.
+ */
+namespace score::mw::per::kvs {
+
+/**
+ * @class KvsFlusher
+ * @brief Runs a flush job in a background thread and coalesces repeated requests.
+ *
+ * Requests made while no job is pending create a new pending job, requests made while a job is
+ * pending join it (same future, additional callback). A job that already started doesn't take new
+ * requests, since it may have captured the data before the request was made.
+ *
+ * Public Methods:
+ * - `request`: Requests a run of the job, returns the future of the (possibly shared) run.
+ * - `wait`: Waits until no job is pending or running.
+ *
+ * Private Methods:
+ * - `run`: Loop of the background thread.
+ *
+ * Notice:
+ * - The thread is started by the first request, so unused flushers don't cost a thread.
+ * - The destructor finishes a pending job before it joins the thread, no request is lost.
+ * - Callbacks are called in the background thread before the future becomes ready,
+ *   they must not wait for a future of the same flusher.
+ */
+class KvsFlusher final {
+public:
+    using Job = std::function<score::ResultBlank()>;
+    using Callback = std::function<void(const score::ResultBlank&)>;
+
+    explicit KvsFlusher(Job job);
+    ~KvsFlusher();
+    KvsFlusher(const KvsFlusher&) = delete;
+    KvsFlusher& operator=(const KvsFlusher&) = delete;
+
+    std::shared_future<score::ResultBlank> request(Callback callback = nullptr);
+    void wait();
+
+private:
+    void run();
+
+    Job job;
+    std::mutex mutex;
+    std::condition_variable cv;                    /* Signals new requests and stopping to the thread */
+    std::condition_variable idle_cv;               /* Signals finished jobs to wait() */
+    bool pending;                                  /* A job was requested and not started yet */
+    bool running;                                  /* The thread currently runs a job */
+    bool stopping;                                 /* The destructor was called */
+    std::promise<score::ResultBlank> promise;      /* Result of the pending job */
+    std::shared_future<score::ResultBlank> future; /* Shared with every request of the pending job */
+    std::vector<Callback> callbacks;               /* Callbacks of the pending job */
+    std::thread thread;
+};
+
+} /* namespace score::mw::per::kvs */
+
+#endif // SCORE_LIB_KVS_INTERNAL_KVS_FLUSHER_HPP
@@ -10,32 +10,25 @@
 *
 * SPDX-License-Identifier: Apache-2.0
 ********************************************************************************/
+#include <algorithm>
 #include "kvs_helper.hpp"
 
 namespace score::mw::per::kvs {
 
 /*********************** Hash Functions *********************/
 /*Adler 32 checksum algorithm*/
-// Optimized version: processes data in blocks to reduce modulo operations
+// Accelerated implementation is selected at runtime, see kvs_checksum.hpp
+uint32_t update_hash_adler32(uint32_t hash, const char* data, size_t len) {
+    return hash_update(KvsHashAlgorithm::Adler32, hash, data, len);
+}
+
 uint32_t calculate_hash_adler32(const std::string& data) {
-    constexpr size_t ADLER32_NMAX = 5552;
-    constexpr uint32_t ADLER32_BASE = 65521;
-    uint32_t a = 1, b = 0;
-    size_t len = data.size();
-    size_t i = 0;
+    return update_hash_adler32(KVS_HASH_ADLER32_INIT, data.data(), data.size());
+}
 
-    // Process in blocks of 5552 bytes (as recommended for Adler-32)
-    while (len > 0) {
-        size_t tlen = len > ADLER32_NMAX ? ADLER32_NMAX : len;
-        len -= tlen;
-        for (size_t j = 0; j < tlen; ++j, ++i) {
-            a += static_cast<unsigned char>(data[i]);
-            b += a;
-        }
-        a %= ADLER32_BASE;
-        b %= ADLER32_BASE;
-    }
-    return (b << 16) | a;
+/* Checksum of data with the given algorithm */
+uint32_t calculate_hash(KvsHashAlgorithm algorithm, const std::string& data) {
+    return hash_update(algorithm, hash_init(algorithm), data.data(), data.size());
 }
 
 /*Parse Adler32 checksum Byte-Array to uint32 */
@@ -74,12 +67,49 @@ std::array<uint8_t,4> get_hash_bytes(const std::string& data)
     return value;
 }
 
-/* Wrapper Function to check, if Hash is valid*/
+/* Wrapper Function to get the content of a hash file (legacy format for Adler-32, tagged for other algorithms) */
+std::string get_hash_file_content(KvsHashAlgorithm algorithm, uint32_t hash)
+{
+    std::string content;
+    if (KvsHashAlgorithm::Adler32 != algorithm) {
+        content.push_back(static_cast<char>(algorithm));
+    }
+    const std::array<uint8_t, 4> hash_bytes = get_hash_bytes_adler32(hash); /* Same byte order for all algorithms */
+    content.append(reinterpret_cast<const char*>(hash_bytes.data()), hash_bytes.size());
+    return content;
+}
+
+/* Wrapper Function to parse a hash file, fails if the size or the tag is invalid */
+bool parse_hash_file(std::istream& in, KvsHashAlgorithm& algorithm, uint32_t& hash)
+{
+    bool result = false;
+    std::array<char, KVS_HASH_FILE_TAGGED_SIZE + 1> buf{};
+    in.read(buf.data(), buf.size());
+    const size_t size = static_cast<size_t>(in.gcount());
+    if (KVS_HASH_FILE_LEGACY_SIZE == size) {
+        algorithm = KvsHashAlgorithm::Adler32;
+        std::istringstream value(std::string(buf.data(), size));
+        hash = parse_hash_adler32(value);
+        result = true;
+    }else if ((KVS_HASH_FILE_TAGGED_SIZE == size)
+        && ((static_cast<uint8_t>(KvsHashAlgorithm::Adler32) == static_cast<uint8_t>(buf[0]))
+            || (static_cast<uint8_t>(KvsHashAlgorithm::Crc32c) == static_cast<uint8_t>(buf[0])))) {
+        algorithm = static_cast<KvsHashAlgorithm>(buf[0]);
+        std::istringstream value(std::string(buf.data() + 1, KVS_HASH_FILE_LEGACY_SIZE));
+        hash = parse_hash_adler32(value);
+        result = true;
+    }
+
+    return result;
+}
+
+/* Wrapper Function to check, if Hash is valid (with the algorithm of the hash file)*/
 bool check_hash(const std::string& data_calculate, std::istream& data_parse){
     bool result;
-    uint32_t calculated_hash = calculate_hash_adler32(data_calculate);
-    uint32_t parsed_hash = parse_hash_adler32(data_parse);
-    if(calculated_hash == parsed_hash){
+    KvsHashAlgorithm algorithm = KvsHashAlgorithm::Adler32;
+    uint32_t parsed_hash = 0;
+    if(parse_hash_file(data_parse, algorithm, parsed_hash)
+        && (calculate_hash(algorithm, data_calculate) == parsed_hash)){
         result = true;
     }else{
         result = false;
@@ -88,10 +118,70 @@ bool check_hash(const std::string& data_calculate, std::istream& data_parse){
     return result;
 }
 
+/*********************** File Read Functions *********************/
+
+/* Read the remaining stream into a buffer sized from the stream length, optionally updating a checksum per chunk */
+static bool read_stream_chunks(std::istream& in, std::string& data, const KvsHashAlgorithm* algorithm, uint32_t& hash)
+{
+    bool result = false;
+    if (in.good()) {
+        size_t size = 0;
+        const std::istream::pos_type start = in.tellg();
+        if ((start != std::istream::pos_type(-1)) && in.seekg(0, std::ios::end)) {
+            const std::istream::pos_type end = in.tellg();
+            if ((end != std::istream::pos_type(-1)) && (end > start)) {
+                size = static_cast<size_t>(end - start);
+            }
+            in.seekg(start);
+        }
+        in.clear(); /* Streams without seek support are read without size hint */
+
+        /* The size is only a hint, a file that changed in between is read completely as well */
+        data.resize(size);
+        size_t offset = 0;
+        bool done = false;
+        while (!done) {
+            if ((offset == data.size()) && (std::char_traits<char>::eof() == in.peek())) {
+                done = true;
+            }else{
+                if (offset == data.size()) {
+                    data.resize(offset + KVS_READ_CHUNK_SIZE); /* Longer than expected */
+                }
+                const size_t chunk = std::min(KVS_READ_CHUNK_SIZE, data.size() - offset);
+                in.read(&data[offset], static_cast<std::streamsize>(chunk));
+                const size_t count = static_cast<size_t>(in.gcount());
+                if (nullptr != algorithm) {
+                    hash = hash_update(*algorithm, hash, data.data() + offset, count);
+                }
+                offset += count;
+                done = (count < chunk);
+            }
+        }
+        data.resize(offset);
+        result = in.eof() && !in.bad();
+    }
+
+    return result;
+}
+
+/* Read a complete stream in one pre-sized buffer */
+bool read_stream(std::istream& in, std::string& data)
+{
+    uint32_t unused_hash = 0;
+    return read_stream_chunks(in, data, nullptr, unused_hash);
+}
+
+/* Read a complete stream in one pre-sized buffer and calculate its checksum in the same pass */
+bool read_stream_hashed(std::istream& in, KvsHashAlgorithm algorithm, std::string& data, uint32_t& hash)
+{
+    hash = hash_init(algorithm);
+    return read_stream_chunks(in, data, &algorithm, hash);
+}
+
 /*********************** Standalone Helper Functions *********************/
 
 /* Helper Function for Any -> KVSValue conversion */
-score::Result<KvsValue> any_to_kvsvalue(const score::json::Any& any){
+score::Result<KvsValue> any_to_kvsvalue(const score::json::Any& any, const KvsElementAllocator& alloc){
     score::Result<KvsValue> result = score::MakeUnexpected(ErrorCode::UnmappedError);
     if (auto o = any.As<score::json::Object>(); o.has_value()) {
         const auto& objAny = o.value().get();
@@ -171,13 +261,13 @@ score::Result<KvsValue> any_to_kvsvalue(const score::json::Any& any){
                         KvsValue::Array arr;
                         bool error = false;
                         for (auto const& elem : l.value().get()) {
-                            auto conv = any_to_kvsvalue(elem);
+                            auto conv = any_to_kvsvalue(elem, alloc);
                             if (!conv) {
                                 error = true;
                                 result = score::MakeUnexpected(ErrorCode::InvalidValueType);
                                 break;
                             }
-                            arr.emplace_back(std::make_shared<KvsValue>(std::move(conv.value())));
+                            arr.emplace_back(std::allocate_shared<KvsValue>(alloc, std::move(conv.value())));
                         }
                         if (!error){
                             result = KvsValue(std::move(arr));
@@ -191,13 +281,13 @@ score::Result<KvsValue> any_to_kvsvalue(const score::json::Any& any){
                         KvsValue::Object map;
                         bool error = false;
                         for (auto const& [key, valAny] : obj.value().get()) {
-                            auto conv = any_to_kvsvalue(valAny);
+                            auto conv = any_to_kvsvalue(valAny, alloc);
                             if (!conv) {
                                 error = true;
                                 result = score::MakeUnexpected(ErrorCode::InvalidValueType);
                                 break;
                             }
-                            map.emplace(key.GetAsStringView().to_string(), std::make_shared<KvsValue>(std::move(conv.value())));
+                            map.emplace(key.GetAsStringView().to_string(), std::allocate_shared<KvsValue>(alloc, std::move(conv.value())));
                         }
                         if (!error) {
                             result = KvsValue(std::move(map));
@@ -270,14 +360,20 @@ score::Result<score::json::Any> kvsvalue_to_any(const KvsValue& kv) {
         case KvsValue::Type::Array: {
             obj.emplace("t", score::json::Any(std::string("arr")));
             score::json::List list;
-            for (auto& elem : std::get<KvsValue::Array>(kv.getValue())) {
-                auto conv = kvsvalue_to_any(*elem);
-                if (!conv) {
-                    result = score::MakeUnexpected(ErrorCode::InvalidValueType);
-                    error = true;
-                    break;
+            const KvsValue::Array* array = kv.getIf<KvsValue::Array>();
+            if (nullptr == array) {
+                result = score::MakeUnexpected(ErrorCode::InvalidValueType);
+                error = true;
+            }else{
+                for (auto& elem : *array) {
+                    auto conv = kvsvalue_to_any(*elem);
+                    if (!conv) {
+                        result = score::MakeUnexpected(ErrorCode::InvalidValueType);
+                        error = true;
+                        break;
+                    }
+                    list.push_back(std::move(conv.value()));
                 }
-                list.push_back(std::move(conv.value()));
             }
             if (!error) {
                 obj.emplace("v", score::json::Any(std::move(list)));
@@ -287,14 +383,20 @@ score::Result<score::json::Any> kvsvalue_to_any(const KvsValue& kv) {
         case KvsValue::Type::Object: {
             obj.emplace("t", score::json::Any(std::string("obj")));
             score::json::Object inner_obj;
-            for (auto& [key, value] : std::get<KvsValue::Object>(kv.getValue())) {
-                auto conv = kvsvalue_to_any(*value);
-                if (!conv) {
-                    result = score::MakeUnexpected(ErrorCode::InvalidValueType);
-                    error = true;
-                    break;
+            const KvsValue::Object* object = kv.getIf<KvsValue::Object>();
+            if (nullptr == object) {
+                result = score::MakeUnexpected(ErrorCode::InvalidValueType);
+                error = true;
+            }else{
+                for (auto& [key, value] : *object) {
+                    auto conv = kvsvalue_to_any(*value);
+                    if (!conv) {
+                        result = score::MakeUnexpected(ErrorCode::InvalidValueType);
+                        error = true;
+                        break;
+                    }
+                    inner_obj.emplace(key, std::move(conv.value()));
                 }
-                inner_obj.emplace(key, std::move(conv.value()));
             }
             if (!error) {
                 obj.emplace("v", score::json::Any(std::move(inner_obj)));
@@ -16,6 +16,7 @@
 #include <sstream>
 #include <string>
 #include "error.hpp"
+#include "kvs_checksum.hpp"
 #include "kvsvalue.hpp"
 #include "score/json/json_parser.h" /* For JSON Any Type */
 
@@ -25,12 +26,29 @@
  */
 namespace score::mw::per::kvs {
 
+/* Initial value of a rolling Adler-32 checksum (update_hash_adler32 over all chunks equals calculate_hash_adler32) */
+constexpr uint32_t KVS_HASH_ADLER32_INIT = 1;
+
+/* Size of a hash file: legacy format (Adler-32, big-endian) and tagged format (algorithm tag + big-endian value) */
+constexpr size_t KVS_HASH_FILE_LEGACY_SIZE = 4;
+constexpr size_t KVS_HASH_FILE_TAGGED_SIZE = 5;
+
+/* Size of the chunks a file is read in (the checksum of a chunk is updated while it is still cached) */
+constexpr size_t KVS_READ_CHUNK_SIZE = 64 * 1024;
+
 uint32_t parse_hash_adler32(std::istream& in);
+uint32_t update_hash_adler32(uint32_t hash, const char* data, size_t len);
+uint32_t calculate_hash(KvsHashAlgorithm algorithm, const std::string& data);
 uint32_t calculate_hash_adler32(const std::string& data);
 std::array<uint8_t,4> get_hash_bytes_adler32(uint32_t hash);
 std::array<uint8_t,4> get_hash_bytes(const std::string& data);
+std::string get_hash_file_content(KvsHashAlgorithm algorithm, uint32_t hash);
+bool parse_hash_file(std::istream& in, KvsHashAlgorithm& algorithm, uint32_t& hash);
 bool check_hash(const std::string& data_calculate, std::istream& data_parse);
-score::Result<KvsValue> any_to_kvsvalue(const score::json::Any& any);
+bool read_stream(std::istream& in, std::string& data);
+bool read_stream_hashed(std::istream& in, KvsHashAlgorithm algorithm, std::string& data, uint32_t& hash);
+/* Shared elements of Arrays and Objects are allocated with alloc (from the heap by default) */
+score::Result<KvsValue> any_to_kvsvalue(const score::json::Any& any, const KvsElementAllocator& alloc = KvsElementAllocator());
 score::Result<score::json::Any> kvsvalue_to_any(const KvsValue& kv);
 
 } /* namespace score::mw::per::kvs */
@@ -0,0 +1,259 @@
+/********************************************************************************
+* Copyright (c) 2025 Contributors to the Eclipse Foundation
+*
+* See the NOTICE file(s) distributed with this work for additional
+* information regarding copyright ownership.
+*
+* This program and the accompanying materials are made available under the
+* terms of the Apache License Version 2.0 which is available at
+* https://www.apache.org/licenses/LICENSE-2.0
+*
+* SPDX-License-Identifier: Apache-2.0
+********************************************************************************/
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstdio>
+#include "kvs_helper.hpp"
+#include "kvs_json_stream.hpp"
+
+namespace score::mw::per::kvs {
+
+namespace {
+
+/* Indentation of one nesting level */
+constexpr size_t KVS_JSON_INDENT = 4;
+
+void put_indent(KvsStreamSink& sink, size_t indent) {
+    static const std::string spaces(16 * KVS_JSON_INDENT, ' ');
+    while (indent > 0) {
+        const size_t len = (indent > spaces.size()) ? spaces.size() : indent;
+        sink.append(std::string_view(spaces.data(), len));
+        indent -= len;
+    }
+}
+
+/* JSON string with escaped quotes, backslashes and control characters */
+void put_string(KvsStreamSink& sink, std::string_view value) {
+    sink.append("\"");
+    size_t start = 0;
+    for (size_t i = 0; i < value.size(); ++i) {
+        const unsigned char c = static_cast<unsigned char>(value[i]);
+        if ((c >= 0x20) && (c != '"') && (c != '\\')) {
+            continue;
+        }
+        sink.append(value.substr(start, i - start));
+        switch (c) {
+            case '"': sink.append("\\\""); break;
+            case '\\': sink.append("\\\\"); break;
+            case '\b': sink.append("\\b"); break;
+            case '\f': sink.append("\\f"); break;
+            case '\n': sink.append("\\n"); break;
+            case '\r': sink.append("\\r"); break;
+            case '\t': sink.append("\\t"); break;
+            default: {
+                char escaped[8];
+                (void)std::snprintf(escaped, sizeof(escaped), "\\u%04x", static_cast<unsigned int>(c));
+                sink.append(escaped);
+                break;
+            }
+        }
+        start = i + 1;
+    }
+    sink.append(value.substr(start));
+    sink.append("\"");
+}
+
+/* Shortest representation that is read back as the same double (JSON has no NaN/Infinity).
+   std::to_chars ignores the locale, the decimal point is '.' with every LC_NUMERIC. */
+bool put_double(KvsStreamSink& sink, double value) {
+    bool result = false;
+    if (std::isfinite(value)) {
+        char buf[32];
+        const std::to_chars_result res = std::to_chars(buf, buf + sizeof(buf), value);
+        if (std::errc() == res.ec) {
+            sink.append(std::string_view(buf, static_cast<size_t>(res.ptr - buf)));
+            result = true;
+        }
+    }
+
+    return result;
+}
+
+/* Typed value {"t": "<type>", "v": <value>}, indent is the indentation of the braces */
+struct ValueStreamer {
+    KvsStreamSink& sink;
+    size_t indent;
+
+    score::ResultBlank operator()(const KvsValue& value) const {
+        score::ResultBlank result = score::ResultBlank{};
+        const char* type = nullptr;
+        switch (value.getType()) {
+            case KvsValue::Type::i32: type = "i32"; break;
+            case KvsValue::Type::u32: type = "u32"; break;
+            case KvsValue::Type::i64: type = "i64"; break;
+            case KvsValue::Type::u64: type = "u64"; break;
+            case KvsValue::Type::f64: type = "f64"; break;
+            case KvsValue::Type::Boolean: type = "bool"; break;
+            case KvsValue::Type::String: type = "str"; break;
+            case KvsValue::Type::Null: type = "null"; break;
+            case KvsValue::Type::Array: type = (nullptr != value.getIf<KvsValue::Array>()) ? "arr" : nullptr; break;
+            case KvsValue::Type::Object: type = (nullptr != value.getIf<KvsValue::Object>()) ? "obj" : nullptr; break;
+            default: break;
+        }
+
+        if (nullptr == type) {
+            /* Unknown type or a nullptr container */
+            result = score::MakeUnexpected(ErrorCode::InvalidValueType);
+        }else{
+            sink.append("{\n");
+            put_indent(sink, indent + KVS_JSON_INDENT);
+            sink.append("\"t\": \"");
+            sink.append(type);
+            sink.append("\",\n");
+            put_indent(sink, indent + KVS_JSON_INDENT);
+            sink.append("\"v\": ");
+            result = put_payload(value);
+            sink.append("\n");
+            put_indent(sink, indent);
+            sink.append("}");
+        }
+
+        return result;
+    }
+
+    score::ResultBlank put_payload(const KvsValue& value) const {
+        score::ResultBlank result = score::ResultBlank{};
+        const auto& data = value.getValue();
+        switch (value.getType()) {
+            case KvsValue::Type::i32: sink.append(std::to_string(std::get<int32_t>(data))); break;
+            case KvsValue::Type::u32: sink.append(std::to_string(std::get<uint32_t>(data))); break;
+            case KvsValue::Type::i64: sink.append(std::to_string(std::get<int64_t>(data))); break;
+            case KvsValue::Type::u64: sink.append(std::to_string(std::get<uint64_t>(data))); break;
+            case KvsValue::Type::f64: {
+                if (!put_double(sink, std::get<double>(data))) {
+                    result = score::MakeUnexpected(ErrorCode::JsonGeneratorError);
+                }
+                break;
+            }
+            case KvsValue::Type::Boolean: sink.append(std::get<bool>(data) ? "true" : "false"); break;
+            case KvsValue::Type::String: put_string(sink, std::get<std::string>(data)); break;
+            case KvsValue::Type::Null: sink.append("null"); break;
+            case KvsValue::Type::Array: {
+                const auto& array = *std::get<KvsValue::SharedArray>(data);
+                sink.append(array.empty() ? "[" : "[\n");
+                const ValueStreamer element{sink, indent + (2 * KVS_JSON_INDENT)};
+                for (size_t i = 0; (i < array.size()) && result; ++i) {
+                    put_indent(sink, element.indent);
+                    result = element(*array[i]);
+                    sink.append(((i + 1) < array.size()) ? ",\n" : "\n");
+                }
+                if (!array.empty()) {
+                    put_indent(sink, indent + KVS_JSON_INDENT);
+                }
+                sink.append("]");
+                break;
+            }
+            case KvsValue::Type::Object: {
+                const auto& object = *std::get<KvsValue::SharedObject>(data);
+                sink.append(object.empty() ? "{" : "{\n");
+                const ValueStreamer member{sink, indent + (2 * KVS_JSON_INDENT)};
+                size_t remaining = object.size();
+                for (auto it = object.begin(); (it != object.end()) && result; ++it) {
+                    put_indent(sink, member.indent);
+                    put_string(sink, it->first);
+                    sink.append(": ");
+                    result = member(*it->second);
+                    sink.append((--remaining > 0) ? ",\n" : "\n");
+                }
+                if (!object.empty()) {
+                    put_indent(sink, indent + KVS_JSON_INDENT);
+                }
+                sink.append("}");
+                break;
+            }
+            default: {
+                result = score::MakeUnexpected(ErrorCode::InvalidValueType);
+                break;
+            }
+        }
+
+        return result;
+    }
+};
+
+} /* namespace */
+
+KvsStreamSink::KvsStreamSink(std::ostream& out, size_t chunk_size, KvsHashAlgorithm algorithm)
+    : out(out)
+    , chunk_size(chunk_size)
+    , algorithm(algorithm)
+    , checksum(hash_init(algorithm))
+    , total(0)
+    , failed(false)
+{
+    chunk.reserve(chunk_size);
+}
+
+/* Append bytes, full chunks are written to the stream */
+void KvsStreamSink::append(std::string_view data) {
+    total += data.size();
+    while (!data.empty()) {
+        const size_t len = std::min(chunk_size - chunk.size(), data.size());
+        chunk.append(data.data(), len);
+        data.remove_prefix(len);
+        if (chunk.size() >= chunk_size) {
+            drain();
+        }
+    }
+}
+
+/* Write the remaining bytes */
+bool KvsStreamSink::finish() {
+    drain();
+    if (!out.flush()) {
+        failed = true;
+    }
+
+    return !failed;
+}
+
+uint32_t KvsStreamSink::hash() const {
+    return checksum;
+}
+
+size_t KvsStreamSink::size() const {
+    return total;
+}
+
+void KvsStreamSink::drain() {
+    checksum = hash_update(algorithm, checksum, chunk.data(), chunk.size());
+    if ((!failed) && (!out.write(chunk.data(), chunk.size()))) {
+        failed = true;
+    }
+    chunk.clear();
+}
+
+/* Write one typed value, indent is the indentation of the line the value starts in */
+score::ResultBlank json_stream_value(const KvsValue& value, KvsStreamSink& sink, size_t indent) {
+    return ValueStreamer{sink, indent}(value);
+}
+
+/* Write the KVS data as typed JSON object */
+score::ResultBlank json_stream_map(const KvsMap& map, KvsStreamSink& sink) {
+    score::ResultBlank result = score::ResultBlank{};
+    sink.append(map.empty() ? "{" : "{\n");
+    size_t remaining = map.size();
+    for (auto it = map.begin(); (it != map.end()) && result; ++it) {
+        put_indent(sink, KVS_JSON_INDENT);
+        put_string(sink, it->first);
+        sink.append(": ");
+        result = json_stream_value(it->second, sink, KVS_JSON_INDENT);
+        sink.append((--remaining > 0) ? ",\n" : "\n");
+    }
+    sink.append("}");
+
+    return result;
+}
+
+} /* namespace score::mw::per::kvs */
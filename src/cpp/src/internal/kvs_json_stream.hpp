@@ -0,0 +1,75 @@
+/********************************************************************************
+* Copyright (c) 2025 Contributors to the Eclipse Foundation
+*
+* See the NOTICE file(s) distributed with this work for additional
+* information regarding copyright ownership.
+*
+* This program and the accompanying materials are made available under the
+* terms of the Apache License Version 2.0 which is available at
+* https://www.apache.org/licenses/LICENSE-2.0
+*
+* SPDX-License-Identifier: Apache-2.0
+********************************************************************************/
+#ifndef SCORE_LIB_KVS_INTERNAL_KVS_JSON_STREAM_HPP
+#define SCORE_LIB_KVS_INTERNAL_KVS_JSON_STREAM_HPP
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include "error.hpp"
+#include "kvs_checksum.hpp"
+#include "kvsvalue.hpp"
+
+/*
+ * This header defines the streaming serialization of the KVS data into the typed JSON format
+ * ({"key": {"t": "<type>", "v": <value>}, ...}), written without an intermediate JSON tree.
+ * Kvs::write_data uses it for KvsStorageFormat::Json, so a flush doesn't build a score::json tree of
+ * the whole store. The output is parsed by the score::json parser on open.
+ */
+namespace score::mw::per::kvs {
+
+/* Size of the chunks written to the output stream */
+constexpr size_t KVS_STREAM_CHUNK_SIZE = 64 * 1024;
+
+/**
+ * @class KvsStreamSink
+ * @brief Buffered output that writes chunks to a stream and keeps a rolling checksum.
+ *
+ * The checksum and size cover all appended bytes, so they equal calculate_hash and size
+ * of the complete output without keeping it in memory.
+ *
+ * Public Methods:
+ * - `append`: Appends bytes (written to the stream once a chunk is full).
+ * - `finish`: Writes the remaining bytes, returns false if any write failed.
+ * - `hash`: Retrieves the checksum of all appended bytes (complete after finish).
+ * - `size`: Retrieves the number of appended bytes.
+ */
+class KvsStreamSink final {
+public:
+    explicit KvsStreamSink(std::ostream& out, size_t chunk_size = KVS_STREAM_CHUNK_SIZE,
+                           KvsHashAlgorithm algorithm = KvsHashAlgorithm::Adler32);
+
+    void append(std::string_view data);
+    bool finish();
+    uint32_t hash() const;
+    size_t size() const;
+
+private:
+    void drain();
+
+    std::ostream& out;
+    size_t chunk_size;
+    KvsHashAlgorithm algorithm;
+    std::string chunk;  /* Bytes not written yet */
+    uint32_t checksum;  /* Rolling checksum of the written bytes */
+    size_t total;       /* Number of appended bytes */
+    bool failed;        /* A write to the stream failed */
+};
+
+score::ResultBlank json_stream_value(const KvsValue& value, KvsStreamSink& sink, size_t indent);
+score::ResultBlank json_stream_map(const KvsMap& map, KvsStreamSink& sink);
+
+} /* namespace score::mw::per::kvs */
+
+#endif // SCORE_LIB_KVS_INTERNAL_KVS_JSON_STREAM_HPP
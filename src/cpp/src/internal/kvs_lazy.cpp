@@ -0,0 +1,250 @@
+/********************************************************************************
+* Copyright (c) 2025 Contributors to the Eclipse Foundation
+*
+* See the NOTICE file(s) distributed with this work for additional
+* information regarding copyright ownership.
+*
+* This program and the accompanying materials are made available under the
+* terms of the Apache License Version 2.0 which is available at
+* https://www.apache.org/licenses/LICENSE-2.0
+*
+* SPDX-License-Identifier: Apache-2.0
+********************************************************************************/
+#include "kvs_lazy.hpp"
+
+namespace score::mw::per::kvs {
+
+namespace {
+
+/* Characters that end a number or a literal */
+constexpr std::string_view JSON_DELIMITERS = ",}] \t\n\r";
+
+void skip_space(std::string_view data, size_t& offset) {
+    while ((offset < data.size())
+           && ((' ' == data[offset]) || ('\t' == data[offset]) || ('\n' == data[offset]) || ('\r' == data[offset]))) {
+        ++offset;
+    }
+}
+
+/* Read the 4 hex digits of a \u escape and advance offset */
+bool get_hex4(std::string_view data, size_t& offset, uint32_t& value) {
+    bool result = (data.size() - offset >= 4);
+    value = 0;
+    for (size_t i = 0; result && (i < 4); ++i) {
+        const char c = data[offset + i];
+        value <<= 4;
+        if ((c >= '0') && (c <= '9')) {
+            value |= static_cast<uint32_t>(c - '0');
+        }else if ((c >= 'a') && (c <= 'f')) {
+            value |= static_cast<uint32_t>(c - 'a' + 10);
+        }else if ((c >= 'A') && (c <= 'F')) {
+            value |= static_cast<uint32_t>(c - 'A' + 10);
+        }else{
+            result = false;
+        }
+    }
+    if (result) {
+        offset += 4;
+    }
+
+    return result;
+}
+
+void put_utf8(std::string& out, uint32_t code_point) {
+    if (code_point < 0x80) {
+        out.push_back(static_cast<char>(code_point));
+    }else if (code_point < 0x800) {
+        out.push_back(static_cast<char>(0xC0 | (code_point >> 6)));
+        out.push_back(static_cast<char>(0x80 | (code_point & 0x3F)));
+    }else if (code_point < 0x10000) {
+        out.push_back(static_cast<char>(0xE0 | (code_point >> 12)));
+        out.push_back(static_cast<char>(0x80 | ((code_point >> 6) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | (code_point & 0x3F)));
+    }else{
+        out.push_back(static_cast<char>(0xF0 | (code_point >> 18)));
+        out.push_back(static_cast<char>(0x80 | ((code_point >> 12) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | ((code_point >> 6) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | (code_point & 0x3F)));
+    }
+}
+
+/* Decode the escape sequence behind a backslash (offset points behind the backslash) */
+bool unescape(std::string_view data, size_t& offset, std::string& out) {
+    bool result = true;
+    const char c = data[offset++];
+    switch (c) {
+        case '"':
+        case '\\':
+        case '/': out.push_back(c); break;
+        case 'b': out.push_back('\b'); break;
+        case 'f': out.push_back('\f'); break;
+        case 'n': out.push_back('\n'); break;
+        case 'r': out.push_back('\r'); break;
+        case 't': out.push_back('\t'); break;
+        case 'u': {
+            uint32_t code_point = 0;
+            uint32_t low = 0;
+            if (!get_hex4(data, offset, code_point)) {
+                result = false;
+            }else if ((code_point >= 0xD800) && (code_point <= 0xDBFF)) {
+                /* High surrogate, the low surrogate has to follow as second escape */
+                if ((data.size() - offset >= 2) && ('\\' == data[offset]) && ('u' == data[offset + 1])) {
+                    offset += 2;
+                    result = get_hex4(data, offset, low) && (low >= 0xDC00) && (low <= 0xDFFF);
+                }else{
+                    result = false;
+                }
+                code_point = 0x10000 + ((code_point - 0xD800) << 10) + (low - 0xDC00);
+            }else if ((code_point >= 0xDC00) && (code_point <= 0xDFFF)) {
+                result = false;
+            }
+            if (result) {
+                put_utf8(out, code_point);
+            }
+            break;
+        }
+        default: {
+            result = false;
+            break;
+        }
+    }
+
+    return result;
+}
+
+/* Scan a JSON string starting at its opening quote, offset is advanced behind the closing quote.
+   The unescaped string is stored in value, nullptr only checks the extent of the string. */
+bool scan_string(std::string_view data, size_t& offset, std::string* value) {
+    bool done = false;
+    bool error = ((offset >= data.size()) || ('"' != data[offset]));
+    if (!error) {
+        ++offset;
+    }
+    while ((!error) && (!done)) {
+        if (offset >= data.size()) {
+            error = true;
+        }else{
+            const char c = data[offset++];
+            if ('"' == c) {
+                done = true;
+            }else if (static_cast<uint8_t>(c) < 0x20) {
+                error = true; /* Control characters have to be escaped */
+            }else if ('\\' != c) {
+                if (nullptr != value) {
+                    value->push_back(c);
+                }
+            }else if (offset >= data.size()) {
+                error = true;
+            }else if (nullptr != value) {
+                error = !unescape(data, offset, *value);
+            }else{
+                ++offset; /* An escaped quote doesn't end the string */
+            }
+        }
+    }
+
+    return done && (!error);
+}
+
+/* Scan a JSON value and advance offset behind it. Only the extent is determined (strings, nesting of
+   Objects and Arrays), the value itself is checked by the parser once it is accessed. */
+bool scan_value(std::string_view data, size_t& offset) {
+    bool result = false;
+    if (offset >= data.size()) {
+        result = false;
+    }else if ('"' == data[offset]) {
+        result = scan_string(data, offset, nullptr);
+    }else if (('{' == data[offset]) || ('[' == data[offset])) {
+        std::string closers; /* Expected closing brackets of the open Objects and Arrays */
+        result = true;
+        do {
+            const char c = data[offset];
+            if ('"' == c) {
+                result = scan_string(data, offset, nullptr);
+            }else{
+                if ('{' == c) {
+                    closers.push_back('}');
+                }else if ('[' == c) {
+                    closers.push_back(']');
+                }else if (('}' == c) || (']' == c)) {
+                    result = (closers.back() == c);
+                    closers.pop_back();
+                }
+                ++offset;
+            }
+        } while (result && (!closers.empty()) && (offset < data.size()));
+        result = result && closers.empty();
+    }else{
+        const size_t start = offset;
+        while ((offset < data.size()) && (std::string_view::npos == JSON_DELIMITERS.find(data[offset]))) {
+            ++offset;
+        }
+        result = (offset > start);
+    }
+
+    return result;
+}
+
+/* Scan a member of the top-level object ("key": value) and add it to the index */
+bool scan_entry(std::string_view data, size_t& offset, KvsLazyMap& map) {
+    bool result = false;
+    std::string key;
+    if (scan_string(data, offset, &key)) {
+        skip_space(data, offset);
+        if ((offset < data.size()) && (':' == data[offset])) {
+            ++offset;
+            skip_space(data, offset);
+            const size_t start = offset;
+            if (scan_value(data, offset)) {
+                (void)map.emplace(std::move(key), KvsLazyValue{data.substr(start, offset - start), std::nullopt});
+                result = true;
+            }
+        }
+    }
+
+    return result;
+}
+
+} /* namespace */
+
+/* Index the top-level object of a JSON KVS file (key -> text of the value) */
+score::Result<KvsLazyMap> json_index_map(std::string_view data) {
+    score::Result<KvsLazyMap> result = score::MakeUnexpected(ErrorCode::JsonParserError);
+    KvsLazyMap map;
+    size_t offset = 0;
+    bool valid = false;
+
+    skip_space(data, offset);
+    if ((offset < data.size()) && ('{' == data[offset])) {
+        ++offset;
+        skip_space(data, offset);
+        if ((offset < data.size()) && ('}' == data[offset])) {
+            ++offset;
+            valid = true;
+        }else{
+            bool next = true;
+            while (next) {
+                next = false;
+                if (scan_entry(data, offset, map)) {
+                    skip_space(data, offset);
+                    if ((offset < data.size()) && (',' == data[offset])) {
+                        ++offset;
+                        skip_space(data, offset);
+                        next = true;
+                    }else if ((offset < data.size()) && ('}' == data[offset])) {
+                        ++offset;
+                        valid = true;
+                    }
+                }
+            }
+        }
+    }
+    skip_space(data, offset);
+    if (valid && (offset == data.size())) {
+        result = std::move(map);
+    }
+
+    return result;
+}
+
+} /* namespace score::mw::per::kvs */
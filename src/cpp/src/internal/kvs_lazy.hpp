@@ -0,0 +1,46 @@
+/********************************************************************************
+* Copyright (c) 2025 Contributors to the Eclipse Foundation
+*
+* See the NOTICE file(s) distributed with this work for additional
+* information regarding copyright ownership.
+*
+* This program and the accompanying materials are made available under the
+* terms of the Apache License Version 2.0 which is available at
+* https://www.apache.org/licenses/LICENSE-2.0
+*
+* SPDX-License-Identifier: Apache-2.0
+********************************************************************************/
+#ifndef SCORE_LIB_KVS_INTERNAL_KVS_LAZY_HPP
+#define SCORE_LIB_KVS_INTERNAL_KVS_LAZY_HPP
+
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <string>
+#include <string_view>
+#include "error.hpp"
+#include "kvsvalue.hpp"
+
+/*
+ * This header defines the index of a lazily opened KVS file (KvsOptions::lazy_values).
+ * KvsLazyMap is a member of Kvs, so this header is included by kvs.hpp.
+ *
+ * Open only determines the keys and the byte range of every top-level value, the values are decoded
+ * by the first access. The ranges point into the file data, which is kept as long as the index is used.
+ * The index of a binary file is built by binary_index_map (see internal/kvs_binary.hpp).
+ */
+namespace score::mw::per::kvs {
+
+/* Encoded top-level value of a lazily opened KVS file */
+struct KvsLazyValue {
+    std::string_view data;         /* Encoded value (JSON text or binary record) */
+    std::optional<KvsValue> value; /* Decoded value, set by the first access */
+};
+
+using KvsLazyMap = std::map<std::string, KvsLazyValue, std::less<>>;
+
+score::Result<KvsLazyMap> json_index_map(std::string_view data);
+
+} /* namespace score::mw::per::kvs */
+
+#endif // SCORE_LIB_KVS_INTERNAL_KVS_LAZY_HPP
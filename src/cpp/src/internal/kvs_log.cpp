@@ -0,0 +1,162 @@
+/********************************************************************************
+* Copyright (c) 2025 Contributors to the Eclipse Foundation
+*
+* See the NOTICE file(s) distributed with this work for additional
+* information regarding copyright ownership.
+*
+* This program and the accompanying materials are made available under the
+* terms of the Apache License Version 2.0 which is available at
+* https://www.apache.org/licenses/LICENSE-2.0
+*
+* SPDX-License-Identifier: Apache-2.0
+********************************************************************************/
+#include <cstring>
+#include <limits>
+#include "kvs_binary.hpp"
+#include "kvs_helper.hpp"
+#include "kvs_log.hpp"
+
+namespace score::mw::per::kvs {
+
+namespace {
+
+/* Magic bytes at the beginning of every log */
+constexpr char KVS_LOG_MAGIC[4] = {'K', 'V', 'S', 'L'};
+
+/* Append a record (length, payload, checksum) */
+score::ResultBlank append_record(std::string& out, const std::string& payload) {
+    score::ResultBlank result = score::MakeUnexpected(ErrorCode::UnmappedError);
+    if (payload.size() > std::numeric_limits<uint32_t>::max()) {
+        result = score::MakeUnexpected(ErrorCode::SerializationFailed);
+    }else{
+        binary_put_u32(out, static_cast<uint32_t>(payload.size()));
+        out.append(payload);
+        binary_put_u32(out, calculate_hash_adler32(payload));
+        result = score::ResultBlank{};
+    }
+
+    return result;
+}
+
+/* Decode the payload of one record (no value for LogOp::Remove), returns false if the payload is invalid */
+bool decode_record(std::string_view payload, std::string& key, std::optional<KvsValue>& value) {
+    bool result = false;
+    size_t offset = 1;
+    if ((!payload.empty()) && binary_get_string(payload, offset, key)) {
+        if (static_cast<uint8_t>(LogOp::Set) == static_cast<uint8_t>(payload[0])) {
+            auto decoded = binary_decode_value(payload, offset);
+            if (decoded && (offset == payload.size())) {
+                value = std::move(decoded.value());
+                result = true;
+            }
+        }else if ((static_cast<uint8_t>(LogOp::Remove) == static_cast<uint8_t>(payload[0])) && (offset == payload.size())) {
+            value.reset();
+            result = true;
+        }
+    }
+
+    return result;
+}
+
+/* Replay the records of a log, apply is called with the key and value of every valid record */
+template <typename Apply>
+score::Result<size_t> replay_records(std::string_view data, uint32_t base_hash, Apply apply) {
+    score::Result<size_t> result = score::MakeUnexpected(ErrorCode::UnmappedError);
+    size_t offset = 8;
+    uint32_t hash = 0;
+
+    if ((data.size() < KVS_LOG_HEADER_SIZE)
+        || (0 != std::memcmp(data.data(), KVS_LOG_MAGIC, sizeof(KVS_LOG_MAGIC)))
+        || (static_cast<char>(KVS_LOG_VERSION & 0xFF) != data[4])
+        || (static_cast<char>((KVS_LOG_VERSION >> 8) & 0xFF) != data[5])) {
+        result = score::MakeUnexpected(ErrorCode::SerializationFailed);
+    }else if ((!binary_get_u32(data, offset, hash)) || (hash != base_hash)) {
+        result = score::MakeUnexpected(ErrorCode::ValidationFailed); /* Log of another KVS file */
+    }else{
+        size_t valid = offset;
+        while (valid < data.size()) {
+            uint32_t len = 0;
+            uint32_t checksum = 0;
+            offset = valid;
+            if ((!binary_get_u32(data, offset, len)) || (data.size() - offset < static_cast<size_t>(len) + 4)) {
+                break; /* Torn record */
+            }
+            const std::string payload(data.data() + offset, len);
+            offset += len;
+            (void)binary_get_u32(data, offset, checksum);
+            std::string key;
+            std::optional<KvsValue> value;
+            if ((checksum != calculate_hash_adler32(payload)) || (!decode_record(payload, key, value))) {
+                break; /* Corrupted record */
+            }
+            apply(std::move(key), std::move(value));
+            valid = offset;
+        }
+        result = valid;
+    }
+
+    return result;
+}
+
+} /* namespace */
+
+/* Header of a new log for the KVS file with the given hash */
+std::string log_encode_header(uint32_t base_hash) {
+    std::string out(KVS_LOG_MAGIC, sizeof(KVS_LOG_MAGIC));
+    out.push_back(static_cast<char>(KVS_LOG_VERSION & 0xFF));
+    out.push_back(static_cast<char>((KVS_LOG_VERSION >> 8) & 0xFF));
+    out.append(2, '\0'); /* Reserved */
+    binary_put_u32(out, base_hash);
+    return out;
+}
+
+/* Append a record which sets key to value */
+score::ResultBlank log_encode_set(std::string& out, const std::string_view key, const KvsValue& value) {
+    score::ResultBlank result = score::MakeUnexpected(ErrorCode::UnmappedError);
+    std::string payload(1, static_cast<char>(LogOp::Set));
+    if (!binary_put_string(payload, key)) {
+        result = score::MakeUnexpected(ErrorCode::SerializationFailed);
+    }else{
+        auto enc = binary_encode_value(value, payload);
+        if (!enc) {
+            result = score::MakeUnexpected(static_cast<ErrorCode>(*enc.error()));
+        }else{
+            result = append_record(out, payload);
+        }
+    }
+
+    return result;
+}
+
+/* Append a record which removes key */
+score::ResultBlank log_encode_remove(std::string& out, const std::string_view key) {
+    score::ResultBlank result = score::MakeUnexpected(ErrorCode::UnmappedError);
+    std::string payload(1, static_cast<char>(LogOp::Remove));
+    if (!binary_put_string(payload, key)) {
+        result = score::MakeUnexpected(ErrorCode::SerializationFailed);
+    }else{
+        result = append_record(out, payload);
+    }
+
+    return result;
+}
+
+/* Replay the records of a log on map, returns the size of the valid part of the log */
+score::Result<size_t> log_replay(std::string_view data, uint32_t base_hash, KvsMap& map) {
+    return replay_records(data, base_hash, [&map](std::string&& key, std::optional<KvsValue>&& value) {
+        if (value.has_value()) {
+            map.insert_or_assign(std::move(key), std::move(value.value()));
+        }else{
+            (void)map.erase(key);
+        }
+    });
+}
+
+/* Collect the changes of the records of a log by key, returns the size of the valid part of the log */
+score::Result<size_t> log_replay_changes(std::string_view data, uint32_t base_hash, KvsChanges& changes) {
+    return replay_records(data, base_hash, [&changes](std::string&& key, std::optional<KvsValue>&& value) {
+        changes.insert_or_assign(std::move(key), std::move(value));
+    });
+}
+
+} /* namespace score::mw::per::kvs */
@@ -0,0 +1,66 @@
+/********************************************************************************
+* Copyright (c) 2025 Contributors to the Eclipse Foundation
+*
+* See the NOTICE file(s) distributed with this work for additional
+* information regarding copyright ownership.
+*
+* This program and the accompanying materials are made available under the
+* terms of the Apache License Version 2.0 which is available at
+* https://www.apache.org/licenses/LICENSE-2.0
+*
+* SPDX-License-Identifier: Apache-2.0
+********************************************************************************/
+#ifndef SCORE_LIB_KVS_INTERNAL_KVS_LOG_HPP
+#define SCORE_LIB_KVS_INTERNAL_KVS_LOG_HPP
+
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <string>
+#include <string_view>
+#include "error.hpp"
+#include "kvsvalue.hpp"
+
+/*
+ * This header defines the write-ahead log of the incremental flush (kvs_<id>_0.log).
+ * Kvs::flush with KvsFlushMode::Incremental appends the records of the changes since the last flush,
+ * open replays them onto the snapshot whose hash is stored in the log header.
+ *
+ * Layout (all integers little-endian):
+ *   Header: magic "KVSL" | version (u16) | reserved (u16, 0) | base hash (u32)
+ *   Record: payload length (u32) | payload | adler32 of payload (u32)
+ *   Payload: op (u8) | key length (u32) | key bytes | value (only for LogOp::Set, see internal/kvs_binary.hpp)
+ *
+ * The base hash is the hash of the KVS file (kvs_<id>_0.json/.bin) the log applies to, so a log
+ * that belongs to an older file is never replayed. Records are appended, a torn record at the end
+ * (e.g. after a power loss) ends the replay.
+ */
+namespace score::mw::per::kvs {
+
+/* Current version of the log format */
+constexpr uint16_t KVS_LOG_VERSION = 1;
+
+/* Size of the log header */
+constexpr size_t KVS_LOG_HEADER_SIZE = 12;
+
+/* Size up to which the log may grow before it is compacted, even if it gets larger than the KVS file */
+constexpr size_t KVS_LOG_MIN_COMPACTION_SIZE = 4096;
+
+/* Operations of the log records */
+enum class LogOp : uint8_t {
+    Set = 1,
+    Remove = 2
+};
+
+/* Changes of a log by key, the last record of a key wins (std::nullopt for a removed key) */
+using KvsChanges = std::map<std::string, std::optional<KvsValue>, std::less<>>;
+
+std::string log_encode_header(uint32_t base_hash);
+score::ResultBlank log_encode_set(std::string& out, const std::string_view key, const KvsValue& value);
+score::ResultBlank log_encode_remove(std::string& out, const std::string_view key);
+score::Result<size_t> log_replay(std::string_view data, uint32_t base_hash, KvsMap& map);
+score::Result<size_t> log_replay_changes(std::string_view data, uint32_t base_hash, KvsChanges& changes);
+
+} /* namespace score::mw::per::kvs */
+
+#endif // SCORE_LIB_KVS_INTERNAL_KVS_LOG_HPP
@@ -0,0 +1,99 @@
+/********************************************************************************
+* Copyright (c) 2025 Contributors to the Eclipse Foundation
+*
+* See the NOTICE file(s) distributed with this work for additional
+* information regarding copyright ownership.
+*
+* This program and the accompanying materials are made available under the
+* terms of the Apache License Version 2.0 which is available at
+* https://www.apache.org/licenses/LICENSE-2.0
+*
+* SPDX-License-Identifier: Apache-2.0
+********************************************************************************/
+#include <cstddef>
+#include <cstring>
+#include "kvs_binary.hpp"
+#include "kvs_helper.hpp"
+#include "kvs_manifest.hpp"
+
+namespace score::mw::per::kvs {
+
+namespace {
+
+/* Magic bytes at the beginning of every manifest */
+constexpr char KVS_MANIFEST_MAGIC[4] = {'K', 'V', 'S', 'M'};
+
+/* Size of magic, version and reserved bytes */
+constexpr size_t KVS_MANIFEST_PREAMBLE_SIZE = 8;
+
+} /* namespace */
+
+/* Encode the manifest including its checksum */
+std::string manifest_encode(const KvsManifest& manifest) {
+    std::string out(KVS_MANIFEST_MAGIC, sizeof(KVS_MANIFEST_MAGIC));
+    out.push_back(static_cast<char>(KVS_MANIFEST_VERSION & 0xFF));
+    out.push_back(static_cast<char>((KVS_MANIFEST_VERSION >> 8) & 0xFF));
+    out.append(2, '\0'); /* Reserved */
+    binary_put_u32(out, manifest.next_generation);
+    binary_put_u32(out, static_cast<uint32_t>(manifest.entries.size()));
+    for (const uint32_t entry : manifest.entries) {
+        binary_put_u32(out, entry);
+    }
+    binary_put_u32(out, calculate_hash_adler32(out));
+    return out;
+}
+
+/* Decode a manifest, fails on a wrong magic, version, size or checksum */
+bool manifest_decode(std::string_view data, KvsManifest& manifest) {
+    bool result = false;
+    size_t offset = KVS_MANIFEST_PREAMBLE_SIZE;
+    uint32_t next_generation = 0;
+    uint32_t count = 0;
+    if ((data.size() >= KVS_MANIFEST_PREAMBLE_SIZE)
+        && (0 == std::memcmp(data.data(), KVS_MANIFEST_MAGIC, sizeof(KVS_MANIFEST_MAGIC)))
+        && (static_cast<uint8_t>(data[4]) == (KVS_MANIFEST_VERSION & 0xFF))
+        && (static_cast<uint8_t>(data[5]) == ((KVS_MANIFEST_VERSION >> 8) & 0xFF))
+        && binary_get_u32(data, offset, next_generation)
+        && binary_get_u32(data, offset, count)
+        && ((data.size() - offset) == (static_cast<size_t>(count) + 1U) * sizeof(uint32_t))) {
+        std::vector<uint32_t> entries(count);
+        for (uint32_t& entry : entries) {
+            (void)binary_get_u32(data, offset, entry);
+        }
+        const size_t checked_size = offset;
+        uint32_t checksum = 0;
+        (void)binary_get_u32(data, offset, checksum);
+        if (checksum == update_hash_adler32(KVS_HASH_ADLER32_INIT, data.data(), checked_size)) {
+            manifest.next_generation = next_generation;
+            manifest.entries = std::move(entries);
+            result = true;
+        }
+    }
+
+    return result;
+}
+
+/* File name suffix of an entry (appended to kvs_<id>) */
+std::string manifest_entry_suffix(uint32_t entry) {
+    std::string result;
+    if (0U != (entry & KVS_MANIFEST_LEGACY_ENTRY)) {
+        result = "_" + std::to_string(entry & ~KVS_MANIFEST_LEGACY_ENTRY);
+    }else{
+        result = "_g" + std::to_string(entry);
+    }
+    return result;
+}
+
+/* Make next_generation the current entry, returns the entries that are no longer referenced */
+std::vector<uint32_t> manifest_rotate(KvsManifest& manifest, size_t max_snapshots) {
+    std::vector<uint32_t> dropped;
+    manifest.entries.insert(manifest.entries.begin(), manifest.next_generation);
+    manifest.next_generation = (manifest.next_generation + 1U) & ~KVS_MANIFEST_LEGACY_ENTRY;
+    if (manifest.entries.size() > max_snapshots + 1U) {
+        dropped.assign(manifest.entries.begin() + static_cast<std::ptrdiff_t>(max_snapshots + 1U), manifest.entries.end());
+        manifest.entries.resize(max_snapshots + 1U);
+    }
+    return dropped;
+}
+
+} /* namespace score::mw::per::kvs */
@@ -0,0 +1,57 @@
+/********************************************************************************
+* Copyright (c) 2025 Contributors to the Eclipse Foundation
+*
+* See the NOTICE file(s) distributed with this work for additional
+* information regarding copyright ownership.
+*
+* This program and the accompanying materials are made available under the
+* terms of the Apache License Version 2.0 which is available at
+* https://www.apache.org/licenses/LICENSE-2.0
+*
+* SPDX-License-Identifier: Apache-2.0
+********************************************************************************/
+#ifndef SCORE_LIB_KVS_INTERNAL_KVS_MANIFEST_HPP
+#define SCORE_LIB_KVS_INTERNAL_KVS_MANIFEST_HPP
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/*
+ * This header defines the manifest of the generation snapshot layout (kvs_<id>.manifest).
+ * Kvs reads and writes it with KvsSnapshotLayout::Generations. KvsManifest is a member of Kvs,
+ * so this header is included by kvs.hpp.
+ *
+ * Layout (all integers little-endian):
+ *   magic "KVSM" | version (u16) | reserved (u16, 0) | next generation (u32) | count (u32)
+ *   | entry (u32) * count | adler32 of the preceding bytes (u32)
+ *
+ * Entry 0 is the current KVS file, entry n is snapshot n. An entry is the generation number of
+ * the files kvs_<id>_g<generation>.json/.bin/.hash, or (with KVS_MANIFEST_LEGACY_ENTRY set) the
+ * snapshot ID of legacy files kvs_<id>_<n>.json/.bin/.hash that were taken over without renaming.
+ * A flush writes the files of a new generation and replaces the manifest (temporary file + rename),
+ * so the rotation of all snapshots is a single atomic file update.
+ */
+namespace score::mw::per::kvs {
+
+/* Current version of the manifest format */
+constexpr uint16_t KVS_MANIFEST_VERSION = 1;
+
+/* Flag of entries that refer to legacy snapshot files (kvs_<id>_<n>) instead of a generation */
+constexpr uint32_t KVS_MANIFEST_LEGACY_ENTRY = 0x80000000U;
+
+/* Snapshot index of the generation layout */
+struct KvsManifest {
+    uint32_t next_generation = 0; /* Generation number of the next flush */
+    std::vector<uint32_t> entries; /* [0] = current KVS file, [n] = snapshot n */
+};
+
+std::string manifest_encode(const KvsManifest& manifest);
+bool manifest_decode(std::string_view data, KvsManifest& manifest);
+std::string manifest_entry_suffix(uint32_t entry);
+std::vector<uint32_t> manifest_rotate(KvsManifest& manifest, size_t max_snapshots);
+
+} /* namespace score::mw::per::kvs */
+
+#endif // SCORE_LIB_KVS_INTERNAL_KVS_MANIFEST_HPP
@@ -0,0 +1,148 @@
+/********************************************************************************
+* Copyright (c) 2025 Contributors to the Eclipse Foundation
+*
+* See the NOTICE file(s) distributed with this work for additional
+* information regarding copyright ownership.
+*
+* This program and the accompanying materials are made available under the
+* terms of the Apache License Version 2.0 which is available at
+* https://www.apache.org/licenses/LICENSE-2.0
+*
+* SPDX-License-Identifier: Apache-2.0
+********************************************************************************/
+#include "kvs_notifier.hpp"
+
+namespace score::mw::per::kvs {
+
+KvsNotifier::KvsNotifier()
+    : delivering(false)
+    , stopping(false)
+    , next_id(1)
+    , subscriber_count(0)
+{
+}
+
+KvsNotifier::~KvsNotifier() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    cv.notify_one();
+    if (thread.joinable()) {
+        thread.join();
+    }
+}
+
+/* Add a subscriber for a key (or all keys starting with it) */
+KvsSubscriptionId KvsNotifier::subscribe(const std::string_view key, bool prefix, KvsChangeCallback callback) {
+    std::lock_guard<std::mutex> lock(mutex);
+    const KvsSubscriptionId id = next_id++;
+    subscribers.emplace(id, std::make_shared<const Subscriber>(Subscriber{std::string(key), prefix, std::move(callback)}));
+    subscriber_count = subscribers.size();
+    if (!thread.joinable()) {
+        thread = std::thread(&KvsNotifier::run, this); /* Lazy start */
+    }
+
+    return id;
+}
+
+/* Remove a subscriber, waits for a running delivery unless called by a callback */
+bool KvsNotifier::unsubscribe(KvsSubscriptionId id) {
+    bool result = false;
+    bool callback_thread = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        result = (0U != subscribers.erase(id));
+        subscriber_count = subscribers.size();
+        callback_thread = (std::this_thread::get_id() == thread.get_id());
+    }
+    if (result && (!callback_thread)) {
+        std::lock_guard<std::mutex> delivery_lock(delivery_mutex);
+    }
+
+    return result;
+}
+
+/* Whether changes have to be posted */
+bool KvsNotifier::active() const {
+    return 0U != subscriber_count.load(std::memory_order_relaxed);
+}
+
+/* Queue a change */
+void KvsNotifier::post(KvsChange&& change) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        queue.push_back(std::move(change));
+    }
+    cv.notify_one();
+}
+
+/* Queue several changes (in their order) */
+void KvsNotifier::post(std::vector<KvsChange>&& changes) {
+    if (!changes.empty()) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (queue.empty()) {
+                queue = std::move(changes);
+            }else{
+                queue.insert(queue.end(), std::make_move_iterator(changes.begin()), std::make_move_iterator(changes.end()));
+            }
+        }
+        cv.notify_one();
+    }
+}
+
+/* Wait until all changes queued so far are delivered */
+void KvsNotifier::wait() {
+    std::unique_lock<std::mutex> lock(mutex);
+    idle_cv.wait(lock, [this] { return (!thread.joinable()) || (queue.empty() && (!delivering)); });
+}
+
+/* Loop of the background thread, the queued changes are delivered before stopping */
+void KvsNotifier::run() {
+    std::unique_lock<std::mutex> lock(mutex);
+    bool active = true;
+    while (active) {
+        cv.wait(lock, [this] { return (!queue.empty()) || stopping; });
+        if (!queue.empty()) {
+            std::vector<KvsChange> batch;
+            batch.swap(queue);
+            std::vector<std::pair<KvsSubscriptionId, std::shared_ptr<const Subscriber>>> targets(subscribers.begin(),
+                                                                                                 subscribers.end());
+            delivering = true;
+            lock.unlock();
+            /* Subscribers removed until now are skipped below, unsubscribe() waits for the callbacks from here on */
+            std::unique_lock<std::mutex> delivery_lock(delivery_mutex);
+
+            std::vector<KvsChange> matching;
+            for (const auto& [id, subscriber] : targets) {
+                matching.clear();
+                for (const auto& change : batch) {
+                    const bool match = subscriber->prefix ? (0 == change.key.compare(0, subscriber->key.size(), subscriber->key))
+                                                          : (change.key == subscriber->key);
+                    if (match) {
+                        matching.push_back(change);
+                    }
+                }
+                bool subscribed = false;
+                if (!matching.empty()) {
+                    /* A callback of this batch may have removed the subscriber */
+                    std::lock_guard<std::mutex> subscribers_lock(mutex);
+                    subscribed = (0U != subscribers.count(id));
+                }
+                if (subscribed) {
+                    subscriber->callback(matching);
+                }
+            }
+
+            delivery_lock.unlock();
+            lock.lock();
+            delivering = false;
+            idle_cv.notify_all();
+        }else{
+            active = false;
+        }
+    }
+}
+
+} /* namespace score::mw::per::kvs */
@@ -0,0 +1,111 @@
+/********************************************************************************
+* Copyright (c) 2025 Contributors to the Eclipse Foundation
+*
+* See the NOTICE file(s) distributed with this work for additional
+* information regarding copyright ownership.
+*
+* This program and the accompanying materials are made available under the
+* terms of the Apache License Version 2.0 which is available at
+* https://www.apache.org/licenses/LICENSE-2.0
+*
+* SPDX-License-Identifier: Apache-2.0
+********************************************************************************/
+#ifndef SCORE_LIB_KVS_INTERNAL_KVS_NOTIFIER_HPP
+#define SCORE_LIB_KVS_INTERNAL_KVS_NOTIFIER_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include "kvsvalue.hpp"
+
+/*
+ * This header defines the delivery of change notifications (see Kvs::subscribe).
+ * KvsChange is passed to the callbacks of Kvs::subscribe and KvsNotifier is a member of Kvs, so this
+ * header is included by kvs.hpp.
+ */
+namespace score::mw::per::kvs {
+
+/* A change of a written key as delivered to the subscribers */
+struct KvsChange {
+    std::string key;
+    std::optional<KvsValue> value; /* Written value, std::nullopt if the key was removed (e.g. reset to its default) */
+};
+
+/* Callback of a subscription, called with all matching changes of a batch in the order they were made */
+using KvsChangeCallback = std::function<void(const std::vector<KvsChange>&)>;
+
+/* Identifier of a subscription (see Kvs::unsubscribe) */
+using KvsSubscriptionId = size_t;
+
+/**
+ * @class KvsNotifier
+ * @brief Delivers the changes of a KVS to its subscribers in a background thread.
+ *
+ * Writers only queue their changes (under the KVS lock, so the order of the queue is the order of the
+ * writes). The thread takes all changes queued meanwhile as one batch and calls every subscriber once
+ * per batch with the changes matching its key or prefix.
+ *
+ * Public Methods:
+ * - `subscribe`: Adds a subscriber for a key or for all keys with a prefix.
+ * - `unsubscribe`: Removes a subscriber, no call of its callback is running or made afterwards.
+ * - `active`: Whether there is a subscriber (writers skip copying their changes otherwise).
+ * - `post`: Queues changes for delivery.
+ * - `wait`: Waits until all changes queued so far are delivered.
+ *
+ * Private Methods:
+ * - `run`: Loop of the background thread.
+ *
+ * Notice:
+ * - The thread is started by the first subscription, so a KVS without subscribers doesn't cost a thread.
+ * - The destructor delivers the queued changes before it joins the thread.
+ * - Callbacks are called in the background thread, they may access the KVS (also unsubscribe), but they
+ *   delay the delivery of later batches and must not call wait().
+ */
+class KvsNotifier final {
+public:
+    KvsNotifier();
+    ~KvsNotifier();
+    KvsNotifier(const KvsNotifier&) = delete;
+    KvsNotifier& operator=(const KvsNotifier&) = delete;
+
+    KvsSubscriptionId subscribe(const std::string_view key, bool prefix, KvsChangeCallback callback);
+    bool unsubscribe(KvsSubscriptionId id);
+    bool active() const;
+    void post(KvsChange&& change);
+    void post(std::vector<KvsChange>&& changes);
+    void wait();
+
+private:
+    /* A subscriber, matches a key or all keys with a prefix */
+    struct Subscriber {
+        std::string key;
+        bool prefix;
+        KvsChangeCallback callback;
+    };
+
+    void run();
+
+    std::mutex mutex;
+    std::condition_variable cv;                /* Signals queued changes and stopping to the thread */
+    std::condition_variable idle_cv;           /* Signals delivered batches to wait() */
+    std::vector<KvsChange> queue;              /* Changes not taken by the thread yet */
+    bool delivering;                           /* The thread currently delivers a batch */
+    bool stopping;                             /* The destructor was called */
+    std::map<KvsSubscriptionId, std::shared_ptr<const Subscriber>> subscribers;
+    KvsSubscriptionId next_id;
+    std::atomic<size_t> subscriber_count;      /* Read by writers without the mutex */
+    std::mutex delivery_mutex;                 /* Held while callbacks are called (unsubscribe waits for them) */
+    std::thread thread;
+};
+
+} /* namespace score::mw::per::kvs */
+
+#endif // SCORE_LIB_KVS_INTERNAL_KVS_NOTIFIER_HPP
@@ -0,0 +1,307 @@
+/********************************************************************************
+* Copyright (c) 2025 Contributors to the Eclipse Foundation
+*
+* See the NOTICE file(s) distributed with this work for additional
+* information regarding copyright ownership.
+*
+* This program and the accompanying materials are made available under the
+* terms of the Apache License Version 2.0 which is available at
+* https://www.apache.org/licenses/LICENSE-2.0
+*
+* SPDX-License-Identifier: Apache-2.0
+********************************************************************************/
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <new>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+#include "kvs_binary.hpp"
+#include "kvs_checksum.hpp"
+#include "kvs_defaults_image.hpp"
+#include "kvs_shared.hpp"
+
+namespace score::mw::per::kvs {
+
+namespace {
+
+/* Magic bytes at the beginning of every segment */
+constexpr char KVS_SHARED_MAGIC[4] = {'K', 'V', 'S', 'S'};
+
+/* The seqlock lives in memory shared between processes, this only works with lock-free atomics */
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "shared segment needs lock-free 64-bit atomics");
+
+/* Decode a value copied out of the image, the copy has to contain exactly one value */
+score::Result<KvsValue> decode_copy(const std::string& encoded) {
+    size_t offset = 0;
+    score::Result<KvsValue> result = binary_decode_value(encoded, offset);
+    if (result && (offset != encoded.size())) {
+        result = score::MakeUnexpected(ErrorCode::SerializationFailed);
+    }
+
+    return result;
+}
+
+} /* namespace */
+
+/* Header at the beginning of the segment (only the owner writes it) */
+struct SharedStore::Header {
+    char magic[4];
+    uint16_t version;
+    uint16_t reserved;
+    std::atomic<uint64_t> sequence;   /* Odd while the owner writes the image */
+    std::atomic<uint64_t> image_size; /* Size of the published image */
+    uint64_t capacity;                /* Size of the image area */
+};
+
+SharedStore::SharedStore(const std::string& name, int fd, char* data, size_t data_size, bool owner)
+    : name(name)
+    , fd(fd)
+    , data(data)
+    , data_size(data_size)
+    , owner(owner)
+{
+    static_assert(sizeof(Header) <= KVS_SHARED_HEADER_SIZE, "header doesn't fit into the reserved space");
+}
+
+SharedStore::~SharedStore() {
+    /* The name is kept, the next owner takes the segment over and the attached readers stay attached */
+    (void)munmap(data, data_size);
+    if (0 <= fd) {
+        (void)close(fd); /* Releases the owner lock */
+    }
+}
+
+/* Name of the segment: the instance and a hash of the absolute path, so other directories don't collide */
+std::string SharedStore::segment_name(const std::string& prefix) {
+    const size_t separator = prefix.find_last_of('/');
+    const std::string dir = (std::string::npos == separator) ? std::string(".") : prefix.substr(0, separator + 1);
+    const std::string base = (std::string::npos == separator) ? prefix : prefix.substr(separator + 1);
+    char resolved[PATH_MAX];
+    const std::string path = ((nullptr != realpath(dir.c_str(), resolved)) ? std::string(resolved) : dir) + "/" + base;
+    const uint32_t hash = hash_update(KvsHashAlgorithm::Crc32c, hash_init(KvsHashAlgorithm::Crc32c), path.data(), path.size());
+    char suffix[16];
+    (void)std::snprintf(suffix, sizeof(suffix), "_%08x", hash);
+
+    return "/" + base + suffix;
+}
+
+/* Create the segment as owner (an existing segment of a previous owner is reused, so its readers stay attached) */
+score::Result<std::unique_ptr<SharedStore>> SharedStore::create(const std::string& name, size_t capacity) {
+    score::Result<std::unique_ptr<SharedStore>> result = score::MakeUnexpected(ErrorCode::UnmappedError);
+
+    int fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (0 > fd) {
+        result = score::MakeUnexpected(ErrorCode::PhysicalStorageFailure);
+    }else if (0 != flock(fd, LOCK_EX | LOCK_NB)) {
+        (void)close(fd);
+        result = score::MakeUnexpected(ErrorCode::ResourceBusy); /* Another process is the owner */
+    }else{
+        struct stat segment_stat{};
+        const size_t required = KVS_SHARED_HEADER_SIZE + capacity;
+        size_t size = 0;
+        if (0 == fstat(fd, &segment_stat)) {
+            size = std::max(static_cast<size_t>(segment_stat.st_size), required);
+        }
+        void* addr = MAP_FAILED;
+        if ((0 != size) && ((static_cast<size_t>(segment_stat.st_size) == size) || (0 == ftruncate(fd, static_cast<off_t>(size))))) {
+            addr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        }
+        if (MAP_FAILED == addr) {
+            (void)close(fd);
+            result = score::MakeUnexpected(ErrorCode::OutOfStorageSpace);
+        }else{
+            char* data = static_cast<char*>(addr);
+            Header* header = reinterpret_cast<Header*>(data);
+            if ((0 != std::memcmp(header->magic, KVS_SHARED_MAGIC, sizeof(KVS_SHARED_MAGIC))) || (KVS_SHARED_VERSION != header->version)) {
+                /* New segment (zero-filled by ftruncate) */
+                header = new (data) Header{};
+                std::memcpy(header->magic, KVS_SHARED_MAGIC, sizeof(KVS_SHARED_MAGIC));
+                header->version = KVS_SHARED_VERSION;
+            }
+            header->capacity = size - KVS_SHARED_HEADER_SIZE;
+            result = std::unique_ptr<SharedStore>(new SharedStore(name, fd, data, size, true));
+        }
+    }
+
+    return result;
+}
+
+/* Map the segment of an owner read-only */
+score::Result<std::unique_ptr<SharedStore>> SharedStore::attach(const std::string& name) {
+    score::Result<std::unique_ptr<SharedStore>> result = score::MakeUnexpected(ErrorCode::UnmappedError);
+
+    int fd = shm_open(name.c_str(), O_RDONLY | O_CLOEXEC, 0);
+    if (0 > fd) {
+        result = score::MakeUnexpected((ENOENT == errno) ? ErrorCode::FileNotFound : ErrorCode::KvsFileReadError);
+    }else{
+        struct stat segment_stat{};
+        if ((0 != fstat(fd, &segment_stat)) || (static_cast<size_t>(segment_stat.st_size) < KVS_SHARED_HEADER_SIZE)) {
+            result = score::MakeUnexpected(ErrorCode::SerializationFailed);
+        }else{
+            const size_t size = static_cast<size_t>(segment_stat.st_size);
+            void* addr = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+            if (MAP_FAILED == addr) {
+                result = score::MakeUnexpected(ErrorCode::KvsFileReadError);
+            }else if ((0 != std::memcmp(addr, KVS_SHARED_MAGIC, sizeof(KVS_SHARED_MAGIC)))
+                      || (KVS_SHARED_VERSION != reinterpret_cast<const Header*>(addr)->version)) {
+                (void)munmap(addr, size);
+                result = score::MakeUnexpected(ErrorCode::SerializationFailed);
+            }else{
+                result = std::unique_ptr<SharedStore>(new SharedStore(name, -1, static_cast<char*>(addr), size, false));
+            }
+        }
+        (void)close(fd); /* The mapping stays valid after closing the segment */
+    }
+
+    return result;
+}
+
+/* Remove the name of a segment, attached processes keep their mapping */
+bool SharedStore::remove(const std::string& name) {
+    return (0 == shm_unlink(name.c_str())) || (ENOENT == errno);
+}
+
+SharedStore::Header* SharedStore::header() const {
+    return reinterpret_cast<Header*>(data);
+}
+
+/* Replace the published image (readers retry while the sequence is odd) */
+score::ResultBlank SharedStore::publish(std::string_view image) {
+    score::ResultBlank result = score::MakeUnexpected(ErrorCode::UnmappedError);
+    if (!owner) {
+        result = score::MakeUnexpected(ErrorCode::ReadOnly);
+    }else if (image.size() > data_size - KVS_SHARED_HEADER_SIZE) {
+        result = score::MakeUnexpected(ErrorCode::OutOfStorageSpace);
+    }else{
+        std::lock_guard<std::mutex> lock(publish_mutex);
+        Header* shared = header();
+        /* A previous owner may have died while publishing, the sequence is odd then */
+        const uint64_t writing = shared->sequence.load(std::memory_order_relaxed) | 1U;
+        shared->sequence.store(writing, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        std::memcpy(data + KVS_SHARED_HEADER_SIZE, image.data(), image.size());
+        shared->image_size.store(image.size(), std::memory_order_relaxed);
+        shared->sequence.store(writing + 1U, std::memory_order_release);
+        result = score::ResultBlank{};
+    }
+
+    return result;
+}
+
+/* Seqlock read: copy runs on the image until it saw no concurrent publish (the copy may see a torn image) */
+template <typename Copy>
+score::ResultBlank SharedStore::read(const Copy& copy) const {
+    score::ResultBlank result = score::MakeUnexpected(ErrorCode::ResourceBusy);
+    const Header* shared = header();
+    bool done = false;
+    for (size_t attempt = 0; (!done) && (attempt < KVS_SHARED_READ_ATTEMPTS); ++attempt) {
+        const uint64_t begin = shared->sequence.load(std::memory_order_acquire);
+        if (0U != (begin & 1U)) {
+            std::this_thread::yield();
+        }else{
+            const size_t image_size = static_cast<size_t>(shared->image_size.load(std::memory_order_relaxed));
+            score::ResultBlank copy_res = score::ResultBlank{};
+            if (image_size > (data_size - KVS_SHARED_HEADER_SIZE)) {
+                /* A later owner grew the segment beyond the mapping of this reader */
+                copy_res = score::MakeUnexpected(ErrorCode::OutOfStorageSpace);
+            }else{
+                copy_res = copy(std::string_view(data + KVS_SHARED_HEADER_SIZE, image_size));
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (begin == shared->sequence.load(std::memory_order_relaxed)) {
+                result = copy_res;
+                done = true;
+            }
+        }
+    }
+
+    return result;
+}
+
+/* Copy and decode the value of a key */
+score::Result<std::optional<KvsValue>> SharedStore::find(const std::string_view key) const {
+    score::Result<std::optional<KvsValue>> result = score::MakeUnexpected(ErrorCode::UnmappedError);
+    std::string encoded;
+    bool found = false;
+    auto read_res = read([&key, &encoded, &found](std::string_view image) {
+        score::ResultBlank copy_res = score::ResultBlank{};
+        auto value_res = image_find(image, key);
+        found = value_res.has_value();
+        if (found) {
+            encoded.assign(value_res.value().data(), value_res.value().size());
+        }else if (ErrorCode::KeyNotFound != static_cast<ErrorCode>(*value_res.error())) {
+            copy_res = score::MakeUnexpected(static_cast<ErrorCode>(*value_res.error()));
+        }
+        return copy_res;
+    });
+
+    if (!read_res) {
+        result = score::MakeUnexpected(static_cast<ErrorCode>(*read_res.error()));
+    }else if (!found) {
+        result = std::optional<KvsValue>();
+    }else{
+        auto decode_res = decode_copy(encoded);
+        if (!decode_res) {
+            result = score::MakeUnexpected(static_cast<ErrorCode>(*decode_res.error()));
+        }else{
+            result = std::optional<KvsValue>(std::move(decode_res.value()));
+        }
+    }
+
+    return result;
+}
+
+/* Copy and decode all entries with a prefix (in key order) */
+score::Result<std::vector<std::pair<std::string, KvsValue>>> SharedStore::scan(const std::string_view prefix) const {
+    score::Result<std::vector<std::pair<std::string, KvsValue>>> result = score::MakeUnexpected(ErrorCode::UnmappedError);
+    std::vector<std::pair<std::string, std::string>> copied;
+    auto read_res = read([&prefix, &copied](std::string_view image) {
+        copied.clear();
+        return image_scan(image, prefix, [&copied](std::string_view key, std::string_view value) {
+            copied.emplace_back(std::string(key), std::string(value));
+        });
+    });
+
+    if (!read_res) {
+        result = score::MakeUnexpected(static_cast<ErrorCode>(*read_res.error()));
+    }else{
+        std::vector<std::pair<std::string, KvsValue>> entries;
+        entries.reserve(copied.size());
+        bool error = false;
+        for (auto& [key, encoded] : copied) {
+            auto decode_res = decode_copy(encoded);
+            if (!decode_res) {
+                result = score::MakeUnexpected(static_cast<ErrorCode>(*decode_res.error()));
+                error = true;
+                break;
+            }
+            entries.emplace_back(std::move(key), std::move(decode_res.value()));
+        }
+        if (!error) {
+            result = std::move(entries);
+        }
+    }
+
+    return result;
+}
+
+/* Seqlock sequence of the published image */
+uint64_t SharedStore::sequence() const {
+    return header()->sequence.load(std::memory_order_acquire);
+}
+
+/* Maximum size of the published image */
+size_t SharedStore::capacity() const {
+    return data_size - KVS_SHARED_HEADER_SIZE;
+}
+
+} /* namespace score::mw::per::kvs */
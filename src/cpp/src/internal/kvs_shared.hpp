@@ -0,0 +1,106 @@
+/********************************************************************************
+* Copyright (c) 2025 Contributors to the Eclipse Foundation
+*
+* See the NOTICE file(s) distributed with this work for additional
+* information regarding copyright ownership.
+*
+* This program and the accompanying materials are made available under the
+* terms of the Apache License Version 2.0 which is available at
+* https://www.apache.org/licenses/LICENSE-2.0
+*
+* SPDX-License-Identifier: Apache-2.0
+********************************************************************************/
+#ifndef SCORE_LIB_KVS_INTERNAL_KVS_SHARED_HPP
+#define SCORE_LIB_KVS_INTERNAL_KVS_SHARED_HPP
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include "error.hpp"
+#include "kvsvalue.hpp"
+
+/*
+ * This header defines the shared-memory segment of a KVS instance (KvsOptions::sharing).
+ * The KvsSharing::Owner instance publishes an image of its data after every flush, KvsSharing::Reader
+ * instances of other processes serve get_value and get_all_keys from the image instead of the KVS files.
+ *
+ * Layout (POSIX shared memory object /kvs_<id>_<hash of the path>):
+ *   Header: magic "KVSS" | version (u16) | reserved (u16) | sequence (atomic u64) | image size (atomic u64) |
+ *           capacity (u64), padded to 64 bytes
+ *   Image:  the published data in the layout of the defaults image (see internal/kvs_defaults_image.hpp)
+ *
+ * The owner process publishes the data with a seqlock: the sequence is odd while the image is written.
+ * Readers copy the bytes they need out of the image and retry if the sequence changed meanwhile, so they
+ * never block the owner and need no round-trip to it. Only one owner can hold a segment (flock).
+ */
+namespace score::mw::per::kvs {
+
+/* Current version of the segment format */
+constexpr uint16_t KVS_SHARED_VERSION = 1;
+
+/* Size of the segment header */
+constexpr size_t KVS_SHARED_HEADER_SIZE = 64;
+
+/* Number of reads retried while the owner publishes, fails with ErrorCode::ResourceBusy afterwards */
+constexpr size_t KVS_SHARED_READ_ATTEMPTS = 64;
+
+/**
+ * @class SharedStore
+ * @brief Shared-memory segment in which one owner process publishes the KVS data for reader processes.
+ *
+ * Public Methods:
+ * - `segment_name`: Derives the name of the segment from the filename prefix of the instance.
+ * - `create`: Creates (or takes over) the segment as owner, fails if another owner holds it.
+ * - `attach`: Maps the segment of an owner read-only.
+ * - `remove`: Removes the name of a segment (attached readers keep their mapping).
+ * - `publish`: Replaces the published image (owner only).
+ * - `find`: Copies and decodes the value of a key (std::nullopt if it isn't published).
+ * - `scan`: Copies and decodes all published entries whose key starts with a prefix.
+ * - `sequence`: Retrieves the seqlock sequence (even, +2 per publish).
+ * - `capacity`: Retrieves the maximum size of the image.
+ *
+ * The segment is not copyable. It outlives its owner: the next owner takes it over, so attached readers see the
+ * images of the restarted owner without attaching again. A later owner with a larger capacity grows the segment,
+ * readers attached before fail to read an image larger than their mapping with ErrorCode::OutOfStorageSpace.
+ */
+class SharedStore final {
+public:
+    ~SharedStore();
+    SharedStore(const SharedStore&) = delete;
+    SharedStore& operator=(const SharedStore&) = delete;
+
+    static std::string segment_name(const std::string& prefix);
+    static score::Result<std::unique_ptr<SharedStore>> create(const std::string& name, size_t capacity);
+    static score::Result<std::unique_ptr<SharedStore>> attach(const std::string& name);
+    static bool remove(const std::string& name);
+
+    score::ResultBlank publish(std::string_view image);
+    score::Result<std::optional<KvsValue>> find(const std::string_view key) const;
+    score::Result<std::vector<std::pair<std::string, KvsValue>>> scan(const std::string_view prefix) const;
+    uint64_t sequence() const;
+    size_t capacity() const;
+
+private:
+    struct Header;
+
+    SharedStore(const std::string& name, int fd, char* data, size_t data_size, bool owner);
+    Header* header() const;
+    template <typename Copy>
+    score::ResultBlank read(const Copy& copy) const;
+
+    std::string name;         /* Name of the shared memory object */
+    int fd;                   /* Descriptor holding the owner lock (-1 for readers) */
+    char* data;               /* Start of the mapping */
+    size_t data_size;         /* Size of the mapping */
+    bool owner;               /* Mapped writable by the owner */
+    std::mutex publish_mutex; /* Publishers of the owner process */
+};
+
+} /* namespace score::mw::per::kvs */
+
+#endif // SCORE_LIB_KVS_INTERNAL_KVS_SHARED_HPP
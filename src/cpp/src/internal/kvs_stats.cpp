@@ -0,0 +1,106 @@
+/********************************************************************************
+* Copyright (c) 2025 Contributors to the Eclipse Foundation
+*
+* See the NOTICE file(s) distributed with this work for additional
+* information regarding copyright ownership.
+*
+* This program and the accompanying materials are made available under the
+* terms of the Apache License Version 2.0 which is available at
+* https://www.apache.org/licenses/LICENSE-2.0
+*
+* SPDX-License-Identifier: Apache-2.0
+********************************************************************************/
+#include "kvs_stats.hpp"
+
+namespace score::mw::per::kvs {
+
+/* Histogram bucket of a latency (its highest set bit) */
+static size_t latency_bucket(uint64_t ns) {
+    return (0U == ns) ? 0U : static_cast<size_t>(63 - __builtin_clzll(ns));
+}
+
+uint64_t KvsLatencyStats::percentile_ns(double fraction) const {
+    uint64_t result = 0;
+    if (0U != count) {
+        /* Operations counted up to the percentile, at least one */
+        uint64_t remaining = static_cast<uint64_t>(fraction * static_cast<double>(count));
+        remaining = (0U == remaining) ? 1U : remaining;
+        uint64_t counted = 0;
+        for (size_t idx = 0; idx < KVS_LATENCY_BUCKETS; ++idx) {
+            counted += buckets[idx];
+            if (counted >= remaining) {
+                /* Upper bound of the bucket, never above the largest latency */
+                const uint64_t bound = (idx >= 63U) ? UINT64_MAX : ((uint64_t{2} << idx) - 1U);
+                result = (bound < max_ns) ? bound : max_ns;
+                break;
+            }
+        }
+    }
+
+    return result;
+}
+
+const KvsLatencyStats& KvsStats::latency(KvsOperation operation) const {
+    return latencies[static_cast<size_t>(operation)];
+}
+
+uint64_t KvsStats::counter(KvsCounter counter) const {
+    return counters[static_cast<size_t>(counter)];
+}
+
+/* Add the latency from start until now */
+void KvsStatsRecorder::record(KvsOperation operation, std::chrono::steady_clock::time_point start) {
+    record(operation, start, std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start));
+}
+
+void KvsStatsRecorder::record(KvsOperation operation, std::chrono::steady_clock::time_point start, std::chrono::nanoseconds duration) {
+    if constexpr (KVS_STATS_ENABLED) {
+        const uint64_t ns = (duration.count() > 0) ? static_cast<uint64_t>(duration.count()) : 0U;
+        Latency& latency = latencies[static_cast<size_t>(operation)];
+        (void)latency.count.fetch_add(1, std::memory_order_relaxed);
+        (void)latency.total_ns.fetch_add(ns, std::memory_order_relaxed);
+        (void)latency.buckets[latency_bucket(ns)].fetch_add(1, std::memory_order_relaxed);
+        uint64_t max_ns = latency.max_ns.load(std::memory_order_relaxed);
+        while ((ns > max_ns) && (!latency.max_ns.compare_exchange_weak(max_ns, ns, std::memory_order_relaxed))) {
+            /* max_ns was updated to the current maximum, retry */
+        }
+        if (trace_hook) {
+            trace_hook(operation, start, duration);
+        }
+    }
+}
+
+KvsStats KvsStatsRecorder::stats() const {
+    KvsStats result;
+    for (size_t op = 0; op < KVS_OPERATION_COUNT; ++op) {
+        const Latency& latency = latencies[op];
+        KvsLatencyStats& copy = result.latencies[op];
+        copy.count = latency.count.load(std::memory_order_relaxed);
+        copy.total_ns = latency.total_ns.load(std::memory_order_relaxed);
+        copy.max_ns = latency.max_ns.load(std::memory_order_relaxed);
+        for (size_t idx = 0; idx < KVS_LATENCY_BUCKETS; ++idx) {
+            copy.buckets[idx] = latency.buckets[idx].load(std::memory_order_relaxed);
+        }
+    }
+    for (size_t idx = 0; idx < KVS_COUNTER_COUNT; ++idx) {
+        result.counters[idx] = counters[idx].load(std::memory_order_relaxed);
+    }
+
+    return result;
+}
+
+void KvsStatsRecorder::reset() {
+    for (Latency& latency : latencies) {
+        latency.count.store(0, std::memory_order_relaxed);
+        latency.total_ns.store(0, std::memory_order_relaxed);
+        latency.max_ns.store(0, std::memory_order_relaxed);
+        for (auto& bucket : latency.buckets) {
+            bucket.store(0, std::memory_order_relaxed);
+        }
+    }
+    for (auto& counter : counters) {
+        counter.store(0, std::memory_order_relaxed);
+    }
+}
+
+} /* namespace score::mw::per::kvs */
@@ -0,0 +1,170 @@
+/********************************************************************************
+* Copyright (c) 2025 Contributors to the Eclipse Foundation
+*
+* See the NOTICE file(s) distributed with this work for additional
+* information regarding copyright ownership.
+*
+* This program and the accompanying materials are made available under the
+* terms of the Apache License Version 2.0 which is available at
+* https://www.apache.org/licenses/LICENSE-2.0
+*
+* SPDX-License-Identifier: Apache-2.0
+********************************************************************************/
+#ifndef SCORE_LIB_KVS_INTERNAL_KVS_STATS_HPP
+#define SCORE_LIB_KVS_INTERNAL_KVS_STATS_HPP
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+/*
+ * This header defines the instrumentation of the KVS (see Kvs::stats): latency histograms of the
+ * expensive operations and counters of failures. KvsStats is returned by Kvs::stats, so this header
+ * is included by kvs.hpp.
+ *
+ * The instrumentation is compiled in by default. Building with KVS_STATS_DISABLED defined (e.g.
+ * --copt=-DKVS_STATS_DISABLED, for every target that includes the KVS headers) removes the time
+ * measurements and counters from all operations, Kvs::stats() then only returns zeros.
+ */
+namespace score::mw::per::kvs {
+
+#ifdef KVS_STATS_DISABLED
+constexpr bool KVS_STATS_ENABLED = false;
+#else
+constexpr bool KVS_STATS_ENABLED = true;
+#endif
+
+/* Operations whose latency is measured */
+enum class KvsOperation : uint8_t {
+    Open = 0,            /* Kvs::open (defaults, KVS file and log replay) */
+    Flush = 1,           /* Flush in the calling or the background thread (full or incremental) */
+    SnapshotRotate = 2,  /* Rotation of the snapshot files (or update of the manifest) by a full flush */
+    HashVerify = 3,      /* Reading a KVS file and verifying its hash */
+    Parse = 4,           /* Decoding (or indexing with KvsOptions::lazy_values) a KVS file */
+    SnapshotRestore = 5  /* Kvs::snapshot_restore */
+};
+
+/* Number of KvsOperation values */
+constexpr size_t KVS_OPERATION_COUNT = 6;
+
+/* Buckets of a latency histogram, bucket n counts the latencies of [2^n, 2^(n+1)) nanoseconds (bucket 0 also 0 ns) */
+constexpr size_t KVS_LATENCY_BUCKETS = 64;
+
+/* Counted events */
+enum class KvsCounter : uint8_t {
+    LockFailure = 0,       /* An accessor returned ErrorCode::MutexLockFailed (KvsLockMode::TryLock) */
+    FlushFailure = 1,      /* A flush failed */
+    ValidationFailure = 2, /* A read KVS file didn't match its hash file */
+    PublishFailure = 3     /* The data could not be published for the readers (KvsSharing::Owner) */
+};
+
+/* Number of KvsCounter values */
+constexpr size_t KVS_COUNTER_COUNT = 4;
+
+/* Latencies of one operation */
+struct KvsLatencyStats {
+    uint64_t count = 0;    /* Number of measured operations */
+    uint64_t total_ns = 0; /* Sum of all latencies */
+    uint64_t max_ns = 0;   /* Largest latency */
+    std::array<uint64_t, KVS_LATENCY_BUCKETS> buckets{}; /* Histogram (see KVS_LATENCY_BUCKETS) */
+
+    /* Upper bound of the latency of the given fraction (0.0-1.0) of the operations, 0 without operations */
+    uint64_t percentile_ns(double fraction) const;
+};
+
+/* Statistics of a KVS instance (see Kvs::stats) */
+struct KvsStats {
+    std::array<KvsLatencyStats, KVS_OPERATION_COUNT> latencies{};
+    std::array<uint64_t, KVS_COUNTER_COUNT> counters{};
+
+    const KvsLatencyStats& latency(KvsOperation operation) const;
+    uint64_t counter(KvsCounter counter) const;
+};
+
+/* Trace hook, called in the thread of a measured operation once it completed (see KvsOptions::trace_hook) */
+using KvsTraceHook = std::function<void(KvsOperation operation, std::chrono::steady_clock::time_point start,
+                                        std::chrono::nanoseconds duration)>;
+
+/**
+ * @class KvsStatsRecorder
+ * @brief Collects the statistics of a KVS instance.
+ *
+ * Public Methods:
+ * - `record`: Adds the latency of an operation (and calls the trace hook).
+ * - `count`: Counts an event.
+ * - `stats`: Retrieves a copy of the statistics.
+ * - `reset`: Clears the statistics.
+ *
+ * Notice:
+ * - All values are relaxed atomics, recording never takes a lock. A copy made while operations are
+ *   recorded may contain an operation in its count but not yet in its histogram.
+ * - The trace hook is set before the KVS is used by other threads (Kvs::open) and not changed afterwards.
+ */
+class KvsStatsRecorder final {
+public:
+    KvsStatsRecorder() = default;
+    KvsStatsRecorder(const KvsStatsRecorder&) = delete;
+    KvsStatsRecorder& operator=(const KvsStatsRecorder&) = delete;
+
+    void record(KvsOperation operation, std::chrono::steady_clock::time_point start);
+    void record(KvsOperation operation, std::chrono::steady_clock::time_point start, std::chrono::nanoseconds duration);
+    void count(KvsCounter counter) {
+        if constexpr (KVS_STATS_ENABLED) {
+            (void)counters[static_cast<size_t>(counter)].fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+    KvsStats stats() const;
+    void reset();
+
+    KvsTraceHook trace_hook;
+
+private:
+    struct Latency {
+        std::atomic<uint64_t> count{0};
+        std::atomic<uint64_t> total_ns{0};
+        std::atomic<uint64_t> max_ns{0};
+        std::array<std::atomic<uint64_t>, KVS_LATENCY_BUCKETS> buckets{};
+    };
+
+    std::array<Latency, KVS_OPERATION_COUNT> latencies;
+    std::array<std::atomic<uint64_t>, KVS_COUNTER_COUNT> counters{};
+};
+
+/**
+ * @class KvsStatsTimer
+ * @brief Measures the latency of an operation until the end of its scope.
+ *
+ * Without instrumentation (KVS_STATS_DISABLED) the timer doesn't read the clock and is optimized out.
+ */
+class KvsStatsTimer final {
+public:
+    KvsStatsTimer(KvsStatsRecorder& recorder, KvsOperation operation)
+        : recorder(recorder)
+        , operation(operation)
+    {
+        if constexpr (KVS_STATS_ENABLED) {
+            start = std::chrono::steady_clock::now();
+        }
+    }
+
+    ~KvsStatsTimer() {
+        if constexpr (KVS_STATS_ENABLED) {
+            recorder.record(operation, start);
+        }
+    }
+
+    KvsStatsTimer(const KvsStatsTimer&) = delete;
+    KvsStatsTimer& operator=(const KvsStatsTimer&) = delete;
+
+private:
+    KvsStatsRecorder& recorder;
+    KvsOperation operation;
+    std::chrono::steady_clock::time_point start;
+};
+
+} /* namespace score::mw::per::kvs */
+
+#endif // SCORE_LIB_KVS_INTERNAL_KVS_STATS_HPP
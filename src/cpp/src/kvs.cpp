@@ -10,10 +10,21 @@
 *
 * SPDX-License-Identifier: Apache-2.0
 ********************************************************************************/
-#include <fstream>
+#include <algorithm>
+#include <array>
 #include <iostream>
 #include <sstream>
+#include <thread>
+#include "internal/kvs_binary.hpp"
+#include "internal/kvs_defaults_image.hpp"
+#include "internal/kvs_delta.hpp"
+#include "internal/kvs_flusher.hpp"
 #include "internal/kvs_helper.hpp"
+#include "internal/kvs_json_stream.hpp"
+#include "internal/kvs_log.hpp"
+#include "internal/kvs_manifest.hpp"
+#include "internal/kvs_notifier.hpp"
+#include "internal/kvs_shared.hpp"
 #include "kvs.hpp"
 
 //TODO Default Value Handling TBD
@@ -25,83 +36,302 @@ using namespace std;
 
 namespace score::mw::per::kvs {
 
+/* All storage formats, a snapshot is available in exactly one of them */
+static constexpr std::array<KvsStorageFormat, 2> KVS_STORAGE_FORMATS = {KvsStorageFormat::Json, KvsStorageFormat::Binary};
+
+/* File extension of the KVS data in the given storage format */
+static const char* get_data_extension(KvsStorageFormat format) {
+    return (KvsStorageFormat::Binary == format) ? ".bin" : ".json";
+}
+
+/* The respective other storage format */
+static KvsStorageFormat get_other_format(KvsStorageFormat format) {
+    return (KvsStorageFormat::Binary == format) ? KvsStorageFormat::Json : KvsStorageFormat::Binary;
+}
+
+/* Complete a flush that was interrupted before its hash file was renamed (the pending hash matches the data) */
+static bool recover_hash_file(KvsBackend& backend, const std::string& hash_file, const std::string& data) {
+    bool result = false;
+    const std::string tmp_hash_file = hash_file + ".tmp";
+    auto hin = backend.open_read(tmp_hash_file);
+    KvsHashAlgorithm algorithm = KvsHashAlgorithm::Adler32;
+    uint32_t hash = 0;
+    if ((nullptr != hin) && parse_hash_file(*hin, algorithm, hash) && (calculate_hash(algorithm, data) == hash)) {
+        hin.reset();
+        (void)backend.rename(tmp_hash_file, hash_file); /* Otherwise recovered again on the next open */
+        result = true;
+    }
+
+    return result;
+}
+
+/* Read the hash of a hash file */
+static bool read_hash_value(KvsBackend& backend, const std::string& hash_file, uint32_t& hash) {
+    auto hin = backend.open_read(hash_file);
+    KvsHashAlgorithm algorithm = KvsHashAlgorithm::Adler32;
+    return (nullptr != hin) && parse_hash_file(*hin, algorithm, hash);
+}
+
+/* Move a snapshot file to the next ID, the current KVS file (ID 0) is linked, so it stays valid until it is replaced */
+static score::ResultBlank rotate_file(KvsBackend& backend, const std::string& from, const std::string& to, bool keep) {
+    score::ResultBlank result = score::MakeUnexpected(ErrorCode::UnmappedError);
+    if (keep) {
+        result = backend.link(from, to);
+    }else{
+        result = backend.rename(from, to);
+    }
+    return result;
+}
+
+/* Whether a file operation failed (a missing file is skipped) */
+static bool file_failed(const score::ResultBlank& result) {
+    return (!result) && (ErrorCode::FileNotFound != static_cast<ErrorCode>(*result.error()));
+}
+
 /*********************** KVS Implementation *********************/
 Kvs::Kvs()
-    : filesystem(std::make_unique<score::filesystem::Filesystem>(score::filesystem::FilesystemFactory{}.CreateInstance())) /* Create Filesystem instance, noexcept call */
+    : lazy_format(KvsStorageFormat::Json)
+    , key_generation(next_key_generation())
+    , full_flush_required(true)
+    , base_hash(0)
+    , base_size(0)
+    , log_size(0)
+    , unsynced_flushes(0)
+    , backend(std::make_shared<KvsFileBackend>()) /* Files of the OS unless KvsOptions::backend is set */
     , parser(std::make_unique<score::json::JsonParser>())
-    , writer(std::make_unique<score::json::JsonWriter>())
     , logger(std::make_unique<score::mw::log::Logger>("SKVS"))
+    , notifier(std::make_unique<KvsNotifier>())
+    , stats_recorder(std::make_unique<KvsStatsRecorder>())
 {
 }
 
 Kvs::Kvs(Kvs&& other) noexcept
-    : filename_prefix(std::move(other.filename_prefix))
-    , filesystem(std::move(other.filesystem))
-    , parser(std::move(other.parser)) /* Not absolutely necessary, because a new JSON writer/parser object would also be okay*/
-    , writer(std::move(other.writer))
+    : lazy_format(other.lazy_format)
+    , key_generation(next_key_generation()) /* Handles of the moved KVS belong to other, they are looked up again */
+    , options((other.stop_flusher(), other.options)) /* Finish a pending background flush before its data is moved */
+    , full_flush_required(other.full_flush_required.load())
+    , base_hash(other.base_hash)
+    , base_size(other.base_size)
+    , log_size(other.log_size)
+    , unsynced_flushes(other.unsynced_flushes.load())
+    , delta_base(std::move(other.delta_base))
+    , delta_base_hash(other.delta_base_hash)
+    , filename_prefix(std::move(other.filename_prefix))
+    , manifest(std::move(other.manifest))
+    , backend(std::move(other.backend))
+    , parser(std::move(other.parser)) /* Not absolutely necessary, because a new JSON parser object would also be okay*/
     , logger(std::move(other.logger))
+    , notifier(std::move(other.notifier)) /* The subscriptions stay with the data */
+    , stats_recorder(std::move(other.stats_recorder))
 {
     {
-        std::lock_guard<std::mutex> lock(other.kvs_mutex);
+        std::lock_guard<std::shared_mutex> lock(other.kvs_mutex);
         kvs = std::move(other.kvs);
+        lazy_data = std::move(other.lazy_data);
+        lazy_kvs = std::move(other.lazy_kvs);
+        slots = std::move(other.slots); /* The nodes of the maps are moved, the slots still refer to them */
+        other.slots.clear();
+        dirty_keys = std::move(other.dirty_keys);
+        other.key_generation = next_key_generation();
     }
 
     default_values = std::move(other.default_values);
+    default_image = std::move(other.default_image);
+    shared = std::move(other.shared);
 
 }
 
 Kvs& Kvs::operator=(Kvs&& other) noexcept
 {
     if (this != &other) {
+        stop_flusher();
+        other.stop_flusher();
         {
-            std::lock_guard<std::mutex> lock_this(kvs_mutex);
+            std::lock_guard<std::shared_mutex> lock_this(kvs_mutex);
+            slots.clear();
             kvs.clear();
+            lazy_kvs.clear();
+            lazy_data.reset();
+            dirty_keys.clear();
         }
         default_values.clear();
+        default_image.reset();
+        shared.reset();
+        options = other.options;
         filename_prefix = std::move(other.filename_prefix);
+        manifest = std::move(other.manifest);
 
         {
-            std::lock_guard<std::mutex> lock_other(other.kvs_mutex);
-            std::lock_guard<std::mutex> lock_this(kvs_mutex);
+            std::lock_guard<std::shared_mutex> lock_other(other.kvs_mutex);
+            std::lock_guard<std::shared_mutex> lock_this(kvs_mutex);
             kvs = std::move(other.kvs);
+            lazy_data = std::move(other.lazy_data);
+            lazy_kvs = std::move(other.lazy_kvs);
+            lazy_format = other.lazy_format;
+            slots = std::move(other.slots);
+            other.slots.clear();
+            dirty_keys = std::move(other.dirty_keys);
+            key_generation = next_key_generation();
+            other.key_generation = next_key_generation();
         }
+        full_flush_required = other.full_flush_required.load();
+        base_hash = other.base_hash;
+        base_size = other.base_size;
+        log_size = other.log_size;
+        unsynced_flushes = other.unsynced_flushes.load();
+        delta_base = std::move(other.delta_base);
+        delta_base_hash = other.delta_base_hash;
         default_values = std::move(other.default_values);
+        default_image = std::move(other.default_image);
+        shared = std::move(other.shared);
 
-        filesystem = std::move(other.filesystem);
-        /* Transfer ownership of JSON parser and writer
-            Not absolutely necessary, because a new JSON writer/parser object would also be okay*/
+        backend = std::move(other.backend);
+        /* Transfer ownership of JSON parser
+            Not absolutely necessary, because a new JSON parser object would also be okay*/
         parser = std::move(other.parser);
-        writer = std::move(other.writer);
         logger = std::move(other.logger);
+        notifier = std::move(other.notifier);
+        stats_recorder = std::move(other.stats_recorder);
     }
     return *this;
 }
 
-/* Helper Function to parse JSON data for open_json*/
-score::Result<std::unordered_map<std::string, KvsValue>> Kvs::parse_json_data(const std::string& data) {
+Kvs::~Kvs()
+{
+    stop_flusher();
+}
+
+/* Acquire the KVS lock for reading (readers can hold the lock in parallel) */
+std::shared_lock<std::shared_mutex> Kvs::lock_shared() {
+    std::shared_lock<std::shared_mutex> lock(kvs_mutex, std::defer_lock);
+    if (KvsLockMode::Blocking == options.lock_mode) {
+        lock.lock();
+    }else{
+        if (!lock.try_lock()) {
+            stats_recorder->count(KvsCounter::LockFailure); /* Caller checks owns_lock() */
+        }
+    }
+
+    return lock;
+}
+
+/* Acquire the KVS lock for writing (exclusive access) */
+std::unique_lock<std::shared_mutex> Kvs::lock_exclusive() {
+    std::unique_lock<std::shared_mutex> lock(kvs_mutex, std::defer_lock);
+    if (KvsLockMode::Blocking == options.lock_mode) {
+        lock.lock();
+    }else{
+        if (!lock.try_lock()) {
+            stats_recorder->count(KvsCounter::LockFailure); /* Caller checks owns_lock() */
+        }
+    }
+
+    return lock;
+}
+
+/* Minimum number of top-level entries converted by every worker of a parallel JSON parse */
+static constexpr size_t PARALLEL_PARSE_MIN_ENTRIES = 1024;
+
+/* Convert the top-level JSON entries [begin, end) and append them to entries */
+template <typename Iterator>
+static score::ResultBlank convert_json_entries(Iterator begin, Iterator end, const KvsElementAllocator& alloc,
+                                               std::vector<std::pair<std::string, KvsValue>>& entries) {
+    score::ResultBlank result = score::ResultBlank{};
+    for (auto it = begin; result && (it != end); ++it) {
+        auto conv = any_to_kvsvalue(it->second, alloc);
+        if (!conv) {
+            result = score::MakeUnexpected(static_cast<ErrorCode>(*conv.error()));
+        }else{
+            auto sv = it->first.GetAsStringView();
+            entries.emplace_back(std::string(sv.data(), sv.size()), std::move(conv.value()));
+        }
+    }
+    return result;
+}
+
+/* Convert the top-level JSON entries by several workers (the calling thread converts the first part) */
+template <typename Elements>
+static score::ResultBlank convert_json_entries_parallel(const Elements& elements, size_t workers, const KvsElementAllocator& alloc,
+                                                        KvsMap& map) {
+    score::ResultBlank result = score::ResultBlank{};
+    std::vector<typename Elements::const_iterator> bounds;
+    bounds.reserve(workers + 1U);
+    auto it = elements.begin();
+    for (size_t worker = 0; worker < workers; ++worker) {
+        bounds.push_back(it);
+        std::advance(it, (elements.size() / workers) + ((worker < (elements.size() % workers)) ? 1U : 0U));
+    }
+    bounds.push_back(elements.end());
+
+    /* An arena is filled by one thread, so every worker gets its own arena for the elements */
+    std::vector<KvsElementAllocator> allocs(workers, alloc);
+    for (size_t worker = 1; (nullptr != alloc.arena) && (worker < workers); ++worker) {
+        allocs[worker] = KvsElementAllocator(std::make_shared<KvsArena>());
+    }
+    std::vector<std::vector<std::pair<std::string, KvsValue>>> converted(workers);
+    std::vector<score::ResultBlank> results(workers, score::ResultBlank{});
+    std::vector<std::thread> threads;
+    threads.reserve(workers - 1U);
+    for (size_t worker = 1; worker < workers; ++worker) {
+        threads.emplace_back([&, worker]() {
+            results[worker] = convert_json_entries(bounds[worker], bounds[worker + 1U], allocs[worker], converted[worker]);
+        });
+    }
+    results[0] = convert_json_entries(bounds[0], bounds[1], allocs[0], converted[0]);
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    for (size_t worker = 0; result && (worker < workers); ++worker) {
+        if (worker > 0U && (nullptr != allocs[worker].arena)) {
+            allocs[worker].arena->seal();
+        }
+        if (!results[worker]) {
+            result = results[worker];
+        }else{
+            for (auto& [key, value] : converted[worker]) {
+                (void)map.emplace(std::move(key), std::move(value));
+            }
+        }
+    }
+
+    return result;
+}
+
+/* Helper Function to parse JSON data for open_json (json_parser: parser of another thread, nullptr: parser of the KVS) */
+score::Result<KvsMap> Kvs::parse_json_data(const std::string& data, const KvsElementAllocator& alloc, score::json::IJsonParser* json_parser) {
 
-    score::Result<unordered_map<std::string, KvsValue>> result = score::MakeUnexpected(ErrorCode::UnmappedError);
-    auto any_res = parser->FromBuffer(data);
+    score::Result<KvsMap> result = score::MakeUnexpected(ErrorCode::UnmappedError);
+    auto any_res = ((nullptr != json_parser) ? json_parser : parser.get())->FromBuffer(data);
 
     if (!any_res) {
         result = score::MakeUnexpected(ErrorCode::JsonParserError);
     }else{
         score::json::Any root = std::move(any_res).value();
-        std::unordered_map<std::string, KvsValue> result_value;
+        KvsMap result_value{KvsMap::allocator_type(alloc)};
 
         if (auto obj = root.As<score::json::Object>(); obj.has_value()) {
             bool error = false;
-            for (const auto& element : obj.value().get()) {
-                auto sv = element.first.GetAsStringView();
-                std::string key(sv.data(), sv.size());
-
-                auto conv = any_to_kvsvalue(element.second);
-                if (!conv) {
-                    result = score::MakeUnexpected(static_cast<ErrorCode>(*conv.error()));
+            const size_t workers = std::min(options.open_workers, obj.value().get().size() / PARALLEL_PARSE_MIN_ENTRIES);
+            if (workers > 1U) {
+                auto convert_res = convert_json_entries_parallel(obj.value().get(), workers, alloc, result_value);
+                if (!convert_res) {
+                    result = score::MakeUnexpected(static_cast<ErrorCode>(*convert_res.error()));
                     error = true;
-                    break;
-                }else{
-                    result_value.emplace(std::move(key), std::move(conv.value()));
+                }
+            }else{
+                for (const auto& element : obj.value().get()) {
+                    auto sv = element.first.GetAsStringView();
+                    std::string key(sv.data(), sv.size());
+
+                    auto conv = any_to_kvsvalue(element.second, alloc);
+                    if (!conv) {
+                        result = score::MakeUnexpected(static_cast<ErrorCode>(*conv.error()));
+                        error = true;
+                        break;
+                    }else{
+                        result_value.emplace(std::move(key), std::move(conv.value()));
+                    }
                 }
             }
             if (!error) {
@@ -115,59 +345,134 @@ score::Result<std::unordered_map<std::string, KvsValue>> Kvs::parse_json_data(co
     return result;
 }
 
-/* Open and read JSON File */
-score::Result<std::unordered_map<string, KvsValue>> Kvs::open_json(const score::filesystem::Path& prefix, OpenJsonNeedFile need_file)
+/* Determine the storage format the data with the given prefix is available in (configured format first) */
+score::Result<std::optional<KvsStorageFormat>> Kvs::find_data_format(const std::string& prefix) const {
+    score::Result<std::optional<KvsStorageFormat>> result = score::MakeUnexpected(ErrorCode::UnmappedError);
+    const std::array<KvsStorageFormat, 2> formats = {options.format, get_other_format(options.format)};
+    std::optional<KvsStorageFormat> found;
+    bool error = false;
+    for (const KvsStorageFormat format : formats) {
+        const auto fname_exists_res = backend->exists(prefix + get_data_extension(format));
+        if (!fname_exists_res) {
+            result = score::MakeUnexpected(static_cast<ErrorCode>(*fname_exists_res.error()));
+            error = true;
+            break;
+        }else if (true == fname_exists_res.value()) {
+            found = format;
+            break;
+        }
+    }
+    if (!error) {
+        result = found;
+    }
+
+    return result;
+}
+
+/* Open and read JSON or binary File */
+score::Result<KvsMap> Kvs::open_file(const score::filesystem::Path& prefix, KvsStorageFormat format, OpenJsonNeedFile need_file,
+                                     bool lazy, score::json::IJsonParser* json_parser)
 {
-    score::filesystem::Path json_file = prefix.Native() + ".json";
+    score::filesystem::Path data_file = prefix.Native() + get_data_extension(format);
     score::filesystem::Path hash_file = prefix.Native() + ".hash";
     std::string data;
     bool error = false; /* Error flag */
     bool new_kvs = false; /* Flag to check if new KVS file is created*/
-    score::Result<std::unordered_map<string, KvsValue>> result = score::MakeUnexpected(ErrorCode::UnmappedError);
+    score::Result<KvsMap> result = score::MakeUnexpected(ErrorCode::UnmappedError);
 
-    /* Read JSON file */
-    ifstream in(json_file.CStr());
-    if (!in) {
+    /* Read data file */
+    auto in = backend->open_read(data_file.Native());
+    if (nullptr == in) {
         if (need_file == OpenJsonNeedFile::Required) {
-            logger->LogError() << "error: file " << json_file << " could not be read";
+            logger->LogError() << "error: file " << data_file << " could not be read";
             error = true;
             result = score::MakeUnexpected(ErrorCode::KvsFileReadError);
         }else{
-            logger->LogInfo() << "file " << json_file << " not found, using empty data";
+            logger->LogInfo() << "file " << data_file << " not found, using empty data";
             new_kvs = true;
-            result = score::Result<std::unordered_map<string,KvsValue>>({});
+            result = score::Result<KvsMap>({});
+        }
+    }
+
+    /* Read Hash (first, so the data is verified while it is read) */
+    KvsHashAlgorithm algorithm = KvsHashAlgorithm::Adler32;
+    uint32_t expected_hash = 0;
+    bool hash_missing = false;
+    bool hash_valid = false;
+    if((!error) && (!new_kvs)){
+        auto hin = backend->open_read(hash_file.Native());
+        if (nullptr == hin) {
+            hash_missing = true;
+        }else{
+            hash_valid = parse_hash_file(*hin, algorithm, expected_hash);
         }
-    }else{
-        ostringstream ss;
-        ss << in.rdbuf();
-        data = ss.str();
     }
 
-    /* Verify JSON Hash */
+    /* Read data file and verify Hash in a single pass (or the pending hash of an interrupted flush) */
     if((!error) && (!new_kvs)){
-        ifstream hin(hash_file.CStr(), ios::binary);
-        if (!hin) {
+        const KvsStatsTimer timer(*stats_recorder, KvsOperation::HashVerify);
+        uint32_t hash = 0;
+        if (!read_stream_hashed(*in, algorithm, data, hash)) {
+            logger->LogError() << "error: file " << data_file << " could not be read";
+            error = true;
+            result = score::MakeUnexpected(ErrorCode::KvsFileReadError);
+        }else if (hash_valid && (hash == expected_hash)) {
+            logger->LogInfo() << "KVS data has valid hash";
+        }else if (recover_hash_file(*backend, hash_file.Native(), data)) {
+            logger->LogInfo() << "KVS data has valid hash, interrupted flush of " << data_file << " completed";
+        }else if (hash_missing) {
             logger->LogError() << "error: hash file " << hash_file << " could not be read";
             error = true;
             result = score::MakeUnexpected(ErrorCode::KvsHashFileReadError);
+        }else{
+            logger->LogError() << "error: KVS data corrupted (" << data_file << ", " << hash_file << ")";
+            stats_recorder->count(KvsCounter::ValidationFailure);
+            error = true;
+            result = score::MakeUnexpected(ErrorCode::ValidationFailed);
+        }
+    }
 
+    /* Decompress Data (compressed files are detected by their header, the hash covers the compressed data) */
+    if((!error) && (!new_kvs) && is_compressed(data)){
+        auto raw_res = decompress_data(data);
+        if (!raw_res) {
+            logger->LogError() << "error: decompressing " << data_file << " failed";
+            stats_recorder->count(KvsCounter::ValidationFailure);
+            error = true;
+            result = score::MakeUnexpected(static_cast<ErrorCode>(*raw_res.error()));
         }else{
-            bool valid_hash = check_hash(data, hin);
-            if(!valid_hash){
-                logger->LogError() << "error: KVS data corrupted (" << json_file << ", " << hash_file << ")";
-                error = true;
-                result = score::MakeUnexpected(ErrorCode::ValidationFailed);
-            }else{
-                logger->LogInfo() << "JSON data has valid hash";
-            }
+            data = std::move(raw_res.value());
         }
     }
 
-    /* Parse JSON Data */
-    if((!error) && (!new_kvs)){
-        auto parse_res = parse_json_data(data);
+    /* Index Data (the values are decoded from the retained data by their first access) */
+    if((!error) && (!new_kvs) && lazy){
+        const KvsStatsTimer timer(*stats_recorder, KvsOperation::Parse);
+        auto lazy_file = std::make_unique<const std::string>(std::move(data));
+        auto index_res = (KvsStorageFormat::Binary == format) ? binary_index_map(*lazy_file) : json_index_map(*lazy_file);
+        if (!index_res) {
+            logger->LogError() << "error: indexing " << ((KvsStorageFormat::Binary == format) ? "binary" : "JSON") << " data failed";
+            error = true;
+            result = score::MakeUnexpected(static_cast<ErrorCode>(*index_res.error()));
+        }else{
+            lazy_data = std::move(lazy_file);
+            lazy_kvs = std::move(index_res.value());
+            lazy_format = format;
+            result = score::Result<KvsMap>({});
+        }
+    }
+
+    /* Parse Data */
+    if((!error) && (!new_kvs) && (!lazy)){
+        const KvsStatsTimer timer(*stats_recorder, KvsOperation::Parse);
+        /* With KvsOptions::arena the file gets its own arena, sealed once the data is parsed */
+        const KvsElementAllocator alloc(options.arena ? std::make_shared<KvsArena>() : nullptr);
+        auto parse_res = (KvsStorageFormat::Binary == format) ? binary_decode_map(data, alloc) : parse_json_data(data, alloc, json_parser);
+        if (nullptr != alloc.arena) {
+            alloc.arena->seal();
+        }
         if (!parse_res) {
-            logger->LogError() << "error: parsing JSON data failed";
+            logger->LogError() << "error: parsing " << ((KvsStorageFormat::Binary == format) ? "binary" : "JSON") << " data failed";
             error = true;
             result = score::MakeUnexpected(static_cast<ErrorCode>(*parse_res.error()));
         }else{
@@ -178,35 +483,227 @@ score::Result<std::unordered_map<string, KvsValue>> Kvs::open_json(const score::
     return result;
 }
 
+/* Open and read JSON File */
+score::Result<KvsMap> Kvs::open_json(const score::filesystem::Path& prefix, OpenJsonNeedFile need_file,
+                                     score::json::IJsonParser* json_parser)
+{
+    return open_file(prefix, KvsStorageFormat::Json, need_file, false, json_parser);
+}
+
+/* Open and read the KVS data in the format it is available in (migration from the other format) */
+score::Result<KvsMap> Kvs::open_data(const score::filesystem::Path& prefix, OpenJsonNeedFile need_file, bool lazy)
+{
+    score::Result<KvsMap> result = score::MakeUnexpected(ErrorCode::UnmappedError);
+    auto format_res = find_data_format(prefix.Native());
+    if (!format_res) {
+        result = score::MakeUnexpected(ErrorCode::PhysicalStorageFailure);
+    }else{
+        const KvsStorageFormat format = format_res.value().value_or(options.format);
+        if (format != options.format) {
+            logger->LogInfo() << "file " << prefix << get_data_extension(format) << " is converted to "
+                              << get_data_extension(options.format) << " on the next flush";
+        }
+        result = open_file(prefix, format, need_file, lazy);
+    }
+
+    return result;
+}
+
+/* Open the default values (memory-mapped defaults image if enabled and up to date, JSON otherwise).
+   A reader of the shared data always uses the image, so the reader processes keep no heap copy of the defaults. */
+score::ResultBlank Kvs::open_defaults(const score::filesystem::Path& prefix, OpenJsonNeedFile need_file,
+                                      score::json::IJsonParser* json_parser)
+{
+    score::ResultBlank result = score::MakeUnexpected(ErrorCode::UnmappedError);
+    const std::string image_file = prefix.Native() + ".img";
+    bool image_loaded = false;
+    bool source_hash_valid = false;
+    uint32_t source_hash = 0;
+
+    const bool mapped = options.mapped_defaults || (KvsSharing::Reader == options.sharing);
+    if (mapped && backend->maps_files()) {
+        /* The image stores the hash of the JSON file it was built from, so only the hash file has to be read */
+        const score::filesystem::Path hash_file = prefix.Native() + ".hash";
+        auto hin = backend->open_read(hash_file.Native());
+        if (nullptr != hin) {
+            KvsHashAlgorithm source_algorithm = KvsHashAlgorithm::Adler32;
+            source_hash_valid = parse_hash_file(*hin, source_algorithm, source_hash);
+        }
+        if (source_hash_valid) {
+            auto image_res = DefaultsImage::open(image_file, source_hash);
+            if (image_res) {
+                default_image = std::move(image_res.value());
+                image_loaded = true;
+                logger->LogInfo() << "mapped defaults image " << image_file << " (" << default_image->size() << " entries)";
+                result = score::ResultBlank{};
+            }else{
+                logger->LogInfo() << "defaults image " << image_file << " not usable, reading JSON defaults";
+            }
+        }
+    }
+
+    if (!image_loaded) {
+        auto default_res = open_json(prefix, need_file, json_parser);
+        if (!default_res) {
+            result = score::MakeUnexpected(static_cast<ErrorCode>(*default_res.error()));
+        }else{
+            default_values = std::move(default_res.value());
+            if (source_hash_valid) {
+                /* Build the image for the next open, this instance keeps using the parsed defaults */
+                auto write_res = DefaultsImage::write(image_file, default_values, source_hash);
+                if (!write_res) {
+                    logger->LogError() << "error: could not write defaults image " << image_file;
+                }else if (KvsSharing::Reader == options.sharing) {
+                    /* A reader maps the image it just built and releases the parsed defaults */
+                    auto image_res = DefaultsImage::open(image_file, source_hash);
+                    if (image_res) {
+                        default_image = std::move(image_res.value());
+                        default_values = KvsMap();
+                    }
+                }
+            }
+            result = score::ResultBlank{};
+        }
+    }
+
+    return result;
+}
+
+/* Replay the log of the incremental flush on the opened KVS data (prefix of the current KVS file) */
+void Kvs::open_log(const score::filesystem::Path& prefix)
+{
+    const std::string log_file = filename_prefix.Native() + "_0.log";
+    full_flush_required = true;
+    base_hash = 0;
+    base_size = 0;
+    log_size = 0;
+
+    /* The log is only valid together with the KVS file it was written for */
+    const auto format_res = find_data_format(prefix.Native());
+    if (format_res && format_res.value().has_value()) {
+        const std::string data_file = prefix.Native() + get_data_extension(format_res.value().value());
+        const score::filesystem::Path hash_file = prefix.Native() + ".hash";
+        size_t data_size = 0;
+        auto hin = backend->open_read(hash_file.Native());
+        if (backend->size(data_file, data_size) && (nullptr != hin)) {
+            KvsHashAlgorithm base_algorithm = KvsHashAlgorithm::Adler32;
+            if (parse_hash_file(*hin, base_algorithm, base_hash)) {
+                base_size = data_size;
+                full_flush_required = false;
+            }
+        }
+    }
+
+    auto lin = backend->open_read(log_file);
+    if ((nullptr != lin) && full_flush_required) {
+        logger->LogInfo() << "ignoring log " << log_file << " (no KVS file available)";
+    }else if (nullptr != lin) {
+        std::string data;
+        (void)read_stream(*lin, data); /* A partially read log is handled like a torn record */
+        KvsChanges changes;
+        auto replay_res = lazy_kvs.empty() ? log_replay(data, base_hash, kvs) : log_replay_changes(data, base_hash, changes);
+        if (!replay_res) {
+            /* Stale log (e.g. interrupted full flush), it is replaced by the next flush */
+            logger->LogInfo() << "ignoring log " << log_file << " (it doesn't match the KVS file)";
+        }else{
+            for (auto& [key, value] : changes) {
+                /* Logged keys replace the indexed values of a lazily opened file (the slots are built after the log) */
+                (void)lazy_kvs.erase(key);
+                if (value.has_value()) {
+                    (void)kvs.insert_or_assign(key, std::move(value.value()));
+                }else{
+                    (void)kvs.erase(key);
+                }
+            }
+            log_size = replay_res.value();
+            if (log_size != data.size()) {
+                /* Torn record at the end, cut it off so later records are appended to a valid log */
+                logger->LogError() << "error: log " << log_file << " is truncated to " << log_size << " bytes";
+                if (!backend->truncate(log_file, log_size)) {
+                    full_flush_required = true;
+                }
+            }
+            logger->LogInfo() << "replayed log " << log_file;
+        }
+    }
+}
+
 /* Open KVS Instance */
-score::Result<Kvs> Kvs::open(const InstanceId& instance_id, OpenNeedDefaults need_defaults, OpenNeedKvs need_kvs, const std::string&& dir)
+score::Result<Kvs> Kvs::open(const InstanceId& instance_id, OpenNeedDefaults need_defaults, OpenNeedKvs need_kvs, const std::string&& dir, const KvsOptions& options)
 {
     score::Result<Kvs> result = score::MakeUnexpected(ErrorCode::UnmappedError); /* Redundant initialization needed, since Resul<KVS> would call the implicitly-deleted default constructor of KVS */
+    const std::chrono::steady_clock::time_point open_start =
+        KVS_STATS_ENABLED ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point{};
 
     score::filesystem::Path base_path(dir);
     score::filesystem::Path filename_prefix = base_path / ("kvs_" + std::to_string(instance_id.id));
     const score::filesystem::Path filename_default = filename_prefix.Native() + "_default";
-    const score::filesystem::Path filename_kvs = filename_prefix.Native() + "_0";
 
     Kvs kvs; /* Create KVS instance */
-    auto default_res = kvs.open_json(
-        filename_default,
-        need_defaults == OpenNeedDefaults::Required ? OpenJsonNeedFile::Required : OpenJsonNeedFile::Optional);
+    kvs.options = options;
+    kvs.filename_prefix = filename_prefix;
+    if (nullptr != options.backend) {
+        kvs.backend = options.backend;
+    }
+    kvs.stats_recorder->trace_hook = options.trace_hook;
+    const OpenJsonNeedFile need_default_file =
+        (need_defaults == OpenNeedDefaults::Required) ? OpenJsonNeedFile::Required : OpenJsonNeedFile::Optional;
+    const bool concurrent_defaults = (options.open_workers > 1U);
+    std::future<score::ResultBlank> default_future;
+    score::ResultBlank default_res = score::ResultBlank{};
+    if (concurrent_defaults) {
+        /* The defaults only touch default_values and default_image, the KVS data is read meanwhile.
+           The JSON parser isn't thread-safe, the defaults are parsed by a parser of their own. */
+        default_future = std::async(std::launch::async, [&kvs, &filename_default, need_default_file]() {
+            score::json::JsonParser default_parser;
+            return kvs.open_defaults(filename_default, need_default_file, &default_parser);
+        });
+    }else{
+        default_res = kvs.open_defaults(filename_default, need_default_file);
+    }
+
+    score::ResultBlank manifest_res = score::MakeUnexpected(ErrorCode::UnmappedError);
+    score::Result<KvsMap> kvs_res = score::MakeUnexpected(ErrorCode::UnmappedError);
+    score::filesystem::Path filename_kvs;
+    if (KvsSharing::Reader == options.sharing) {
+        /* The data is read from the segment of the owner, the files of the KVS are not opened */
+        manifest_res = score::ResultBlank{};
+        kvs_res = KvsMap();
+    }else if (concurrent_defaults || default_res) {
+        manifest_res = (KvsSnapshotLayout::Generations == options.snapshot_layout) ? kvs.open_manifest() : score::ResultBlank{};
+        if (manifest_res) {
+            filename_kvs = kvs.snapshot_prefix(0);
+            kvs_res = kvs.open_data(
+                filename_kvs,
+                need_kvs == OpenNeedKvs::Required ? OpenJsonNeedFile::Required : OpenJsonNeedFile::Optional,
+                options.lazy_values);
+        }
+    }
+    if (concurrent_defaults) {
+        default_res = default_future.get();
+    }
+
     if (!default_res){
         result = score::MakeUnexpected(static_cast<ErrorCode>(*default_res.error())); /* Dereferences the Error class to its underlying code -> error.h*/
     }
-    else{
-        auto kvs_res = kvs.open_json(
-            filename_kvs,
-            need_kvs == OpenNeedKvs::Required ? OpenJsonNeedFile::Required : OpenJsonNeedFile::Optional);
-        if (!kvs_res){
-            result = score::MakeUnexpected(static_cast<ErrorCode>(*kvs_res.error()));
-        }else{
-            kvs.kvs = std::move(kvs_res.value());
-            kvs.default_values = std::move(default_res.value());
-            kvs.filename_prefix = filename_prefix;
+    else if (!manifest_res){
+        result = score::MakeUnexpected(static_cast<ErrorCode>(*manifest_res.error()));
+    }
+    else if (!kvs_res){
+        result = score::MakeUnexpected(static_cast<ErrorCode>(*kvs_res.error()));
+    }else{
+        kvs.kvs = std::move(kvs_res.value());
+        if (KvsSharing::Reader != options.sharing) {
+            kvs.open_log(filename_kvs);
+        }
+        kvs.rebuild_slots();
+        auto shared_res = kvs.open_shared();
+        if (!shared_res) {
+            result = score::MakeUnexpected(static_cast<ErrorCode>(*shared_res.error()));
+        }else{
             kvs.logger->LogInfo() << "opened KVS: instance '" << instance_id.id << "'";
-            kvs.logger->LogInfo() << "max snapshot count: " << KVS_MAX_SNAPSHOTS;
+            kvs.logger->LogInfo() << "max snapshot count: " << options.snapshot_max_count;
+            kvs.stats_recorder->record(KvsOperation::Open, open_start);
             result = std::move(kvs);
         }
     }
@@ -214,196 +711,1327 @@ score::Result<Kvs> Kvs::open(const InstanceId& instance_id, OpenNeedDefaults nee
     return result;
 }
 
-/* Reset KVS to initial state*/
-score::ResultBlank Kvs::reset() {
+/* Create the segment of the owner (and publish the opened data) or attach the segment of the owner as reader */
+score::ResultBlank Kvs::open_shared() {
     score::ResultBlank result = score::MakeUnexpected(ErrorCode::UnmappedError);
-    std::unique_lock<std::mutex> lock(kvs_mutex, std::try_to_lock);
-    if (lock.owns_lock()) {
-        kvs.clear();
-        result = score::ResultBlank{};
+    const std::string name = SharedStore::segment_name(filename_prefix.Native());
+    if (KvsSharing::Owner == options.sharing) {
+        auto create_res = SharedStore::create(name, options.shared_size);
+        if (!create_res) {
+            logger->LogError() << "error: shared memory " << name << " could not be created";
+            result = score::MakeUnexpected(static_cast<ErrorCode>(*create_res.error()));
+        }else{
+            shared = std::move(create_res.value());
+            result = publish();
+        }
+    }else if (KvsSharing::Reader == options.sharing) {
+        auto attach_res = SharedStore::attach(name);
+        if (!attach_res) {
+            logger->LogError() << "error: shared memory " << name << " of the owner could not be attached";
+            result = score::MakeUnexpected(static_cast<ErrorCode>(*attach_res.error()));
+        }else{
+            shared = std::move(attach_res.value());
+            result = score::ResultBlank{};
+        }
     }else{
-        result = score::MakeUnexpected(ErrorCode::MutexLockFailed);
+        result = score::ResultBlank{};
     }
 
     return result;
 }
 
-/* Retrieve all keys in the KVS*/
-score::Result<std::vector<std::string>> Kvs::get_all_keys() {
-    score::Result<std::vector<std::string>> result = score::MakeUnexpected(ErrorCode::UnmappedError);
-    std::unique_lock<std::mutex> lock(kvs_mutex, std::try_to_lock);
-    if (lock.owns_lock()) {
-        std::vector<std::string> keys;
-        keys.reserve(kvs.size());
-        for (const auto& [key, _] : kvs) {
-            keys.emplace_back(key);
-        }
-        result = std::move(keys);
+/* Publish the current data for the readers */
+score::ResultBlank Kvs::publish() {
+    score::ResultBlank result = score::MakeUnexpected(ErrorCode::UnmappedError);
+    if (KvsSharing::Reader == options.sharing) {
+        result = score::MakeUnexpected(ErrorCode::ReadOnly);
+    }else if (nullptr == shared) {
+        result = score::ResultBlank{}; /* Not shared */
     }else{
-        result = score::MakeUnexpected(ErrorCode::MutexLockFailed);
+        score::ResultBlank lazy_res = score::ResultBlank{};
+        if (options.lazy_values) {
+            /* The image contains encoded values, the remaining values of a lazily opened file are decoded once */
+            std::unique_lock<std::shared_mutex> lock = lock_exclusive();
+            if (lock.owns_lock()) {
+                lazy_res = materialize_lazy();
+            }else{
+                lazy_res = score::MakeUnexpected(ErrorCode::MutexLockFailed);
+            }
+        }
+        if (!lazy_res) {
+            result = score::MakeUnexpected(static_cast<ErrorCode>(*lazy_res.error()));
+        }else{
+            /* Publishing under the shared lock keeps the order of concurrent publishes (no writer in between) */
+            std::shared_lock<std::shared_mutex> lock = lock_shared();
+            if (!lock.owns_lock()) {
+                result = score::MakeUnexpected(ErrorCode::MutexLockFailed);
+            }else{
+                auto image_res = image_encode(kvs, 0U); /* No source file whose changes are detected */
+                if (!image_res) {
+                    result = score::MakeUnexpected(static_cast<ErrorCode>(*image_res.error()));
+                }else{
+                    result = shared->publish(image_res.value());
+                }
+            }
+        }
+        if (!result) {
+            logger->LogError() << "error: KVS data could not be published";
+            stats_recorder->count(KvsCounter::PublishFailure);
+        }
     }
 
     return result;
 }
 
-/* Check if a key exists*/
-score::Result<bool> Kvs::key_exists(const std::string_view key) {
-    score::Result<bool> result = score::MakeUnexpected(ErrorCode::UnmappedError);
-    std::unique_lock<std::mutex> lock(kvs_mutex, std::try_to_lock);
-    if (lock.owns_lock()) {
-        auto search = kvs.find(std::string(key)); /* unordered_map find() needs string and doesnt work with string_view, workaround for c++20: heterogeneous lookup (applies to more functions) */
-        if (search != kvs.end()) {
-            result = true;
-        } else {
-            result = false;
-        }
-    }else{
-        result = score::MakeUnexpected(ErrorCode::MutexLockFailed);
+/* Queue a change for the subscribers, value is nullptr for a removed key (kvs_mutex must be held exclusively) */
+void Kvs::notify_change(const std::string_view key, const KvsValue* value) {
+    if ((nullptr != notifier) && notifier->active()) {
+        notifier->post(KvsChange{std::string(key), (nullptr != value) ? std::optional<KvsValue>(*value) : std::nullopt});
     }
-
-    return result;
 }
 
-/* Retrieve the value associated with a key*/
-score::Result<KvsValue> Kvs::get_value(const std::string_view key) {
-    score::Result<KvsValue> result = score::MakeUnexpected(ErrorCode::UnmappedError);
-    std::unique_lock<std::mutex> lock_kvs(kvs_mutex, std::try_to_lock);
-    if (lock_kvs.owns_lock()){
-        auto search_kvs = kvs.find(std::string(key));
-        if (search_kvs != kvs.end()) {
-            result = search_kvs->second;
-        } else {
-            auto search_default = default_values.find(std::string(key));
-            if (search_default != default_values.end()) {
-                result = search_default->second;
-            } else {
-                result = score::MakeUnexpected(ErrorCode::KeyNotFound);
+/* Queue the changes of replacing all data by new data, only differing keys are changed (kvs_mutex must be held exclusively) */
+void Kvs::notify_replaced(const KvsMap& data) {
+    if ((nullptr != notifier) && notifier->active()) {
+        std::vector<KvsChange> changes;
+        for (const auto& [key, _] : kvs) {
+            if (data.find(key) == data.end()) {
+                changes.push_back(KvsChange{key, std::nullopt});
             }
         }
+        for (const auto& [key, _] : lazy_kvs) {
+            if (data.find(key) == data.end()) {
+                changes.push_back(KvsChange{key, std::nullopt});
+            }
+        }
+        for (const auto& [key, value] : data) {
+            auto search = kvs.find(key);
+            /* Values of a lazily opened file are not decoded for the comparison, they count as changed */
+            if ((search == kvs.end()) || (!(search->second == value))) {
+                changes.push_back(KvsChange{key, value});
+            }
+        }
+        notifier->post(std::move(changes));
     }
-    else{
-        result = score::MakeUnexpected(ErrorCode::MutexLockFailed);
-    }
+}
 
-    return result;
+/* Subscribe to the changes of a key */
+score::Result<KvsSubscriptionId> Kvs::subscribe(const std::string_view key, KvsChangeCallback callback) {
+    return subscribe_changes(key, false, std::move(callback));
 }
 
-/*Retrieve the default value associated with a key*/
-score::Result<KvsValue> Kvs::get_default_value(const std::string_view key) {
-    score::Result<KvsValue> result = score::MakeUnexpected(ErrorCode::UnmappedError);
+/* Subscribe to the changes of all keys with a prefix */
+score::Result<KvsSubscriptionId> Kvs::subscribe_prefix(const std::string_view prefix, KvsChangeCallback callback) {
+    return subscribe_changes(prefix, true, std::move(callback));
+}
 
-    auto search = default_values.find(std::string(key));
-    if (search != default_values.end()) {
-        result = search->second;
-    } else {
-        result = score::MakeUnexpected(ErrorCode::KeyNotFound);
+/* Add a subscriber to the notifier */
+score::Result<KvsSubscriptionId> Kvs::subscribe_changes(const std::string_view key, bool prefix, KvsChangeCallback callback) {
+    score::Result<KvsSubscriptionId> result = score::MakeUnexpected(ErrorCode::UnmappedError);
+    if (KvsSharing::Reader == options.sharing) {
+        result = score::MakeUnexpected(ErrorCode::ReadOnly); /* Changes are made (and notified) by the owner */
+    }else if (!callback) {
+        result = score::MakeUnexpected(ErrorCode::ValidationFailed);
+    }else{
+        result = notifier->subscribe(key, prefix, std::move(callback));
     }
 
     return result;
 }
 
-/* Resets a Key to its default value (Deletes written key if default is available) */
-score::ResultBlank Kvs::reset_key(const std::string_view key)
-{
+/* Remove a subscription */
+score::ResultBlank Kvs::unsubscribe(KvsSubscriptionId id) {
     score::ResultBlank result = score::MakeUnexpected(ErrorCode::UnmappedError);
-    std::unique_lock<std::mutex> lock_kvs(kvs_mutex, std::try_to_lock);
-    if (!lock_kvs.owns_lock()) {
-        result = score::MakeUnexpected(ErrorCode::MutexLockFailed);
-    }
-    else {
-        auto search_default = default_values.find(std::string(key));
-        if (search_default == default_values.end()) {
-            result = score::MakeUnexpected(ErrorCode::KeyDefaultNotFound);
-        }
-        else {
-            auto search_kvs = kvs.find(std::string(key));
-            if (search_kvs != kvs.end()) {
-                (void)kvs.erase(std::string(key)); /* Return Value ignored, since its already secured, that the key exists*/
-                result = score::ResultBlank{};
-            }else{
-                result = score::ResultBlank{};
-            }
-        }
+    if (notifier->unsubscribe(id)) {
+        result = score::ResultBlank{};
+    }else{
+        result = score::MakeUnexpected(ErrorCode::KeyNotFound);
     }
 
     return result;
 }
 
-/* Check if a key has a default value*/
-score::Result<bool> Kvs::has_default_value(const std::string_view key) {
-    score::Result<bool> result = score::MakeUnexpected(ErrorCode::UnmappedError);
+/* Wait until the changes made so far are delivered */
+void Kvs::wait_notifications() {
+    notifier->wait();
+}
 
-    auto search = default_values.find(std::string(key)); /* unordered_map find() needs string and doesnt work with string_view, workaround for c++20: heterogeneous lookup (applies to more functions) */
-    if (search != default_values.end()) {
-        result = true;
-    } else {
-        result = false;
+/* Record a changed key for the incremental flush (kvs_mutex must be held exclusively) */
+void Kvs::mark_dirty(const std::string_view key) {
+    if (KvsFlushMode::Incremental == options.flush_mode) {
+        auto search = dirty_keys.lower_bound(key);
+        if ((search == dirty_keys.end()) || (*search != key)) {
+            (void)dirty_keys.emplace_hint(search, key);
+        }
+    }
+}
+
+/* Find the written or the default value of a key, ErrorCode::KeyNotFound if there is none
+   (kvs_mutex must be held, except by a reader of the shared data) */
+score::Result<const KvsValue*> Kvs::find_value(const std::string_view key, std::optional<KvsValue>& copy) {
+    score::Result<const KvsValue*> result = score::MakeUnexpected(ErrorCode::UnmappedError);
+    if (KvsSharing::Reader == options.sharing) {
+        /* The published value is copied out of the segment, the owner may replace it at any time */
+        auto shared_res = shared->find(key);
+        if (!shared_res) {
+            result = score::MakeUnexpected(static_cast<ErrorCode>(*shared_res.error()));
+        }else if (shared_res.value().has_value()) {
+            copy = std::move(shared_res.value());
+            result = &copy.value();
+        }else{
+            result = slot_value(slots.find(key), key, copy); /* The slots of a reader only hold its defaults */
+        }
+    }else{
+        result = slot_value(slots.find(key), key, copy);
+    }
+
+    return result;
+}
+
+/* Look the key of a handle up again if keys were added or removed since its last lookup (kvs_mutex must be held) */
+/* Generations are unique in the process: (owner, generation) of a handle is never reused by another KVS at the same address */
+uint64_t Kvs::next_key_generation() {
+    static std::atomic<uint64_t> counter(0);
+    return counter.fetch_add(1U, std::memory_order_relaxed) + 1U;
+}
+
+void Kvs::resolve_handle(KeyHandle& handle) {
+    if ((this != handle.owner) || (key_generation != handle.generation)) {
+        handle.owner = this;
+        handle.generation = key_generation;
+        handle.slot = slots.find(handle.name);
+    }
+}
+
+/* Build the slots of all keys after kvs, lazy_kvs or default_values were replaced (kvs_mutex must be held exclusively) */
+void Kvs::rebuild_slots() {
+    slots.clear();
+    slots.reserve(kvs.size() + lazy_kvs.size() + default_values.size());
+    for (const auto& [key, value] : default_values) {
+        slots[key].default_value = &value; /* First, so a slot with a default refers to the key of the default */
+    }
+    for (auto entry = kvs.begin(); entry != kvs.end(); ++entry) {
+        slots[entry->first].value = entry;
+    }
+    for (auto entry = lazy_kvs.begin(); entry != lazy_kvs.end(); ++entry) {
+        slots[entry->first].lazy = entry;
+    }
+    key_generation = next_key_generation();
+}
+
+/* Add a key just written to kvs to its slot, a slot of a default keeps referring to the key of the default
+   (kvs_mutex must be held exclusively, the key has no indexed value) */
+KvsSlotMap::iterator Kvs::insert_slot(KvsMap::iterator entry) {
+    auto slot = slots.try_emplace(entry->first).first;
+    slot->second.value = entry;
+    key_generation = next_key_generation();
+
+    return slot;
+}
+
+/* Erase the written or the indexed value of a slot, the slot is kept while the key has a default
+   (kvs_mutex must be held exclusively), returns the kept slot or the end of the slots */
+KvsSlotMap::iterator Kvs::erase_entry(KvsSlotMap::iterator slot) {
+    KvsSlotMap::iterator result = slot;
+    const std::optional<KvsMap::iterator> value = slot->second.value;
+    const std::optional<KvsLazyMap::iterator> lazy = slot->second.lazy;
+    if (nullptr == slot->second.default_value) {
+        (void)slots.erase(slot); /* Before the entry whose key the slot refers to */
+        result = slots.end();
+    }else{
+        slot->second.value.reset();
+        slot->second.lazy.reset();
+    }
+    if (value.has_value()) {
+        (void)kvs.erase(value.value());
+    }
+    if (lazy.has_value()) {
+        (void)lazy_kvs.erase(lazy.value());
+    }
+    key_generation = next_key_generation();
+
+    return result;
+}
+
+/* Resolve the value of a slot: the written value, the indexed value (decoded on first access) or the default,
+   a key without a default in its slot is looked up in the defaults image (kvs_mutex must be held) */
+score::Result<const KvsValue*> Kvs::slot_value(KvsSlotMap::iterator slot, const std::string_view key, std::optional<KvsValue>& copy) {
+    score::Result<const KvsValue*> result = score::MakeUnexpected(ErrorCode::UnmappedError);
+    const KvsKeySlot* entries = (slot != slots.end()) ? &slot->second : nullptr;
+    if ((nullptr != entries) && entries->value.has_value()) {
+        result = &entries->value.value()->second;
+    }else if ((nullptr != entries) && entries->lazy.has_value()) {
+        result = lazy_value(entries->lazy.value()->second);
+    }else if ((nullptr != entries) && (nullptr != entries->default_value)) {
+        result = entries->default_value;
+    }else if (nullptr != default_image) {
+        /* Values of the defaults image are decoded on access */
+        auto image_res = default_image->find(key);
+        if (image_res) {
+            copy = std::move(image_res.value());
+            result = &copy.value();
+        }else{
+            result = score::MakeUnexpected(static_cast<ErrorCode>(*image_res.error()));
+        }
+    }else{
+        result = score::MakeUnexpected(ErrorCode::KeyNotFound);
+    }
+
+    return result;
+}
+
+/* Find the written or the default value of a handle, ErrorCode::KeyNotFound if there is none (kvs_mutex must be held) */
+score::Result<const KvsValue*> Kvs::handle_value(KeyHandle& handle, std::optional<KvsValue>& copy) {
+    resolve_handle(handle);
+    return slot_value(handle.slot, handle.name, copy);
+}
+
+/* Decode a value of a lazily opened file by its first access (kvs_mutex must be held) */
+score::Result<const KvsValue*> Kvs::lazy_value(KvsLazyValue& entry) {
+    score::Result<const KvsValue*> result = score::MakeUnexpected(ErrorCode::UnmappedError);
+    /* Readers share kvs_mutex, the first of them decodes the value, the others wait for it */
+    std::lock_guard<std::mutex> lock(lazy_mutex);
+    if (entry.value.has_value()) {
+        result = &entry.value.value();
+    }else if (KvsStorageFormat::Binary == lazy_format) {
+        size_t offset = 0;
+        auto decode_res = binary_decode_value(entry.data, offset);
+        if (!decode_res) {
+            result = score::MakeUnexpected(static_cast<ErrorCode>(*decode_res.error()));
+        }else{
+            entry.value = std::move(decode_res.value());
+            result = &entry.value.value();
+        }
+    }else{
+        /* Own parser, snapshot_restore() parses its snapshot with the parser of the KVS concurrently */
+        score::json::JsonParser lazy_parser;
+        auto any_res = lazy_parser.FromBuffer(entry.data);
+        if (!any_res) {
+            result = score::MakeUnexpected(ErrorCode::JsonParserError);
+        }else{
+            auto conv = any_to_kvsvalue(any_res.value());
+            if (!conv) {
+                result = score::MakeUnexpected(static_cast<ErrorCode>(*conv.error()));
+            }else{
+                entry.value = std::move(conv.value());
+                result = &entry.value.value();
+            }
+        }
+    }
+
+    return result;
+}
+
+/* Drop the indexed value of a key that is written or removed, returns whether it was indexed (kvs_mutex must be held exclusively) */
+bool Kvs::drop_lazy(KvsSlotMap::iterator slot) {
+    bool result = false;
+    if ((slot != slots.end()) && slot->second.lazy.has_value()) {
+        (void)erase_entry(slot);
+        result = true;
+    }
+
+    return result;
+}
+
+/* Move all values of a lazily opened file into kvs, decodes the ones not accessed yet (kvs_mutex must be held exclusively) */
+score::ResultBlank Kvs::materialize_lazy() {
+    score::ResultBlank result = score::ResultBlank{};
+    const bool indexed = !lazy_kvs.empty();
+    while (result && (!lazy_kvs.empty())) {
+        auto value_res = lazy_value(lazy_kvs.begin()->second);
+        if (!value_res) {
+            logger->LogError() << "error: value of key " << lazy_kvs.begin()->first << " could not be decoded";
+            result = score::MakeUnexpected(static_cast<ErrorCode>(*value_res.error()));
+        }else{
+            /* The keys are sorted, the node is moved without copying the key */
+            auto node = lazy_kvs.extract(lazy_kvs.begin());
+            (void)kvs.emplace(std::move(node.key()), std::move(node.mapped().value.value()));
+        }
+    }
+    if (indexed) {
+        rebuild_slots(); /* The moved keys no longer belong to lazy_kvs */
+    }
+    if (result) {
+        lazy_data.reset();
+    }
+
+    return result;
+}
+
+/* Reset KVS to initial state*/
+score::ResultBlank Kvs::reset() {
+    score::ResultBlank result = score::MakeUnexpected(ErrorCode::UnmappedError);
+    std::unique_lock<std::shared_mutex> lock = lock_exclusive();
+    if (KvsSharing::Reader == options.sharing) {
+        result = score::MakeUnexpected(ErrorCode::ReadOnly);
+    }else if (lock.owns_lock()) {
+        notify_replaced(KvsMap());
+        KvsMap().swap(kvs); /* Unlike clear(), also releases the arena of the loaded data */
+        lazy_kvs.clear();
+        rebuild_slots(); /* Only the slots of the defaults remain */
+        lazy_data.reset();
+        dirty_keys.clear();
+        full_flush_required = true; /* Removing all keys is cheaper as a full flush */
+        result = score::ResultBlank{};
+    }else{
+        result = score::MakeUnexpected(ErrorCode::MutexLockFailed);
+    }
+
+    return result;
+}
+
+/* Retrieve all keys in the KVS*/
+score::Result<std::vector<std::string>> Kvs::get_all_keys() {
+    score::Result<std::vector<std::string>> result = score::MakeUnexpected(ErrorCode::UnmappedError);
+    std::shared_lock<std::shared_mutex> lock = lock_shared();
+    if (KvsSharing::Reader == options.sharing) {
+        auto shared_res = shared->scan("");
+        if (!shared_res) {
+            result = score::MakeUnexpected(static_cast<ErrorCode>(*shared_res.error()));
+        }else{
+            std::vector<std::string> keys;
+            keys.reserve(shared_res.value().size());
+            for (auto& [key, _] : shared_res.value()) {
+                keys.emplace_back(std::move(key));
+            }
+            result = std::move(keys);
+        }
+    }else if (lock.owns_lock()) {
+        std::vector<std::string> keys;
+        keys.reserve(kvs.size() + lazy_kvs.size());
+        for (const auto& [key, _] : kvs) {
+            keys.emplace_back(key);
+        }
+        if (!lazy_kvs.empty()) {
+            /* Both maps are sorted, the keys stay in ascending order */
+            const auto middle = static_cast<std::ptrdiff_t>(keys.size());
+            for (const auto& [key, _] : lazy_kvs) {
+                keys.emplace_back(key);
+            }
+            std::inplace_merge(keys.begin(), keys.begin() + middle, keys.end());
+        }
+        result = std::move(keys);
+    }else{
+        result = score::MakeUnexpected(ErrorCode::MutexLockFailed);
+    }
+
+    return result;
+}
+
+/* Check if a key exists*/
+score::Result<bool> Kvs::key_exists(const std::string_view key) {
+    score::Result<bool> result = score::MakeUnexpected(ErrorCode::UnmappedError);
+    std::shared_lock<std::shared_mutex> lock = lock_shared();
+    if (KvsSharing::Reader == options.sharing) {
+        auto shared_res = shared->find(key);
+        if (!shared_res) {
+            result = score::MakeUnexpected(static_cast<ErrorCode>(*shared_res.error()));
+        }else{
+            result = shared_res.value().has_value();
+        }
+    }else if (lock.owns_lock()) {
+        /* Indexed keys exist without decoding their value */
+        auto slot = slots.find(key);
+        result = (slot != slots.end()) && (slot->second.value.has_value() || slot->second.lazy.has_value());
+    }else{
+        result = score::MakeUnexpected(ErrorCode::MutexLockFailed);
+    }
+
+    return result;
+}
+
+/* Retrieve the value associated with a key*/
+score::Result<KvsValue> Kvs::get_value(const std::string_view key) {
+    score::Result<KvsValue> result = score::MakeUnexpected(ErrorCode::UnmappedError);
+    std::shared_lock<std::shared_mutex> lock_kvs = lock_shared();
+    if ((KvsSharing::Reader == options.sharing) || lock_kvs.owns_lock()){ /* A reader of the shared data has no local data */
+        std::optional<KvsValue> copy;
+        auto search = find_value(key, copy); /* One lookup of the slot finds the written and the default value */
+        if (!search) {
+            result = score::MakeUnexpected(static_cast<ErrorCode>(*search.error()));
+        } else {
+            result = *search.value();
+        }
+    }
+    else{
+        result = score::MakeUnexpected(ErrorCode::MutexLockFailed);
+    }
+
+    return result;
+}
+
+/* Visit the value associated with a key without copying it */
+score::ResultBlank Kvs::visit_value(const std::string_view key, const std::function<void(const KvsValue&)>& visitor) {
+    score::ResultBlank result = score::MakeUnexpected(ErrorCode::UnmappedError);
+    std::shared_lock<std::shared_mutex> lock_kvs = lock_shared();
+    if ((KvsSharing::Reader == options.sharing) || lock_kvs.owns_lock()){
+        std::optional<KvsValue> copy;
+        auto search = find_value(key, copy);
+        if (!search) {
+            result = score::MakeUnexpected(static_cast<ErrorCode>(*search.error()));
+        } else {
+            visitor(*search.value());
+            result = score::ResultBlank{};
+        }
+    }
+    else{
+        result = score::MakeUnexpected(ErrorCode::MutexLockFailed);
+    }
+
+    return result;
+}
+
+/* Resolve a key for repeated accesses */
+KeyHandle Kvs::resolve(const std::string_view key) {
+    KeyHandle handle(key);
+    std::shared_lock<std::shared_mutex> lock_kvs = lock_shared();
+    if ((KvsSharing::Reader != options.sharing) && lock_kvs.owns_lock()) {
+        resolve_handle(handle);
+    }
+
+    return handle;
+}
+
+/* Retrieve the value of a resolved key */
+score::Result<KvsValue> Kvs::get_value(KeyHandle& handle) {
+    score::Result<KvsValue> result = score::MakeUnexpected(ErrorCode::UnmappedError);
+    if (KvsSharing::Reader == options.sharing) {
+        result = get_value(handle.name); /* No local entries, the value is copied out of the published data */
+    }else{
+        std::shared_lock<std::shared_mutex> lock_kvs = lock_shared();
+        if (lock_kvs.owns_lock()) {
+            std::optional<KvsValue> copy;
+            auto search = handle_value(handle, copy);
+            if (!search) {
+                result = score::MakeUnexpected(static_cast<ErrorCode>(*search.error()));
+            }else{
+                result = *search.value();
+            }
+        }else{
+            result = score::MakeUnexpected(ErrorCode::MutexLockFailed);
+        }
+    }
+
+    return result;
+}
+
+/* Visit the value of a resolved key without copying it */
+score::ResultBlank Kvs::visit_value(KeyHandle& handle, const std::function<void(const KvsValue&)>& visitor) {
+    score::ResultBlank result = score::MakeUnexpected(ErrorCode::UnmappedError);
+    if (KvsSharing::Reader == options.sharing) {
+        result = visit_value(handle.name, visitor);
+    }else{
+        std::shared_lock<std::shared_mutex> lock_kvs = lock_shared();
+        if (lock_kvs.owns_lock()) {
+            std::optional<KvsValue> copy;
+            auto search = handle_value(handle, copy);
+            if (!search) {
+                result = score::MakeUnexpected(static_cast<ErrorCode>(*search.error()));
+            }else{
+                visitor(*search.value());
+                result = score::ResultBlank{};
+            }
+        }else{
+            result = score::MakeUnexpected(ErrorCode::MutexLockFailed);
+        }
+    }
+
+    return result;
+}
+
+/* Retrieve the values associated with several keys under one lock */
+score::Result<std::vector<score::Result<KvsValue>>> Kvs::get_values(const std::vector<std::string_view>& keys) {
+    score::Result<std::vector<score::Result<KvsValue>>> result = score::MakeUnexpected(ErrorCode::UnmappedError);
+    std::shared_lock<std::shared_mutex> lock_kvs = lock_shared();
+    if ((KvsSharing::Reader == options.sharing) || lock_kvs.owns_lock()){
+        std::vector<score::Result<KvsValue>> values;
+        values.reserve(keys.size());
+        for (const std::string_view key : keys) {
+            std::optional<KvsValue> copy;
+            auto search = find_value(key, copy);
+            if (!search) {
+                values.emplace_back(score::MakeUnexpected(static_cast<ErrorCode>(*search.error())));
+            } else {
+                values.emplace_back(*search.value());
+            }
+        }
+        result = std::move(values);
+    }
+    else{
+        result = score::MakeUnexpected(ErrorCode::MutexLockFailed);
+    }
+
+    return result;
+}
+
+/* Visit all written keys with a prefix (the map is ordered, the matching keys are adjacent) */
+score::ResultBlank Kvs::scan_prefix(const std::string_view prefix,
+                                    const std::function<void(const std::string&, const KvsValue&)>& visitor) {
+    score::ResultBlank result = score::MakeUnexpected(ErrorCode::UnmappedError);
+    std::shared_lock<std::shared_mutex> lock_kvs = lock_shared();
+    if (KvsSharing::Reader == options.sharing) {
+        /* The matching entries are copied out of the segment first, the visitor sees one published state */
+        auto shared_res = shared->scan(prefix);
+        if (!shared_res) {
+            result = score::MakeUnexpected(static_cast<ErrorCode>(*shared_res.error()));
+        }else{
+            for (const auto& [key, value] : shared_res.value()) {
+                visitor(key, value);
+            }
+            result = score::ResultBlank{};
+        }
+    }else if (lock_kvs.owns_lock()){
+        const auto matches = [prefix](const std::string& key) { return 0 == key.compare(0, prefix.size(), prefix); };
+        auto it = kvs.lower_bound(prefix);
+        auto lazy_it = lazy_kvs.lower_bound(prefix);
+        bool in_kvs = (it != kvs.end()) && matches(it->first);
+        bool in_lazy = (lazy_it != lazy_kvs.end()) && matches(lazy_it->first);
+        result = score::ResultBlank{};
+        /* Merge the written and the indexed keys of a lazily opened file in key order */
+        while (result && (in_kvs || in_lazy)) {
+            if (in_kvs && ((!in_lazy) || (it->first < lazy_it->first))) {
+                visitor(it->first, it->second);
+                ++it;
+                in_kvs = (it != kvs.end()) && matches(it->first);
+            }else{
+                auto value_res = lazy_value(lazy_it->second);
+                if (!value_res) {
+                    result = score::MakeUnexpected(static_cast<ErrorCode>(*value_res.error()));
+                }else{
+                    visitor(lazy_it->first, *value_res.value());
+                }
+                ++lazy_it;
+                in_lazy = (lazy_it != lazy_kvs.end()) && matches(lazy_it->first);
+            }
+        }
+    }
+    else{
+        result = score::MakeUnexpected(ErrorCode::MutexLockFailed);
+    }
+
+    return result;
+}
+
+/*Retrieve the default value associated with a key*/
+score::Result<KvsValue> Kvs::get_default_value(const std::string_view key) {
+    score::Result<KvsValue> result = score::MakeUnexpected(ErrorCode::UnmappedError);
+
+    auto search = default_values.find(key);
+    if (search != default_values.end()) {
+        result = search->second;
+    } else if (nullptr != default_image) {
+        result = default_image->find(key);
+    } else {
+        result = score::MakeUnexpected(ErrorCode::KeyNotFound);
+    }
+
+    return result;
+}
+
+/* Resets a Key to its default value (Deletes written key if default is available) */
+score::ResultBlank Kvs::reset_key(const std::string_view key)
+{
+    score::ResultBlank result = score::MakeUnexpected(ErrorCode::UnmappedError);
+    std::unique_lock<std::shared_mutex> lock_kvs = lock_exclusive();
+    if (KvsSharing::Reader == options.sharing) {
+        result = score::MakeUnexpected(ErrorCode::ReadOnly);
+    }
+    else if (!lock_kvs.owns_lock()) {
+        result = score::MakeUnexpected(ErrorCode::MutexLockFailed);
+    }
+    else {
+        auto slot = slots.find(key); /* The slot holds the written and the default entry, no second lookup needed */
+        if (((slot == slots.end()) || (nullptr == slot->second.default_value))
+            && ((nullptr == default_image) || (!default_image->contains(key)))) {
+            result = score::MakeUnexpected(ErrorCode::KeyDefaultNotFound);
+        }
+        else if ((slot != slots.end()) && (slot->second.value.has_value() || slot->second.lazy.has_value())) {
+            (void)erase_entry(slot);
+            mark_dirty(key);
+            notify_change(key, nullptr);
+            result = score::ResultBlank{};
+        }
+        else {
+            result = score::ResultBlank{}; /* Not written, the default already applies */
+        }
+    }
+
+    return result;
+}
+
+/* Resets a resolved key to its default value */
+score::ResultBlank Kvs::reset_key(KeyHandle& handle)
+{
+    score::ResultBlank result = score::MakeUnexpected(ErrorCode::UnmappedError);
+    std::unique_lock<std::shared_mutex> lock_kvs = lock_exclusive();
+    if (KvsSharing::Reader == options.sharing) {
+        result = score::MakeUnexpected(ErrorCode::ReadOnly);
+    }
+    else if (!lock_kvs.owns_lock()) {
+        result = score::MakeUnexpected(ErrorCode::MutexLockFailed);
+    }
+    else {
+        resolve_handle(handle);
+        if (((handle.slot == slots.end()) || (nullptr == handle.slot->second.default_value))
+            && ((nullptr == default_image) || (!default_image->contains(handle.name)))) {
+            result = score::MakeUnexpected(ErrorCode::KeyDefaultNotFound);
+        }
+        else if ((handle.slot == slots.end())
+                 || ((!handle.slot->second.value.has_value()) && (!handle.slot->second.lazy.has_value()))) {
+            result = score::ResultBlank{}; /* Not written, the default already applies */
+        }
+        else {
+            handle.slot = erase_entry(handle.slot);
+            handle.generation = key_generation;
+            mark_dirty(handle.name);
+            notify_change(handle.name, nullptr);
+            result = score::ResultBlank{};
+        }
+    }
+
+    return result;
+}
+
+/* Check if a key has a default value*/
+score::Result<bool> Kvs::has_default_value(const std::string_view key) {
+    score::Result<bool> result = score::MakeUnexpected(ErrorCode::UnmappedError);
+
+    auto search = default_values.find(key); /* Heterogeneous lookup, no temporary std::string needed */
+    if (search != default_values.end()) {
+        result = true;
+    } else if (nullptr != default_image) {
+        result = default_image->contains(key);
+    } else {
+        result = false;
+    }
+
+    return result;
+}
+
+/* Check if the value of a key is its default value (written value and default under one lock) */
+score::Result<bool> Kvs::is_value_default(const std::string_view key) {
+    score::Result<bool> result = score::MakeUnexpected(ErrorCode::UnmappedError);
+    std::shared_lock<std::shared_mutex> lock_kvs = lock_shared();
+    score::Result<bool> written = score::MakeUnexpected(ErrorCode::UnmappedError);
+    KvsSlotMap::iterator slot = slots.end();
+    if (KvsSharing::Reader == options.sharing) {
+        auto shared_res = shared->find(key);
+        if (!shared_res) {
+            written = score::MakeUnexpected(static_cast<ErrorCode>(*shared_res.error()));
+        }else{
+            written = shared_res.value().has_value();
+            slot = slots.find(key); /* The slots of a reader only hold its defaults */
+        }
+    }else if (lock_kvs.owns_lock()) {
+        slot = slots.find(key); /* One lookup for the written and the default entry */
+        written = (slot != slots.end()) && (slot->second.value.has_value() || slot->second.lazy.has_value());
+    }else{
+        written = score::MakeUnexpected(ErrorCode::MutexLockFailed);
+    }
+
+    if (!written) {
+        result = score::MakeUnexpected(static_cast<ErrorCode>(*written.error()));
+    }else if (written.value()) {
+        result = false;
+    }else if (((slot != slots.end()) && (nullptr != slot->second.default_value))
+              || ((nullptr != default_image) && default_image->contains(key))) {
+        result = true;
+    }else{
+        result = score::MakeUnexpected(ErrorCode::KeyNotFound);
+    }
+
+    return result;
+}
+
+/* Check if the value of a resolved key is its default value */
+score::Result<bool> Kvs::is_value_default(KeyHandle& handle) {
+    score::Result<bool> result = score::MakeUnexpected(ErrorCode::UnmappedError);
+    if (KvsSharing::Reader == options.sharing) {
+        result = is_value_default(handle.name);
+    }else{
+        std::shared_lock<std::shared_mutex> lock_kvs = lock_shared();
+        if (lock_kvs.owns_lock()) {
+            resolve_handle(handle);
+            const KvsKeySlot* entries = (handle.slot != slots.end()) ? &handle.slot->second : nullptr;
+            if ((nullptr != entries) && (entries->value.has_value() || entries->lazy.has_value())) {
+                result = false;
+            }else if (((nullptr != entries) && (nullptr != entries->default_value))
+                      || ((nullptr != default_image) && default_image->contains(handle.name))) {
+                result = true;
+            }else{
+                result = score::MakeUnexpected(ErrorCode::KeyNotFound);
+            }
+        }else{
+            result = score::MakeUnexpected(ErrorCode::MutexLockFailed);
+        }
+    }
+
+    return result;
+}
+
+/* Set the value for a key*/
+score::ResultBlank Kvs::set_value(const std::string_view key, const KvsValue& value) {
+    score::ResultBlank result = score::MakeUnexpected(ErrorCode::UnmappedError);
+    std::unique_lock<std::shared_mutex> lock = lock_exclusive();
+    if (KvsSharing::Reader == options.sharing) {
+        result = score::MakeUnexpected(ErrorCode::ReadOnly);
+    }else if (lock.owns_lock()) {
+        auto slot = slots.find(key);
+        if ((slot != slots.end()) && slot->second.value.has_value()) {
+            slot->second.value.value()->second = value; /* Existing key: assign the value, no key allocation */
+        }else{
+            (void)drop_lazy(slot); /* The indexed value is replaced without decoding it */
+            (void)insert_slot(kvs.emplace(std::string(key), value).first);
+        }
+        mark_dirty(key);
+        notify_change(key, &value);
+        result = score::ResultBlank{};
+    }else{
+        result = score::MakeUnexpected(ErrorCode::MutexLockFailed);
+    }
+
+    return result;
+}
+
+/* Set the value for a key by moving the key and the value into the map */
+score::ResultBlank Kvs::set_value(std::string&& key, KvsValue&& value) {
+    score::ResultBlank result = score::MakeUnexpected(ErrorCode::UnmappedError);
+    std::unique_lock<std::shared_mutex> lock = lock_exclusive();
+    if (KvsSharing::Reader == options.sharing) {
+        result = score::MakeUnexpected(ErrorCode::ReadOnly);
+    }else if (lock.owns_lock()) {
+        auto slot = slots.find(key);
+        if ((slot != slots.end()) && slot->second.value.has_value()) {
+            auto entry = slot->second.value.value();
+            entry->second = std::move(value);
+            mark_dirty(key);
+            notify_change(entry->first, &entry->second);
+        }else{
+            mark_dirty(key); /* Before the key is moved into the map */
+            (void)drop_lazy(slot);
+            auto inserted = kvs.emplace(std::move(key), std::move(value)).first;
+            (void)insert_slot(inserted);
+            notify_change(inserted->first, &inserted->second);
+        }
+        result = score::ResultBlank{};
+    }else{
+        result = score::MakeUnexpected(ErrorCode::MutexLockFailed);
+    }
+
+    return result;
+}
+
+/* Set the value of a resolved key */
+score::ResultBlank Kvs::set_value(KeyHandle& handle, const KvsValue& value) {
+    score::ResultBlank result = score::MakeUnexpected(ErrorCode::UnmappedError);
+    std::unique_lock<std::shared_mutex> lock = lock_exclusive();
+    if (KvsSharing::Reader == options.sharing) {
+        result = score::MakeUnexpected(ErrorCode::ReadOnly);
+    }else if (lock.owns_lock()) {
+        resolve_handle(handle);
+        if ((handle.slot != slots.end()) && handle.slot->second.value.has_value()) {
+            handle.slot->second.value.value()->second = value; /* Written key: no lookup */
+        }else{
+            (void)drop_lazy(handle.slot); /* The indexed value is replaced without decoding it */
+            handle.slot = insert_slot(kvs.emplace(handle.name, value).first);
+            handle.generation = key_generation; /* Other handles are looked up again, this one is up to date */
+        }
+        mark_dirty(handle.name);
+        notify_change(handle.name, &value);
+        result = score::ResultBlank{};
+    }else{
+        result = score::MakeUnexpected(ErrorCode::MutexLockFailed);
+    }
+
+    return result;
+}
+
+/* Remove a key-value pair*/
+score::ResultBlank Kvs::remove_key(const std::string_view key) {
+    score::ResultBlank result = score::MakeUnexpected(ErrorCode::UnmappedError);
+    std::unique_lock<std::shared_mutex> lock = lock_exclusive();
+    if (KvsSharing::Reader == options.sharing) {
+        result = score::MakeUnexpected(ErrorCode::ReadOnly);
+    }else if (lock.owns_lock()) {
+        auto slot = slots.find(key);
+        if ((slot != slots.end()) && (slot->second.value.has_value() || slot->second.lazy.has_value())) {
+            (void)erase_entry(slot); /* Written or indexed value, a default stays in the slot */
+            mark_dirty(key);
+            notify_change(key, nullptr);
+            result = score::ResultBlank{};
+        } else {
+            result = score::MakeUnexpected(ErrorCode::KeyNotFound);
+        }
+    }else{
+        result = score::MakeUnexpected(ErrorCode::MutexLockFailed);
+    }
+
+    return result;
+}
+
+/* Add setting the value of a key to the batch (copies the key and the value) */
+void KvsWriteBatch::set_value(const std::string_view key, const KvsValue& value) {
+    changes.push_back(Change{std::string(key), value});
+}
+
+/* Add setting the value of a key to the batch (moves the key and the value) */
+void KvsWriteBatch::set_value(std::string&& key, KvsValue&& value) {
+    changes.push_back(Change{std::move(key), std::move(value)});
+}
+
+/* Add removing a key to the batch */
+void KvsWriteBatch::remove_key(const std::string_view key) {
+    changes.push_back(Change{std::string(key), std::nullopt});
+}
+
+/* Remove all changes from the batch */
+void KvsWriteBatch::clear() {
+    changes.clear();
+}
+
+/* Number of changes in the batch */
+size_t KvsWriteBatch::size() const {
+    return changes.size();
+}
+
+/* Whether the batch contains no changes */
+bool KvsWriteBatch::empty() const {
+    return changes.empty();
+}
+
+/* Apply all changes of a batch under one lock */
+score::ResultBlank Kvs::write(KvsWriteBatch&& batch, bool flush_after) {
+    score::ResultBlank result = score::MakeUnexpected(ErrorCode::UnmappedError);
+    std::unique_lock<std::shared_mutex> lock = lock_exclusive();
+    if (KvsSharing::Reader == options.sharing) {
+        result = score::MakeUnexpected(ErrorCode::ReadOnly);
+    }else if (lock.owns_lock()) {
+        for (auto& change : batch.changes) {
+            auto slot = slots.find(change.key);
+            if (change.value.has_value()) {
+                if ((slot != slots.end()) && slot->second.value.has_value()) {
+                    auto entry = slot->second.value.value();
+                    entry->second = std::move(*change.value);
+                    mark_dirty(change.key);
+                    notify_change(entry->first, &entry->second);
+                }else{
+                    /* mark_dirty() before the key is moved into the map */
+                    mark_dirty(change.key);
+                    (void)drop_lazy(slot);
+                    auto inserted = kvs.emplace(std::move(change.key), std::move(*change.value)).first;
+                    (void)insert_slot(inserted);
+                    notify_change(inserted->first, &inserted->second);
+                }
+            }else if ((slot != slots.end()) && (slot->second.value.has_value() || slot->second.lazy.has_value())) {
+                (void)erase_entry(slot);
+                mark_dirty(change.key);
+                notify_change(change.key, nullptr);
+            }
+        }
+        lock.unlock();
+        batch.changes.clear();
+        if (flush_after) {
+            result = flush();
+        }else{
+            result = score::ResultBlank{};
+        }
+    }else{
+        result = score::MakeUnexpected(ErrorCode::MutexLockFailed);
+    }
+
+    return result;
+}
+
+/* Helper Function to create the directory of a KVS file */
+score::ResultBlank Kvs::create_data_dir(const score::filesystem::Path& path)
+{
+    score::ResultBlank result = score::MakeUnexpected(ErrorCode::UnmappedError);
+    score::filesystem::Path dir = path.ParentPath();
+    if  (!dir.Empty()) {
+        if(!backend->create_directories(dir.Native())) {
+            result = score::MakeUnexpected(ErrorCode::PhysicalStorageFailure);
+        } else {
+            result = score::ResultBlank{};
+        }
+    } else {
+        logger->LogError() << "Failed to create directory for KVS file '" << path << "'";
+        result = score::MakeUnexpected(ErrorCode::PhysicalStorageFailure);
+    }
+
+    return result;
+}
+
+/* Helper Function to write the hash file of a KVS file (synced to the storage if requested) */
+score::ResultBlank Kvs::write_hash_file(const std::string& hash_file, uint32_t hash, bool sync)
+{
+    score::ResultBlank result = score::MakeUnexpected(ErrorCode::UnmappedError);
+    const std::string content = get_hash_file_content(options.hash_algorithm, hash);
+    if (!backend->write(hash_file, content, sync)) {
+        result = score::MakeUnexpected(ErrorCode::PhysicalStorageFailure);
+    } else {
+        result = score::ResultBlank{};
+    }
+
+    return result;
+}
+
+/* Helper Function to write JSON or binary data to a file for flush process (also adds Hash file)*/
+score::ResultBlank Kvs::write_data(const std::string& buf, KvsStorageFormat format)
+{
+    score::ResultBlank result = score::MakeUnexpected(ErrorCode::UnmappedError);
+    score::filesystem::Path json_path{filename_prefix.Native() + "_0" + get_data_extension(format)};
+    auto dir_res = create_data_dir(json_path);
+    if (!dir_res) {
+        result = dir_res;
+    } else {
+        const std::string data = compress_data(buf, options.compression);
+        if (!backend->write(json_path.Native(), data, false)) {
+            result = score::MakeUnexpected(ErrorCode::PhysicalStorageFailure);
+        } else {
+            /* Write Hash File (of the stored, possibly compressed data) */
+            result = write_hash_file(filename_prefix.Native() + "_0.hash", calculate_hash(options.hash_algorithm, data), false);
+        }
+    }
+
+    return result;
+}
+
+/* Helper Function to write JSON data to a file for flush process (also adds Hash file)*/
+score::ResultBlank Kvs::write_json_data(const std::string& buf)
+{
+    return write_data(buf, KvsStorageFormat::Json);
+}
+
+/* Serialize the KVS data in the configured storage format directly into a file */
+score::Result<Kvs::DataFileInfo> Kvs::serialize_data(const score::filesystem::Path& path, std::string* delta) {
+    score::Result<DataFileInfo> result = score::MakeUnexpected(ErrorCode::UnmappedError);
+    auto dir_res = create_data_dir(path);
+    if (!dir_res) {
+        result = score::MakeUnexpected(static_cast<ErrorCode>(*dir_res.error()));
+    }else{
+        std::shared_lock<std::shared_mutex> lock = lock_shared();
+        if (!lock.owns_lock()) {
+            result = score::MakeUnexpected(ErrorCode::MutexLockFailed);
+        }else{
+            /* Copy the map (Arrays and Objects are shared), so writers are only blocked for the copy and not by
+               the encoding, the compression and the file write */
+            const KvsMap data = kvs;
+            lock.unlock();
+
+            result = serialize_map(data, path);
+            if (result && (nullptr != delta)) {
+                /* Changes back to the previous KVS file, the delta base only copies the changed keys */
+                auto delta_res = delta_encode(data, delta_base, result.value().hash);
+                *delta = delta_res ? std::move(delta_res.value()) : std::string{};
+                delta_update(delta_base, data);
+            }
+        }
+    }
+
+    return result;
+}
+
+/* Serialize a map in the configured storage format into a file */
+score::Result<Kvs::DataFileInfo> Kvs::serialize_map(const KvsMap& data, const score::filesystem::Path& path) const {
+    score::Result<DataFileInfo> result = score::MakeUnexpected(ErrorCode::UnmappedError);
+    std::unique_ptr<std::ostream> out = backend->open_write(path.Native());
+    if (nullptr == out) {
+        result = score::MakeUnexpected(ErrorCode::PhysicalStorageFailure);
+    }else{
+        /* With KvsOptions::compression the sink writes into the compression, which writes the file block by block */
+        std::unique_ptr<KvsCompressBuffer> compress;
+        std::unique_ptr<std::ostream> compress_out;
+        if (KvsCompression::None != options.compression) {
+            compress = std::make_unique<KvsCompressBuffer>(*out, options.compression, options.hash_algorithm);
+            compress_out = std::make_unique<std::ostream>(compress.get());
+        }
+        KvsStreamSink sink((nullptr != compress_out) ? *compress_out : *out, KVS_STREAM_CHUNK_SIZE, options.hash_algorithm);
+        score::ResultBlank enc = score::ResultBlank{};
+        if (KvsStorageFormat::Binary == options.format) {
+            /* Binary encoding is done directly on the stored values, no intermediate representation needed */
+            auto buf_res = binary_encode_map(data);
+            if (!buf_res) {
+                enc = score::MakeUnexpected(static_cast<ErrorCode>(*buf_res.error()));
+            }else{
+                sink.append(buf_res.value());
+            }
+        }else{
+            /* JSON is written while the map is walked, only one chunk is kept in memory */
+            enc = json_stream_map(data, sink);
+        }
+
+        if (enc && (!sink.finish())) {
+            enc = score::MakeUnexpected(ErrorCode::PhysicalStorageFailure);
+        }
+        if (enc && (nullptr != compress) && (!compress->finish())) {
+            enc = score::MakeUnexpected(ErrorCode::PhysicalStorageFailure);
+        }
+        out.reset(); /* The file is complete once the stream is closed */
+        if (!enc) {
+            (void)backend->remove(path.Native());
+            result = score::MakeUnexpected(static_cast<ErrorCode>(*enc.error()));
+        }else if (nullptr != compress) {
+            result = DataFileInfo{compress->hash(), compress->size()};
+        }else{
+            result = DataFileInfo{sink.hash(), sink.size()};
+        }
+    }
+
+    return result;
+}
+
+/* Write the complete KVS file (rotates the snapshots and removes the log, snapshot_mutex must be held) */
+score::ResultBlank Kvs::flush_full() {
+    score::ResultBlank result = score::MakeUnexpected(ErrorCode::UnmappedError);
+    bool error = false;
+    if ((KvsFlushMode::Incremental == options.flush_mode) || options.lazy_values) {
+        /* All changes up to here are part of the complete file, later changes are marked dirty again.
+           The complete file also needs the values of a lazily opened file that weren't accessed yet. */
+        std::unique_lock<std::shared_mutex> lock = lock_exclusive();
+        if (!lock.owns_lock()) {
+            result = score::MakeUnexpected(ErrorCode::MutexLockFailed);
+            error = true;
+        }else if (auto materialize_res = materialize_lazy(); !materialize_res) {
+            result = materialize_res;
+            error = true;
+        }else{
+            dirty_keys.clear();
+        }
+    }
+
+    if (!error) {
+        /* The generation layout writes next to the current files, the legacy layout replaces kvs_<id>_0 */
+        const bool generations = (KvsSnapshotLayout::Generations == options.snapshot_layout);
+        const bool sync = sync_due();
+        uint32_t generation = 0;
+        if (generations) {
+            std::lock_guard<std::mutex> manifest_lock(manifest_mutex);
+            generation = manifest.next_generation;
+        }
+        const std::string data_prefix = filename_prefix.Native() + (generations ? manifest_entry_suffix(generation) : std::string("_0"));
+        const std::string hash_file = data_prefix + ".hash";
+        const std::string tmp_hash_file = hash_file + ".tmp";
+
+        /* Write Data (to a temporary file, so a failed serialization keeps the current file and the snapshots) */
+        const score::filesystem::Path data_file = data_prefix + get_data_extension(options.format);
+        const score::filesystem::Path tmp_file = data_file.Native() + ".tmp";
+        const bool delta = options.delta_snapshots && (0 < options.snapshot_max_count) && open_delta_base();
+        const uint32_t previous_hash = delta ? delta_base_hash.value() : 0;
+        std::string delta_data;
+        auto data_res = serialize_data(tmp_file, delta ? &delta_data : nullptr);
+        if (data_res && sync && (!backend->sync(tmp_file.Native()))) {
+            logger->LogError() << "error: could not sync " << tmp_file;
+            data_res = score::MakeUnexpected(ErrorCode::PhysicalStorageFailure);
+            (void)backend->remove(tmp_file.Native());
+        }
+        if (!data_res) {
+            result = score::MakeUnexpected(static_cast<ErrorCode>(*data_res.error()));
+        }else if (generations) {
+            /* The new generation becomes the current KVS file with the manifest update */
+            if (!backend->rename(tmp_file.Native(), data_file.Native())) {
+                logger->LogError() << "error: could not rename " << tmp_file << " to " << data_file;
+                result = score::MakeUnexpected(ErrorCode::PhysicalStorageFailure);
+                (void)backend->remove(tmp_file.Native());
+            }else{
+                result = write_hash_file(hash_file, data_res.value().hash, sync);
+                if (result && sync && (!backend->sync_dir(hash_file))) {
+                    result = score::MakeUnexpected(ErrorCode::PhysicalStorageFailure);
+                }
+                if (result) {
+                    result = snapshot_rotate_manifest(sync);
+                }
+                if (!result) {
+                    remove_snapshot_files(data_prefix);
+                }
+            }
+        }else{
+            /* Both files are complete before the current files are replaced */
+            result = write_hash_file(tmp_hash_file, data_res.value().hash, sync);
+            if (result) {
+                /* Rotate Snapshots */
+                result = snapshot_rotate();
+            }
+            if (!result) {
+                (void)backend->remove(tmp_file.Native());
+                (void)backend->remove(tmp_hash_file);
+            }else if (!backend->rename(tmp_file.Native(), data_file.Native())) {
+                logger->LogError() << "error: could not rename " << tmp_file << " to " << data_file;
+                result = score::MakeUnexpected(ErrorCode::PhysicalStorageFailure);
+                (void)backend->remove(tmp_file.Native());
+                (void)backend->remove(tmp_hash_file);
+            }else if (!backend->rename(tmp_hash_file, hash_file)) {
+                /* The pending hash file is kept, open completes the flush with it */
+                logger->LogError() << "error: could not rename " << tmp_hash_file << " to " << hash_file;
+                result = score::MakeUnexpected(ErrorCode::PhysicalStorageFailure);
+            }else{
+                /* A file of the other format is stale now (it was linked into snapshot 1) */
+                (void)backend->remove(data_prefix + get_data_extension(get_other_format(options.format)));
+                if (sync && (!backend->sync_dir(hash_file))) {
+                    result = score::MakeUnexpected(ErrorCode::PhysicalStorageFailure);
+                }
+            }
+        }
+        if (result) {
+            /* The new KVS file contains all logged changes */
+            const std::string log_file = filename_prefix.Native() + "_0.log";
+            (void)backend->remove(log_file);
+            base_hash = data_res.value().hash;
+            base_size = data_res.value().size;
+            log_size = 0;
+            full_flush_required = false;
+            if (delta) {
+                snapshot_delta(delta_data, previous_hash, sync);
+                delta_base_hash = data_res.value().hash;
+            }
+        }else{
+            full_flush_required = true; /* KVS file or log may be missing changes */
+            delta_base_hash.reset(); /* The delta base may already contain the data that wasn't written */
+        }
+    }
+
+    return result;
+}
+
+/* Append the changed keys to the log (snapshot_mutex must be held, the records are appended in the order they are encoded) */
+score::ResultBlank Kvs::flush_incremental() {
+    score::ResultBlank result = score::MakeUnexpected(ErrorCode::UnmappedError);
+    std::string records;
+    bool error = false;
+
+    if (full_flush_required) {
+        result = flush_full();
+    }else{
+        {
+            std::unique_lock<std::shared_mutex> lock = lock_exclusive();
+            if (!lock.owns_lock()) {
+                result = score::MakeUnexpected(ErrorCode::MutexLockFailed);
+                error = true;
+            }else{
+                for (const auto& key : dirty_keys) {
+                    auto search = kvs.find(key);
+                    auto enc = (search != kvs.end()) ? log_encode_set(records, key, search->second) : log_encode_remove(records, key);
+                    if (!enc) {
+                        result = score::MakeUnexpected(static_cast<ErrorCode>(*enc.error()));
+                        error = true;
+                        break;
+                    }
+                }
+                if (!error) {
+                    dirty_keys.clear();
+                }
+            }
+        }
+
+        if (!error) {
+            if (records.empty()) {
+                result = score::ResultBlank{}; /* Nothing changed */
+            }else if ((log_size + records.size()) > std::max(base_size, KVS_LOG_MIN_COMPACTION_SIZE)) {
+                /* Compaction: the log would get larger than the KVS file */
+                result = flush_full();
+            }else{
+                const std::string log_file = filename_prefix.Native() + "_0.log";
+                const bool new_log = (0 == log_size);
+                const std::string header = new_log ? log_encode_header(base_hash) : std::string{};
+                const bool written = new_log ? backend->write(log_file, header + records, false) : backend->append(log_file, records);
+                if (!written) {
+                    logger->LogError() << "error: could not append to log " << log_file;
+                    full_flush_required = true; /* Log may contain a partial record */
+                    result = score::MakeUnexpected(ErrorCode::PhysicalStorageFailure);
+                }else if (sync_due() && ((!backend->sync(log_file)) || (new_log && (!backend->sync_dir(log_file))))) {
+                    logger->LogError() << "error: could not sync log " << log_file;
+                    log_size += header.size() + records.size(); /* The records are appended, only not synced */
+                    result = score::MakeUnexpected(ErrorCode::PhysicalStorageFailure);
+                }else{
+                    log_size += header.size() + records.size();
+                    result = score::ResultBlank{};
+                }
+            }
+        }
     }
 
     return result;
 }
 
-/* Set the value for a key*/
-score::ResultBlank Kvs::set_value(const std::string_view key, const KvsValue& value) {
+/* Flush in the calling thread according to the flush mode */
+score::ResultBlank Kvs::flush_now() {
     score::ResultBlank result = score::MakeUnexpected(ErrorCode::UnmappedError);
-    std::unique_lock<std::mutex> lock(kvs_mutex, std::try_to_lock);
-    if (lock.owns_lock()) {
-        kvs.insert_or_assign(std::string(key), value);
-        result = score::ResultBlank{};
+    const KvsStatsTimer timer(*stats_recorder, KvsOperation::Flush);
+    if (KvsSharing::Reader == options.sharing) {
+        result = score::MakeUnexpected(ErrorCode::ReadOnly); /* The owner flushes the files */
     }else{
-        result = score::MakeUnexpected(ErrorCode::MutexLockFailed);
+        /* One flush at a time writes the files, snapshots are read without the KVS lock and wait until the files are replaced */
+        std::lock_guard<std::mutex> snapshot_lock(snapshot_mutex);
+        if (KvsFlushMode::Incremental == options.flush_mode) {
+            result = flush_incremental();
+        }else{
+            result = flush_full();
+        }
+    }
+    if (!result) {
+        stats_recorder->count(KvsCounter::FlushFailure);
+    }else if (KvsSharing::Owner == options.sharing) {
+        /* Readers see the flushed state, a failed publish doesn't fail the written flush (see KvsCounter::PublishFailure) */
+        (void)publish();
     }
 
     return result;
 }
 
-/* Remove a key-value pair*/
-score::ResultBlank Kvs::remove_key(const std::string_view key) {
-    score::ResultBlank result = score::MakeUnexpected(ErrorCode::UnmappedError);
-    std::unique_lock<std::mutex> lock(kvs_mutex, std::try_to_lock);
-    if (lock.owns_lock()) {
-        const auto erased = kvs.erase(std::string(key));
-        if (erased > 0U) {
-            result = score::ResultBlank{};
-        } else {
-            result = score::MakeUnexpected(ErrorCode::KeyNotFound);
+/* Count a flush and decide if its files are synced to the storage */
+bool Kvs::sync_due() {
+    bool result = false;
+    if (KvsDurability::Always == options.durability) {
+        result = true;
+    }else if (KvsDurability::Grouped == options.durability) {
+        const size_t interval = std::max(options.sync_interval, static_cast<size_t>(1));
+        if ((unsynced_flushes.fetch_add(1) + 1) >= interval) {
+            unsynced_flushes = 0;
+            result = true;
         }
     }else{
-        result = score::MakeUnexpected(ErrorCode::MutexLockFailed);
+        /* Deferred: written back by the OS or with sync() */
     }
 
     return result;
 }
 
-/* Helper Function to write JSON data to a file for flush process (also adds Hash file)*/
-score::ResultBlank Kvs::write_json_data(const std::string& buf)
-{
+/* Sync the files of the current KVS to the storage */
+score::ResultBlank Kvs::sync() {
     score::ResultBlank result = score::MakeUnexpected(ErrorCode::UnmappedError);
-    score::filesystem::Path json_path{filename_prefix.Native() + "_0.json"};
-    score::filesystem::Path dir = json_path.ParentPath();
-    if  (!dir.Empty()) {
-        const auto create_path_res = filesystem->standard->CreateDirectories(dir);
-        if(!create_path_res.has_value()) {
-            result = score::MakeUnexpected(ErrorCode::PhysicalStorageFailure);
-        } else {
-            std::ofstream out(json_path.CStr(), std::ios::binary);
-            if (!out.write(buf.data(), buf.size())) {
+    {
+        /* A pending background flush is part of the synced state */
+        std::lock_guard<std::mutex> flusher_lock(flusher_mutex);
+        if (flusher) {
+            flusher->wait();
+        }
+    }
+    const std::string data_prefix = snapshot_prefix(0);
+    auto format_res = find_data_format(data_prefix);
+    if (!format_res) {
+        result = score::MakeUnexpected(ErrorCode::PhysicalStorageFailure);
+    }else{
+        std::vector<std::string> files;
+        if (format_res.value().has_value()) {
+            files.push_back(data_prefix + get_data_extension(format_res.value().value()));
+            files.push_back(data_prefix + ".hash");
+        }
+        files.push_back(filename_prefix.Native() + "_0.log");
+        files.push_back(filename_prefix.Native() + ".manifest");
+
+        result = score::ResultBlank{};
+        for (const auto& file : files) {
+            if (backend->exists(file).value_or(false) && (!backend->sync(file))) {
+                logger->LogError() << "error: could not sync " << file;
                 result = score::MakeUnexpected(ErrorCode::PhysicalStorageFailure);
-            } else {
-                /* Write Hash File */
-                std::array<uint8_t, 4> hash_bytes = get_hash_bytes(buf);
-                score::filesystem::Path fn_hash = filename_prefix.Native() + "_0.hash";
-                std::ofstream hout(fn_hash.CStr(), std::ios::binary);
-                if (!hout.write(reinterpret_cast<const char*>(hash_bytes.data()), hash_bytes.size())) {
-                    result = score::MakeUnexpected(ErrorCode::PhysicalStorageFailure);
-                } else {
-                    result = score::ResultBlank{};
-                }
             }
         }
-    } else {
-        logger->LogError() << "Failed to create directory for KVS file '" << json_path << "'";
-        result = score::MakeUnexpected(ErrorCode::PhysicalStorageFailure);
+        if (result && (!backend->sync_dir(files.front()))) {
+            logger->LogError() << "error: could not sync the directory of " << files.front();
+            result = score::MakeUnexpected(ErrorCode::PhysicalStorageFailure);
+        }
+        if (result) {
+            unsynced_flushes = 0;
+        }
     }
 
     return result;
@@ -412,69 +2040,66 @@ score::ResultBlank Kvs::write_json_data(const std::string& buf)
 /* Flush the key-value store*/
 score::ResultBlank Kvs::flush() {
     score::ResultBlank result = score::MakeUnexpected(ErrorCode::UnmappedError);
-    /* Create JSON Object */
-    score::json::Object root_obj;
-    bool error = false;
-    {
-        std::unique_lock<std::mutex> lock(kvs_mutex, std::try_to_lock);
-        if (lock.owns_lock()) {
-            for (auto const& [key, value] : kvs) {
-                auto conv = kvsvalue_to_any(value);
-                if (!conv) {
-                    result = score::MakeUnexpected(static_cast<ErrorCode>(*conv.error()));
-                    error = true;
-                    break;
-                }else{
-                    root_obj.emplace(
-                        key,
-                        std::move(conv.value()) /*emplace in map uses move operator*/
-                    );
-                }
-            }
-        } else {
-            result = score::MakeUnexpected(ErrorCode::MutexLockFailed);
-            error = true;
-        }
+    if (options.background_flush) {
+        result = flush_async().get(); /* All flushes are done by the background thread */
+    }else{
+        result = flush_now();
     }
 
-    if(!error){
-        /* Serialize Buffer */
-        auto buf_res = writer->ToBuffer(root_obj);
-        if (!buf_res) {
-            result = score::MakeUnexpected(ErrorCode::JsonGeneratorError);
-        }else{
-            /* Rotate Snapshots */
-            auto rotate_result = snapshot_rotate();
-            if (!rotate_result) {
-                result = rotate_result;
-            }else{
-                /* Write JSON Data */
-                std::string buf = std::move(buf_res.value());
-                result = write_json_data(buf);
-            }
+    return result;
+}
+
+/* Request a flush without waiting for it */
+std::shared_future<score::ResultBlank> Kvs::flush_async(KvsFlushCallback callback) {
+    std::shared_future<score::ResultBlank> result;
+    if (options.background_flush) {
+        std::lock_guard<std::mutex> lock(flusher_mutex);
+        if (!flusher) {
+            flusher = std::make_unique<KvsFlusher>([this]() { return flush_now(); });
+        }
+        result = flusher->request(std::move(callback));
+    }else{
+        std::promise<score::ResultBlank> done;
+        const score::ResultBlank flush_res = flush_now();
+        if (callback) {
+            callback(flush_res);
         }
+        done.set_value(flush_res);
+        result = done.get_future().share();
     }
 
     return result;
 }
 
+/* Finish a pending background flush and stop the background thread */
+void Kvs::stop_flusher() {
+    std::lock_guard<std::mutex> lock(flusher_mutex);
+    flusher.reset();
+}
+
 /* Retrieve the snapshot count*/
 score::Result<size_t> Kvs::snapshot_count() const {
     score::Result<size_t> result = score::MakeUnexpected(ErrorCode::UnmappedError);
     size_t count = 0;
     bool error = false;
-    for (size_t idx = 1; idx <= KVS_MAX_SNAPSHOTS; ++idx) {
-        const score::filesystem::Path fname = filename_prefix.Native() + "_" + to_string(idx) + ".json";
-        const auto fname_exists_res = filesystem->standard->Exists(fname);
-        if (fname_exists_res) {
-            if(false == fname_exists_res.value()) {
+    if (KvsSnapshotLayout::Generations == options.snapshot_layout) {
+        /* Cached by the manifest, no file access needed */
+        std::lock_guard<std::mutex> manifest_lock(manifest_mutex);
+        count = manifest.entries.empty() ? 0 : std::min(manifest.entries.size() - 1, options.snapshot_max_count);
+    }else{
+        for (size_t idx = 1; idx <= options.snapshot_max_count; ++idx) {
+            const std::string prefix = filename_prefix.Native() + "_" + to_string(idx);
+            const auto format_res = find_data_format(prefix);
+            if (format_res) {
+                if((false == format_res.value().has_value()) && (!backend->exists(prefix + KVS_DELTA_EXTENSION).value_or(false))) {
+                    break;
+                }
+            } else{
+                error = true;
                 break;
             }
-        } else{
-            error = true;
-            break;
+            count = idx;
         }
-        count = idx;
     }
     if (error) {
         result = score::MakeUnexpected(ErrorCode::PhysicalStorageFailure);
@@ -487,40 +2112,62 @@ score::Result<size_t> Kvs::snapshot_count() const {
 
 /* Retrieve the max snapshot count*/
 size_t Kvs::snapshot_max_count() const {
-    return KVS_MAX_SNAPSHOTS;
+    return options.snapshot_max_count;
 }
 
 /* Rotate Snapshots */
 score::ResultBlank Kvs::snapshot_rotate() {
     score::ResultBlank result = score::MakeUnexpected(ErrorCode::UnmappedError);
-    std::unique_lock<std::mutex> lock(kvs_mutex, std::try_to_lock);
+    const KvsStatsTimer timer(*stats_recorder, KvsOperation::SnapshotRotate);
+    std::unique_lock<std::shared_mutex> lock = lock_exclusive();
     if (lock.owns_lock()) {
         bool error = false;
-        for (size_t idx = KVS_MAX_SNAPSHOTS; idx > 0; --idx) {
-            score::filesystem::Path hash_old = filename_prefix.Native() + "_" + to_string(idx - 1) + ".hash";
-            score::filesystem::Path hash_new = filename_prefix.Native() + "_" + to_string(idx)     + ".hash";
-            score::filesystem::Path snap_old = filename_prefix.Native() + "_" + to_string(idx - 1) + ".json";
-            score::filesystem::Path snap_new = filename_prefix.Native() + "_" + to_string(idx)     + ".json";
+        for (size_t idx = options.snapshot_max_count; idx > 0; --idx) {
+            const std::string prefix_old = filename_prefix.Native() + "_" + to_string(idx - 1);
+            const std::string prefix_new = filename_prefix.Native() + "_" + to_string(idx);
+            score::filesystem::Path hash_old = prefix_old + ".hash";
+            score::filesystem::Path hash_new = prefix_new + ".hash";
 
-            logger->LogInfo() << "rotating: " << snap_old << " -> " << snap_new;
+            logger->LogInfo() << "rotating: " << prefix_old << " -> " << prefix_new;
             /* Rename hash */
-            int32_t hash_rename = std::rename(hash_old.CStr(), hash_new.CStr());
-            if (0 != hash_rename) {
-                if (errno != ENOENT) {
-                    error = true;
-                    logger->LogError() << "error: could not rename hash file " << snap_old << ". Rename Errorcode " << errno;
-                    result = score::MakeUnexpected(ErrorCode::PhysicalStorageFailure);
-                }
+            const score::ResultBlank hash_rename = rotate_file(*backend, hash_old.Native(), hash_new.Native(), 1 == idx);
+            if (file_failed(hash_rename)) {
+                error = true;
+                logger->LogError() << "error: could not rename hash file " << hash_old;
+                result = score::MakeUnexpected(ErrorCode::PhysicalStorageFailure);
             }
             if(!error){
-                /* Rename snapshot */
-                int32_t snap_rename = std::rename(snap_old.CStr(), snap_new.CStr());
-                if (0 != snap_rename) {
-                    if (errno != ENOENT) {
+                /* Rename snapshot (JSON or binary file) */
+                for (const KvsStorageFormat format : KVS_STORAGE_FORMATS) {
+                    score::filesystem::Path snap_old = prefix_old + get_data_extension(format);
+                    score::filesystem::Path snap_new = prefix_new + get_data_extension(format);
+                    const score::ResultBlank snap_rename = rotate_file(*backend, snap_old.Native(), snap_new.Native(), 1 == idx);
+                    if (snap_rename) {
+                        /* A file of the other format or a delta at the new position is stale (its hash was just replaced) */
+                        score::filesystem::Path snap_stale = prefix_new + get_data_extension(get_other_format(format));
+                        (void)backend->remove(snap_stale.Native());
+                        (void)backend->remove(prefix_new + KVS_DELTA_EXTENSION);
+                    }else if (file_failed(snap_rename)) {
                         error = true;
-                        logger->LogError() << "error: could not rename snapshot file " << snap_old << ". Rename Errorcode " << errno;
+                        logger->LogError() << "error: could not rename snapshot file " << snap_old;
                         result = score::MakeUnexpected(ErrorCode::PhysicalStorageFailure);
+                        break;
+                    }
+                }
+            }
+            if(!error){
+                /* Rename delta (the current KVS file is never a delta) */
+                const std::string delta_old = prefix_old + KVS_DELTA_EXTENSION;
+                const std::string delta_new = prefix_new + KVS_DELTA_EXTENSION;
+                const score::ResultBlank delta_rename = backend->rename(delta_old, delta_new);
+                if (delta_rename) {
+                    for (const KvsStorageFormat format : KVS_STORAGE_FORMATS) {
+                        (void)backend->remove(prefix_new + get_data_extension(format));
                     }
+                }else if (file_failed(delta_rename)) {
+                    error = true;
+                    logger->LogError() << "error: could not rename snapshot file " << delta_old;
+                    result = score::MakeUnexpected(ErrorCode::PhysicalStorageFailure);
                 }
             }
             if(error){
@@ -537,35 +2184,404 @@ score::ResultBlank Kvs::snapshot_rotate() {
     return result;
 }
 
+/* Make the next generation the current KVS file (generation layout, its files are already written) */
+score::ResultBlank Kvs::snapshot_rotate_manifest(bool sync) {
+    score::ResultBlank result = score::MakeUnexpected(ErrorCode::UnmappedError);
+    const KvsStatsTimer timer(*stats_recorder, KvsOperation::SnapshotRotate);
+    std::unique_lock<std::shared_mutex> lock = lock_exclusive();
+    if (lock.owns_lock()) {
+        std::vector<uint32_t> dropped;
+        {
+            std::lock_guard<std::mutex> manifest_lock(manifest_mutex);
+            KvsManifest updated = manifest;
+            dropped = manifest_rotate(updated, options.snapshot_max_count);
+            result = write_manifest(updated, sync);
+            if (result) {
+                manifest = std::move(updated);
+            }
+        }
+        /* Files of snapshots that were rotated out (a failed removal only leaves an unused file) */
+        if (result) {
+            for (const uint32_t entry : dropped) {
+                remove_snapshot_files(filename_prefix.Native() + manifest_entry_suffix(entry));
+            }
+        }
+    } else {
+        result = score::MakeUnexpected(ErrorCode::MutexLockFailed);
+    }
+
+    return result;
+}
+
+/* Filename prefix of a snapshot (ID 0 is the current KVS file), empty if the snapshot isn't available */
+std::string Kvs::snapshot_prefix(size_t snapshot_id) const {
+    std::string result = filename_prefix.Native() + "_" + std::to_string(snapshot_id);
+    if (KvsSnapshotLayout::Generations == options.snapshot_layout) {
+        std::lock_guard<std::mutex> manifest_lock(manifest_mutex);
+        if (snapshot_id < manifest.entries.size()) {
+            result = filename_prefix.Native() + manifest_entry_suffix(manifest.entries[snapshot_id]);
+        }else if (0 != snapshot_id) {
+            result.clear();
+        }else{
+            /* No KVS file yet, kvs_<id>_0 doesn't exist (it would have been taken over) */
+        }
+    }
+
+    return result;
+}
+
+/* Read the manifest of the generation layout */
+score::ResultBlank Kvs::open_manifest() {
+    score::ResultBlank result = score::MakeUnexpected(ErrorCode::UnmappedError);
+    const std::string manifest_file = filename_prefix.Native() + ".manifest";
+    KvsManifest opened;
+    auto in = backend->open_read(manifest_file);
+    if (nullptr != in) {
+        std::string data;
+        if (read_stream(*in, data) && manifest_decode(data, opened)) {
+            logger->LogInfo() << "opened manifest " << manifest_file << " (" << opened.entries.size() << " entries)";
+            result = score::ResultBlank{};
+        }else{
+            logger->LogError() << "error: manifest " << manifest_file << " corrupted";
+            result = score::MakeUnexpected(ErrorCode::ValidationFailed);
+        }
+    }else{
+        /* No manifest yet: the legacy files are taken over as they are, the next flush writes the manifest */
+        result = score::ResultBlank{};
+        for (size_t idx = 0; idx <= options.snapshot_max_count; ++idx) {
+            const auto format_res = find_data_format(filename_prefix.Native() + "_" + to_string(idx));
+            if (!format_res) {
+                result = score::MakeUnexpected(ErrorCode::PhysicalStorageFailure);
+                break;
+            }else if (false == format_res.value().has_value()) {
+                break;
+            }else{
+                opened.entries.push_back(KVS_MANIFEST_LEGACY_ENTRY | static_cast<uint32_t>(idx));
+            }
+        }
+    }
+    if (result) {
+        std::lock_guard<std::mutex> manifest_lock(manifest_mutex);
+        manifest = std::move(opened);
+    }
+
+    return result;
+}
+
+/* Replace the manifest (temporary file + rename, so a power loss keeps the old or the new manifest) */
+score::ResultBlank Kvs::write_manifest(const KvsManifest& updated, bool sync) {
+    score::ResultBlank result = score::MakeUnexpected(ErrorCode::UnmappedError);
+    const std::string manifest_file = filename_prefix.Native() + ".manifest";
+    const std::string tmp_file = manifest_file + ".tmp";
+    const std::string data = manifest_encode(updated);
+    if ((!backend->write(tmp_file, data, sync)) || (!backend->rename(tmp_file, manifest_file))) {
+        logger->LogError() << "error: could not write manifest " << manifest_file;
+        (void)backend->remove(tmp_file);
+        result = score::MakeUnexpected(ErrorCode::PhysicalStorageFailure);
+    }else if (sync && (!backend->sync_dir(manifest_file))) {
+        logger->LogError() << "error: could not sync manifest " << manifest_file;
+        result = score::MakeUnexpected(ErrorCode::PhysicalStorageFailure);
+    }else{
+        result = score::ResultBlank{};
+    }
+
+    return result;
+}
+
+/* Remove the data files (all formats) and the hash file of a snapshot */
+void Kvs::remove_snapshot_files(const std::string& prefix) {
+    for (const KvsStorageFormat format : KVS_STORAGE_FORMATS) {
+        (void)backend->remove(prefix + get_data_extension(format));
+    }
+    (void)backend->remove(prefix + KVS_DELTA_EXTENSION);
+    (void)backend->remove(prefix + ".hash");
+}
+
+/* Make the data of the current KVS file the base of the next delta (only read once after open) */
+bool Kvs::open_delta_base() {
+    if (!(delta_base_hash.has_value() && (delta_base_hash.value() == base_hash))) {
+        delta_base_hash.reset();
+        delta_base.clear();
+        const std::string prefix = snapshot_prefix(0);
+        const auto format_res = find_data_format(prefix);
+        uint32_t hash = 0;
+        if (format_res && format_res.value().has_value() && read_hash_value(*backend, prefix + ".hash", hash)) {
+            auto data_res = open_file(prefix, format_res.value().value(), OpenJsonNeedFile::Required);
+            if (data_res) {
+                delta_base = std::move(data_res.value());
+                delta_base_hash = hash;
+            }
+        }
+    }
+
+    return delta_base_hash.has_value();
+}
+
+/* Store snapshot 1 (the previous KVS file) as delta to the new KVS file (a failure keeps the complete snapshot) */
+void Kvs::snapshot_delta(const std::string& delta, uint32_t previous_hash, bool sync) {
+    const std::string prefix = snapshot_prefix(1);
+    const auto format_res = prefix.empty() ? score::Result<std::optional<KvsStorageFormat>>(std::nullopt) : find_data_format(prefix);
+    uint32_t hash = 0;
+    /* Only if snapshot 1 is the file the delta was encoded against */
+    if ((!delta.empty()) && format_res && format_res.value().has_value()
+        && read_hash_value(*backend, prefix + ".hash", hash) && (previous_hash == hash)) {
+        const std::string delta_file = prefix + KVS_DELTA_EXTENSION;
+        const std::string tmp_file = delta_file + ".tmp";
+        if ((!backend->write(tmp_file, delta, sync)) || (!backend->rename(tmp_file, delta_file))
+            || (sync && (!backend->sync_dir(delta_file)))) {
+            logger->LogError() << "error: could not store snapshot " << prefix << " as delta, it is kept complete";
+            (void)backend->remove(tmp_file);
+        }else{
+            /* The hash file stays, it is the base of the next older delta */
+            for (const KvsStorageFormat format : KVS_STORAGE_FORMATS) {
+                (void)backend->remove(prefix + get_data_extension(format));
+            }
+        }
+    }
+}
+
+/* Read a snapshot, a delta snapshot is reconstructed from the nearest complete newer snapshot */
+score::Result<KvsMap> Kvs::open_snapshot(size_t snapshot_id) {
+    score::Result<KvsMap> result = score::MakeUnexpected(ErrorCode::UnmappedError);
+    bool error = false;
+
+    /* Nearest complete snapshot (the current KVS file is always complete) */
+    size_t base_id = snapshot_id;
+    std::optional<KvsStorageFormat> format;
+    while (!error) {
+        const std::string prefix = snapshot_prefix(base_id);
+        const auto format_res = prefix.empty() ? score::Result<std::optional<KvsStorageFormat>>(std::nullopt) : find_data_format(prefix);
+        if (!format_res) {
+            error = true;
+            result = score::MakeUnexpected(ErrorCode::PhysicalStorageFailure);
+        }else if (format_res.value().has_value()) {
+            format = format_res.value();
+            break;
+        }else if (0 == base_id) {
+            error = true;
+            result = score::MakeUnexpected(ErrorCode::FileNotFound);
+        }else{
+            --base_id;
+        }
+    }
+
+    KvsMap map;
+    uint32_t base_hash = 0;
+    if (!error) {
+        const std::string prefix = snapshot_prefix(base_id);
+        auto data_res = open_file(prefix, format.value(), OpenJsonNeedFile::Required);
+        if (!data_res) {
+            error = true;
+            result = score::MakeUnexpected(static_cast<ErrorCode>(*data_res.error()));
+        }else if (!read_hash_value(*backend, prefix + ".hash", base_hash)) {
+            error = true;
+            result = score::MakeUnexpected(ErrorCode::KvsHashFileReadError);
+        }else{
+            map = std::move(data_res.value());
+        }
+    }
+
+    /* Apply the deltas up to the requested snapshot */
+    for (size_t idx = base_id + 1; (!error) && (idx <= snapshot_id); ++idx) {
+        const std::string prefix = snapshot_prefix(idx);
+        const std::string delta_file = prefix + KVS_DELTA_EXTENSION;
+        auto in = backend->open_read(delta_file);
+        std::string data;
+        if ((nullptr == in) || (!read_stream(*in, data))) {
+            logger->LogError() << "error: file " << delta_file << " could not be read";
+            error = true;
+            result = score::MakeUnexpected(ErrorCode::KvsFileReadError);
+        }else if (!delta_apply(data, base_hash, map)) {
+            logger->LogError() << "error: KVS data corrupted (" << delta_file << ")";
+            stats_recorder->count(KvsCounter::ValidationFailure);
+            error = true;
+            result = score::MakeUnexpected(ErrorCode::ValidationFailed);
+        }else if (!read_hash_value(*backend, prefix + ".hash", base_hash)) {
+            logger->LogError() << "error: hash file " << prefix << ".hash could not be read";
+            error = true;
+            result = score::MakeUnexpected(ErrorCode::KvsHashFileReadError);
+        }
+    }
+    if (!error) {
+        result = std::move(map);
+    }
+
+    return result;
+}
+
+/* Write the data of a snapshot as complete KVS file */
+score::ResultBlank Kvs::snapshot_materialize(const SnapshotId& snapshot_id, const score::filesystem::Path& path) {
+    score::ResultBlank result = score::MakeUnexpected(ErrorCode::UnmappedError);
+    {
+        /* A pending background flush is part of the snapshots */
+        std::lock_guard<std::mutex> flusher_lock(flusher_mutex);
+        if (flusher) {
+            flusher->wait();
+        }
+    }
+    std::lock_guard<std::mutex> snapshot_lock(snapshot_mutex);
+    auto snapshot_count_res = snapshot_count();
+    if (!snapshot_count_res) {
+        result = score::MakeUnexpected(static_cast<ErrorCode>(*snapshot_count_res.error()));
+    }else if (snapshot_count_res.value() < snapshot_id.id) {
+        result = score::MakeUnexpected(ErrorCode::InvalidSnapshotId);
+    }else{
+        auto data_res = open_snapshot(snapshot_id.id);
+        if (!data_res) {
+            result = score::MakeUnexpected(static_cast<ErrorCode>(*data_res.error()));
+        }else{
+            auto write_res = serialize_map(data_res.value(), path);
+            if (!write_res) {
+                result = score::MakeUnexpected(static_cast<ErrorCode>(*write_res.error()));
+            }else{
+                result = score::ResultBlank{};
+            }
+        }
+    }
+
+    return result;
+}
+
 /* Restore the key-value store from a snapshot*/
 score::ResultBlank Kvs::snapshot_restore(const SnapshotId& snapshot_id) {
     score::ResultBlank result = score::MakeUnexpected(ErrorCode::UnmappedError);
-    std::unique_lock<std::mutex> lock(kvs_mutex, std::try_to_lock);
-    if (lock.owns_lock()) {
+    const KvsStatsTimer timer(*stats_recorder, KvsOperation::SnapshotRestore);
+    {
+        /* Snapshots must not be rotated by the background flush while one is restored */
+        std::lock_guard<std::mutex> flusher_lock(flusher_mutex);
+        if (flusher) {
+            flusher->wait();
+        }
+    }
+
+    /* Read the snapshot without the KVS lock, readers and writers only wait for the swap */
+    score::Result<KvsMap> data_res = score::MakeUnexpected(ErrorCode::UnmappedError);
+    {
+        std::lock_guard<std::mutex> snapshot_lock(snapshot_mutex);
         auto snapshot_count_res = snapshot_count();
-        if (!snapshot_count_res) {
-            result = score::MakeUnexpected(static_cast<ErrorCode>(*snapshot_count_res.error()));
-        }else{
+        if (KvsSharing::Reader == options.sharing) {
+            data_res = score::MakeUnexpected(ErrorCode::ReadOnly);
+        }else if (!snapshot_count_res) {
+            data_res = score::MakeUnexpected(static_cast<ErrorCode>(*snapshot_count_res.error()));
+        }else if (0 == snapshot_id.id) {
             /* Fail if the snapshot ID is the current KVS */
-            if (0 == snapshot_id.id) {
-                result = score::MakeUnexpected(ErrorCode::InvalidSnapshotId);
-            }else if (snapshot_count_res.value() < snapshot_id.id) {
-                result = score::MakeUnexpected(ErrorCode::InvalidSnapshotId);
+            data_res = score::MakeUnexpected(ErrorCode::InvalidSnapshotId);
+        }else if (snapshot_count_res.value() < snapshot_id.id) {
+            data_res = score::MakeUnexpected(ErrorCode::InvalidSnapshotId);
+        }else{
+            data_res = open_snapshot(snapshot_id.id);
+        }
+    }
+
+    if (!data_res) {
+        result = score::MakeUnexpected(static_cast<ErrorCode>(*data_res.error()));
+    }else{
+        KvsMap previous; /* Destroyed after the lock is released */
+        KvsLazyMap previous_lazy;
+        std::unique_ptr<const std::string> previous_lazy_data;
+        std::unique_lock<std::shared_mutex> lock = lock_exclusive();
+        if (lock.owns_lock()) {
+            notify_replaced(data_res.value());
+            previous.swap(kvs);
+            previous_lazy.swap(lazy_kvs);
+            previous_lazy_data.swap(lazy_data);
+            kvs.swap(data_res.value());
+            rebuild_slots(); /* Before the replaced entries the slots refer to are destroyed */
+            dirty_keys.clear();
+            full_flush_required = true; /* The log doesn't apply to the restored data */
+            result = score::ResultBlank{};
+        } else {
+            result = score::MakeUnexpected(ErrorCode::MutexLockFailed);
+        }
+    }
+
+    return result;
+}
+
+/* Keys that differ between two snapshots */
+score::Result<std::vector<std::string>> Kvs::snapshot_diff(const SnapshotId& snapshot_a, const SnapshotId& snapshot_b) {
+    score::Result<std::vector<std::string>> result = score::MakeUnexpected(ErrorCode::UnmappedError);
+    const size_t newer_id = std::min(snapshot_a.id, snapshot_b.id);
+    const size_t older_id = std::max(snapshot_a.id, snapshot_b.id);
+    {
+        /* A pending background flush is part of the snapshots */
+        std::lock_guard<std::mutex> flusher_lock(flusher_mutex);
+        if (flusher) {
+            flusher->wait();
+        }
+    }
+    std::lock_guard<std::mutex> snapshot_lock(snapshot_mutex);
+    auto snapshot_count_res = snapshot_count();
+    if (!snapshot_count_res) {
+        result = score::MakeUnexpected(static_cast<ErrorCode>(*snapshot_count_res.error()));
+    }else if (snapshot_count_res.value() < older_id) {
+        result = score::MakeUnexpected(ErrorCode::InvalidSnapshotId);
+    }else if (newer_id == older_id) {
+        result = std::vector<std::string>{};
+    }else{
+        /* Changes from the newer to the older snapshot, if all snapshots in between are deltas */
+        KvsChanges changes;
+        bool deltas = true;
+        uint32_t base_hash = 0;
+        score::ResultBlank changes_res = score::ResultBlank{};
+        if (!read_hash_value(*backend, snapshot_prefix(newer_id) + ".hash", base_hash)) {
+            deltas = false;
+        }
+        for (size_t idx = newer_id + 1; deltas && changes_res && (idx <= older_id); ++idx) {
+            const std::string prefix = snapshot_prefix(idx);
+            auto in = backend->open_read(prefix + KVS_DELTA_EXTENSION);
+            std::string data;
+            const auto format_res = find_data_format(prefix);
+            if ((!format_res) || format_res.value().has_value() || (nullptr == in) || (!read_stream(*in, data))) {
+                deltas = false; /* A complete snapshot (or none) */
             }else{
-                score::filesystem::Path restore_path = filename_prefix.Native() + "_" + to_string(snapshot_id.id);
-                auto data_res = open_json(
-                    restore_path,
-                    OpenJsonNeedFile::Required);
-                if (!data_res) {
-                    result = score::MakeUnexpected(static_cast<ErrorCode>(*data_res.error()));
-                }else{
-                    kvs = std::move(data_res.value());
-                    result = score::ResultBlank{};
+                changes_res = delta_changes(data, base_hash, changes);
+                if (changes_res && (!read_hash_value(*backend, prefix + ".hash", base_hash))) {
+                    changes_res = score::MakeUnexpected(ErrorCode::KvsHashFileReadError);
                 }
             }
         }
-    } else {
-        result = score::MakeUnexpected(ErrorCode::MutexLockFailed);
+
+        /* Only the newer snapshot is read, the deltas contain the values of the older one */
+        auto newer_res = changes_res ? open_snapshot(newer_id) : score::Result<KvsMap>(score::MakeUnexpected(static_cast<ErrorCode>(*changes_res.error())));
+        auto older_res = (newer_res && (!deltas)) ? open_snapshot(older_id) : score::Result<KvsMap>(KvsMap{});
+        if (!newer_res) {
+            result = score::MakeUnexpected(static_cast<ErrorCode>(*newer_res.error()));
+        }else if (!older_res) {
+            result = score::MakeUnexpected(static_cast<ErrorCode>(*older_res.error()));
+        }else{
+            const KvsMap& newer = newer_res.value();
+            std::vector<std::string> keys;
+            if (deltas) {
+                for (const auto& [key, value] : changes) {
+                    auto search = newer.find(key);
+                    if ((search == newer.end()) ? value.has_value() : ((!value.has_value()) || (value.value() != search->second))) {
+                        keys.push_back(key);
+                    }
+                }
+            }else{
+                /* Both snapshots are complete (sorted maps, walked once) */
+                const KvsMap& older = older_res.value();
+                auto newer_it = newer.begin();
+                auto older_it = older.begin();
+                while ((newer_it != newer.end()) || (older_it != older.end())) {
+                    if ((older_it == older.end()) || ((newer_it != newer.end()) && (newer_it->first < older_it->first))) {
+                        keys.push_back(newer_it->first);
+                        ++newer_it;
+                    }else if ((newer_it == newer.end()) || (older_it->first < newer_it->first)) {
+                        keys.push_back(older_it->first);
+                        ++older_it;
+                    }else{
+                        if (newer_it->second != older_it->second) {
+                            keys.push_back(newer_it->first);
+                        }
+                        ++newer_it;
+                        ++older_it;
+                    }
+                }
+            }
+            result = std::move(keys);
+        }
     }
 
     return result;
@@ -573,28 +2589,29 @@ score::ResultBlank Kvs::snapshot_restore(const SnapshotId& snapshot_id) {
 
 /* Get the filename for a snapshot*/
 score::Result<score::filesystem::Path> Kvs::get_kvs_filename(const SnapshotId& snapshot_id) const {
-    score::filesystem::Path filename = filename_prefix.Native() + "_" + std::to_string(snapshot_id.id) + ".json";
+    const std::string prefix = snapshot_prefix(snapshot_id.id);
     score::Result<score::filesystem::Path> result = score::MakeUnexpected(ErrorCode::UnmappedError);
 
-    const auto fname_exists_res = filesystem->standard->Exists(filename);
-    if (fname_exists_res) {
-        if (false == fname_exists_res.value()) {
+    const auto format_res = prefix.empty() ? score::Result<std::optional<KvsStorageFormat>>(std::nullopt) : find_data_format(prefix);
+    if (format_res) {
+        if (false == format_res.value().has_value()) {
             result = score::MakeUnexpected(ErrorCode::FileNotFound);
         } else {
-            result = filename;
+            result = score::filesystem::Path(prefix + get_data_extension(format_res.value().value()));
         }
     } else {
-        result = score::MakeUnexpected(static_cast<ErrorCode>(*fname_exists_res.error()));
+        result = score::MakeUnexpected(static_cast<ErrorCode>(*format_res.error()));
     }
     return result;
 }
 
 /* Get the hash filename for a snapshot*/
 score::Result<score::filesystem::Path> Kvs::get_hash_filename(const SnapshotId& snapshot_id) const {
-    score::filesystem::Path filename = filename_prefix.Native() + "_" + std::to_string(snapshot_id.id) + ".hash";
+    const std::string prefix = snapshot_prefix(snapshot_id.id);
+    score::filesystem::Path filename = prefix + ".hash";
     score::Result<score::filesystem::Path> result = score::MakeUnexpected(ErrorCode::UnmappedError);
 
-    const auto fname_exists_res = filesystem->standard->Exists(filename);
+    const auto fname_exists_res = prefix.empty() ? score::Result<bool>(false) : backend->exists(filename.Native());
     if (fname_exists_res) {
         if (false == fname_exists_res.value()) {
             result = score::MakeUnexpected(ErrorCode::FileNotFound);
@@ -607,4 +2624,14 @@ score::Result<score::filesystem::Path> Kvs::get_hash_filename(const SnapshotId&
     return result;
 }
 
+/* Retrieve the statistics of this instance */
+KvsStats Kvs::stats() const {
+    return stats_recorder->stats();
+}
+
+/* Clear the statistics of this instance */
+void Kvs::reset_stats() {
+    stats_recorder->reset();
+}
+
 } /* namespace score::mw::per::kvs */
@@ -14,24 +14,43 @@
 #define SCORE_LIB_KVS_KVS_HPP
 
 #include <atomic>
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
 #include <mutex>
 #include <optional>
+#include <set>
+#include <shared_mutex>
 #include <stdexcept>
 #include <string>
+#include <tuple>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 #include "internal/error.hpp"
+#include "internal/kvs_checksum.hpp"
+#include "internal/kvs_compress.hpp"
+#include "internal/kvs_lazy.hpp"
+#include "internal/kvs_manifest.hpp"
+#include "internal/kvs_notifier.hpp"
+#include "internal/kvs_stats.hpp"
+#include "kvs_backend.hpp"
 #include "kvsvalue.hpp"
 #include "score/filesystem/filesystem.h"
 #include "score/json/json_parser.h"
-#include "score/json/json_writer.h"
 #include "score/result/result.h"
 #include "score/mw/log/logger.h"
 
+/* Default of KvsOptions::snapshot_max_count */
 #define KVS_MAX_SNAPSHOTS 3
 
 namespace score::mw::per::kvs {
 
+class DefaultsImage; /* Memory-mapped defaults, see internal/kvs_defaults_image.hpp */
+class KvsFlusher; /* Background flush thread, see internal/kvs_flusher.hpp */
+class SharedStore; /* Shared-memory segment, see internal/kvs_shared.hpp */
+
 struct InstanceId {
     size_t id;
 
@@ -60,6 +79,150 @@ enum class OpenNeedKvs {
     Required = 1 /* Required: KVS must be already exist*/
 };
 
+/* Lock-Mode flag */
+enum class KvsLockMode {
+    TryLock = 0, /* TryLock: Fail with ErrorCode::MutexLockFailed if the KVS is currently locked */
+    Blocking = 1 /* Blocking: Readers share the lock in parallel, writers wait for exclusive access */
+};
+
+/* Storage-Format flag */
+enum class KvsStorageFormat {
+    Json = 0, /* Json: Typed JSON files (kvs_<id>_<n>.json) */
+    Binary = 1 /* Binary: Compact binary files (kvs_<id>_<n>.bin), see internal/kvs_binary.hpp */
+};
+
+/* Flush-Mode flag */
+enum class KvsFlushMode {
+    Full = 0, /* Full: Every flush writes the complete KVS file and rotates the snapshots */
+    Incremental = 1 /* Incremental: A flush appends the changed keys to kvs_<id>_0.log, the log is compacted into a full flush */
+};
+
+/* Snapshot-Layout flag */
+enum class KvsSnapshotLayout {
+    Legacy = 0, /* Legacy: Snapshot n is stored as kvs_<id>_<n>, every flush renames all snapshot files */
+    Generations = 1 /* Generations: Files of every flush get a new generation (kvs_<id>_g<n>), kvs_<id>.manifest lists the snapshots */
+};
+
+/* Durability flag */
+enum class KvsDurability {
+    Deferred = 0, /* Deferred: Files are replaced atomically, the OS writes them back to the storage (Kvs::sync forces it) */
+    Grouped = 1, /* Grouped: Every KvsOptions::sync_interval-th flush waits until the data is on the storage */
+    Always = 2 /* Always: Every flush waits until the data is on the storage (fdatasync) */
+};
+
+/* Sharing flag */
+enum class KvsSharing {
+    Private = 0, /* Private: The KVS data is only accessible in this process */
+    Owner = 1, /* Owner: The KVS is opened from its files and publishes its data in shared memory for readers */
+    Reader = 2 /* Reader: The KVS reads the data published by the owner process, writes fail with ErrorCode::ReadOnly */
+};
+
+/* Additional options for opening a KVS (configured via KvsBuilder) */
+struct KvsOptions {
+    KvsLockMode lock_mode = KvsLockMode::TryLock; /* Locking behaviour of the KVS accessors */
+    KvsStorageFormat format = KvsStorageFormat::Json; /* Format used by flush for the KVS data (defaults are always JSON) */
+    bool mapped_defaults = false; /* Look up default values lazily in a memory-mapped image (kvs_<id>_default.img) */
+    KvsFlushMode flush_mode = KvsFlushMode::Full; /* Amount of data written by flush */
+    bool background_flush = false; /* Serialize and write the data in a background thread (see Kvs::flush_async) */
+    KvsHashAlgorithm hash_algorithm = KvsHashAlgorithm::Adler32; /* Checksum written to the hash files (files of both are read) */
+    size_t snapshot_max_count = KVS_MAX_SNAPSHOTS; /* Number of snapshots kept by the flush */
+    KvsSnapshotLayout snapshot_layout = KvsSnapshotLayout::Legacy; /* File layout of the KVS file and its snapshots */
+    KvsDurability durability = KvsDurability::Deferred; /* When flushed files are synced to the storage */
+    size_t sync_interval = 8; /* Number of flushes per sync with KvsDurability::Grouped */
+    bool delta_snapshots = false; /* Store snapshots as delta to the next newer snapshot (see Kvs::snapshot_materialize) */
+    bool arena = false; /* Allocate the map and the elements of a loaded KVS file from one arena (see KvsArena) */
+    size_t open_workers = 1; /* Threads of open: >1 loads defaults and KVS data concurrently and converts large files in parallel */
+    bool lazy_values = false; /* Open only indexes the keys of the KVS file, every value is decoded by its first access */
+    KvsSharing sharing = KvsSharing::Private; /* Access of other processes to the KVS data (see Kvs::publish) */
+    size_t shared_size = 1024U * 1024U; /* Maximum size of the data published by a KvsSharing::Owner */
+    std::shared_ptr<KvsBackend> backend; /* Storage of the KVS files, nullptr: files of the OS (KvsFileBackend) */
+    KvsTraceHook trace_hook; /* Called after every operation measured by Kvs::stats, nullptr: no hook */
+    KvsCompression compression = KvsCompression::None; /* Block compression of the KVS files written by flush (compressed files are always read) */
+};
+
+/* Callback of an asynchronous flush, called with the result once the data is written (or the flush failed) */
+using KvsFlushCallback = std::function<void(const score::ResultBlank&)>;
+
+/**
+ * @class KvsWriteBatch
+ * @brief Collects changes of a KVS, Kvs::write applies them together under one lock.
+ *
+ * The keys and values are copied (or moved) into the batch without any lock, Kvs::write moves them
+ * into the KVS. Readers see either none or all changes of a batch. The changes are applied in the
+ * order they were added, so a later change of a key overrides an earlier one.
+ * A batch is not thread-safe, every thread should use its own batch.
+ */
+class KvsWriteBatch final {
+    public:
+        /* Adds setting the value of a key (the key and the value are copied) */
+        void set_value(const std::string_view key, const KvsValue& value);
+
+        /* Adds setting the value of a key (the key and the value are moved into the batch) */
+        void set_value(std::string&& key, KvsValue&& value);
+
+        /* Adds removing a key (a key that isn't written when the batch is applied is ignored) */
+        void remove_key(const std::string_view key);
+
+        /* Removes all changes from the batch */
+        void clear();
+
+        /* Number of changes in the batch */
+        size_t size() const;
+
+        /* Whether the batch contains no changes */
+        bool empty() const;
+
+    private:
+        friend class Kvs;
+
+        /* A change of a key, without value the key is removed */
+        struct Change {
+            std::string key;
+            std::optional<KvsValue> value;
+        };
+
+        std::vector<Change> changes;
+};
+
+class Kvs;
+
+/* Entries of one key in a Kvs: written value, indexed value of a lazily opened file and default value */
+struct KvsKeySlot {
+    std::optional<KvsMap::iterator> value;    /* Written value (a key is either written or indexed) */
+    std::optional<KvsLazyMap::iterator> lazy; /* Indexed value of a lazily opened file */
+    const KvsValue* default_value = nullptr;  /* Default value, nullptr: none (or only in the defaults image) */
+};
+
+/* Slots of all keys of a Kvs, the key of a slot refers to the key string of its default or otherwise of its
+   written or indexed entry, so a slot never copies its key */
+using KvsSlotMap = std::unordered_map<std::string_view, KvsKeySlot>;
+
+/**
+ * @class KeyHandle
+ * @brief A key resolved once by Kvs::resolve, repeated reads and writes through it skip the lookups of the key.
+ *
+ * The handle remembers the slot of its key (written value, indexed value of a lazily opened file and
+ * default value). The accessors of Kvs taking a handle use it directly as long as no key was added to or
+ * removed from the KVS since, otherwise they look the key up once more and update the handle.
+ * Like an iterator a handle belongs to one KVS and is used by one thread at a time; a handle of another KVS
+ * (or of a moved KVS) is looked up again and stays usable.
+ */
+class KeyHandle final {
+    public:
+        /* The key of the handle */
+        const std::string& key() const { return name; }
+
+    private:
+        friend class Kvs;
+
+        explicit KeyHandle(const std::string_view key) : name(key) {}
+
+        std::string name;
+        const Kvs* owner = nullptr; /* KVS the entries belong to, nullptr: not looked up yet */
+        uint64_t generation = 0; /* Kvs::key_generation of the lookup */
+        KvsSlotMap::iterator slot; /* Slot of the key, end() of the slots if the key has no entry */
+};
+
 /* Need-File flag */
 enum class OpenJsonNeedFile {
     Optional = 0, /* Optional: If the file doesn't exist, start with empty data */
@@ -81,36 +244,199 @@ enum class OpenJsonNeedFile {
  * - `get_all_keys`: Retrieves all keys stored in the KVS (only written keys, not defaults).
  * - `key_exists`: Checks if a specific key exists in the KVS (only written keys).
  * - `get_value`: Retrieves the value associated with a specific key (returns default if not written).
+ * - `visit_value`: Gives read access to the value of a specific key without copying it.
+ * - `get_values`: Retrieves the values of several keys under one lock (returns defaults if not written).
+ * - `scan_prefix`: Gives read access to all written keys with a given prefix in key order.
+ * - `get_value_as`: Retrieves the value of a specific key as the given type.
+ * - `resolve`: Returns a KeyHandle of a key, `get_value`, `visit_value`, `get_value_as`, `set_value`, `reset_key` and
+ *   `is_value_default` also accept it.
  * - `get_default_value`: Retrieves the default value associated with a specific key.
  * - `reset_key`: Resets a key to its default value if available.
  * - `has_default_value`: Checks if a default value exists for a specific key.
- * - `set_value`: Sets the value for a specific key in the KVS.
+ * - `is_value_default`: Checks if a specific key has a default value and isn't written.
+ * - `set_value`: Sets the value for a specific key in the KVS (copies or moves the value).
+ * - `emplace_value`: Sets the value for a specific key, the value is constructed in place.
  * - `remove_key`: Removes a specific key from the KVS.
+ * - `write`: Applies the changes of a KvsWriteBatch under one lock (optionally followed by a flush).
  * - `flush`: Flushes the KVS to storage.
+ * - `flush_async`: Requests a flush in the background thread and returns a future of its result.
+ * - `sync`: Waits until all flushed files are on the storage.
  * - `flush_default`: Flushes the default values to storage.
  * - `snapshot_count`: Retrieves the number of available snapshots.
  * - `snapshot_max_count`: Retrieves the maximum number of snapshots allowed.
  * - `snapshot_restore`: Restores the KVS from a specified snapshot.
  * - `get_kvs_filename`: Retrieves the filename (path) associated with a snapshot.
  * - `get_hash_filename`: Retrieves the hashname (path) associated with a snapshot.
+ * - `snapshot_materialize`: Writes the complete data of a snapshot (also of a delta snapshot) to a file.
+ * - `snapshot_diff`: Returns the keys that differ between two snapshots.
+ * - `publish`: Publishes the current data for the reader processes (KvsSharing::Owner).
+ * - `subscribe`, `subscribe_prefix`: Registers a callback for the changes of a key or of all keys with a prefix.
+ * - `unsubscribe`: Removes a subscription.
+ * - `wait_notifications`: Waits until the changes made so far are delivered to the subscribers.
+ * - `stats`, `reset_stats`: Retrieves or clears the latency histograms and failure counters of this instance.
  *
  * Private Methods:
+ * - `lock_shared`: Acquires the KVS lock for reading according to the configured lock mode.
+ * - `lock_exclusive`: Acquires the KVS lock for writing according to the configured lock mode.
  * - `snapshot_rotate`: Rotates the snapshots, ensuring that the maximum count is maintained.
- * - `parse_json_data`: Parses JSON data into an unordered map of key-value pairs.
- * - `open_json`: Opens a JSON file and returns its contents as an unordered map of key-value pairs.
+ * - `snapshot_rotate_manifest`: Makes the next generation the current KVS file by one manifest update (generation layout).
+ * - `snapshot_prefix`: Returns the filename prefix of a snapshot (empty if it isn't available).
+ * - `open_manifest`: Reads the manifest of the generation layout (takes over legacy files if there is none).
+ * - `write_manifest`: Replaces the manifest atomically (temporary file + rename).
+ * - `remove_snapshot_files`: Removes the data and hash files of a snapshot that was rotated out.
+ * - `open_delta_base`: Makes the data of the current KVS file the base of the next delta (read once after open).
+ * - `snapshot_delta`: Stores snapshot 1 (the previous KVS file) as delta to the new KVS file.
+ * - `open_snapshot`: Reads a snapshot, a delta snapshot is reconstructed from the nearest complete newer snapshot.
+ * - `parse_json_data`: Parses JSON data into a map of key-value pairs.
+ * - `find_data_format`: Determines in which storage format the data of a snapshot is available.
+ * - `open_file`: Opens a JSON or binary file and returns its contents as a map of key-value pairs (or only indexes it).
+ * - `open_json`: Opens a JSON file and returns its contents as a map of key-value pairs.
+ * - `open_data`: Opens the data of a snapshot in the format it is available in (migration between formats).
+ * - `open_defaults`: Opens the default values (from the memory-mapped defaults image if enabled).
+ * - `open_log`: Replays the write-ahead log of the incremental flush on the opened KVS data.
+ * - `open_shared`: Creates (KvsSharing::Owner) or attaches (KvsSharing::Reader) the shared-memory segment.
+ * - `resolve_handle`: Looks the slot of a KeyHandle up again if keys were added or removed since its last lookup.
+ * - `next_key_generation`: Draws the next value of `key_generation` from the process-wide counter.
+ * - `rebuild_slots`: Builds the slots of all keys after `kvs`, `lazy_kvs` or `default_values` were replaced.
+ * - `insert_slot`: Adds a key written to `kvs` to its slot.
+ * - `erase_entry`: Erases the written or indexed value of a slot (the slot stays while the key has a default).
+ * - `slot_value`: Returns the written, indexed or default value of a slot (or the value of the defaults image).
+ * - `handle_value`: Finds the written or the default value of a KeyHandle (`slot_value` of its cached slot).
+ * - `find_value`: Finds the written or the default value of a key by one slot lookup (decodes the value of a lazily
+ *   opened file on first access, a value published by the owner or decoded from the defaults image is copied into
+ *   the given storage).
+ * - `lazy_value`: Decodes the value of a lazily opened file once and returns it.
+ * - `drop_lazy`: Drops the indexed value of a slot whose key is written.
+ * - `materialize_lazy`: Moves all values of a lazily opened file into the map (decodes the ones not accessed yet).
+ * - `mark_dirty`: Records a changed key for the incremental flush.
+ * - `notify_change`: Queues a changed key for the subscribers.
+ * - `notify_replaced`: Queues the keys that differ between the current data and the data replacing it.
+ * - `subscribe_changes`: Adds a subscription for a key or a prefix.
+ * - `flush_full`: Writes the complete KVS file (rotates the snapshots and removes the log).
+ * - `flush_incremental`: Appends the changed keys to the log (compacts the log by a full flush if it gets too large).
+ * - `flush_now`: Flushes the KVS in the calling thread according to the configured flush mode.
+ * - `sync_due`: Counts a flush and returns whether its files have to be synced (durability policy).
+ * - `stop_flusher`: Finishes a pending background flush and stops the background thread.
+ * - `serialize_data`: Serializes a copy of the KVS data in the configured storage format directly into a file (JSON is
+ *   streamed, the KVS lock is only held for the copy), optionally together with the delta back to the previous KVS file.
+ * - `serialize_map`: Serializes a map in the configured storage format into a file.
+ * - `create_data_dir`: Creates the directory of a KVS file.
+ * - `write_hash_file`: Writes the hash file of the current KVS file.
+ * - `write_data`: Writes the provided data to a JSON or binary file.
  * - `write_json_data`: Writes the provided data to a JSON file.
  *
  * Private Members:
- * - `kvs_mutex`: A mutex for ensuring thread safety.
- * - `kvs`: An unordered map for storing key-value pairs.
+ * - `kvs_mutex`: A reader-writer mutex for ensuring thread safety (shared for reads, exclusive for writes).
+ * - `options`: The options the KVS was opened with (e.g. lock mode, storage format).
+ * - `kvs`: A map for storing key-value pairs (lookup with std::string_view without allocation).
+ * - `lazy_data`, `lazy_kvs`, `lazy_format`: Data, index and format of a lazily opened KVS file, a key is either in
+ *   `kvs` or in `lazy_kvs` (only used with KvsOptions::lazy_values).
+ * - `lazy_mutex`: A mutex for decoding values of `lazy_kvs` by readers that share kvs_mutex.
+ * - `key_generation`: Replaced whenever a key is added to or removed from `kvs` or `lazy_kvs` (KeyHandle lookups). Every value
+ *   is drawn from one process-wide counter, so a KVS created later at the same address never matches an old handle.
+ * - `slots`: The slot of every key with the entries of `kvs`, `lazy_kvs` and `default_values`, so get_value(), reset_key(),
+ *   is_value_default() and the other accessors by key find the written and the default value by one lookup. A slot refers to
+ *   the key string of one of its entries, the keys are not copied into the slots.
  * - `default_mutex`: A mutex for default value operations.
- * - `default_values`: An unordered map for storing optional default values.
+ * - `default_values`: A map for storing optional default values (only replaced by open and a move, so
+ *   get_default_value() and has_default_value() read it without kvs_mutex).
+ * - `default_image`: The memory-mapped defaults image (only used with KvsOptions::mapped_defaults).
+ * - `dirty_keys`: Keys changed since the last flush (only tracked with KvsFlushMode::Incremental).
+ * - `full_flush_required`: Whether the next flush has to write the complete KVS file.
+ * - `base_hash`, `base_size`, `log_size`: State of the current KVS file and its log (guarded by snapshot_mutex).
+ * - `unsynced_flushes`: Flushes since the last sync (KvsDurability::Grouped).
+ * - `delta_base`, `delta_base_hash`: Data and hash of the current KVS file (KvsOptions::delta_snapshots).
  * - `filename_prefix`: A path prefix for filenames associated with snapshots.
- * - `filesystem`: A unique pointer to a filesystem handler for file operations.
- * - `parser`: A unique pointer to a JSON parser for reading KVS data.
- * - `writer`: A unique pointer to a JSON writer for writing KVS data.
+ * - `snapshot_mutex`: A mutex for the KVS files and the snapshots, held while a flush writes them (one flush at a time)
+ *   and while a snapshot is read (lock order: snapshot_mutex before kvs_mutex).
+ * - `manifest_mutex`: A mutex for the manifest (lock order: kvs_mutex before manifest_mutex).
+ * - `manifest`: The snapshot index of the generation layout (cached, the snapshot count needs no file access).
+ * - `backend`: The storage of the KVS files (KvsOptions::backend or the files of the OS).
+ * - `parser`: A unique pointer to a JSON parser for reading KVS data (not thread-safe: the defaults read concurrently
+ *   by open and lazily decoded values use parsers of their own).
+ * - `flusher_mutex`: A mutex for starting and stopping the background flusher.
+ * - `flusher`: The background flusher (only used with KvsOptions::background_flush, started by the first flush).
+ * - `shared`: The shared-memory segment (only used with KvsSharing::Owner and KvsSharing::Reader).
+ * - `notifier`: Delivers the changes to the subscribers (its thread is started by the first subscription).
+ * - `stats_recorder`: Collects the latencies and failure counters of this instance (see stats()).
  *
  * ----------------Notice----------------
+ * - With KvsLockMode::TryLock (default) an accessor returns ErrorCode::MutexLockFailed if the lock
+ *   can't be acquired immediately. Readers don't block each other, only a concurrent writer makes them fail.
+ * - With KvsLockMode::Blocking readers run in parallel and writers wait until they get exclusive access.
+ * - With KvsStorageFormat::Binary the KVS data is stored as kvs_<id>_<n>.bin instead of kvs_<id>_<n>.json.
+ *   Existing files of the other format are still read, the next flush writes the configured format
+ *   (the older snapshots keep their format until they are rotated out).
+ * - With KvsOptions::mapped_defaults the defaults JSON file is converted once into kvs_<id>_default.img.
+ *   Later opens only map this image and default values are decoded on access. The image is rebuilt
+ *   if kvs_<id>_default.hash changes.
+ * - With KvsFlushMode::Incremental a flush only appends the keys changed since the last flush to kvs_<id>_0.log.
+ *   The log is replayed by open (in every flush mode) and compacted by a full flush once it is larger than the
+ *   KVS file. Snapshots are only created by full flushes, reset() and snapshot_restore() also trigger a full flush.
+ * - A flush only copies the map under the lock (Arrays and Objects are shared), writers are not blocked while
+ *   the copy is encoded and written.
+ * - With KvsOptions::background_flush the data is serialized and written by a background thread. Requests made
+ *   while a flush is pending are coalesced into this flush. flush() waits for the result, flush_async() only requests the flush.
+ *   A move or the destruction of the KVS finishes a pending flush first.
+ * - With KvsHashAlgorithm::Crc32c the hash files contain a tag byte before the CRC-32C value, Adler-32 hash files
+ *   keep the legacy 4-byte format. Both formats are verified with the algorithm of the file, so existing files
+ *   stay readable after a change of the algorithm.
+ * - With KvsSnapshotLayout::Generations a flush writes the KVS file under a new generation number and replaces
+ *   kvs_<id>.manifest instead of renaming every snapshot. Legacy files are taken over by the first flush without
+ *   renaming them and are removed once they are rotated out. The log stays kvs_<id>_0.log in both layouts.
+ * - A full flush writes the KVS file and its hash file under temporary names and renames them over the current
+ *   files, the current file is linked (not moved) into snapshot 1. A power loss leaves the previous or the new
+ *   KVS file, open completes a flush that was interrupted between the two renames. KvsOptions::durability
+ *   selects which flushes also wait for the storage (fdatasync of the files and their directory).
+ * - With KvsOptions::delta_snapshots a flush stores snapshot 1 as kvs_<id>_1.delta, the changes from the new KVS file
+ *   to the previous one. Older snapshots are already deltas, so a flush only writes the changed keys once more.
+ *   snapshot_restore() applies the deltas to the nearest complete snapshot, delta snapshots have no data file
+ *   (get_kvs_filename() fails with ErrorCode::FileNotFound), snapshot_materialize() writes their data on demand.
+ * - With KvsOptions::arena the map nodes and the Array and Object elements of a loaded file (open, snapshot_restore())
+ *   are allocated from one KvsArena instead of separately from the heap. Changes made later use the heap. The arena is
+ *   released in bulk once the loaded data is replaced (reset(), snapshot_restore()) and no copied value shares its elements.
+ * - With KvsOptions::open_workers > 1 open reads the defaults concurrently to the KVS data, and the top-level entries of
+ *   a large JSON file are converted by up to open_workers threads (every thread converts at least 1024 entries).
+ *   Binary files are always decoded by one thread.
+ * - With KvsOptions::lazy_values open verifies the hash of the KVS file, but only indexes its keys. A value is decoded by
+ *   its first access, so the time to the first read doesn't depend on the number of keys. Values that are replaced or
+ *   removed are never decoded, a full flush decodes the remaining ones. An invalid value fails its access (or the flush)
+ *   instead of open. Lazily decoded values are neither converted in parallel nor allocated from an arena.
+ * - With KvsSharing::Owner the KVS publishes its data in a POSIX shared-memory segment (kvs_<id>_<hash of the path>)
+ *   by open, by every successful flush and by publish(). With KvsSharing::Reader open only attaches this segment:
+ *   reads copy the value out of the published data with a seqlock (no lock shared with the owner, no IPC round-trip
+ *   and no copy of the data on the heap of the reader). Readers see the state of the last publish, their writes fail
+ *   with ErrorCode::ReadOnly and have to be forwarded to the owner process (e.g. by the IPC of the application).
+ *   The segment outlives the owner, readers stay attached while the owner restarts and see its data once it is opened
+ *   again. A flush whose publish fails still succeeds (its files are written), the failure is logged and counted as
+ *   KvsCounter::PublishFailure, publish() retries it and returns the error.
+ *   A reader always looks its defaults up in the mapped defaults image (as with KvsOptions::mapped_defaults, built by the
+ *   first process that needs it), so the defaults are shared in the page cache instead of being parsed into the heap of
+ *   every reader. Only backends whose files can't be memory-mapped (or a missing defaults hash file) load them on the heap.
+ * - Subscribers are called by a background thread with batches of the changes made by set_value(), emplace_value(),
+ *   remove_key(), reset_key(), write(), reset() and snapshot_restore() (only the keys whose value differs). Writers only
+ *   queue a change under the KVS lock, the callbacks never extend the time the lock is held. A subscriber may access the
+ *   KVS, but slow callbacks delay later batches. Without subscribers no change is copied.
+ * - Open, flush, snapshot rotation and restore and the reading (hash verification) and parsing of KVS files are timed
+ *   into per-instance latency histograms, failed lock attempts, flushes and hash checks are counted (see stats()).
+ *   Recording only updates relaxed atomics, KvsOptions::trace_hook is called in addition if set. The accessors
+ *   (get_value, set_value, ...) are not timed, a failed lock attempt is their only recorded event.
+ * - Every file of the KVS is accessed through KvsOptions::backend (see kvs_backend.hpp), e.g. KvsMemoryBackend
+ *   keeps the files in memory for tests and benchmarks. Backends whose files can't be memory-mapped read the JSON
+ *   defaults on every open instead of KvsOptions::mapped_defaults.
+ * - The accessors by key look the key up once in the slots, the slot holds the written (or indexed) and the default value
+ *   of the key. Defaults of the mapped defaults image have no slot, a key without a written value or an in-memory default
+ *   is looked up in the image in addition.
+ * - A KeyHandle (resolve()) caches the slot of its key, reads and overwrites through it need no lookup at all. Adding or
+ *   removing any key (including reset(), snapshot_restore() and the decoding of all values of a lazily opened file by a
+ *   full flush) makes every handle look its key up once more. A reader of the shared data has no local entries, its
+ *   handles always look the key up in the published data.
+ * - snapshot_restore() reads the snapshot without the KVS lock, readers and writers only wait while the restored
+ *   data is swapped in. A flush waits until the snapshot is read.
+ * - With KvsOptions::compression a flush compresses the KVS file (snapshots and snapshot_materialize() included) in
+ *   blocks of 64 KiB while it is serialized (see internal/kvs_compress.hpp). The file keeps its name, open detects the
+ *   compressed data by its header after the hash check, so files of both settings are read. The log, the delta
+ *   snapshots and the defaults are not compressed. Lazily opened files are decompressed completely by open.
  * - Blank should be used instead of void for Result class
  * Refer: "Blank and score::ResultBlank shall be used for `T` instead of `void`" in result.h
  * A KVS Object is not copyable, but it can be moved.
@@ -128,6 +454,9 @@ class Kvs final {
         Kvs(Kvs&& other) noexcept;
         Kvs& operator=(Kvs&& other) noexcept;
 
+        // Destructor finishes a pending background flush
+        ~Kvs();
+
         /**
          * @brief Opens the key-value store with the specified instance ID and flags.
          *
@@ -145,6 +474,7 @@ class Kvs final {
          *                 - OpenNeedKvs::Optional: An empty KVS will be used if no KVS exists.
          * @param dir The directory path where the KVS files are located. It is passed as an rvalue reference to avoid unnecessary copying.
          *            Use "" or "." for the current directory.
+         * @param options Additional options (e.g. the lock mode). Defaults to KvsOptions{}.
          * @return A Result object containing either:
          *         - A Kvs object if the operation is successful.
          *         - An ErrorCode if an error occurs during the operation.
@@ -152,7 +482,7 @@ class Kvs final {
          * IMPORTANT: Instead of using the Kvs::open method directly, it is recommended to use the KvsBuilder class.
          *
          */
-        static score::Result<Kvs> open(const InstanceId& instance_id, OpenNeedDefaults need_defaults, OpenNeedKvs need_kvs, const std::string&& dir);
+        static score::Result<Kvs> open(const InstanceId& instance_id, OpenNeedDefaults need_defaults, OpenNeedKvs need_kvs, const std::string&& dir, const KvsOptions& options = KvsOptions{});
 
 
         /**
@@ -196,6 +526,119 @@ class Kvs final {
         score::Result<KvsValue> get_value(const std::string_view key);
 
 
+        /**
+         * @brief Gives read access to the value associated with the specified key without copying it.
+         *        If no Key was written, the default value is visited if available.
+         *
+         * The visitor is called while the KVS is locked for reading. The reference passed to the visitor
+         * is only valid during the call, copy the required parts if they are needed afterwards.
+         * Important: The visitor must not call any other function of this KVS.
+         *
+         * @param key The key for which the value is to be visited.
+         * @param visitor Function which is called with the stored value.
+         * @return A score::Result object that indicates the success or failure of the operation.
+         *         - On success: Returns a blank score::Result (the visitor was called).
+         *         - On failure: Returns an ErrorCode describing the error (the visitor was not called).
+         */
+        score::ResultBlank visit_value(const std::string_view key, const std::function<void(const KvsValue&)>& visitor);
+
+
+        /**
+         * @brief Retrieves the values associated with several keys under a single lock acquisition.
+         *        If a key was not written, its default value is returned if available.
+         *
+         * The values are a consistent view of the store, no writer runs between the lookups.
+         *
+         * @param keys The keys for which the values are to be retrieved.
+         * @return A score::Result object containing a vector with one score::Result per key (in the order of keys,
+         *         holding the value like get_value() or ErrorCode::KeyNotFound), or an ErrorCode if the store
+         *         can't be locked.
+         */
+        score::Result<std::vector<score::Result<KvsValue>>> get_values(const std::vector<std::string_view>& keys);
+
+
+        /**
+         * @brief Gives read access to all written keys that start with the specified prefix, in key order.
+         *        Important: Like get_all_keys() it only visits written keys, no default keys.
+         *
+         * Only the matching keys are visited, the other keys are neither visited nor copied. The visitor is
+         * called while the KVS is locked for reading, key and value are only valid during the call.
+         * Important: The visitor must not call any other function of this KVS.
+         *
+         * @param prefix The prefix of the visited keys (an empty prefix visits all written keys).
+         * @param visitor Function which is called with every matching key and its value.
+         * @return A score::Result object that indicates the success or failure of the operation.
+         *         - On success: Returns a blank score::Result (also if no key matches).
+         *         - On failure: Returns an ErrorCode describing the error (the visitor was not called).
+         */
+        score::ResultBlank scan_prefix(const std::string_view prefix,
+                                       const std::function<void(const std::string&, const KvsValue&)>& visitor);
+
+
+        /**
+         * @brief Retrieves the value associated with the specified key as the given type.
+         *        If no Key was written, it returns the default value if available.
+         *
+         * Only the requested alternative is copied out of the stored value, e.g. get_value_as<int32_t>
+         * copies a single integer and no KvsValue is created.
+         *
+         * @tparam T The requested type, one of the KvsValue alternatives
+         *           (int32_t, uint32_t, int64_t, uint64_t, double, bool, std::string, std::nullptr_t,
+         *           KvsValue::Array, KvsValue::Object (copies of the container) or KvsValue::SharedArray,
+         *           KvsValue::SharedObject (shared container, O(1))).
+         * @param key The key for which the value is to be retrieved.
+         * @return A score::Result object containing either the value as T or an ErrorCode.
+         *         Returns ErrorCode::ConversionFailed if the stored value has a different type.
+         */
+        template <typename T>
+        score::Result<T> get_value_as(const std::string_view key);
+
+
+        /**
+         * @brief Resolves a key once for repeated accesses.
+         *
+         * The returned handle is accepted by get_value(), visit_value(), get_value_as() and set_value()
+         * instead of the key. These accessors behave like the ones taking the key (defaults included), but
+         * use the map entries remembered by the handle instead of looking up the key on every call.
+         * The key doesn't need to exist, a handle of a key that is written later is updated by its next use.
+         *
+         * @param key The key to resolve.
+         * @return The handle of the key (if the KVS can't be locked, its first use looks the key up).
+         */
+        KeyHandle resolve(const std::string_view key);
+
+
+        /**
+         * @brief Retrieves the value of a resolved key (see get_value(const std::string_view)).
+         *
+         * @param handle The handle returned by resolve(), updated if keys were added or removed since its last use.
+         * @return A score::Result object containing either the retrieved value (KvsValue) or an ErrorCode.
+         */
+        score::Result<KvsValue> get_value(KeyHandle& handle);
+
+
+        /**
+         * @brief Gives read access to the value of a resolved key without copying it
+         *        (see visit_value(const std::string_view, ...)).
+         *
+         * @param handle The handle returned by resolve().
+         * @param visitor Function which is called with the stored value (must not call any other function of this KVS).
+         * @return A score::Result object that indicates the success or failure of the operation.
+         */
+        score::ResultBlank visit_value(KeyHandle& handle, const std::function<void(const KvsValue&)>& visitor);
+
+
+        /**
+         * @brief Retrieves the value of a resolved key as the given type (see get_value_as(const std::string_view)).
+         *
+         * @tparam T The requested type, one of the KvsValue alternatives.
+         * @param handle The handle returned by resolve().
+         * @return A score::Result object containing either the value as T or an ErrorCode.
+         */
+        template <typename T>
+        score::Result<T> get_value_as(KeyHandle& handle);
+
+
         /**
          * @brief Retrieves the default value associated with the specified key.
          *
@@ -230,6 +673,17 @@ class Kvs final {
         score::ResultBlank reset_key(const std::string_view key);
 
 
+        /**
+         * @brief Resets a resolved key to its default value (see reset_key(const std::string_view)).
+         *
+         * The default and the written value are taken from the handle, no key is looked up.
+         *
+         * @param handle The handle returned by resolve().
+         * @return A score::Result object that indicates the success or failure of the operation.
+         */
+        score::ResultBlank reset_key(KeyHandle& handle);
+
+
         /**
          * @brief Checks if the specified key has a default value.
          *
@@ -244,6 +698,30 @@ class Kvs final {
         score::Result<bool> has_default_value(const std::string_view key);
 
 
+        /**
+         * @brief Checks if the value of the specified key is its default value (the key isn't written).
+         *
+         * Unlike has_default_value() and get_default_value() the written value and the default are looked up
+         * under one lock, so the result is consistent with a concurrent writer.
+         *
+         * @param key The key to check.
+         * @return score::Result<bool>
+         *         - On success: true if the key has a default value and isn't written, false if it is written.
+         *         - On failure: ErrorCode::KeyNotFound if the key is neither written nor has a default value,
+         *           or another ErrorCode (e.g. ErrorCode::MutexLockFailed).
+         */
+        score::Result<bool> is_value_default(const std::string_view key);
+
+
+        /**
+         * @brief Checks if the value of a resolved key is its default value (see is_value_default(const std::string_view)).
+         *
+         * @param handle The handle returned by resolve().
+         * @return score::Result<bool> like is_value_default(const std::string_view).
+         */
+        score::Result<bool> is_value_default(KeyHandle& handle);
+
+
         /**
          * @brief Stores a key-value pair in the key-value store.
          *
@@ -258,6 +736,52 @@ class Kvs final {
         score::ResultBlank set_value(const std::string_view key, const KvsValue& value);
 
 
+        /**
+         * @brief Stores a key-value pair in the key-value store by moving the key and the value.
+         *
+         * Large values built by the caller (e.g. Arrays and Objects) are transferred without copying them,
+         * a new key only needs the allocation of the map node.
+         *
+         * @param key The key associated with the value to be stored (moved into the store).
+         * @param value The value to be stored (moved into the store).
+         *
+         * @return A score::Result object that indicates the success or failure of the operation.
+         *         - On success: Returns a blank score::Result.
+         *         - On failure: Returns an ErrorCode describing the error (key and value are left unchanged).
+         */
+        score::ResultBlank set_value(std::string&& key, KvsValue&& value);
+
+
+        /**
+         * @brief Stores the value of a resolved key (see set_value(const std::string_view, const KvsValue&)).
+         *
+         * An existing key is overwritten without a lookup, a new key is added once and the handle
+         * refers to the written value afterwards.
+         *
+         * @param handle The handle returned by resolve().
+         * @param value The value to be stored.
+         * @return A score::Result object that indicates the success or failure of the operation.
+         */
+        score::ResultBlank set_value(KeyHandle& handle, const KvsValue& value);
+
+
+        /**
+         * @brief Stores a value constructed in place from the given arguments.
+         *
+         * The KvsValue is constructed directly in the map (from the KvsValue constructor arguments,
+         * e.g. a KvsValue::Array&&), only a new key is copied into the store.
+         *
+         * @param key The key associated with the value to be stored.
+         * @param args The arguments of the KvsValue constructor.
+         *
+         * @return A score::Result object that indicates the success or failure of the operation.
+         *         - On success: Returns a blank score::Result.
+         *         - On failure: Returns an ErrorCode describing the error.
+         */
+        template <typename... Args>
+        score::ResultBlank emplace_value(const std::string_view key, Args&&... args);
+
+
         /**
          * @brief Removes a key-value pair from the store based on the specified key.
          *
@@ -270,6 +794,23 @@ class Kvs final {
         score::ResultBlank remove_key(const std::string_view key);
 
 
+        /**
+         * @brief Applies all changes of a write batch under a single lock acquisition.
+         *
+         * The keys and values are moved from the batch into the store, readers never see a partially
+         * applied batch. Removed keys that aren't written are ignored (unlike remove_key()).
+         * The batch is empty afterwards, only if the lock can't be acquired it is left unchanged (to retry it).
+         *
+         * @param batch The changes to be applied.
+         * @param flush_after True to flush the store after the changes are applied.
+         * @return A score::Result object that indicates the success or failure of the operation.
+         *         - On success: Returns a blank score::Result.
+         *         - On failure: Returns an ErrorCode describing the error (e.g. ErrorCode::MutexLockFailed,
+         *           nothing is applied then; a failed flush keeps the applied changes).
+         */
+        score::ResultBlank write(KvsWriteBatch&& batch, bool flush_after = false);
+
+
         /**
          * @brief Flushes the key-value store, ensuring that all pending changes
          *        are written to the underlying storage.
@@ -281,6 +822,34 @@ class Kvs final {
         score::ResultBlank flush();
 
 
+        /**
+         * @brief Requests a flush of the key-value store without waiting for it.
+         *
+         * With KvsOptions::background_flush the flush is done by a background thread. If a flush is
+         * already pending (not started yet), the request joins it and gets the same future. Without
+         * background flush the KVS is flushed in the calling thread and the returned future is ready.
+         *
+         * @param callback Optional callback, called with the result before the future becomes ready
+         *                 (in the background thread, it must not wait for a flush of this KVS).
+         * @return A future of the flush result.
+         *         - On success: Returns a blank score::Result once the data is written.
+         *         - On failure: Returns an ErrorCode describing the error.
+         */
+        std::shared_future<score::ResultBlank> flush_async(KvsFlushCallback callback = nullptr);
+
+        /**
+         * @brief Waits until all flushed files of the key-value store are on the storage.
+         *
+         * Syncs the current KVS file, its hash file, the log and the manifest (if available) and their
+         * directory. Needed with KvsDurability::Deferred or Grouped before data must survive a power loss.
+         *
+         * @return A score::Result object that indicates the success or failure of the operation.
+         *         - On success: Returns a blank score::Result.
+         *         - On failure: Returns ErrorCode::PhysicalStorageFailure.
+         */
+        score::ResultBlank sync();
+
+
         /**
          * @brief Retrieves the number of snapshots currently stored in the key-value store.
          *
@@ -295,7 +864,8 @@ class Kvs final {
          * @brief Retrieves the maximum number of snapshots that can be stored.
          *
          * This function returns the upper limit on the number of snapshots
-         * that the key-value store can maintain at any given time.
+         * that the key-value store can maintain at any given time
+         * (KvsOptions::snapshot_max_count, KVS_MAX_SNAPSHOTS by default).
          *
          * @return The maximum count of snapshots as a size_t value.
          */
@@ -320,6 +890,8 @@ class Kvs final {
         /**
          * @brief Retrieves the filename associated with a given snapshot ID in the key-value store.
          *
+         * The filename ends with ".json" or ".bin", depending on the format the snapshot was written in.
+         *
          * @param snapshot_id The identifier of the snapshot for which the filename is to be retrieved.
          * @return score::ResultBlank
          *         - On success: A score::filesystem::Path with the filename (path) associated with the snapshot ID.
@@ -342,38 +914,310 @@ class Kvs final {
          */
         score::Result<score::filesystem::Path> get_hash_filename(const SnapshotId& snapshot_id) const;
 
+
+        /**
+         * @brief Writes the data of a snapshot as complete KVS file (without hash file).
+         *
+         * A snapshot stored as delta (KvsOptions::delta_snapshots) is reconstructed from the newer snapshots,
+         * so its data is available like the data of a complete snapshot at get_kvs_filename().
+         *
+         * @param snapshot_id The identifier of the snapshot (0 is the current KVS file).
+         * @param path The file to write, in the configured storage format.
+         * @return score::ResultBlank
+         *         - On success: An empty score::Result, the file contains the data of the snapshot.
+         *         - On failure: An error code describing the reason for the failure.
+         */
+        score::ResultBlank snapshot_materialize(const SnapshotId& snapshot_id, const score::filesystem::Path& path);
+
+
+        /**
+         * @brief Returns the keys that were added, changed or removed between two snapshots.
+         *
+         * If all snapshots between them are stored as delta, only the newer snapshot is read and the
+         * values of the older one are taken from the deltas. Otherwise both snapshots are read.
+         *
+         * @param snapshot_a The identifier of the first snapshot (0 is the current KVS file).
+         * @param snapshot_b The identifier of the second snapshot (the order of the IDs doesn't matter).
+         * @return score::Result<std::vector<std::string>>
+         *         - On success: The differing keys in ascending order (empty if the snapshots are equal).
+         *         - On failure: An error code describing the reason for the failure.
+         */
+        score::Result<std::vector<std::string>> snapshot_diff(const SnapshotId& snapshot_a, const SnapshotId& snapshot_b);
+
+
+        /**
+         * @brief Publishes the current data in the shared-memory segment for the reader processes.
+         *
+         * Only needed with KvsSharing::Owner for changes that shall be visible before the next flush
+         * (open and every successful flush publish the data already). Without sharing nothing is done.
+         *
+         * @return score::ResultBlank
+         *         - On success: An empty score::Result, readers see the current data.
+         *         - On failure: An error code describing the reason for the failure (e.g. ErrorCode::OutOfStorageSpace
+         *           if the data is larger than KvsOptions::shared_size, ErrorCode::ReadOnly for a reader).
+         */
+        score::ResultBlank publish();
+
+
+        /**
+         * @brief Subscribes to the changes of a key.
+         *
+         * The callback is called in a background thread with the changes of the key in the order they were made,
+         * changes made shortly after each other are delivered in one call. A change without value removed the key
+         * (the default value applies again). Changes are only notified to the subscribers in this process.
+         *
+         * @param key The key to observe.
+         * @param callback Called with the changes of the key (must not call wait_notifications()).
+         * @return score::Result<KvsSubscriptionId>
+         *         - On success: The ID of the subscription (see unsubscribe()).
+         *         - On failure: ErrorCode::ValidationFailed without callback, ErrorCode::ReadOnly for a
+         *           KvsSharing::Reader (its data is changed by the owner).
+         */
+        score::Result<KvsSubscriptionId> subscribe(const std::string_view key, KvsChangeCallback callback);
+
+
+        /**
+         * @brief Subscribes to the changes of all keys with a prefix (an empty prefix observes all keys).
+         *
+         * @param prefix The prefix of the keys to observe.
+         * @param callback Called with the changes of the matching keys (see subscribe()).
+         * @return score::Result<KvsSubscriptionId> like subscribe().
+         */
+        score::Result<KvsSubscriptionId> subscribe_prefix(const std::string_view prefix, KvsChangeCallback callback);
+
+
+        /**
+         * @brief Removes a subscription.
+         *
+         * After the return the callback is neither running nor called again (unless it removes itself).
+         *
+         * @param id The ID returned by subscribe() or subscribe_prefix().
+         * @return score::ResultBlank
+         *         - On success: An empty score::Result.
+         *         - On failure: ErrorCode::KeyNotFound if there is no subscription with this ID.
+         */
+        score::ResultBlank unsubscribe(KvsSubscriptionId id);
+
+
+        /**
+         * @brief Waits until all changes made so far are delivered to the subscribers.
+         */
+        void wait_notifications();
+
+        /**
+         * @brief Retrieves the statistics of this instance.
+         *
+         * Latency histograms of open, flush, snapshot rotation, hash verification, parsing and
+         * snapshot restore, and the number of lock, flush and validation failures since open
+         * (or since reset_stats()). Built with KVS_STATS_DISABLED all values are zero.
+         *
+         * @return A copy of the statistics (see internal/kvs_stats.hpp).
+         */
+        KvsStats stats() const;
+
+        /**
+         * @brief Clears the statistics of this instance.
+         */
+        void reset_stats();
+
     private:
         /* Private constructor to prevent direct instantiation */
         Kvs();
 
+        /* Checksum and size of a written KVS file */
+        struct DataFileInfo {
+            uint32_t hash;
+            size_t size;
+        };
+
         /* Internal storage and configuration details.*/
-        std::mutex kvs_mutex;
-        std::unordered_map<std::string, KvsValue> kvs;
+        std::shared_mutex kvs_mutex;
+        KvsMap kvs;
+
+        /* Lazily opened KVS file (values not accessed yet), the index points into the data */
+        std::unique_ptr<const std::string> lazy_data;
+        KvsLazyMap lazy_kvs;
+        KvsStorageFormat lazy_format;
+        std::mutex lazy_mutex;
+
+        /* Changes whenever a key is added or removed (KeyHandle slots are looked up again) */
+        uint64_t key_generation;
+
+        /* Written, indexed and default entries of every key (one lookup per key) */
+        KvsSlotMap slots;
+
+        /* Options the KVS was opened with */
+        KvsOptions options;
 
         /* Optional default values */
-        std::unordered_map<std::string, KvsValue> default_values;
+        KvsMap default_values;
+        std::shared_ptr<const DefaultsImage> default_image;
+
+        /* Incremental flush state */
+        std::set<std::string, std::less<>> dirty_keys;
+        std::atomic<bool> full_flush_required;
+        uint32_t base_hash;
+        size_t base_size;
+        size_t log_size;
+
+        /* Flushes since the last sync (durability policy) */
+        std::atomic<size_t> unsynced_flushes;
+
+        /* Data of the current KVS file, the base of the next delta snapshot (values are shared with the KVS) */
+        KvsMap delta_base;
+        std::optional<uint32_t> delta_base_hash;
 
         /* Filename prefix */
         score::filesystem::Path filename_prefix;
 
-        /* Filesystem handling */
-        std::unique_ptr<score::filesystem::Filesystem> filesystem;
+        /* Snapshot files (flush vs. readers of snapshots) */
+        std::mutex snapshot_mutex;
+
+        /* Snapshot index of the generation layout */
+        mutable std::mutex manifest_mutex;
+        KvsManifest manifest;
+
+        /* Storage of the KVS files */
+        std::shared_ptr<KvsBackend> backend;
 
         /* Json handling */
         std::unique_ptr<score::json::IJsonParser> parser;
-        std::unique_ptr<score::json::IJsonWriter> writer;
 
         /* Logging */
         std::unique_ptr<score::mw::log::Logger> logger;
 
+        /* Change notification */
+        std::unique_ptr<KvsNotifier> notifier;
+
+        /* Instrumentation */
+        std::unique_ptr<KvsStatsRecorder> stats_recorder;
+
+        /* Shared-memory segment of the owner or the reader */
+        std::unique_ptr<SharedStore> shared;
+
+        /* Background flush (last member, so it is stopped before the data it flushes is destroyed) */
+        std::mutex flusher_mutex;
+        std::unique_ptr<KvsFlusher> flusher;
+
         /* Private Methods */
+        std::shared_lock<std::shared_mutex> lock_shared();
+        std::unique_lock<std::shared_mutex> lock_exclusive();
         score::ResultBlank snapshot_rotate();
-        score::Result<std::unordered_map<std::string, KvsValue>> parse_json_data(const std::string& data);
-        score::Result<std::unordered_map<std::string, KvsValue>> open_json(const score::filesystem::Path& prefix, OpenJsonNeedFile need_file);
+        score::ResultBlank snapshot_rotate_manifest(bool sync);
+        std::string snapshot_prefix(size_t snapshot_id) const;
+        score::ResultBlank open_manifest();
+        score::ResultBlank write_manifest(const KvsManifest& updated, bool sync);
+        void remove_snapshot_files(const std::string& prefix);
+        bool open_delta_base();
+        void snapshot_delta(const std::string& delta, uint32_t previous_hash, bool sync);
+        score::Result<KvsMap> open_snapshot(size_t snapshot_id);
+        score::Result<KvsMap> parse_json_data(const std::string& data, const KvsElementAllocator& alloc = KvsElementAllocator(),
+                                              score::json::IJsonParser* json_parser = nullptr);
+        score::Result<std::optional<KvsStorageFormat>> find_data_format(const std::string& prefix) const;
+        score::Result<KvsMap> open_file(const score::filesystem::Path& prefix, KvsStorageFormat format, OpenJsonNeedFile need_file,
+                                        bool lazy = false, score::json::IJsonParser* json_parser = nullptr);
+        score::Result<KvsMap> open_json(const score::filesystem::Path& prefix, OpenJsonNeedFile need_file,
+                                        score::json::IJsonParser* json_parser = nullptr);
+        score::Result<KvsMap> open_data(const score::filesystem::Path& prefix, OpenJsonNeedFile need_file, bool lazy = false);
+        score::ResultBlank open_defaults(const score::filesystem::Path& prefix, OpenJsonNeedFile need_file,
+                                         score::json::IJsonParser* json_parser = nullptr);
+        void open_log(const score::filesystem::Path& prefix);
+        score::ResultBlank open_shared();
+        void resolve_handle(KeyHandle& handle);
+        static uint64_t next_key_generation();
+        void rebuild_slots();
+        KvsSlotMap::iterator insert_slot(KvsMap::iterator entry);
+        KvsSlotMap::iterator erase_entry(KvsSlotMap::iterator slot);
+        score::Result<const KvsValue*> slot_value(KvsSlotMap::iterator slot, const std::string_view key, std::optional<KvsValue>& copy);
+        score::Result<const KvsValue*> handle_value(KeyHandle& handle, std::optional<KvsValue>& copy);
+        score::Result<const KvsValue*> find_value(const std::string_view key, std::optional<KvsValue>& copy);
+        score::Result<const KvsValue*> lazy_value(KvsLazyValue& entry);
+        bool drop_lazy(KvsSlotMap::iterator slot);
+        score::ResultBlank materialize_lazy();
+        void mark_dirty(const std::string_view key);
+        void notify_change(const std::string_view key, const KvsValue* value);
+        void notify_replaced(const KvsMap& data);
+        score::Result<KvsSubscriptionId> subscribe_changes(const std::string_view key, bool prefix, KvsChangeCallback callback);
+        score::ResultBlank flush_full();
+        score::ResultBlank flush_incremental();
+        score::ResultBlank flush_now();
+        bool sync_due();
+        void stop_flusher();
+        score::Result<DataFileInfo> serialize_data(const score::filesystem::Path& path, std::string* delta = nullptr);
+        score::Result<DataFileInfo> serialize_map(const KvsMap& data, const score::filesystem::Path& path) const;
+        score::ResultBlank create_data_dir(const score::filesystem::Path& path);
+        score::ResultBlank write_hash_file(const std::string& hash_file, uint32_t hash, bool sync);
+        score::ResultBlank write_data(const std::string& buf, KvsStorageFormat format);
         score::ResultBlank write_json_data(const std::string& buf);
 
 };
 
+/* Retrieve the value associated with a key as type T */
+template <typename T>
+score::Result<T> Kvs::get_value_as(const std::string_view key) {
+    score::Result<T> result = score::MakeUnexpected(ErrorCode::UnmappedError);
+    auto visit_res = visit_value(key, [&result](const KvsValue& value) {
+        const T* typed_value = value.getIf<T>();
+        if (nullptr != typed_value) {
+            result = *typed_value;
+        }else{
+            result = score::MakeUnexpected(ErrorCode::ConversionFailed);
+        }
+    });
+    if (!visit_res) {
+        result = score::MakeUnexpected(static_cast<ErrorCode>(*visit_res.error()));
+    }
+
+    return result;
+}
+
+/* Retrieve the value of a resolved key as type T */
+template <typename T>
+score::Result<T> Kvs::get_value_as(KeyHandle& handle) {
+    score::Result<T> result = score::MakeUnexpected(ErrorCode::UnmappedError);
+    auto visit_res = visit_value(handle, [&result](const KvsValue& value) {
+        const T* typed_value = value.getIf<T>();
+        if (nullptr != typed_value) {
+            result = *typed_value;
+        }else{
+            result = score::MakeUnexpected(ErrorCode::ConversionFailed);
+        }
+    });
+    if (!visit_res) {
+        result = score::MakeUnexpected(static_cast<ErrorCode>(*visit_res.error()));
+    }
+
+    return result;
+}
+
+template <typename... Args>
+score::ResultBlank Kvs::emplace_value(const std::string_view key, Args&&... args) {
+    score::ResultBlank result = score::MakeUnexpected(ErrorCode::UnmappedError);
+    std::unique_lock<std::shared_mutex> lock = lock_exclusive();
+    if (KvsSharing::Reader == options.sharing) {
+        result = score::MakeUnexpected(ErrorCode::ReadOnly);
+    }else if (lock.owns_lock()) {
+        auto slot = slots.find(key);
+        KvsMap::iterator entry;
+        if ((slot != slots.end()) && slot->second.value.has_value()) {
+            entry = slot->second.value.value();
+            entry->second = KvsValue(std::forward<Args>(args)...);
+        }else{
+            (void)drop_lazy(slot);
+            entry = kvs.emplace(std::piecewise_construct, std::forward_as_tuple(key),
+                                std::forward_as_tuple(std::forward<Args>(args)...)).first;
+            (void)insert_slot(entry);
+        }
+        mark_dirty(key);
+        notify_change(key, &entry->second);
+        result = score::ResultBlank{};
+    }else{
+        result = score::MakeUnexpected(ErrorCode::MutexLockFailed);
+    }
+
+    return result;
+}
+
 } /* namespace score::mw::per::kvs */
 
 #endif /* SCORE_LIB_KVS_KVS_HPP */
@@ -0,0 +1,364 @@
+/********************************************************************************
+* Copyright (c) 2025 Contributors to the Eclipse Foundation
+*
+* See the NOTICE file(s) distributed with this work for additional
+* information regarding copyright ownership.
+*
+* This program and the accompanying materials are made available under the
+* terms of the Apache License Version 2.0 which is available at
+* https://www.apache.org/licenses/LICENSE-2.0
+*
+* SPDX-License-Identifier: Apache-2.0
+********************************************************************************/
+#include <cerrno>
+#include <cstdio>
+#include <fstream>
+#include <streambuf>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "internal/kvs_file.hpp"
+#include "kvs_backend.hpp"
+
+namespace score::mw::per::kvs {
+
+/* Result of a file operation of the OS on path, ErrorCode::FileNotFound only if path itself doesn't exist
+   (ENOENT is also set for a missing directory of the new name) */
+static score::ResultBlank file_result(bool done, const std::string& path) {
+    score::ResultBlank result = score::ResultBlank{};
+    if (!done) {
+        struct stat path_stat{};
+        const bool missing = (ENOENT == errno) && (0 != ::stat(path.c_str(), &path_stat));
+        result = score::MakeUnexpected(missing ? ErrorCode::FileNotFound : ErrorCode::PhysicalStorageFailure);
+    }
+
+    return result;
+}
+
+/*********************** File Backend *********************/
+KvsFileBackend::KvsFileBackend()
+    : filesystem(std::make_unique<score::filesystem::Filesystem>(score::filesystem::FilesystemFactory{}.CreateInstance()))
+{
+}
+
+KvsFileBackend::KvsFileBackend(std::unique_ptr<score::filesystem::Filesystem> filesystem)
+    : filesystem(std::move(filesystem))
+{
+}
+
+score::Result<bool> KvsFileBackend::exists(const std::string& path) {
+    return filesystem->standard->Exists(score::filesystem::Path(path));
+}
+
+bool KvsFileBackend::size(const std::string& path, size_t& size) {
+    bool result = false;
+    struct stat file_stat{};
+    if (0 == ::stat(path.c_str(), &file_stat)) {
+        size = static_cast<size_t>(file_stat.st_size);
+        result = true;
+    }
+
+    return result;
+}
+
+std::unique_ptr<std::istream> KvsFileBackend::open_read(const std::string& path) {
+    std::unique_ptr<std::istream> result = std::make_unique<std::ifstream>(path, std::ios::binary);
+    if (!(*result)) {
+        result.reset();
+    }
+
+    return result;
+}
+
+std::unique_ptr<std::ostream> KvsFileBackend::open_write(const std::string& path) {
+    std::unique_ptr<std::ostream> result = std::make_unique<std::ofstream>(path, std::ios::binary | std::ios::trunc);
+    if (!(*result)) {
+        result.reset();
+    }
+
+    return result;
+}
+
+bool KvsFileBackend::write(const std::string& path, std::string_view content, bool sync) {
+    return file_write(path, content, sync);
+}
+
+bool KvsFileBackend::append(const std::string& path, std::string_view content) {
+    std::ofstream out(path, std::ios::binary | std::ios::app);
+    const bool written = out.write(content.data(), static_cast<std::streamsize>(content.size())) && out.flush();
+    out.close();
+
+    return written && (!out.fail());
+}
+
+bool KvsFileBackend::truncate(const std::string& path, size_t size) {
+    return 0 == ::truncate(path.c_str(), static_cast<off_t>(size));
+}
+
+score::ResultBlank KvsFileBackend::rename(const std::string& from, const std::string& to) {
+    return file_result(0 == std::rename(from.c_str(), to.c_str()), from);
+}
+
+score::ResultBlank KvsFileBackend::link(const std::string& from, const std::string& to) {
+    return file_result(file_link(from, to), from);
+}
+
+score::ResultBlank KvsFileBackend::remove(const std::string& path) {
+    return file_result(0 == std::remove(path.c_str()), path);
+}
+
+bool KvsFileBackend::sync(const std::string& path) {
+    return file_sync(path);
+}
+
+bool KvsFileBackend::sync_dir(const std::string& path) {
+    return dir_sync(path);
+}
+
+bool KvsFileBackend::create_directories(const std::string& dir) {
+    return filesystem->standard->CreateDirectories(score::filesystem::Path(dir)).has_value();
+}
+
+bool KvsFileBackend::maps_files() const {
+    return true;
+}
+
+/*********************** Memory Backend *********************/
+
+/* Reads the shared content of a file (seekable, so the size is known before reading) */
+class KvsMemoryReadBuffer final : public std::streambuf {
+public:
+    explicit KvsMemoryReadBuffer(std::shared_ptr<const std::string> content)
+        : content(std::move(content))
+    {
+        char* begin = const_cast<char*>(this->content->data()); /* Only read, the get area is never written */
+        setg(begin, begin, begin + this->content->size());
+    }
+
+protected:
+    pos_type seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which) override {
+        pos_type result = pos_type(off_type(-1));
+        off_type base = 0;
+        if (std::ios_base::cur == dir) {
+            base = gptr() - eback();
+        }else if (std::ios_base::end == dir) {
+            base = egptr() - eback();
+        }else{
+            /* std::ios_base::beg */
+        }
+        const off_type pos = base + off;
+        if ((0 != (which & std::ios_base::in)) && (pos >= 0) && (pos <= (egptr() - eback()))) {
+            setg(eback(), eback() + pos, egptr());
+            result = pos_type(pos);
+        }
+
+        return result;
+    }
+
+    pos_type seekpos(pos_type pos, std::ios_base::openmode which) override {
+        return seekoff(off_type(pos), std::ios_base::beg, which);
+    }
+
+private:
+    std::shared_ptr<const std::string> content;
+};
+
+class KvsMemoryReadStream final : public std::istream {
+public:
+    explicit KvsMemoryReadStream(std::shared_ptr<const std::string> content)
+        : std::istream(nullptr)
+        , buffer(std::move(content))
+    {
+        rdbuf(&buffer);
+    }
+
+private:
+    KvsMemoryReadBuffer buffer;
+};
+
+/* Collects the written content, it replaces the file when the stream is destroyed */
+class KvsMemoryWriteBuffer final : public std::streambuf {
+public:
+    std::string content;
+
+protected:
+    int_type overflow(int_type ch) override {
+        if (!traits_type::eq_int_type(ch, traits_type::eof())) {
+            content.push_back(traits_type::to_char_type(ch));
+        }
+        return traits_type::not_eof(ch);
+    }
+
+    std::streamsize xsputn(const char* data, std::streamsize count) override {
+        content.append(data, static_cast<size_t>(count));
+        return count;
+    }
+};
+
+class KvsMemoryWriteStream final : public std::ostream {
+public:
+    KvsMemoryWriteStream(KvsMemoryBackend& backend, const std::string& path)
+        : std::ostream(nullptr)
+        , backend(backend)
+        , path(path)
+    {
+        rdbuf(&buffer);
+    }
+
+    ~KvsMemoryWriteStream() override {
+        backend.store(path, std::move(buffer.content));
+    }
+
+    KvsMemoryWriteStream(const KvsMemoryWriteStream&) = delete;
+    KvsMemoryWriteStream& operator=(const KvsMemoryWriteStream&) = delete;
+
+private:
+    KvsMemoryBackend& backend;
+    const std::string path;
+    KvsMemoryWriteBuffer buffer;
+};
+
+score::Result<bool> KvsMemoryBackend::exists(const std::string& path) {
+    std::lock_guard<std::mutex> lock(mutex);
+    return files.find(path) != files.end();
+}
+
+bool KvsMemoryBackend::size(const std::string& path, size_t& size) {
+    bool result = false;
+    std::lock_guard<std::mutex> lock(mutex);
+    auto search = files.find(path);
+    if (search != files.end()) {
+        size = search->second->size();
+        result = true;
+    }
+
+    return result;
+}
+
+std::unique_ptr<std::istream> KvsMemoryBackend::open_read(const std::string& path) {
+    std::unique_ptr<std::istream> result;
+    std::lock_guard<std::mutex> lock(mutex);
+    auto search = files.find(path);
+    if (search != files.end()) {
+        result = std::make_unique<KvsMemoryReadStream>(search->second);
+    }
+
+    return result;
+}
+
+std::unique_ptr<std::ostream> KvsMemoryBackend::open_write(const std::string& path) {
+    {
+        /* The file exists (empty) from now on, like a created file of the OS */
+        std::lock_guard<std::mutex> lock(mutex);
+        (void)files.try_emplace(path, std::make_shared<std::string>());
+    }
+    return std::make_unique<KvsMemoryWriteStream>(*this, path);
+}
+
+bool KvsMemoryBackend::write(const std::string& path, std::string_view content, bool sync) {
+    (void)sync; /* Nothing to sync */
+    store(path, std::string(content));
+    return true;
+}
+
+bool KvsMemoryBackend::append(const std::string& path, std::string_view content) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto& file = files[path];
+    if (nullptr == file) {
+        file = std::make_shared<std::string>(content);
+    }else if (1 == file.use_count()) {
+        file->append(content);
+    }else{
+        /* A reader shares the content, it keeps the content it opened */
+        auto appended = std::make_shared<std::string>(*file);
+        appended->append(content);
+        file = std::move(appended);
+    }
+
+    return true;
+}
+
+bool KvsMemoryBackend::truncate(const std::string& path, size_t size) {
+    bool result = false;
+    std::lock_guard<std::mutex> lock(mutex);
+    auto search = files.find(path);
+    if (search != files.end()) {
+        auto& file = search->second;
+        if (1 != file.use_count()) {
+            file = std::make_shared<std::string>(*file);
+        }
+        file->resize(size);
+        result = true;
+    }
+
+    return result;
+}
+
+score::ResultBlank KvsMemoryBackend::rename(const std::string& from, const std::string& to) {
+    score::ResultBlank result = score::ResultBlank{};
+    std::lock_guard<std::mutex> lock(mutex);
+    auto search = files.find(from);
+    if (search == files.end()) {
+        result = score::MakeUnexpected(ErrorCode::FileNotFound);
+    }else if (from != to) {
+        files[to] = std::move(search->second);
+        (void)files.erase(from);
+    }
+
+    return result;
+}
+
+score::ResultBlank KvsMemoryBackend::link(const std::string& from, const std::string& to) {
+    score::ResultBlank result = score::ResultBlank{};
+    std::lock_guard<std::mutex> lock(mutex);
+    auto search = files.find(from);
+    if (search == files.end()) {
+        result = score::MakeUnexpected(ErrorCode::FileNotFound);
+    }else{
+        /* Shared like an opened file, a change of either file copies it */
+        files[to] = search->second;
+    }
+
+    return result;
+}
+
+score::ResultBlank KvsMemoryBackend::remove(const std::string& path) {
+    score::ResultBlank result = score::ResultBlank{};
+    std::lock_guard<std::mutex> lock(mutex);
+    if (0 == files.erase(path)) {
+        result = score::MakeUnexpected(ErrorCode::FileNotFound);
+    }
+
+    return result;
+}
+
+bool KvsMemoryBackend::sync(const std::string& path) {
+    std::lock_guard<std::mutex> lock(mutex);
+    return files.find(path) != files.end();
+}
+
+bool KvsMemoryBackend::sync_dir(const std::string& path) {
+    (void)path; /* Files in memory are never lost before the backend */
+    return true;
+}
+
+bool KvsMemoryBackend::create_directories(const std::string& dir) {
+    (void)dir; /* No directories */
+    return true;
+}
+
+bool KvsMemoryBackend::maps_files() const {
+    return false;
+}
+
+size_t KvsMemoryBackend::file_count() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return files.size();
+}
+
+void KvsMemoryBackend::store(const std::string& path, std::string content) {
+    auto file = std::make_shared<std::string>(std::move(content));
+    std::lock_guard<std::mutex> lock(mutex);
+    files[path] = std::move(file);
+}
+
+} /* namespace score::mw::per::kvs */
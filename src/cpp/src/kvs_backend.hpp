@@ -0,0 +1,167 @@
+/********************************************************************************
+* Copyright (c) 2025 Contributors to the Eclipse Foundation
+*
+* See the NOTICE file(s) distributed with this work for additional
+* information regarding copyright ownership.
+*
+* This program and the accompanying materials are made available under the
+* terms of the Apache License Version 2.0 which is available at
+* https://www.apache.org/licenses/LICENSE-2.0
+*
+* SPDX-License-Identifier: Apache-2.0
+********************************************************************************/
+#ifndef SCORE_LIB_KVS_KVS_BACKEND_HPP
+#define SCORE_LIB_KVS_KVS_BACKEND_HPP
+
+#include <cstddef>
+#include <istream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include "internal/error.hpp"
+#include "score/filesystem/filesystem.h"
+#include "score/result/result.h"
+
+/*
+ * This header defines the storage of the KVS files, the extension point for other storages (see KvsOptions::backend).
+ * A storage is added by implementing KvsBackend and passing an instance to Kvs::open (or KvsBuilder::backend),
+ * the KVS needs no other changes. KvsFileBackend and KvsMemoryBackend are the implementations shipped with the KVS.
+ */
+namespace score::mw::per::kvs {
+
+/**
+ * @class KvsBackend
+ * @brief Storage of the files of a KVS (data, hash, log, manifest and snapshot files).
+ *
+ * The KVS decides which files are written, read, renamed and removed to keep its data consistent,
+ * a backend only stores the files by their path. Every KVS file operation goes through the backend
+ * of the KVS, so a faster or special storage (e.g. in memory for tests and benchmarks or a raw flash
+ * partition) doesn't need changes of the KVS itself.
+ *
+ * Public Methods:
+ * - `exists`: Whether a file exists.
+ * - `size`: Size of a file.
+ * - `open_read`: Opens a file for reading.
+ * - `open_write`: Creates or replaces a file that is written as a stream (complete when the stream is destroyed).
+ * - `write`: Creates or replaces a file with the given content.
+ * - `append`: Appends to a file.
+ * - `truncate`: Cuts a file off at the given size.
+ * - `rename`: Renames a file, an existing file with the new name is replaced atomically.
+ * - `link`: Makes a file available under a second name (an existing file with this name is replaced), the file keeps its name.
+ * - `remove`: Removes a file.
+ * - `sync`: Waits until the data of a written file is on the storage.
+ * - `sync_dir`: Waits until the created, renamed or removed files of a directory are on the storage.
+ * - `create_directories`: Creates a directory and its parents.
+ * - `maps_files`: Whether the paths are files of the OS which can be memory-mapped.
+ *
+ * Implementing a backend:
+ * - Paths are the complete names the KVS builds from KvsOptions::dir (e.g. "<dir>/kvs_<id>_0.json"), a backend may
+ *   map them to its storage in any way. Directories only need to exist for backends with a file hierarchy.
+ * - Methods returning bool return false on any failure. rename, link and remove return ErrorCode::FileNotFound
+ *   if the file doesn't exist (the KVS skips missing snapshot files) and ErrorCode::PhysicalStorageFailure on
+ *   any other failure.
+ * - A written stream of open_write may be incomplete until it is destroyed. write with sync, sync and sync_dir
+ *   return only once the data survives a power loss (they may do nothing for storages without a cache).
+ * - maps_files returns true only if the paths are files that can be opened and memory-mapped by the OS
+ *   (KvsOptions::mapped_defaults and KvsSharing::Reader load the defaults on the heap otherwise).
+ *
+ * Notice:
+ * - The methods may be called concurrently (e.g. the defaults are read while the KVS file is read
+ *   with KvsOptions::open_workers > 1, or a background flush writes while a snapshot is read).
+ */
+class KvsBackend {
+public:
+    virtual ~KvsBackend() = default;
+
+    virtual score::Result<bool> exists(const std::string& path) = 0;
+    virtual bool size(const std::string& path, size_t& size) = 0;
+    virtual std::unique_ptr<std::istream> open_read(const std::string& path) = 0;
+    virtual std::unique_ptr<std::ostream> open_write(const std::string& path) = 0;
+    virtual bool write(const std::string& path, std::string_view content, bool sync) = 0;
+    virtual bool append(const std::string& path, std::string_view content) = 0;
+    virtual bool truncate(const std::string& path, size_t size) = 0;
+    virtual score::ResultBlank rename(const std::string& from, const std::string& to) = 0;
+    virtual score::ResultBlank link(const std::string& from, const std::string& to) = 0;
+    virtual score::ResultBlank remove(const std::string& path) = 0;
+    virtual bool sync(const std::string& path) = 0;
+    virtual bool sync_dir(const std::string& path) = 0;
+    virtual bool create_directories(const std::string& dir) = 0;
+    virtual bool maps_files() const = 0;
+};
+
+/**
+ * @class KvsFileBackend
+ * @brief Files of the OS (the default backend).
+ *
+ * Existence checks and directories use the score filesystem, replaceable by a mock for tests.
+ * A written stream is complete when it is destroyed.
+ */
+class KvsFileBackend final : public KvsBackend {
+public:
+    KvsFileBackend();
+    explicit KvsFileBackend(std::unique_ptr<score::filesystem::Filesystem> filesystem);
+
+    score::Result<bool> exists(const std::string& path) override;
+    bool size(const std::string& path, size_t& size) override;
+    std::unique_ptr<std::istream> open_read(const std::string& path) override;
+    std::unique_ptr<std::ostream> open_write(const std::string& path) override;
+    bool write(const std::string& path, std::string_view content, bool sync) override;
+    bool append(const std::string& path, std::string_view content) override;
+    bool truncate(const std::string& path, size_t size) override;
+    score::ResultBlank rename(const std::string& from, const std::string& to) override;
+    score::ResultBlank link(const std::string& from, const std::string& to) override;
+    score::ResultBlank remove(const std::string& path) override;
+    bool sync(const std::string& path) override;
+    bool sync_dir(const std::string& path) override;
+    bool create_directories(const std::string& dir) override;
+    bool maps_files() const override;
+
+private:
+    std::unique_ptr<score::filesystem::Filesystem> filesystem;
+};
+
+/**
+ * @class KvsMemoryBackend
+ * @brief Files in memory (e.g. for tests and benchmarks without I/O costs).
+ *
+ * The files are lost with the backend, a KVS reopened with the same backend instance finds its
+ * files again. Directories don't exist, every path is a file. Reads share the content of the file
+ * (a later write replaces the content, it doesn't change it), so opening a file doesn't copy it.
+ * A linked file is a copy of the file (the KVS only links files it doesn't change afterwards).
+ * A written stream must be destroyed before its backend.
+ */
+class KvsMemoryBackend final : public KvsBackend {
+public:
+    score::Result<bool> exists(const std::string& path) override;
+    bool size(const std::string& path, size_t& size) override;
+    std::unique_ptr<std::istream> open_read(const std::string& path) override;
+    std::unique_ptr<std::ostream> open_write(const std::string& path) override;
+    bool write(const std::string& path, std::string_view content, bool sync) override;
+    bool append(const std::string& path, std::string_view content) override;
+    bool truncate(const std::string& path, size_t size) override;
+    score::ResultBlank rename(const std::string& from, const std::string& to) override;
+    score::ResultBlank link(const std::string& from, const std::string& to) override;
+    score::ResultBlank remove(const std::string& path) override;
+    bool sync(const std::string& path) override;
+    bool sync_dir(const std::string& path) override;
+    bool create_directories(const std::string& dir) override;
+    bool maps_files() const override;
+
+    /* Number of stored files */
+    size_t file_count() const;
+
+private:
+    friend class KvsMemoryWriteStream;
+    void store(const std::string& path, std::string content);
+
+    mutable std::mutex mutex;
+    /* Content of a file is only changed in place while no reader shares it */
+    std::map<std::string, std::shared_ptr<std::string>> files;
+};
+
+} /* namespace score::mw::per::kvs */
+
+#endif // SCORE_LIB_KVS_KVS_BACKEND_HPP
@@ -20,6 +20,7 @@ KvsBuilder::KvsBuilder(const InstanceId& instance_id)
     , need_defaults(false)
     , need_kvs(false)
     , directory("./data_folder/") /* Default Directory */
+    , options()
 {}
 
 KvsBuilder& KvsBuilder::need_defaults_flag(bool flag) {
@@ -37,6 +38,100 @@ KvsBuilder& KvsBuilder::dir(std::string&& dir_path) {
     return *this;
 }
 
+KvsBuilder& KvsBuilder::lock_mode(KvsLockMode mode) {
+    options.lock_mode = mode;
+    return *this;
+}
+
+KvsBuilder& KvsBuilder::storage_format(KvsStorageFormat format) {
+    options.format = format;
+    return *this;
+}
+
+KvsBuilder& KvsBuilder::mapped_defaults_flag(bool flag) {
+    options.mapped_defaults = flag;
+    return *this;
+}
+
+KvsBuilder& KvsBuilder::flush_mode(KvsFlushMode mode) {
+    options.flush_mode = mode;
+    return *this;
+}
+
+KvsBuilder& KvsBuilder::background_flush_flag(bool flag) {
+    options.background_flush = flag;
+    return *this;
+}
+
+KvsBuilder& KvsBuilder::hash_algorithm(KvsHashAlgorithm algorithm) {
+    options.hash_algorithm = algorithm;
+    return *this;
+}
+
+KvsBuilder& KvsBuilder::snapshot_max_count(size_t count) {
+    options.snapshot_max_count = count;
+    return *this;
+}
+
+KvsBuilder& KvsBuilder::snapshot_layout(KvsSnapshotLayout layout) {
+    options.snapshot_layout = layout;
+    return *this;
+}
+
+KvsBuilder& KvsBuilder::durability(KvsDurability durability) {
+    options.durability = durability;
+    return *this;
+}
+
+KvsBuilder& KvsBuilder::sync_interval(size_t interval) {
+    options.sync_interval = interval;
+    return *this;
+}
+
+KvsBuilder& KvsBuilder::delta_snapshots_flag(bool flag) {
+    options.delta_snapshots = flag;
+    return *this;
+}
+
+KvsBuilder& KvsBuilder::arena_flag(bool flag) {
+    options.arena = flag;
+    return *this;
+}
+
+KvsBuilder& KvsBuilder::open_workers(size_t workers) {
+    options.open_workers = workers;
+    return *this;
+}
+
+KvsBuilder& KvsBuilder::lazy_values_flag(bool flag) {
+    options.lazy_values = flag;
+    return *this;
+}
+
+KvsBuilder& KvsBuilder::sharing(KvsSharing sharing) {
+    options.sharing = sharing;
+    return *this;
+}
+
+KvsBuilder& KvsBuilder::shared_size(size_t size) {
+    options.shared_size = size;
+    return *this;
+}
+
+KvsBuilder& KvsBuilder::backend(std::shared_ptr<KvsBackend> backend) {
+    options.backend = std::move(backend);
+    return *this;
+}
+
+KvsBuilder& KvsBuilder::trace_hook(KvsTraceHook hook) {
+    options.trace_hook = std::move(hook);
+    return *this;
+}
+
+KvsBuilder& KvsBuilder::compression(KvsCompression compression) {
+    options.compression = compression;
+    return *this;
+}
 
 score::Result<Kvs> KvsBuilder::build() {
     score::Result<Kvs> result = score::MakeUnexpected(ErrorCode::UnmappedError);
@@ -50,7 +145,8 @@ score::Result<Kvs> KvsBuilder::build() {
         instance_id,
         need_defaults ? OpenNeedDefaults::Required : OpenNeedDefaults::Optional,
         need_kvs      ? OpenNeedKvs::Required      : OpenNeedKvs::Optional,
-        std::move(directory)
+        std::move(directory),
+        options
     );
 
     return result;
@@ -22,7 +22,8 @@ namespace score::mw::per::kvs {
  * @class KvsBuilder
  * @brief Builder for opening a KVS object.
  * This class allows configuration of various options for opening a KVS instance,
- * such as whether default values are required, whether the KVS data must already exist.
+ * such as whether default values are required, whether the KVS data must already exist
+ * and how concurrent accesses are handled.
  *
  * Important: You don't need to include any other header files to use the KVS.
  * For documentation of the KVS Functions, refer to the kvs.hpp documentation.
@@ -87,6 +88,154 @@ public:
      */
     KvsBuilder& dir(std::string&& dir_path);
 
+    /**
+     * @brief Configure how the KVS accessors behave if the KVS is locked by another thread.
+     * @param mode KvsLockMode::TryLock to fail with ErrorCode::MutexLockFailed (default);
+     *             KvsLockMode::Blocking to let readers run in parallel and writers wait for exclusive access.
+     * @return Reference to this builder (for chaining).
+     */
+    KvsBuilder& lock_mode(KvsLockMode mode);
+
+    /**
+     * @brief Configure the format in which the KVS data is written to storage.
+     * @param format KvsStorageFormat::Json for the typed JSON files (default);
+     *               KvsStorageFormat::Binary for the compact binary files.
+     *               Existing files of the other format are read and converted on the next flush.
+     *               Default values are always read from JSON.
+     * @return Reference to this builder (for chaining).
+     */
+    KvsBuilder& storage_format(KvsStorageFormat format);
+
+    /**
+     * @brief Configure if the default values are looked up in a memory-mapped image.
+     * @param flag True to convert the defaults JSON file once into kvs_<id>_default.img and map it
+     *             on later opens (values are decoded on access); false to parse the JSON file (default).
+     * @return Reference to this builder (for chaining).
+     */
+    KvsBuilder& mapped_defaults_flag(bool flag);
+
+    /**
+     * @brief Configure how much data is written by flush.
+     * @param mode KvsFlushMode::Full to write the complete KVS file on every flush (default);
+     *             KvsFlushMode::Incremental to append only the changed keys to a log, which is
+     *             compacted into the KVS file once it gets larger than the KVS file.
+     * @return Reference to this builder (for chaining).
+     */
+    KvsBuilder& flush_mode(KvsFlushMode mode);
+
+    /**
+     * @brief Configure if flushes are done by a background thread.
+     * @param flag True to serialize and write the data in a background thread that coalesces
+     *             repeated flush requests (see Kvs::flush_async); false to flush in the calling thread (default).
+     * @return Reference to this builder (for chaining).
+     */
+    KvsBuilder& background_flush_flag(bool flag);
+
+    /**
+     * @brief Selects the checksum algorithm written to the hash files.
+     * @param algorithm KvsHashAlgorithm::Adler32 (default, legacy 4-byte hash files) or
+     *                  KvsHashAlgorithm::Crc32c (tagged hash files). Files of both algorithms are read.
+     * @return Reference to this builder (for chaining).
+     */
+    KvsBuilder& hash_algorithm(KvsHashAlgorithm algorithm);
+
+    /**
+     * @brief Sets the number of snapshots kept by the flush.
+     * @param count Maximum snapshot count (KVS_MAX_SNAPSHOTS by default, 0 keeps no snapshots).
+     * @return Reference to this builder (for chaining).
+     */
+    KvsBuilder& snapshot_max_count(size_t count);
+
+    /**
+     * @brief Selects the file layout of the KVS file and its snapshots.
+     * @param layout KvsSnapshotLayout::Legacy (default) to rename all snapshot files on every flush, or
+     *               KvsSnapshotLayout::Generations to write every flush as a new generation listed in a manifest.
+     * @return Reference to this builder (for chaining).
+     */
+    KvsBuilder& snapshot_layout(KvsSnapshotLayout layout);
+
+    /**
+     * @brief Selects when flushed files are synced to the storage.
+     * @param durability KvsDurability::Deferred (default), KvsDurability::Grouped or KvsDurability::Always.
+     * @return Reference to this builder (for chaining).
+     */
+    KvsBuilder& durability(KvsDurability durability);
+
+    /**
+     * @brief Sets the number of flushes per sync with KvsDurability::Grouped.
+     * @param interval Flushes per sync (8 by default, 0 is treated as 1).
+     * @return Reference to this builder (for chaining).
+     */
+    KvsBuilder& sync_interval(size_t interval);
+
+    /**
+     * @brief Stores the snapshots as delta to the next newer snapshot.
+     * @param flag True to write kvs_<id>_<n>.delta instead of complete snapshot files (default: false).
+     * @return Reference to this builder (for chaining).
+     */
+    KvsBuilder& delta_snapshots_flag(bool flag);
+
+    /**
+     * @brief Allocates the data of every loaded KVS file from one arena, released in bulk.
+     * @param flag True to use an arena per loaded file (default: false).
+     * @return Reference to this builder (for chaining).
+     */
+    KvsBuilder& arena_flag(bool flag);
+
+    /**
+     * @brief Sets the number of threads used to open the KVS.
+     * @param workers Threads of open (1 by default: sequential, 0 is treated as 1).
+     * @return Reference to this builder (for chaining).
+     */
+    KvsBuilder& open_workers(size_t workers);
+
+    /**
+     * @brief Configure if the values of the KVS file are decoded on first access.
+     * @param flag True to only index the keys at open and decode every value by its first access;
+     *             false to decode the complete file at open (default).
+     * @return Reference to this builder (for chaining).
+     */
+    KvsBuilder& lazy_values_flag(bool flag);
+
+    /**
+     * @brief Configure if the KVS data is shared with other processes.
+     * @param sharing KvsSharing::Owner to publish the data, KvsSharing::Reader to read the data
+     *                published by the owner (default: KvsSharing::Private).
+     * @return Reference to this builder (for chaining).
+     */
+    KvsBuilder& sharing(KvsSharing sharing);
+
+    /**
+     * @brief Sets the maximum size of the data published by the owner.
+     * @param size Size of the shared-memory segment without its header in bytes (default: 1 MiB).
+     * @return Reference to this builder (for chaining).
+     */
+    KvsBuilder& shared_size(size_t size);
+
+    /**
+     * @brief Sets the storage of the KVS files.
+     * @param backend Backend for all file operations of the KVS, e.g. a KvsMemoryBackend
+     *                (default: nullptr, the files of the OS).
+     * @return Reference to this builder (for chaining).
+     */
+    KvsBuilder& backend(std::shared_ptr<KvsBackend> backend);
+
+    /**
+     * @brief Sets a hook that is called after every operation measured by Kvs::stats.
+     * @param hook Called with the operation, its start and its duration in the thread of the operation
+     *             (default: nullptr, no hook).
+     * @return Reference to this builder (for chaining).
+     */
+    KvsBuilder& trace_hook(KvsTraceHook hook);
+
+    /**
+     * @brief Selects the block compression of the KVS files written by flush.
+     * @param compression KvsCompression::None (default, plain JSON or binary files) or KvsCompression::Lz4.
+     *                    Compressed files are read with every setting.
+     * @return Reference to this builder (for chaining).
+     */
+    KvsBuilder& compression(KvsCompression compression);
+
     /**
      * @brief Builds and opens the Kvs instance with the configured options.
      *
@@ -101,6 +250,7 @@ private:
     bool                               need_defaults; ///< Whether default values are required
     bool                               need_kvs;      ///< Whether an existing KVS is required
     std::string                        directory;     ///< Directory where to store the KVS Files
+    KvsOptions                         options;       ///< Additional open options (e.g. lock mode, storage format)
 };
 
 } /* namespace score::mw::per::kvs */
@@ -10,93 +10,141 @@
 *
 * SPDX-License-Identifier: Apache-2.0
 ********************************************************************************/
+#include <algorithm>
+#include <new>
+#include <type_traits>
 #include "kvsvalue.hpp"
 
 namespace score::mw::per::kvs {
 
-KvsValue::KvsValue(const Array& array){
-    Array shared_array;
-    shared_array.reserve(array.size());
-    for (const auto& item : array) {
-        shared_array.push_back(std::make_shared<KvsValue>(*item));
-    }
-    value = std::move(shared_array);
-    type = Type::Array;
-}
-
-KvsValue::KvsValue(const Object& object) {
-    Object shared_object;
-    for (const auto& [key, value] : object) {
-        shared_object[key] = std::make_shared<KvsValue>(*value);
-    }
-    value = std::move(shared_object);
-    type = Type::Object;
-}
+/* getType() returns the index of the variant, so Type must list the alternatives in the same order */
+using KvsVariant = std::decay_t<decltype(std::declval<KvsValue>().getValue())>;
+template <KvsValue::Type type, typename T>
+constexpr bool type_matches = std::is_same_v<std::variant_alternative_t<static_cast<size_t>(type), KvsVariant>, T>;
+static_assert(type_matches<KvsValue::Type::i32, int32_t> && type_matches<KvsValue::Type::u32, uint32_t>
+              && type_matches<KvsValue::Type::i64, int64_t> && type_matches<KvsValue::Type::u64, uint64_t>
+              && type_matches<KvsValue::Type::f64, double> && type_matches<KvsValue::Type::Boolean, bool>
+              && type_matches<KvsValue::Type::String, std::string> && type_matches<KvsValue::Type::Null, std::nullptr_t>
+              && type_matches<KvsValue::Type::Array, KvsValue::SharedArray> && type_matches<KvsValue::Type::Object, KvsValue::SharedObject>
+              && (std::variant_size_v<KvsVariant> == 10U),
+              "KvsValue::Type does not match the alternatives of the variant");
 
 KvsValue::KvsValue(const std::vector<KvsValue>& array) {
     Array shared_array;
     shared_array.reserve(array.size());  // Reserve space for N elements
     for (const auto& item : array) {
-        shared_array.emplace_back(std::make_shared<KvsValue>(item));
+        shared_array.emplace_back(std::make_shared<KvsValue>(item)); /* Nested elements of item are shared */
     }
-    value = std::move(shared_array);
-    type = Type::Array;
+    value = std::make_shared<const Array>(std::move(shared_array));
 }
 
 KvsValue::KvsValue(const std::unordered_map<std::string, KvsValue>& object) {
     Object shared_object;
     for (const auto& [key, value] : object) {
-        shared_object[key] = std::make_shared<KvsValue>(value);
+        shared_object.emplace(key, std::make_shared<KvsValue>(value)); /* Nested elements of value are shared */
     }
-    value = std::move(shared_object);
-    type = Type::Object;
+    value = std::make_shared<const Object>(std::move(shared_object));
 }
 
-/* copy constructor */
-KvsValue::KvsValue(const KvsValue& other) : type(other.type) {
-    switch(other.type){
-        case Type::Array:{
-            const Array& otherArray = std::get<Array>(other.value);
-            Array copiedArray;
-            copiedArray.reserve(otherArray.size());
-            for (const auto& item : otherArray) {
-                copiedArray.push_back(std::make_shared<KvsValue>(*item));
-            }
-            value = std::move(copiedArray);
-            break;
-        }
-        case Type::Object:{
-            const Object& otherObject = std::get<Object>(other.value);
-            Object copiedObject;
-            for (const auto& [key, value] : otherObject) {
-                copiedObject[key] = std::make_shared<KvsValue>(*value);
-            }
-            value = std::move(copiedObject);
-            break;
-        }
-        default:
-            value = other.value; // For other types, just copy the value
-            break;
-    }
+/* Containers with mutable elements (Array and Object before the elements became immutable), the elements are shared */
+KvsValue::KvsValue(const std::vector<std::shared_ptr<KvsValue>>& array)
+    : value(std::make_shared<const Array>(array.begin(), array.end()))
+{
 }
 
-/* copy Assignment Operator */
-KvsValue& KvsValue::operator=(const KvsValue& other) {
-    if (this != &other) {
-        KvsValue temp(other); // deep copy
-        std::swap(value, temp.value);
-        type = other.type;
-    }
-    return *this;
+KvsValue::KvsValue(const std::unordered_map<std::string, std::shared_ptr<KvsValue>>& object)
+    : value(std::make_shared<const Object>(object.begin(), object.end()))
+{
+}
+
+/* A nullptr container is stored as empty container, so the stored pointer is never nullptr */
+KvsValue::KvsValue(SharedArray array)
+    : value((nullptr != array) ? std::move(array) : std::make_shared<const Array>())
+{
+}
+
+KvsValue::KvsValue(SharedObject object)
+    : value((nullptr != object) ? std::move(object) : std::make_shared<const Object>())
+{
 }
 
 /* move Assignment Operator */
 KvsValue& KvsValue::operator=(KvsValue&& other) noexcept {
     if (this != &other) {
         value = std::move(other.value);
-        type = other.type;
     }
     return *this;
 }
 
+/* Compare two shared elements of an Array or Object */
+static bool elements_equal(const std::shared_ptr<const KvsValue>& lhs, const std::shared_ptr<const KvsValue>& rhs) {
+    return (lhs == rhs) || ((nullptr != lhs) && (nullptr != rhs) && (*lhs == *rhs));
+}
+
+/* Comparison Operator */
+bool KvsValue::operator==(const KvsValue& other) const {
+    const Type type = getType();
+    const bool same_type = (type == other.getType());
+    bool result = (value == other.value); /* Same scalar, or the same shared container */
+    if ((!result) && same_type && (Type::Array == type)) {
+        const Array& lhs = getArray();
+        const Array& rhs = other.getArray();
+        result = (lhs.size() == rhs.size());
+        for (size_t idx = 0; result && (idx < lhs.size()); ++idx) {
+            result = elements_equal(lhs[idx], rhs[idx]);
+        }
+    }else if ((!result) && same_type && (Type::Object == type)) {
+        const Object& lhs = getObject();
+        const Object& rhs = other.getObject();
+        result = (lhs.size() == rhs.size());
+        for (auto it = lhs.begin(); result && (it != lhs.end()); ++it) {
+            auto search = rhs.find(it->first);
+            result = (search != rhs.end()) && elements_equal(it->second, search->second);
+        }
+    }
+    return result;
+}
+
+/* Size of the first chunk of an arena, every further chunk doubles the size up to the maximum */
+static constexpr size_t ARENA_FIRST_CHUNK = 4U << 10;
+static constexpr size_t ARENA_MAX_CHUNK = 1U << 20;
+
+/* Allocate memory from the last chunk of the arena (a new chunk is added if it is full) */
+void* KvsArena::allocate(size_t size, size_t alignment) {
+    void* result = nullptr;
+    if (sealed.load(std::memory_order_acquire)) {
+        result = ::operator new(size);
+    }else{
+        size_t start = (offset + alignment - 1U) & ~(alignment - 1U);
+        if (chunks.empty() || ((start + size) > chunks.back().size)) {
+            const size_t next = chunks.empty() ? ARENA_FIRST_CHUNK : std::min(chunks.back().size * 2U, ARENA_MAX_CHUNK);
+            const size_t chunk_size = std::max(next, size + alignment);
+            chunks.push_back(Chunk{std::unique_ptr<unsigned char[]>(new unsigned char[chunk_size]), chunk_size}); /* Not zeroed */
+            /* operator new[] memory is aligned for every fundamental type */
+            start = 0;
+        }
+        result = chunks.back().data.get() + start;
+        offset = start + size;
+        used_bytes += size;
+    }
+    return result;
+}
+
+/* Deallocate memory, memory of the arena is only released with the arena */
+void KvsArena::deallocate(void* ptr, size_t, size_t) noexcept {
+    if (!owns(ptr)) {
+        ::operator delete(ptr);
+    }
+}
+
+/* Check whether a pointer lies in a chunk of the arena */
+bool KvsArena::owns(const void* ptr) const noexcept {
+    bool result = false;
+    const std::less<const void*> before;
+    for (auto it = chunks.begin(); (!result) && (it != chunks.end()); ++it) {
+        result = !before(ptr, it->data.get()) && before(ptr, it->data.get() + it->size);
+    }
+    return result;
+}
+
 } /* end namespace score::mw::per::kvs */
\ No newline at end of file
@@ -13,10 +13,17 @@
 #ifndef SCORE_LIB_KVS_KVSVALUE_HPP
 #define SCORE_LIB_KVS_KVSVALUE_HPP
 
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
 #include <optional>
 #include <stdexcept>
 #include <string>
+#include <type_traits>
 #include <unordered_map>
+#include <variant>
 #include <vector>
 
 namespace score::mw::per::kvs {
@@ -28,41 +35,71 @@ namespace score::mw::per::kvs {
  *        including numbers, booleans, strings, null, arrays, and objects.
  *
  * The KvsValue class provides a type-safe way to store and retrieve values of
- * different types. It uses a std::variant to hold the underlying value and an
- * enum to track the type of the value.
+ * different types. It uses a std::variant to hold the underlying value, the type
+ * of the value is derived from the index of the variant (no separate type member).
+ *
+ * ## Memory Layout:
+ * The size of a KvsValue is the size of its largest alternative plus the variant index.
+ * Scalars are stored inline, short strings use the small-string buffer of std::string and
+ * Arrays and Objects are stored out-of-line (a shared pointer to the immutable container).
+ *
+ * ## Structural Sharing:
+ * An Array or Object and its elements are immutable (std::shared_ptr<const Array>,
+ * std::shared_ptr<const Object> and std::shared_ptr<const KvsValue> elements). Copying a
+ * KvsValue only increments the reference count of its container, whatever its size, the
+ * container and all nested elements are shared between the copies instead of being cloned.
+ * A KvsValue is modified by building a new value (copy on write): copy the container
+ * (getArray(), getObject()), change the copy and construct a new KvsValue from it, the
+ * unchanged elements of the old value are reused.
  *
  * ## Supported Types:
  * - Number (double)
  * - Boolean (bool)
  * - String (std::string)
  * - Null (std::nullptr_t)
- * - Array (std::vector<KvsValue>)
- * - Object (std::unordered_map<std::string, KvsValue>)
+ * - Array (std::vector<std::shared_ptr<const KvsValue>>, stored as SharedArray)
+ * - Object (std::map<std::string, std::shared_ptr<const KvsValue>>, stored as SharedObject)
  *
  * ## Public Methods:
  * - `KvsValue(double number)`: Constructs a KvsValue holding a number.
  * - `KvsValue(bool boolean)`:
- * - Access the underlying value using `getValue()` and `std::get`.
+ * - Access the underlying value using `getValue()` and `std::get` (SharedArray and SharedObject for containers).
+ * - `getArray()`, `getObject()`: Access the shared container (throw std::bad_variant_access for another type).
+ * - `getIf<T>()`: Pointer to the value as T (Array and Object resolve the shared container), nullptr for another type.
+ *
+ * ## Migration (see CHANGELOG.md):
+ * Arrays and Objects used to be alternatives of the variant with mutable elements. Code written for them changes to:
+ * - `std::get<KvsValue::Array>(v.getValue())` -> `v.getArray()` (or `*std::get<KvsValue::SharedArray>(v.getValue())`),
+ *   `std::get<KvsValue::Object>(v.getValue())` -> `v.getObject()`.
+ * - `std::get_if<KvsValue::Array>(&v.getValue())` -> `v.getIf<KvsValue::Array>()` (same for Object).
+ * - Visitors of `getValue()` take `const SharedArray&` and `const SharedObject&` instead of `const Array&` and `const Object&`.
+ * - Elements can't be changed in place, build a new container and a new KvsValue from it (see Structural Sharing).
+ *   Containers of `std::shared_ptr<KvsValue>` (the former Array and Object types) are still accepted by the constructors.
  *
  * ## Example:
  * @code
  * KvsValue numberValue(42.0);
  * KvsValue stringValue("Hello, World!");
- * KvsValue arrayValue(KvsValue::Array{numberValue, stringValue});
+ * KvsValue arrayValue(std::vector<KvsValue>{numberValue, stringValue});
  *
- * if (numberValue.getType() == KvsValue::Type::Number) {
+ * if (numberValue.getType() == KvsValue::Type::f64) {
  *     double number = std::get<double>(numberValue.getValue());
  * }
+ * for (const auto& element : arrayValue.getArray()) { ... }
  * @endcode
  */
 
 class KvsValue final {
 public:
     /* Define the possible types for KvsValue*/
-    using Array = std::vector<std::shared_ptr<KvsValue>>;
-    using Object = std::unordered_map<std::string, std::shared_ptr<KvsValue>>;
+    using Array = std::vector<std::shared_ptr<const KvsValue>>;
+    using Object = std::map<std::string, std::shared_ptr<const KvsValue>, std::less<>>;
 
-    /* Enum to represent the type of the value*/
+    /* Stored alternatives of Array and Object (never nullptr), copies share the container */
+    using SharedArray = std::shared_ptr<const Array>;
+    using SharedObject = std::shared_ptr<const Object>;
+
+    /* Enum to represent the type of the value (same order as the alternatives of the variant) */
     enum class Type {
         i32,
         u32,
@@ -77,48 +114,164 @@ public:
     };
 
     /* Constructors for each type*/
-    explicit KvsValue(int32_t number) : value(number), type(Type::i32) {}
-    explicit KvsValue(uint32_t number) : value(number), type(Type::u32) {}
-    explicit KvsValue(int64_t number) : value(number), type(Type::i64) {}
-    explicit KvsValue(uint64_t number) : value(number), type(Type::u64) {}
-    explicit KvsValue(double number) : value(number), type(Type::f64) {}
-    explicit KvsValue(bool boolean) : value(boolean), type(Type::Boolean) {}
-    explicit KvsValue(const char* str) : value(std::string(str)), type(Type::String) {}
-    explicit KvsValue(const std::string& str) : value(str), type(Type::String) {}
-    explicit KvsValue(std::nullptr_t) : value(nullptr), type(Type::Null) {}
-    explicit KvsValue(const Array& array) ;
-    explicit KvsValue(const Object& object);
+    explicit KvsValue(int32_t number) : value(number) {}
+    explicit KvsValue(uint32_t number) : value(number) {}
+    explicit KvsValue(int64_t number) : value(number) {}
+    explicit KvsValue(uint64_t number) : value(number) {}
+    explicit KvsValue(double number) : value(number) {}
+    explicit KvsValue(bool boolean) : value(boolean) {}
+    explicit KvsValue(const char* str) : value(std::string(str)) {}
+    explicit KvsValue(const std::string& str) : value(str) {}
+    explicit KvsValue(std::nullptr_t) : value(nullptr) {}
+    explicit KvsValue(const Array& array) : value(std::make_shared<const Array>(array)) {}
+    explicit KvsValue(Array&& array) : value(std::make_shared<const Array>(std::move(array))) {}
+    explicit KvsValue(const Object& object) : value(std::make_shared<const Object>(object)) {}
+    explicit KvsValue(Object&& object) : value(std::make_shared<const Object>(std::move(object))) {}
+    explicit KvsValue(SharedArray array);
+    explicit KvsValue(SharedObject object);
     explicit KvsValue(const std::vector<KvsValue>& array);
     explicit KvsValue(const std::unordered_map<std::string, KvsValue>& object);
+    explicit KvsValue(const std::vector<std::shared_ptr<KvsValue>>& array);
+    explicit KvsValue(const std::unordered_map<std::string, std::shared_ptr<KvsValue>>& object);
 
-    /* Copy constructor */
-    KvsValue(const KvsValue& other);
+    /* Copy constructor (shares the container of Array and Object values, O(1)) */
+    KvsValue(const KvsValue& other) = default;
 
-    /* copy assignment operator */
-    KvsValue& operator=(const KvsValue& other);
+    /* copy assignment operator (shares the container of Array and Object values, O(1)) */
+    KvsValue& operator=(const KvsValue& other) = default;
 
     /* Move constructor */
-    KvsValue(KvsValue&& other) noexcept : value(std::move(other.value)), type(other.type) {}
+    KvsValue(KvsValue&& other) noexcept : value(std::move(other.value)) {}
 
     /* move assignment operator */
     KvsValue& operator=(KvsValue&& other) noexcept;
 
-    /* Get the type of the value*/
-    Type getType() const { return type; }
+    /* Deep comparison of the type and the value (shared Array and Object elements are not compared again) */
+    bool operator==(const KvsValue& other) const;
+    bool operator!=(const KvsValue& other) const { return !(*this == other); }
+
+    /* Get the type of the value (the index of the variant) */
+    Type getType() const { return static_cast<Type>(value.index()); }
 
     /* Access the underlying value (use std::get to retrieve the value)*/
-    const std::variant<int32_t, uint32_t, int64_t, uint64_t, double, bool, std::string, std::nullptr_t, Array, Object>& getValue() const {
+    const std::variant<int32_t, uint32_t, int64_t, uint64_t, double, bool, std::string, std::nullptr_t, SharedArray, SharedObject>& getValue() const {
         return value;
     }
 
+    /* Access the shared container of an Array or Object value (throws std::bad_variant_access for another type) */
+    const Array& getArray() const { return *std::get<SharedArray>(value); }
+    const Object& getObject() const { return *std::get<SharedObject>(value); }
+
+    /* Pointer to the value as T, nullptr if the value has another type (Array and Object resolve the shared container) */
+    template <typename T>
+    const T* getIf() const {
+        const T* result = nullptr;
+        if constexpr (std::is_same_v<T, Array>) {
+            const SharedArray* array = std::get_if<SharedArray>(&value);
+            result = (nullptr != array) ? array->get() : nullptr;
+        }else if constexpr (std::is_same_v<T, Object>) {
+            const SharedObject* object = std::get_if<SharedObject>(&value);
+            result = (nullptr != object) ? object->get() : nullptr;
+        }else{
+            result = std::get_if<T>(&value);
+        }
+        return result;
+    }
+
 private:
     /* The underlying value*/
-    std::variant<int32_t, uint32_t, int64_t, uint64_t, double, bool, std::string, std::nullptr_t, Array, Object> value;
+    std::variant<int32_t, uint32_t, int64_t, uint64_t, double, bool, std::string, std::nullptr_t, SharedArray, SharedObject> value;
+};
+
+/**
+ * @class KvsArena
+ * @brief Bump allocator for the data of one loaded KVS file (see KvsOptions::arena).
+ *
+ * Memory is handed out from a few large chunks and is only released in bulk when the arena is
+ * destroyed, deallocating memory of the arena does nothing. The arena is filled by one thread while
+ * a file is parsed and sealed afterwards: later allocations (e.g. keys added by set_value) use the heap,
+ * so a long running KVS doesn't accumulate memory in the arena. A sealed arena is thread-safe.
+ * The arena is shared by the allocators that use it, it lives as long as any map or element of it.
+ */
+class KvsArena final {
+public:
+    KvsArena() = default;
+    ~KvsArena() = default;
+    KvsArena(const KvsArena&) = delete;
+    KvsArena& operator=(const KvsArena&) = delete;
+
+    /* Allocate memory (from the heap once the arena is sealed) */
+    void* allocate(size_t size, size_t alignment);
+
+    /* Deallocate memory (does nothing for memory of the arena) */
+    void deallocate(void* ptr, size_t size, size_t alignment) noexcept;
+
+    /* Use the heap for all later allocations */
+    void seal() noexcept { sealed.store(true, std::memory_order_release); }
+
+    /* Number of bytes handed out from the chunks of the arena */
+    size_t used() const noexcept { return used_bytes; }
 
-    /* The type of the value*/
-    Type type;
+private:
+    /* Whether ptr lies in a chunk of the arena (the chunks don't change once the arena is sealed) */
+    bool owns(const void* ptr) const noexcept;
+
+    struct Chunk {
+        std::unique_ptr<unsigned char[]> data;
+        size_t size;
+    };
+
+    std::vector<Chunk> chunks;
+    size_t offset = 0; /* Offset of the free memory in the last chunk */
+    size_t used_bytes = 0;
+    std::atomic<bool> sealed{false};
 };
 
+/* Allocator of the stored data: Allocates from a KvsArena if it has one, otherwise from the heap.
+   The arena moves with the map (move and swap), copies of a map allocate from the heap. */
+template <typename T>
+class KvsAllocator {
+public:
+    using value_type = T;
+    using propagate_on_container_move_assignment = std::true_type;
+    using propagate_on_container_swap = std::true_type;
+
+    KvsAllocator() noexcept = default;
+    explicit KvsAllocator(std::shared_ptr<KvsArena> arena) noexcept : arena(std::move(arena)) {}
+    template <typename U>
+    KvsAllocator(const KvsAllocator<U>& other) noexcept : arena(other.arena) {}
+
+    T* allocate(size_t count) {
+        return (nullptr != arena) ? static_cast<T*>(arena->allocate(count * sizeof(T), alignof(T)))
+                                  : std::allocator<T>().allocate(count);
+    }
+
+    void deallocate(T* ptr, size_t count) noexcept {
+        if (nullptr != arena) {
+            arena->deallocate(ptr, count * sizeof(T), alignof(T));
+        }else{
+            std::allocator<T>().deallocate(ptr, count);
+        }
+    }
+
+    KvsAllocator select_on_container_copy_construction() const noexcept { return KvsAllocator(); }
+
+    template <typename U>
+    bool operator==(const KvsAllocator<U>& other) const noexcept { return arena == other.arena; }
+    template <typename U>
+    bool operator!=(const KvsAllocator<U>& other) const noexcept { return arena != other.arena; }
+
+    std::shared_ptr<KvsArena> arena;
+};
+
+/* Map type for the stored and the default key-value pairs of a KVS.
+   Uses a transparent comparator, so lookups with a std::string_view don't need a temporary std::string
+   (heterogeneous lookup for std::unordered_map is only available since C++20). */
+using KvsMap = std::map<std::string, KvsValue, std::less<>, KvsAllocator<std::pair<const std::string, KvsValue>>>;
+
+/* Allocator of the shared Array and Object elements created while data is parsed */
+using KvsElementAllocator = KvsAllocator<KvsValue>;
+
 } /* namespace score::mw::per::kvs */
 
 #endif /* SCORE_LIB_KVS_KVSVALUE_HPP */
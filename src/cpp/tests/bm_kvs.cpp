@@ -11,8 +11,15 @@
 * SPDX-License-Identifier: Apache-2.0
 ********************************************************************************/
 
+#include <atomic>
 #include <benchmark/benchmark.h>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <new>
+#include <sstream>
 #include <string>
+#include <vector>
 
 #define private public
 #define final
@@ -20,8 +27,35 @@
 #undef private
 #undef final
 #include "internal/kvs_helper.hpp"
+#include "internal/kvs_shared.hpp"
 using namespace score::mw::per::kvs;
 
+/* Machine-readable results: bm_kvs_cpp --benchmark_out=bm_kvs.json --benchmark_out_format=json
+ * tools/bm_compare.py compares such a result file against the checked-in bm_kvs_baseline.json and reports the
+ * benchmarks that got slower than the threshold (see there how the baseline is regenerated). */
+
+/* Count heap allocations and allocated bytes of the benchmark process (used to show allocation-free lookups) */
+static std::atomic<int64_t> bm_allocations{0};
+static std::atomic<int64_t> bm_allocated_bytes{0};
+
+void* operator new(std::size_t size) {
+    bm_allocations.fetch_add(1, std::memory_order_relaxed);
+    bm_allocated_bytes.fetch_add(static_cast<int64_t>(size), std::memory_order_relaxed);
+    void* ptr = std::malloc((0U == size) ? 1U : size);
+    if (nullptr == ptr) {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+void operator delete(void* ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept {
+    std::free(ptr);
+}
+
 static void BM_get_hash_bytes(benchmark::State& state) {
     // Prepare a test string of configurable size
     std::string data(state.range(0), 'a');
@@ -34,4 +68,1144 @@ static void BM_get_hash_bytes(benchmark::State& state) {
 // Register the function as a benchmark with different input sizes
 BENCHMARK(BM_get_hash_bytes)->Range(16, 16<<10);
 
+static void BM_hash(benchmark::State& state, uint32_t (*update)(uint32_t, const char*, size_t), const char* feature) {
+    // Throughput of a single checksum implementation (skipped if the CPU lacks the feature)
+#ifdef KVS_CHECKSUM_X86
+    if ((nullptr != feature) && !checksum_cpu_supports(feature)) {
+        state.SkipWithError("CPU feature not supported");
+        return;
+    }
+#else
+    (void)feature;
+#endif
+    std::string data(state.range(0), '\0');
+    for (size_t idx = 0; idx < data.size(); ++idx) {
+        data[idx] = static_cast<char>(idx * 31);
+    }
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(update(1, data.data(), data.size()));
+    }
+    state.SetBytesProcessed(int64_t(state.iterations()) * int64_t(data.size()));
+}
+
+BENCHMARK_CAPTURE(BM_hash, adler32_scalar, adler32_update_scalar, nullptr)->Range(16, 4<<20);
+BENCHMARK_CAPTURE(BM_hash, crc32c_scalar, crc32c_update_scalar, nullptr)->Range(16, 4<<20);
+#ifdef KVS_CHECKSUM_X86
+BENCHMARK_CAPTURE(BM_hash, adler32_ssse3, adler32_update_ssse3, "ssse3")->Range(16, 4<<20);
+BENCHMARK_CAPTURE(BM_hash, adler32_avx2, adler32_update_avx2, "avx2")->Range(16, 4<<20);
+BENCHMARK_CAPTURE(BM_hash, crc32c_sse42, crc32c_update_sse42, "sse4.2")->Range(16, 4<<20);
+#endif
+
+static void BM_read_verify(benchmark::State& state, bool single_pass) {
+    // Read and verify a file: stream copy + second checksum pass vs. pre-sized single pass
+    std::filesystem::create_directories("./bm_data/");
+    const std::string path = "./bm_data/read_verify.json";
+    const std::string content(state.range(0), 'a');
+    std::ofstream(path, std::ios::binary) << content;
+    const uint32_t expected = calculate_hash_adler32(content);
+    for (auto _ : state) {
+        std::ifstream in(path, std::ios::binary);
+        std::string data;
+        uint32_t hash = 0;
+        if (single_pass) {
+            (void)read_stream_hashed(in, KvsHashAlgorithm::Adler32, data, hash);
+        }else{
+            std::ostringstream ss;
+            ss << in.rdbuf();
+            data = ss.str();
+            hash = calculate_hash_adler32(data);
+        }
+        if (hash != expected) {
+            state.SkipWithError("hash mismatch");
+            break;
+        }
+        benchmark::DoNotOptimize(data.data());
+    }
+    state.SetBytesProcessed(int64_t(state.iterations()) * int64_t(content.size()));
+}
+
+BENCHMARK_CAPTURE(BM_read_verify, two_pass, false)->Range(1<<10, 4<<20);
+BENCHMARK_CAPTURE(BM_read_verify, single_pass, true)->Range(1<<10, 4<<20);
+
+/* Number of keys in the KVS used by the get_value benchmarks */
+constexpr size_t bm_key_count = 1024;
+
+static const std::vector<std::string>& bm_keys() {
+    static const std::vector<std::string> keys = []() {
+        std::vector<std::string> result;
+        result.reserve(bm_key_count);
+        for (size_t idx = 0; idx < bm_key_count; ++idx) {
+            result.emplace_back("benchmark_key_" + std::to_string(idx));
+        }
+        return result;
+    }();
+    return keys;
+}
+
+static Kvs open_bm_kvs(KvsLockMode mode) {
+    /* The KVS is never flushed, so no files are written to the benchmark directory */
+    auto open_res = KvsBuilder(InstanceId(static_cast<size_t>(mode)))
+                        .dir("./bm_data/")
+                        .lock_mode(mode)
+                        .build();
+    Kvs kvs = std::move(open_res.value());
+    for (size_t idx = 0; idx < bm_key_count; ++idx) {
+        (void)kvs.set_value(bm_keys()[idx], KvsValue(static_cast<int32_t>(idx)));
+    }
+    return kvs;
+}
+
+static Kvs& bm_shared_kvs(KvsLockMode mode) {
+    /* One KVS per lock mode, shared by all benchmark threads (static initialization is thread-safe) */
+    static Kvs kvs_trylock = open_bm_kvs(KvsLockMode::TryLock);
+    static Kvs kvs_blocking = open_bm_kvs(KvsLockMode::Blocking);
+    return (KvsLockMode::Blocking == mode) ? kvs_blocking : kvs_trylock;
+}
+
+static void BM_get_value_parallel(benchmark::State& state, KvsLockMode mode) {
+    // Read throughput of concurrent readers on one shared KVS
+    Kvs& kvs = bm_shared_kvs(mode);
+    const std::vector<std::string>& keys = bm_keys();
+    size_t idx = static_cast<size_t>(state.thread_index());
+    int64_t failures = 0;
+    for (auto _ : state) {
+        auto res = kvs.get_value(keys[idx % bm_key_count]);
+        if (!res) {
+            ++failures;
+        }
+        benchmark::DoNotOptimize(res);
+        ++idx;
+    }
+    state.SetItemsProcessed(int64_t(state.iterations()));
+    state.counters["lock_failures"] = benchmark::Counter(static_cast<double>(failures), benchmark::Counter::kAvgThreads);
+}
+
+// Read throughput from 1 to 16 threads for both lock modes
+BENCHMARK_CAPTURE(BM_get_value_parallel, trylock, KvsLockMode::TryLock)->ThreadRange(1, 16)->UseRealTime();
+BENCHMARK_CAPTURE(BM_get_value_parallel, blocking, KvsLockMode::Blocking)->ThreadRange(1, 16)->UseRealTime();
+
+static void BM_lookup_long_key(benchmark::State& state) {
+    // Read path with keys longer than the small string buffer: must not allocate
+    Kvs& kvs = bm_shared_kvs(KvsLockMode::TryLock);
+    static const std::string long_key = std::string(64, 'k') + "_long_key_lookup";
+    (void)kvs.set_value(long_key, KvsValue(42.0));
+    kvs.default_values.insert_or_assign(long_key, KvsValue(1.0));
+    kvs.rebuild_slots();
+
+    int64_t allocations_start = bm_allocations.load(std::memory_order_relaxed);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(kvs.key_exists(long_key));
+        benchmark::DoNotOptimize(kvs.get_value(long_key));
+        benchmark::DoNotOptimize(kvs.has_default_value(long_key));
+        benchmark::DoNotOptimize(kvs.get_default_value(long_key));
+    }
+    int64_t allocations = bm_allocations.load(std::memory_order_relaxed) - allocations_start;
+    state.counters["allocs_per_iteration"] = benchmark::Counter(static_cast<double>(allocations) / static_cast<double>(state.iterations()));
+}
+
+BENCHMARK(BM_lookup_long_key);
+
+static void BM_read_array(benchmark::State& state, bool copy) {
+    // Read a large array value either as copy (get_value) or in place (visit_value)
+    Kvs& kvs = bm_shared_kvs(KvsLockMode::TryLock);
+    static const std::string array_key = "benchmark_array";
+    std::vector<KvsValue> array;
+    array.reserve(static_cast<size_t>(state.range(0)));
+    for (int64_t idx = 0; idx < state.range(0); ++idx) {
+        array.emplace_back(static_cast<int32_t>(idx));
+    }
+    (void)kvs.set_value(array_key, KvsValue(array));
+
+    int64_t allocations_start = bm_allocations.load(std::memory_order_relaxed);
+    for (auto _ : state) {
+        if (copy) {
+            benchmark::DoNotOptimize(kvs.get_value(array_key));
+        }else{
+            (void)kvs.visit_value(array_key, [](const KvsValue& value) {
+                benchmark::DoNotOptimize(value.getArray().size());
+            });
+        }
+    }
+    int64_t allocations = bm_allocations.load(std::memory_order_relaxed) - allocations_start;
+    state.counters["allocs_per_iteration"] = benchmark::Counter(static_cast<double>(allocations) / static_cast<double>(state.iterations()));
+}
+
+BENCHMARK_CAPTURE(BM_read_array, get_value, true)->Range(16, 16<<10);
+BENCHMARK_CAPTURE(BM_read_array, visit_value, false)->Range(16, 16<<10);
+
+static void BM_get_value_as_scalar(benchmark::State& state) {
+    // Typed scalar read without creating a KvsValue
+    Kvs& kvs = bm_shared_kvs(KvsLockMode::TryLock);
+    const std::vector<std::string>& keys = bm_keys();
+    size_t idx = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(kvs.get_value_as<int32_t>(keys[idx % bm_key_count]));
+        ++idx;
+    }
+}
+
+BENCHMARK(BM_get_value_as_scalar);
+
+/* Fill a KVS with a mix of scalar, string and array values for the storage benchmarks */
+static void fill_bm_storage_kvs(Kvs& kvs, size_t key_count) {
+    KvsValue::Array array;
+    for (int32_t idx = 0; idx < 4; ++idx) {
+        array.push_back(std::make_shared<KvsValue>(idx));
+    }
+    const KvsValue array_value(array);
+    for (size_t idx = 0; idx < key_count; ++idx) {
+        const std::string key = "storage_key_" + std::to_string(idx);
+        switch (idx % 4) {
+            case 0: (void)kvs.set_value(key, KvsValue(static_cast<int32_t>(idx))); break;
+            case 1: (void)kvs.set_value(key, KvsValue(static_cast<double>(idx) * 0.5)); break;
+            case 2: (void)kvs.set_value(key, KvsValue(std::string("value_") + std::to_string(idx))); break;
+            default: (void)kvs.set_value(key, array_value); break;
+        }
+    }
+}
+
+static score::Result<Kvs> open_bm_storage_kvs(KvsStorageFormat format, bool need_kvs) {
+    return KvsBuilder(InstanceId(100 + static_cast<size_t>(format)))
+               .dir("./bm_data/")
+               .need_kvs_flag(need_kvs)
+               .storage_format(format)
+               .build();
+}
+
+static void BM_flush(benchmark::State& state, KvsStorageFormat format) {
+    // Flush latency (serialization, snapshot rotation and file writes) for the given storage format
+    auto open_res = open_bm_storage_kvs(format, false);
+    Kvs kvs = std::move(open_res.value());
+    kvs.kvs.clear(); /* Ignore data of previous runs */
+    kvs.rebuild_slots();
+    fill_bm_storage_kvs(kvs, static_cast<size_t>(state.range(0)));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(kvs.flush());
+    }
+    state.SetItemsProcessed(int64_t(state.iterations()) * state.range(0));
+}
+
+static void BM_open(benchmark::State& state, KvsStorageFormat format) {
+    // Open latency (file read, hash check and parsing) for the given storage format
+    {
+        auto open_res = open_bm_storage_kvs(format, false);
+        Kvs kvs = std::move(open_res.value());
+        kvs.kvs.clear();
+        kvs.rebuild_slots();
+        fill_bm_storage_kvs(kvs, static_cast<size_t>(state.range(0)));
+        (void)kvs.flush();
+    }
+    for (auto _ : state) {
+        auto open_res = open_bm_storage_kvs(format, true);
+        if (!open_res) {
+            state.SkipWithError("open failed");
+            break;
+        }
+        benchmark::DoNotOptimize(open_res);
+    }
+    state.SetItemsProcessed(int64_t(state.iterations()) * state.range(0));
+}
+
+// Open and flush latency of the JSON and the binary storage format
+BENCHMARK_CAPTURE(BM_flush, json, KvsStorageFormat::Json)->Range(64, 4<<10)->Unit(benchmark::kMicrosecond);
+BENCHMARK_CAPTURE(BM_flush, binary, KvsStorageFormat::Binary)->Range(64, 4<<10)->Unit(benchmark::kMicrosecond);
+BENCHMARK_CAPTURE(BM_open, json, KvsStorageFormat::Json)->Range(64, 4<<10)->Unit(benchmark::kMicrosecond);
+BENCHMARK_CAPTURE(BM_open, binary, KvsStorageFormat::Binary)->Range(64, 4<<10)->Unit(benchmark::kMicrosecond);
+
+/* Write kvs_<id>_default.json with the given number of defaults (and its hash file) */
+static void write_bm_defaults(size_t instance, size_t key_count) {
+    std::string json = "{";
+    for (size_t idx = 0; idx < key_count; ++idx) {
+        json += (0 == idx) ? "" : ",";
+        json += "\"default_key_" + std::to_string(idx) + "\":{\"t\":\"i32\",\"v\":" + std::to_string(idx) + "}";
+    }
+    json += "}";
+    std::filesystem::create_directories("./bm_data/");
+    const std::string prefix = "./bm_data/kvs_" + std::to_string(instance) + "_default";
+    std::ofstream(prefix + ".json", std::ios::binary) << json;
+    const std::array<uint8_t, 4> hash = get_hash_bytes(json);
+    std::ofstream(prefix + ".hash", std::ios::binary).write(reinterpret_cast<const char*>(hash.data()), hash.size());
+    std::filesystem::remove(prefix + ".img");
+}
+
+static score::Result<Kvs> open_bm_defaults_kvs(size_t instance, bool mapped) {
+    return KvsBuilder(InstanceId(instance))
+               .dir("./bm_data/")
+               .need_defaults_flag(true)
+               .mapped_defaults_flag(mapped)
+               .build();
+}
+
+static void BM_open_defaults(benchmark::State& state, bool mapped) {
+    // Open latency with a large defaults file: parsed JSON vs. memory-mapped image
+    const size_t instance = mapped ? 201 : 200;
+    write_bm_defaults(instance, static_cast<size_t>(state.range(0)));
+    (void)open_bm_defaults_kvs(instance, mapped); /* Builds the image */
+    for (auto _ : state) {
+        auto open_res = open_bm_defaults_kvs(instance, mapped);
+        if (!open_res) {
+            state.SkipWithError("open failed");
+            break;
+        }
+        benchmark::DoNotOptimize(open_res);
+    }
+    state.SetItemsProcessed(int64_t(state.iterations()) * state.range(0));
+}
+
+BENCHMARK_CAPTURE(BM_open_defaults, json, false)->Range(64, 16<<10)->Unit(benchmark::kMicrosecond);
+BENCHMARK_CAPTURE(BM_open_defaults, mapped, true)->Range(64, 16<<10)->Unit(benchmark::kMicrosecond);
+
+static void BM_get_default_value(benchmark::State& state, bool mapped) {
+    // Lookup cost of a default value: map vs. lazy lookup in the memory-mapped image
+    const size_t instance = mapped ? 203 : 202;
+    constexpr size_t key_count = 4096;
+    write_bm_defaults(instance, key_count);
+    (void)open_bm_defaults_kvs(instance, mapped);
+    auto open_res = open_bm_defaults_kvs(instance, mapped);
+    Kvs kvs = std::move(open_res.value());
+    std::vector<std::string> keys;
+    for (size_t idx = 0; idx < key_count; ++idx) {
+        keys.emplace_back("default_key_" + std::to_string(idx));
+    }
+    size_t idx = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(kvs.get_default_value(keys[idx % key_count]));
+        ++idx;
+    }
+    state.SetItemsProcessed(int64_t(state.iterations()));
+}
+
+BENCHMARK_CAPTURE(BM_get_default_value, map, false);
+BENCHMARK_CAPTURE(BM_get_default_value, mapped, true);
+
+static void BM_flush_single_change(benchmark::State& state, KvsFlushMode mode) {
+    // Flush latency after changing one key: rewrite of the whole KVS file vs. append to the log
+    const size_t instance = (KvsFlushMode::Incremental == mode) ? 301 : 300;
+    std::filesystem::remove("./bm_data/kvs_" + std::to_string(instance) + "_0.log");
+    auto open_res = KvsBuilder(InstanceId(instance)).dir("./bm_data/").flush_mode(mode).build();
+    Kvs kvs = std::move(open_res.value());
+    kvs.kvs.clear(); /* Ignore data of previous runs */
+    kvs.rebuild_slots();
+    fill_bm_storage_kvs(kvs, static_cast<size_t>(state.range(0)));
+    kvs.full_flush_required = true;
+    (void)kvs.flush();
+    int32_t idx = 0;
+    for (auto _ : state) {
+        (void)kvs.set_value("storage_key_0", KvsValue(idx++));
+        benchmark::DoNotOptimize(kvs.flush());
+    }
+    state.SetItemsProcessed(int64_t(state.iterations()));
+}
+
+BENCHMARK_CAPTURE(BM_flush_single_change, full, KvsFlushMode::Full)->Range(64, 4<<10)->Unit(benchmark::kMicrosecond);
+BENCHMARK_CAPTURE(BM_flush_single_change, incremental, KvsFlushMode::Incremental)->Range(64, 4<<10)->Unit(benchmark::kMicrosecond);
+
+static void BM_flush_caller_latency(benchmark::State& state, bool background) {
+    // Time the caller is blocked by set_value + flush: synchronous flush vs. request to the background flusher
+    const size_t instance = background ? 311 : 310;
+    auto open_res = KvsBuilder(InstanceId(instance)).dir("./bm_data/").background_flush_flag(background).build();
+    Kvs kvs = std::move(open_res.value());
+    kvs.kvs.clear(); /* Ignore data of previous runs */
+    kvs.rebuild_slots();
+    fill_bm_storage_kvs(kvs, static_cast<size_t>(state.range(0)));
+    int32_t idx = 0;
+    for (auto _ : state) {
+        (void)kvs.set_value("storage_key_0", KvsValue(idx++));
+        benchmark::DoNotOptimize(kvs.flush_async());
+    }
+    (void)kvs.flush(); /* Wait for the last background flush (not measured) */
+    state.SetItemsProcessed(int64_t(state.iterations()));
+}
+
+BENCHMARK_CAPTURE(BM_flush_caller_latency, sync, false)->Range(64, 4<<10)->Unit(benchmark::kMicrosecond);
+BENCHMARK_CAPTURE(BM_flush_caller_latency, background, true)->Range(64, 4<<10)->Unit(benchmark::kMicrosecond);
+
+static void BM_snapshot_rotation(benchmark::State& state, KvsSnapshotLayout layout) {
+    // Flush of a small KVS with many snapshots: one rename per snapshot file vs. one manifest update
+    const size_t instance = (KvsSnapshotLayout::Generations == layout) ? 321 : 320;
+    auto open_res = KvsBuilder(InstanceId(instance))
+                        .dir("./bm_data/")
+                        .snapshot_max_count(static_cast<size_t>(state.range(0)))
+                        .snapshot_layout(layout)
+                        .build();
+    Kvs kvs = std::move(open_res.value());
+    kvs.kvs.clear(); /* Ignore data of previous runs */
+    kvs.rebuild_slots();
+    fill_bm_storage_kvs(kvs, 16);
+    int32_t idx = 0;
+    for (auto _ : state) {
+        (void)kvs.set_value("storage_key_0", KvsValue(idx++));
+        (void)kvs.flush();
+        benchmark::DoNotOptimize(kvs.snapshot_count());
+    }
+    state.SetItemsProcessed(int64_t(state.iterations()));
+}
+
+BENCHMARK_CAPTURE(BM_snapshot_rotation, legacy, KvsSnapshotLayout::Legacy)->RangeMultiplier(4)->Range(1, 64)->Unit(benchmark::kMicrosecond);
+BENCHMARK_CAPTURE(BM_snapshot_rotation, generations, KvsSnapshotLayout::Generations)->RangeMultiplier(4)->Range(1, 64)->Unit(benchmark::kMicrosecond);
+
+static void BM_flush_durability(benchmark::State& state, KvsDurability durability) {
+    // Flush latency of the durability policies (Grouped syncs every 8th flush)
+    const size_t instance = 330 + static_cast<size_t>(durability);
+    auto open_res = KvsBuilder(InstanceId(instance))
+                        .dir("./bm_data/")
+                        .durability(durability)
+                        .build();
+    Kvs kvs = std::move(open_res.value());
+    kvs.kvs.clear(); /* Ignore data of previous runs */
+    kvs.rebuild_slots();
+    fill_bm_storage_kvs(kvs, static_cast<size_t>(state.range(0)));
+    int32_t idx = 0;
+    for (auto _ : state) {
+        (void)kvs.set_value("storage_key_0", KvsValue(idx++));
+        benchmark::DoNotOptimize(kvs.flush());
+    }
+    state.SetItemsProcessed(int64_t(state.iterations()));
+}
+
+BENCHMARK_CAPTURE(BM_flush_durability, deferred, KvsDurability::Deferred)->Range(64, 4<<10)->Unit(benchmark::kMicrosecond);
+BENCHMARK_CAPTURE(BM_flush_durability, grouped, KvsDurability::Grouped)->Range(64, 4<<10)->Unit(benchmark::kMicrosecond);
+BENCHMARK_CAPTURE(BM_flush_durability, always, KvsDurability::Always)->Range(64, 4<<10)->Unit(benchmark::kMicrosecond);
+
+static void BM_delta_snapshots(benchmark::State& state, bool delta) {
+    // Flush of a KVS with one changed key: complete snapshot copies vs. deltas, snapshot_bytes is the size on flash
+    const size_t instance = delta ? 341 : 340;
+    auto open_res = KvsBuilder(InstanceId(instance))
+                        .dir("./bm_data/")
+                        .delta_snapshots_flag(delta)
+                        .build();
+    Kvs kvs = std::move(open_res.value());
+    kvs.kvs.clear(); /* Ignore data of previous runs */
+    kvs.rebuild_slots();
+    fill_bm_storage_kvs(kvs, static_cast<size_t>(state.range(0)));
+    int32_t idx = 0;
+    for (auto _ : state) {
+        (void)kvs.set_value("storage_key_0", KvsValue(idx++));
+        benchmark::DoNotOptimize(kvs.flush());
+    }
+    uintmax_t snapshot_bytes = 0;
+    for (const auto& entry : std::filesystem::directory_iterator("./bm_data/")) {
+        const std::string name = entry.path().filename().string();
+        if ((0 == name.rfind("kvs_" + std::to_string(instance) + "_", 0)) && (0 != name.rfind("kvs_" + std::to_string(instance) + "_0", 0))) {
+            snapshot_bytes += entry.file_size();
+        }
+    }
+    state.counters["snapshot_bytes"] = benchmark::Counter(static_cast<double>(snapshot_bytes));
+    state.SetItemsProcessed(int64_t(state.iterations()));
+}
+
+BENCHMARK_CAPTURE(BM_delta_snapshots, complete, false)->Range(64, 4<<10)->Unit(benchmark::kMicrosecond);
+BENCHMARK_CAPTURE(BM_delta_snapshots, delta, true)->Range(64, 4<<10)->Unit(benchmark::kMicrosecond);
+
+static void BM_snapshot_diff(benchmark::State& state, bool delta) {
+    // Diff of the two newest snapshots with one changed key: both files parsed vs. the newer file and the delta
+    const size_t instance = delta ? 351 : 350;
+    auto open_res = KvsBuilder(InstanceId(instance))
+                        .dir("./bm_data/")
+                        .delta_snapshots_flag(delta)
+                        .build();
+    Kvs kvs = std::move(open_res.value());
+    kvs.kvs.clear(); /* Ignore data of previous runs */
+    kvs.rebuild_slots();
+    fill_bm_storage_kvs(kvs, static_cast<size_t>(state.range(0)));
+    for (int32_t idx = 0; idx < 3; ++idx) {
+        (void)kvs.set_value("storage_key_0", KvsValue(idx));
+        (void)kvs.flush();
+    }
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(kvs.snapshot_diff(1, 2));
+    }
+    state.SetItemsProcessed(int64_t(state.iterations()));
+}
+
+BENCHMARK_CAPTURE(BM_snapshot_diff, complete, false)->Range(64, 4<<10)->Unit(benchmark::kMicrosecond);
+BENCHMARK_CAPTURE(BM_snapshot_diff, delta, true)->Range(64, 4<<10)->Unit(benchmark::kMicrosecond);
+
+static void BM_update_keys(benchmark::State& state, bool batch) {
+    // Update of a group of keys: one lock per set_value() vs. one lock for a KvsWriteBatch
+    auto open_res = KvsBuilder(InstanceId(batch ? 361 : 360)).dir("./bm_data/").build();
+    Kvs kvs = std::move(open_res.value()); /* Never flushed */
+    const size_t key_count = static_cast<size_t>(state.range(0));
+    int32_t round = 0;
+    KvsWriteBatch write_batch; /* Reused, write() keeps the capacity of the emptied batch */
+    for (auto _ : state) {
+        if (batch) {
+            for (size_t idx = 0; idx < key_count; ++idx) {
+                write_batch.set_value(bm_keys()[idx], KvsValue(round));
+            }
+            benchmark::DoNotOptimize(kvs.write(std::move(write_batch)));
+        }else{
+            for (size_t idx = 0; idx < key_count; ++idx) {
+                benchmark::DoNotOptimize(kvs.set_value(bm_keys()[idx], KvsValue(round)));
+            }
+        }
+        ++round;
+    }
+    state.SetItemsProcessed(int64_t(state.iterations()) * state.range(0));
+}
+
+BENCHMARK_CAPTURE(BM_update_keys, set_value, false)->Range(8, 512);
+BENCHMARK_CAPTURE(BM_update_keys, write_batch, true)->Range(8, 512);
+
+enum class BmSetMode { Copy, Move, Emplace };
+
+static void BM_set_nested_value(benchmark::State& state, BmSetMode mode) {
+    // Write of a caller-built Array of Objects: copied, moved or constructed in place
+    auto open_res = KvsBuilder(InstanceId(370 + static_cast<size_t>(mode))).dir("./bm_data/").build();
+    Kvs kvs = std::move(open_res.value()); /* Never flushed */
+    const auto element = std::make_shared<KvsValue>(KvsValue::Object{{"x", std::make_shared<KvsValue>(1.0)},
+                                                                     {"y", std::make_shared<KvsValue>(2.0)}});
+    size_t key_idx = 0;
+    for (auto _ : state) {
+        KvsValue::Array array(static_cast<size_t>(state.range(0)), element);
+        const std::string& key = bm_keys()[key_idx];
+        switch (mode) {
+            case BmSetMode::Copy: {
+                const KvsValue value(std::move(array));
+                benchmark::DoNotOptimize(kvs.set_value(key, value));
+                break;
+            }
+            case BmSetMode::Move:
+                benchmark::DoNotOptimize(kvs.set_value(std::string(key), KvsValue(std::move(array))));
+                break;
+            default:
+                benchmark::DoNotOptimize(kvs.emplace_value(key, std::move(array)));
+                break;
+        }
+        key_idx = (key_idx + 1) % bm_key_count; /* New and existing keys */
+    }
+    state.SetItemsProcessed(int64_t(state.iterations()));
+}
+
+BENCHMARK_CAPTURE(BM_set_nested_value, copy, BmSetMode::Copy)->Range(8, 4<<10);
+BENCHMARK_CAPTURE(BM_set_nested_value, move, BmSetMode::Move)->Range(8, 4<<10);
+BENCHMARK_CAPTURE(BM_set_nested_value, emplace, BmSetMode::Emplace)->Range(8, 4<<10);
+
+enum class BmGroupRead { AllKeys, GetValues, ScanPrefix };
+
+static void BM_read_key_group(benchmark::State& state, BmGroupRead mode) {
+    // Read of the 16 keys of one group out of 1024 keys: get_all_keys() + get_value() vs. get_values() vs. scan_prefix()
+    auto open_res = KvsBuilder(InstanceId(380 + static_cast<size_t>(mode))).dir("./bm_data/").build();
+    Kvs kvs = std::move(open_res.value()); /* Never flushed */
+    constexpr size_t group_size = 16;
+    std::vector<std::string> group_keys;
+    for (size_t idx = 0; idx < bm_key_count; ++idx) {
+        std::string key = "group_" + std::to_string(idx / group_size) + ".key_" + std::to_string(idx % group_size);
+        if ((idx / group_size) == 7) {
+            group_keys.push_back(key);
+        }
+        (void)kvs.set_value(std::move(key), KvsValue(static_cast<int32_t>(idx)));
+    }
+    const std::vector<std::string_view> group_views(group_keys.begin(), group_keys.end());
+    const std::string prefix = "group_7.";
+    for (auto _ : state) {
+        int64_t sum = 0;
+        switch (mode) {
+            case BmGroupRead::AllKeys:
+                for (const auto& key : kvs.get_all_keys().value()) {
+                    if (0 == key.compare(0, prefix.size(), prefix)) {
+                        sum += std::get<int32_t>(kvs.get_value(key).value().getValue());
+                    }
+                }
+                break;
+            case BmGroupRead::GetValues:
+                for (const auto& value : kvs.get_values(group_views).value()) {
+                    sum += std::get<int32_t>(value.value().getValue());
+                }
+                break;
+            default:
+                (void)kvs.scan_prefix(prefix, [&sum](const std::string&, const KvsValue& value) {
+                    sum += std::get<int32_t>(value.getValue());
+                });
+                break;
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(int64_t(state.iterations()) * int64_t(group_size));
+}
+
+BENCHMARK_CAPTURE(BM_read_key_group, get_all_keys, BmGroupRead::AllKeys);
+BENCHMARK_CAPTURE(BM_read_key_group, get_values, BmGroupRead::GetValues);
+BENCHMARK_CAPTURE(BM_read_key_group, scan_prefix, BmGroupRead::ScanPrefix);
+
+static void BM_store_memory(benchmark::State& state) {
+    // Heap memory per entry of a store of mostly scalars (ints, doubles, bools and a few short strings)
+    const size_t key_count = static_cast<size_t>(state.range(0));
+    for (auto _ : state) {
+        auto open_res = KvsBuilder(InstanceId(390)).dir("./bm_data/").build();
+        Kvs kvs = std::move(open_res.value()); /* Never flushed */
+        const int64_t bytes_before = bm_allocated_bytes.load(std::memory_order_relaxed);
+        for (size_t idx = 0; idx < key_count; ++idx) {
+            std::string key = "key_" + std::to_string(idx); /* Short key, stored inline in std::string */
+            switch (idx % 10) {
+                case 0: (void)kvs.set_value(std::move(key), KvsValue(std::string("short"))); break;
+                case 1: case 2: (void)kvs.set_value(std::move(key), KvsValue(idx % 3 == 0)); break;
+                case 3: case 4: case 5: (void)kvs.set_value(std::move(key), KvsValue(static_cast<double>(idx))); break;
+                default: (void)kvs.set_value(std::move(key), KvsValue(static_cast<int32_t>(idx))); break;
+            }
+        }
+        state.counters["bytes_per_key"] = static_cast<double>(bm_allocated_bytes.load(std::memory_order_relaxed) - bytes_before)
+                                          / static_cast<double>(key_count);
+    }
+    state.counters["sizeof_value"] = static_cast<double>(sizeof(KvsValue));
+}
+
+BENCHMARK(BM_store_memory)->Arg(100000)->Iterations(1)->Unit(benchmark::kMillisecond);
+
+static void BM_open_arena(benchmark::State& state, KvsStorageFormat format, bool arena) {
+    // Open and release of a KVS with nested values, map nodes and elements allocated separately vs. from one arena
+    const size_t instance = 400 + (static_cast<size_t>(format) * 2U) + (arena ? 1U : 0U);
+    {
+        auto open_res = KvsBuilder(InstanceId(instance)).dir("./bm_data/").storage_format(format).build();
+        Kvs kvs = std::move(open_res.value());
+        kvs.kvs.clear();
+        kvs.rebuild_slots();
+        fill_bm_storage_kvs(kvs, static_cast<size_t>(state.range(0)));
+        (void)kvs.flush();
+    }
+    for (auto _ : state) {
+        auto open_res = KvsBuilder(InstanceId(instance))
+                            .dir("./bm_data/")
+                            .need_kvs_flag(true)
+                            .storage_format(format)
+                            .arena_flag(arena)
+                            .build();
+        if (!open_res) {
+            state.SkipWithError("open failed");
+            break;
+        }
+        benchmark::DoNotOptimize(open_res);
+    }
+    state.SetItemsProcessed(int64_t(state.iterations()) * state.range(0));
+}
+
+BENCHMARK_CAPTURE(BM_open_arena, json_heap, KvsStorageFormat::Json, false)->Range(64, 4<<10)->Unit(benchmark::kMicrosecond);
+BENCHMARK_CAPTURE(BM_open_arena, json_arena, KvsStorageFormat::Json, true)->Range(64, 4<<10)->Unit(benchmark::kMicrosecond);
+BENCHMARK_CAPTURE(BM_open_arena, binary_heap, KvsStorageFormat::Binary, false)->Range(64, 4<<10)->Unit(benchmark::kMicrosecond);
+BENCHMARK_CAPTURE(BM_open_arena, binary_arena, KvsStorageFormat::Binary, true)->Range(64, 4<<10)->Unit(benchmark::kMicrosecond);
+
+static void BM_open_parallel(benchmark::State& state, size_t workers) {
+    // Startup of a JSON KVS with defaults of the same size, loaded and converted by one vs. several threads
+    const size_t instance = 410 + (workers > 1U ? 1U : 0U);
+    const size_t key_count = static_cast<size_t>(state.range(0));
+    write_bm_defaults(instance, key_count);
+    {
+        auto open_res = KvsBuilder(InstanceId(instance)).dir("./bm_data/").build();
+        Kvs kvs = std::move(open_res.value());
+        kvs.kvs.clear();
+        kvs.rebuild_slots();
+        fill_bm_storage_kvs(kvs, key_count);
+        (void)kvs.flush();
+    }
+    for (auto _ : state) {
+        auto open_res = KvsBuilder(InstanceId(instance))
+                            .dir("./bm_data/")
+                            .need_defaults_flag(true)
+                            .need_kvs_flag(true)
+                            .open_workers(workers)
+                            .build();
+        if (!open_res) {
+            state.SkipWithError("open failed");
+            break;
+        }
+        benchmark::DoNotOptimize(open_res);
+    }
+    state.SetItemsProcessed(int64_t(state.iterations()) * state.range(0));
+}
+
+BENCHMARK_CAPTURE(BM_open_parallel, sequential, 1U)->Arg(1000)->Arg(10000)->Arg(100000)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_open_parallel, parallel, 4U)->Arg(1000)->Arg(10000)->Arg(100000)->Unit(benchmark::kMillisecond);
+
+static void BM_open_first_read(benchmark::State& state, KvsStorageFormat format, bool lazy) {
+    // Open of a KVS followed by the first read of one key, all values decoded at open vs. on first access
+    const size_t instance = 420 + (static_cast<size_t>(format) * 2U) + (lazy ? 1U : 0U);
+    const size_t key_count = static_cast<size_t>(state.range(0));
+    {
+        auto open_res = KvsBuilder(InstanceId(instance)).dir("./bm_data/").storage_format(format).build();
+        Kvs kvs = std::move(open_res.value());
+        kvs.kvs.clear();
+        kvs.rebuild_slots();
+        fill_bm_storage_kvs(kvs, key_count);
+        (void)kvs.flush();
+    }
+    const std::string key = "storage_key_" + std::to_string(key_count / 2U);
+    for (auto _ : state) {
+        auto open_res = KvsBuilder(InstanceId(instance))
+                            .dir("./bm_data/")
+                            .need_kvs_flag(true)
+                            .storage_format(format)
+                            .lazy_values_flag(lazy)
+                            .build();
+        if (!open_res) {
+            state.SkipWithError("open failed");
+            break;
+        }
+        auto value = open_res.value().get_value(key);
+        if (!value) {
+            state.SkipWithError("get_value failed");
+            break;
+        }
+        benchmark::DoNotOptimize(value);
+    }
+    state.SetItemsProcessed(int64_t(state.iterations()) * state.range(0));
+}
+
+BENCHMARK_CAPTURE(BM_open_first_read, json_eager, KvsStorageFormat::Json, false)->Arg(1000)->Arg(10000)->Arg(100000)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_open_first_read, json_lazy, KvsStorageFormat::Json, true)->Arg(1000)->Arg(10000)->Arg(100000)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_open_first_read, binary_eager, KvsStorageFormat::Binary, false)->Arg(1000)->Arg(10000)->Arg(100000)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_open_first_read, binary_lazy, KvsStorageFormat::Binary, true)->Arg(1000)->Arg(10000)->Arg(100000)->Unit(benchmark::kMillisecond);
+
+static void BM_shared_get_value(benchmark::State& state, KvsSharing sharing) {
+    // get_value of the owner (map under the KVS lock) vs. a reader of the published data (copied out of shared memory)
+    const size_t key_count = static_cast<size_t>(state.range(0));
+    auto owner_res = KvsBuilder(InstanceId(430)).dir("./bm_data/").sharing(KvsSharing::Owner).shared_size(16U << 20U).build();
+    if (!owner_res) {
+        state.SkipWithError("open of the owner failed");
+        return;
+    }
+    Kvs& owner = owner_res.value();
+    owner.kvs.clear();
+    owner.rebuild_slots();
+    fill_bm_storage_kvs(owner, key_count);
+    (void)owner.publish();
+    auto reader_res = KvsBuilder(InstanceId(430)).dir("./bm_data/").sharing(KvsSharing::Reader).build();
+    if (!reader_res) {
+        state.SkipWithError("open of the reader failed");
+        return;
+    }
+    Kvs& kvs = (KvsSharing::Reader == sharing) ? reader_res.value() : owner;
+    const std::string key = "storage_key_" + std::to_string(key_count / 2U);
+    for (auto _ : state) {
+        auto value = kvs.get_value(key);
+        if (!value) {
+            state.SkipWithError("get_value failed");
+            break;
+        }
+        benchmark::DoNotOptimize(value);
+    }
+    state.SetItemsProcessed(int64_t(state.iterations()));
+    (void)SharedStore::remove(SharedStore::segment_name(owner.filename_prefix.Native())); /* The segment outlives the owner */
+}
+
+BENCHMARK_CAPTURE(BM_shared_get_value, owner, KvsSharing::Owner)->Range(64, 16<<10);
+BENCHMARK_CAPTURE(BM_shared_get_value, reader, KvsSharing::Reader)->Range(64, 16<<10);
+
+static void BM_set_value_subscribed(benchmark::State& state, bool subscribed) {
+    // Writer cost without subscribers vs. with a subscriber (the change is only queued under the lock)
+    auto open_res = KvsBuilder(InstanceId(440)).dir("./bm_data/").build();
+    if (!open_res) {
+        state.SkipWithError("open failed");
+        return;
+    }
+    Kvs& kvs = open_res.value();
+    std::atomic<int64_t> delivered{0};
+    if (subscribed) {
+        (void)kvs.subscribe_prefix("bm_", [&delivered](const std::vector<KvsChange>& changes) {
+            delivered += static_cast<int64_t>(changes.size());
+        });
+    }
+    const KvsValue value(std::string(32, 'v'));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(kvs.set_value("bm_key", value));
+    }
+    kvs.wait_notifications();
+    state.SetItemsProcessed(int64_t(state.iterations()));
+    state.counters["delivered"] = benchmark::Counter(static_cast<double>(delivered.load()));
+}
+
+BENCHMARK_CAPTURE(BM_set_value_subscribed, none, false);
+BENCHMARK_CAPTURE(BM_set_value_subscribed, subscribed, true);
+
+static void BM_flush_open_backend(benchmark::State& state, bool memory) {
+    // Flush + open of the same data on the files of the OS vs. in memory (in-memory cost without I/O)
+    std::shared_ptr<KvsBackend> backend = memory ? std::shared_ptr<KvsBackend>(std::make_shared<KvsMemoryBackend>()) : nullptr;
+    auto open_res = KvsBuilder(InstanceId(450)).dir("./bm_data/").backend(backend).build();
+    if (!open_res) {
+        state.SkipWithError("open failed");
+        return;
+    }
+    Kvs& kvs = open_res.value();
+    kvs.kvs.clear(); /* Ignore data of previous runs */
+    kvs.rebuild_slots();
+    fill_bm_storage_kvs(kvs, static_cast<size_t>(state.range(0)));
+    for (auto _ : state) {
+        if (!kvs.flush()) {
+            state.SkipWithError("flush failed");
+            break;
+        }
+        auto reopen_res = KvsBuilder(InstanceId(450)).dir("./bm_data/").need_kvs_flag(true).backend(backend).build();
+        if (!reopen_res) {
+            state.SkipWithError("reopen failed");
+            break;
+        }
+        benchmark::DoNotOptimize(reopen_res.value().kvs.size());
+    }
+    state.SetItemsProcessed(int64_t(state.iterations()) * state.range(0));
+}
+
+BENCHMARK_CAPTURE(BM_flush_open_backend, file, false)->Range(64, 4<<10)->Unit(benchmark::kMicrosecond);
+BENCHMARK_CAPTURE(BM_flush_open_backend, memory, true)->Range(64, 4<<10)->Unit(benchmark::kMicrosecond);
+
+static void BM_stats_timer(benchmark::State& state, bool hook) {
+    // Cost of one measured operation (two clock reads and the atomic updates), with and without trace hook
+    KvsStatsRecorder recorder;
+    uint64_t traced = 0;
+    if (hook) {
+        recorder.trace_hook = [&traced](KvsOperation, std::chrono::steady_clock::time_point, std::chrono::nanoseconds) {
+            ++traced;
+        };
+    }
+    for (auto _ : state) {
+        const KvsStatsTimer timer(recorder, KvsOperation::Flush);
+    }
+    benchmark::DoNotOptimize(traced);
+    state.SetItemsProcessed(int64_t(state.iterations()));
+}
+
+BENCHMARK_CAPTURE(BM_stats_timer, recorder, false);
+BENCHMARK_CAPTURE(BM_stats_timer, trace_hook, true);
+
+/* Value shapes of the value and store size benchmarks */
+enum class BmShape {
+    Scalar, /* Single i32 */
+    Nested  /* Object with scalars, a string, an array of objects and a child object */
+};
+
+static KvsValue bm_value(BmShape shape, size_t elements) {
+    if (BmShape::Scalar == shape) {
+        return KvsValue(static_cast<int32_t>(elements));
+    }
+    KvsValue::Array items;
+    items.reserve(elements);
+    for (size_t idx = 0; idx < elements; ++idx) {
+        KvsValue::Object item;
+        item.emplace("id", std::make_shared<KvsValue>(static_cast<uint32_t>(idx)));
+        item.emplace("weight", std::make_shared<KvsValue>(static_cast<double>(idx) * 0.25));
+        items.push_back(std::make_shared<KvsValue>(std::move(item)));
+    }
+    KvsValue::Object child;
+    child.emplace("enabled", std::make_shared<KvsValue>(true));
+    child.emplace("limit", std::make_shared<KvsValue>(static_cast<int64_t>(elements)));
+    KvsValue::Object object;
+    object.emplace("name", std::make_shared<KvsValue>(std::string("nested_value_") + std::to_string(elements)));
+    object.emplace("items", std::make_shared<KvsValue>(std::move(items)));
+    object.emplace("child", std::make_shared<KvsValue>(std::move(child)));
+    return KvsValue(std::move(object));
+}
+
+/* Number of array elements of a value: scalars have none, nested values use the benchmark argument */
+static size_t bm_value_elements(const benchmark::State& state, BmShape shape) {
+    return (BmShape::Scalar == shape) ? 1U : static_cast<size_t>(state.range(0));
+}
+
+static void BM_value_copy(benchmark::State& state, BmShape shape) {
+    // Copy of a KvsValue (what get_value returns), nested elements are shared and only reference counted
+    const KvsValue value = bm_value(shape, bm_value_elements(state, shape));
+    for (auto _ : state) {
+        KvsValue copy(value);
+        benchmark::DoNotOptimize(copy);
+    }
+    state.SetItemsProcessed(int64_t(state.iterations()));
+}
+
+BENCHMARK_CAPTURE(BM_value_copy, scalar, BmShape::Scalar);
+BENCHMARK_CAPTURE(BM_value_copy, nested, BmShape::Nested)->Range(4, 1<<10);
+
+static void BM_kvsvalue_to_any(benchmark::State& state, BmShape shape) {
+    // Conversion to the JSON representation (used by the JSON flush) per value shape
+    const KvsValue value = bm_value(shape, bm_value_elements(state, shape));
+    for (auto _ : state) {
+        auto res = kvsvalue_to_any(value);
+        if (!res) {
+            state.SkipWithError("conversion failed");
+            break;
+        }
+        benchmark::DoNotOptimize(res);
+    }
+    state.SetItemsProcessed(int64_t(state.iterations()));
+}
+
+static void BM_any_to_kvsvalue(benchmark::State& state, BmShape shape) {
+    // Conversion from the JSON representation (used by the JSON open) per value shape
+    auto any = kvsvalue_to_any(bm_value(shape, bm_value_elements(state, shape)));
+    if (!any) {
+        state.SkipWithError("conversion failed");
+        return;
+    }
+    for (auto _ : state) {
+        auto res = any_to_kvsvalue(any.value());
+        if (!res) {
+            state.SkipWithError("conversion failed");
+            break;
+        }
+        benchmark::DoNotOptimize(res);
+    }
+    state.SetItemsProcessed(int64_t(state.iterations()));
+}
+
+BENCHMARK_CAPTURE(BM_kvsvalue_to_any, scalar, BmShape::Scalar);
+BENCHMARK_CAPTURE(BM_kvsvalue_to_any, nested, BmShape::Nested)->Range(4, 1<<10);
+BENCHMARK_CAPTURE(BM_any_to_kvsvalue, scalar, BmShape::Scalar);
+BENCHMARK_CAPTURE(BM_any_to_kvsvalue, nested, BmShape::Nested)->Range(4, 1<<10);
+
+/* Open a KVS (never flushed) with the given number of keys holding values of the given shape */
+static score::Result<Kvs> open_bm_sized_kvs(BmShape shape, size_t key_count) {
+    auto open_res = KvsBuilder(InstanceId(460 + static_cast<size_t>(shape))).dir("./bm_data/").build();
+    if (open_res) {
+        Kvs& kvs = open_res.value();
+        kvs.kvs.clear();
+        kvs.rebuild_slots();
+        const KvsValue value = bm_value(shape, 8);
+        for (size_t idx = 0; idx < key_count; ++idx) {
+            (void)kvs.set_value("sized_key_" + std::to_string(idx), value);
+        }
+    }
+    return open_res;
+}
+
+static void BM_get_value_store_size(benchmark::State& state, BmShape shape) {
+    // Random-order reads depending on the number of keys in the store (map depth and cache misses)
+    const size_t key_count = static_cast<size_t>(state.range(0));
+    auto open_res = open_bm_sized_kvs(shape, key_count);
+    if (!open_res) {
+        state.SkipWithError("open failed");
+        return;
+    }
+    Kvs& kvs = open_res.value();
+    std::vector<std::string> keys;
+    keys.reserve(key_count);
+    for (size_t idx = 0; idx < key_count; ++idx) {
+        keys.push_back("sized_key_" + std::to_string((idx * 7919U) % key_count));
+    }
+    size_t idx = 0;
+    for (auto _ : state) {
+        auto res = kvs.get_value(keys[idx % key_count]);
+        if (!res) {
+            state.SkipWithError("get_value failed");
+            break;
+        }
+        benchmark::DoNotOptimize(res);
+        ++idx;
+    }
+    state.SetItemsProcessed(int64_t(state.iterations()));
+}
+
+static void BM_set_value_store_size(benchmark::State& state, BmShape shape) {
+    // Overwrite of existing keys depending on the number of keys in the store
+    const size_t key_count = static_cast<size_t>(state.range(0));
+    auto open_res = open_bm_sized_kvs(shape, key_count);
+    if (!open_res) {
+        state.SkipWithError("open failed");
+        return;
+    }
+    Kvs& kvs = open_res.value();
+    std::vector<std::string> keys;
+    keys.reserve(key_count);
+    for (size_t idx = 0; idx < key_count; ++idx) {
+        keys.push_back("sized_key_" + std::to_string((idx * 7919U) % key_count));
+    }
+    const KvsValue value = bm_value(shape, 8);
+    size_t idx = 0;
+    for (auto _ : state) {
+        if (!kvs.set_value(keys[idx % key_count], value)) {
+            state.SkipWithError("set_value failed");
+            break;
+        }
+        ++idx;
+    }
+    state.SetItemsProcessed(int64_t(state.iterations()));
+}
+
+BENCHMARK_CAPTURE(BM_get_value_store_size, scalar, BmShape::Scalar)->RangeMultiplier(8)->Range(64, 256<<10);
+BENCHMARK_CAPTURE(BM_get_value_store_size, nested, BmShape::Nested)->RangeMultiplier(8)->Range(64, 256<<10);
+BENCHMARK_CAPTURE(BM_set_value_store_size, scalar, BmShape::Scalar)->RangeMultiplier(8)->Range(64, 256<<10);
+BENCHMARK_CAPTURE(BM_set_value_store_size, nested, BmShape::Nested)->RangeMultiplier(8)->Range(64, 256<<10);
+
+static void BM_snapshot_restore(benchmark::State& state, KvsStorageFormat format) {
+    // Restore of the newest snapshot (snapshot read and parse, the full flush and the swap of the data)
+    const size_t instance = (KvsStorageFormat::Json == format) ? 470 : 471;
+    auto open_res = KvsBuilder(InstanceId(instance)).dir("./bm_data/").storage_format(format).build();
+    if (!open_res) {
+        state.SkipWithError("open failed");
+        return;
+    }
+    Kvs& kvs = open_res.value();
+    kvs.kvs.clear();
+    kvs.rebuild_slots();
+    fill_bm_storage_kvs(kvs, static_cast<size_t>(state.range(0)));
+    if (!kvs.flush() || !kvs.flush()) {
+        state.SkipWithError("flush failed");
+        return;
+    }
+    for (auto _ : state) {
+        if (!kvs.snapshot_restore(1)) {
+            state.SkipWithError("snapshot_restore failed");
+            break;
+        }
+    }
+    state.SetItemsProcessed(int64_t(state.iterations()) * state.range(0));
+}
+
+BENCHMARK_CAPTURE(BM_snapshot_restore, json, KvsStorageFormat::Json)->Range(64, 4<<10)->Unit(benchmark::kMicrosecond);
+BENCHMARK_CAPTURE(BM_snapshot_restore, binary, KvsStorageFormat::Binary)->Range(64, 4<<10)->Unit(benchmark::kMicrosecond);
+
+static void BM_mixed_contention(benchmark::State& state, KvsLockMode mode) {
+    // Concurrent readers and writers on one shared KVS, the argument is the percentage of writes per thread
+    Kvs& kvs = bm_shared_kvs(mode);
+    const std::vector<std::string>& keys = bm_keys();
+    const size_t write_percent = static_cast<size_t>(state.range(0));
+    size_t idx = static_cast<size_t>(state.thread_index()) * 37U;
+    int64_t failures = 0;
+    for (auto _ : state) {
+        const size_t key = idx % bm_key_count;
+        if ((idx % 100U) < write_percent) {
+            /* Writes store the value the key already has, the other benchmarks on the shared KVS stay valid */
+            if (!kvs.set_value(keys[key], KvsValue(static_cast<int32_t>(key)))) {
+                ++failures;
+            }
+        }else{
+            auto res = kvs.get_value(keys[key]);
+            if (!res) {
+                ++failures;
+            }
+            benchmark::DoNotOptimize(res);
+        }
+        ++idx;
+    }
+    state.SetItemsProcessed(int64_t(state.iterations()));
+    state.counters["lock_failures"] = benchmark::Counter(static_cast<double>(failures), benchmark::Counter::kAvgThreads);
+}
+
+// Throughput from 1 to 16 threads with 0 %, 10 % and 50 % writes for both lock modes
+BENCHMARK_CAPTURE(BM_mixed_contention, trylock, KvsLockMode::TryLock)->Arg(0)->Arg(10)->Arg(50)->ThreadRange(1, 16)->UseRealTime();
+BENCHMARK_CAPTURE(BM_mixed_contention, blocking, KvsLockMode::Blocking)->Arg(0)->Arg(10)->Arg(50)->ThreadRange(1, 16)->UseRealTime();
+
+static void BM_get_value_handle(benchmark::State& state, bool handle) {
+    // Repeated reads and writes of a few hot keys by the key vs. through a KeyHandle resolved once
+    const size_t key_count = static_cast<size_t>(state.range(0));
+    auto open_res = open_bm_sized_kvs(BmShape::Scalar, key_count);
+    if (!open_res) {
+        state.SkipWithError("open failed");
+        return;
+    }
+    Kvs& kvs = open_res.value();
+    std::vector<std::string> keys;
+    std::vector<KeyHandle> handles;
+    for (size_t idx = 0; idx < 8; ++idx) {
+        keys.push_back("sized_key_" + std::to_string((idx * 7919U) % key_count));
+        handles.push_back(kvs.resolve(keys.back()));
+    }
+    const KvsValue value(static_cast<int32_t>(1));
+    size_t idx = 0;
+    for (auto _ : state) {
+        if (handle) {
+            benchmark::DoNotOptimize(kvs.get_value(handles[idx % 8]));
+            benchmark::DoNotOptimize(kvs.set_value(handles[idx % 8], value));
+        }else{
+            benchmark::DoNotOptimize(kvs.get_value(keys[idx % 8]));
+            benchmark::DoNotOptimize(kvs.set_value(keys[idx % 8], value));
+        }
+        ++idx;
+    }
+    state.SetItemsProcessed(int64_t(state.iterations()) * 2);
+}
+
+BENCHMARK_CAPTURE(BM_get_value_handle, key, false)->RangeMultiplier(8)->Range(64, 256<<10);
+BENCHMARK_CAPTURE(BM_get_value_handle, handle, true)->RangeMultiplier(8)->Range(64, 256<<10);
+
+static void BM_read_default_handle(benchmark::State& state, bool handle) {
+    // get_value and is_value_default of keys that only have a default: both maps by key vs. the entries of a KeyHandle
+    constexpr size_t instance = 490;
+    constexpr size_t key_count = 4096;
+    write_bm_defaults(instance, key_count);
+    auto open_res = open_bm_defaults_kvs(instance, false);
+    if (!open_res) {
+        state.SkipWithError("open failed");
+        return;
+    }
+    Kvs& kvs = open_res.value();
+    fill_bm_storage_kvs(kvs, key_count);
+    std::vector<std::string> keys;
+    std::vector<KeyHandle> handles;
+    for (size_t idx = 0; idx < 8; ++idx) {
+        keys.push_back("default_key_" + std::to_string((idx * 7919U) % key_count));
+        handles.push_back(kvs.resolve(keys.back()));
+    }
+    size_t idx = 0;
+    for (auto _ : state) {
+        if (handle) {
+            benchmark::DoNotOptimize(kvs.get_value(handles[idx % 8]));
+            benchmark::DoNotOptimize(kvs.is_value_default(handles[idx % 8]));
+        }else{
+            benchmark::DoNotOptimize(kvs.get_value(keys[idx % 8]));
+            benchmark::DoNotOptimize(kvs.is_value_default(keys[idx % 8]));
+        }
+        ++idx;
+    }
+    state.SetItemsProcessed(int64_t(state.iterations()) * 2);
+}
+
+BENCHMARK_CAPTURE(BM_read_default_handle, key, false);
+BENCHMARK_CAPTURE(BM_read_default_handle, handle, true);
+
+/* Open the KVS of the compressed flush and open benchmarks (one instance per storage format) */
+static score::Result<Kvs> open_bm_compressed_kvs(KvsStorageFormat format, KvsCompression compression, bool need_kvs) {
+    const size_t instance = (KvsStorageFormat::Json == format) ? 500 : 501;
+    return KvsBuilder(InstanceId(instance)).dir("./bm_data/").need_kvs_flag(need_kvs)
+               .storage_format(format).compression(compression).build();
+}
+
+static void BM_flush_compressed(benchmark::State& state, KvsStorageFormat format) {
+    // Flush latency with KvsCompression::Lz4 (compare with BM_flush), file_bytes is the size of the compressed file
+    auto open_res = open_bm_compressed_kvs(format, KvsCompression::Lz4, false);
+    if (!open_res) {
+        state.SkipWithError("open failed");
+        return;
+    }
+    Kvs& kvs = open_res.value();
+    kvs.kvs.clear();
+    kvs.rebuild_slots();
+    fill_bm_storage_kvs(kvs, static_cast<size_t>(state.range(0)));
+    for (auto _ : state) {
+        if (!kvs.flush()) {
+            state.SkipWithError("flush failed");
+            break;
+        }
+    }
+    state.SetItemsProcessed(int64_t(state.iterations()) * state.range(0));
+    auto file_res = kvs.get_kvs_filename(0);
+    if (file_res) {
+        state.counters["file_bytes"] = static_cast<double>(std::filesystem::file_size(file_res.value().Native()));
+    }
+}
+
+static void BM_open_compressed(benchmark::State& state, KvsStorageFormat format) {
+    // Open latency of a compressed KVS file (read, hash check, decompression and parsing, compare with BM_open)
+    {
+        auto open_res = open_bm_compressed_kvs(format, KvsCompression::Lz4, false);
+        if (!open_res) {
+            state.SkipWithError("open failed");
+            return;
+        }
+        open_res.value().kvs.clear();
+        open_res.value().rebuild_slots();
+        fill_bm_storage_kvs(open_res.value(), static_cast<size_t>(state.range(0)));
+        (void)open_res.value().flush();
+    }
+    for (auto _ : state) {
+        auto open_res = open_bm_compressed_kvs(format, KvsCompression::None, true);
+        if (!open_res) {
+            state.SkipWithError("open failed");
+            break;
+        }
+        benchmark::DoNotOptimize(open_res);
+    }
+    state.SetItemsProcessed(int64_t(state.iterations()) * state.range(0));
+}
+
+BENCHMARK_CAPTURE(BM_flush_compressed, json, KvsStorageFormat::Json)->Range(64, 4<<10)->Unit(benchmark::kMicrosecond);
+BENCHMARK_CAPTURE(BM_flush_compressed, binary, KvsStorageFormat::Binary)->Range(64, 4<<10)->Unit(benchmark::kMicrosecond);
+BENCHMARK_CAPTURE(BM_open_compressed, json, KvsStorageFormat::Json)->Range(64, 4<<10)->Unit(benchmark::kMicrosecond);
+BENCHMARK_CAPTURE(BM_open_compressed, binary, KvsStorageFormat::Binary)->Range(64, 4<<10)->Unit(benchmark::kMicrosecond);
+
 BENCHMARK_MAIN();
@@ -28,6 +28,7 @@ TEST(kvs_constructor, move_constructor) {
     /* Create Test Data*/
     kvs_b.kvs.insert({ "test_kvs", KvsValue(42.0) });
     kvs_b.default_values.insert({ "test_default", KvsValue(true) });
+    kvs_b.rebuild_slots();
 
     /* Move assignment operator */
     kvs_a = std::move(kvs_b);
@@ -264,7 +265,7 @@ TEST(kvs_reset, reset_failure){
     auto result = Kvs::open(instance_id, OpenNeedDefaults::Required, OpenNeedKvs::Required, std::string(data_dir));
     ASSERT_TRUE(result);
 
-    std::unique_lock<std::mutex> lock(result.value().kvs_mutex);
+    std::unique_lock<std::shared_mutex> lock(result.value().kvs_mutex);
     auto reset_result = result.value().reset();
     EXPECT_FALSE(reset_result);
     EXPECT_EQ(static_cast<ErrorCode>(*reset_result.error()), ErrorCode::MutexLockFailed);
@@ -292,6 +293,7 @@ TEST(kvs_get_all_keys, get_all_keys_success){
 
     /* Check if empty keys are returned */
     result.value().kvs.clear();
+    result.value().rebuild_slots();
     get_all_keys_result = result.value().get_all_keys();
     EXPECT_TRUE(get_all_keys_result.value().empty());
 
@@ -305,7 +307,7 @@ TEST(kvs_get_all_keys, get_all_keys_failure){
     /* Mutex locked */
     auto result = Kvs::open(instance_id, OpenNeedDefaults::Required, OpenNeedKvs::Required, std::string(data_dir));
     ASSERT_TRUE(result);
-    std::unique_lock<std::mutex> lock(result.value().kvs_mutex);
+    std::unique_lock<std::shared_mutex> lock(result.value().kvs_mutex);
 
     auto get_all_keys_result = result.value().get_all_keys();
     EXPECT_FALSE(get_all_keys_result);
@@ -332,6 +334,11 @@ TEST(kvs_key_exists, key_exists_success){
     exists_result = result.value().key_exists("non_existing_key");
     EXPECT_TRUE(exists_result);
     EXPECT_FALSE(exists_result.value());
+    /* Check lookup with a std::string_view which is not null-terminated */
+    const std::string_view key_view = std::string_view("kvs_not_a_key").substr(0, 3);
+    exists_result = result.value().key_exists(key_view);
+    EXPECT_TRUE(exists_result);
+    EXPECT_TRUE(exists_result.value());
 
     cleanup_environment();
 }
@@ -344,7 +351,7 @@ TEST(kvs_key_exists, key_exists_failure){
     auto result = Kvs::open(instance_id, OpenNeedDefaults::Required, OpenNeedKvs::Required, std::string(data_dir));
     ASSERT_TRUE(result);
 
-    std::unique_lock<std::mutex> lock(result.value().kvs_mutex);
+    std::unique_lock<std::shared_mutex> lock(result.value().kvs_mutex);
     auto exists_result = result.value().key_exists("kvs");
     EXPECT_FALSE(exists_result);
     EXPECT_EQ(static_cast<ErrorCode>(*exists_result.error()), ErrorCode::MutexLockFailed);
@@ -376,6 +383,7 @@ TEST(kvs_get_value, get_value_success){
         "kvs",
         KvsValue(default_value)
     );
+    result.value().rebuild_slots();
     get_value_result = result.value().get_value("kvs");
     ASSERT_TRUE(get_value_result);
     EXPECT_EQ(get_value_result.value().getType(), KvsValue::Type::i32);
@@ -399,7 +407,7 @@ TEST(kvs_get_value, get_value_failure){
     /* Mutex locked */
     result = Kvs::open(instance_id, OpenNeedDefaults::Required, OpenNeedKvs::Required, std::string(data_dir));
     ASSERT_TRUE(result);
-    std::unique_lock<std::mutex> lock(result.value().kvs_mutex);
+    std::unique_lock<std::shared_mutex> lock(result.value().kvs_mutex);
     get_value_result = result.value().get_value("kvs");
     EXPECT_FALSE(get_value_result);
     EXPECT_EQ(static_cast<ErrorCode>(*get_value_result.error()), ErrorCode::MutexLockFailed);
@@ -407,6 +415,197 @@ TEST(kvs_get_value, get_value_failure){
     cleanup_environment();
 }
 
+TEST(kvs_visit_value, visit_value_success){
+
+    prepare_environment();
+
+    auto result = Kvs::open(instance_id, OpenNeedDefaults::Required, OpenNeedKvs::Required, std::string(data_dir));
+    ASSERT_TRUE(result);
+
+    /* Check if the stored value is visited (no copy) */
+    const KvsValue* visited = nullptr;
+    auto visit_result = result.value().visit_value("kvs", [&visited](const KvsValue& value) {
+        visited = &value;
+    });
+    ASSERT_TRUE(visit_result);
+    EXPECT_EQ(visited, &result.value().kvs.at("kvs"));
+
+    /* Check if the default value is visited when no written key exists */
+    visited = nullptr;
+    visit_result = result.value().visit_value("default", [&visited](const KvsValue& value) {
+        visited = &value;
+    });
+    ASSERT_TRUE(visit_result);
+    EXPECT_EQ(visited, &result.value().default_values.at("default"));
+
+    cleanup_environment();
+}
+
+TEST(kvs_visit_value, visit_value_failure){
+
+    prepare_environment();
+
+    auto result = Kvs::open(instance_id, OpenNeedDefaults::Required, OpenNeedKvs::Required, std::string(data_dir));
+    ASSERT_TRUE(result);
+
+    /* Check if non-existing key returns error and the visitor is not called */
+    bool called = false;
+    auto visit_result = result.value().visit_value("non_existing_key", [&called](const KvsValue&) {
+        called = true;
+    });
+    EXPECT_FALSE(visit_result);
+    EXPECT_EQ(visit_result.error(), ErrorCode::KeyNotFound);
+    EXPECT_FALSE(called);
+
+    /* Mutex locked */
+    std::unique_lock<std::shared_mutex> lock(result.value().kvs_mutex);
+    visit_result = result.value().visit_value("kvs", [&called](const KvsValue&) {
+        called = true;
+    });
+    EXPECT_FALSE(visit_result);
+    EXPECT_EQ(static_cast<ErrorCode>(*visit_result.error()), ErrorCode::MutexLockFailed);
+    EXPECT_FALSE(called);
+
+    cleanup_environment();
+}
+
+TEST(kvs_get_values, get_values){
+
+    prepare_environment();
+
+    auto result = Kvs::open(instance_id, OpenNeedDefaults::Required, OpenNeedKvs::Required, std::string(data_dir));
+    ASSERT_TRUE(result);
+    result.value().kvs.clear();
+    result.value().rebuild_slots();
+    ASSERT_TRUE(result.value().set_value("written", KvsValue(1)));
+    result.value().default_values.insert_or_assign("defaulted", KvsValue(42));
+    result.value().rebuild_slots();
+
+    /* Written value, default value and a missing key in the order of the keys */
+    auto get_values_result = result.value().get_values({"defaulted", "non_existing_key", "written"});
+    ASSERT_TRUE(get_values_result);
+    ASSERT_EQ(get_values_result.value().size(), 3U);
+    ASSERT_TRUE(get_values_result.value()[0]);
+    EXPECT_EQ(std::get<int32_t>(get_values_result.value()[0].value().getValue()), 42);
+    ASSERT_FALSE(get_values_result.value()[1]);
+    EXPECT_EQ(get_values_result.value()[1].error(), ErrorCode::KeyNotFound);
+    ASSERT_TRUE(get_values_result.value()[2]);
+    EXPECT_EQ(std::get<int32_t>(get_values_result.value()[2].value().getValue()), 1);
+
+    get_values_result = result.value().get_values({});
+    ASSERT_TRUE(get_values_result);
+    EXPECT_TRUE(get_values_result.value().empty());
+
+    /* Mutex locked */
+    std::unique_lock<std::shared_mutex> lock(result.value().kvs_mutex);
+    get_values_result = result.value().get_values({"written"});
+    EXPECT_FALSE(get_values_result);
+    EXPECT_EQ(static_cast<ErrorCode>(*get_values_result.error()), ErrorCode::MutexLockFailed);
+
+    cleanup_environment();
+}
+
+TEST(kvs_scan_prefix, scan_prefix){
+
+    prepare_environment();
+
+    auto result = Kvs::open(instance_id, OpenNeedDefaults::Required, OpenNeedKvs::Required, std::string(data_dir));
+    ASSERT_TRUE(result);
+    result.value().kvs.clear();
+    result.value().rebuild_slots();
+    for (const char* key : {"camera.rear.exposure", "camera.front.gain", "camera.front", "camera.front.exposure",
+                            "camera.frontal", "audio.volume"}) {
+        ASSERT_TRUE(result.value().set_value(key, KvsValue(std::string(key))));
+    }
+    result.value().default_values.insert_or_assign("camera.front.default", KvsValue(42)); /* Not visited */
+    result.value().rebuild_slots();
+
+    /* Matching keys are visited in key order */
+    std::vector<std::string> keys;
+    auto scan_result = result.value().scan_prefix("camera.front.", [&keys](const std::string& key, const KvsValue& value) {
+        EXPECT_EQ(std::get<std::string>(value.getValue()), key);
+        keys.push_back(key);
+    });
+    ASSERT_TRUE(scan_result);
+    EXPECT_EQ(keys, (std::vector<std::string>{"camera.front.exposure", "camera.front.gain"}));
+
+    keys.clear();
+    ASSERT_TRUE(result.value().scan_prefix("camera.front", [&keys](const std::string& key, const KvsValue&) {
+        keys.push_back(key);
+    }));
+    EXPECT_EQ(keys, (std::vector<std::string>{"camera.front", "camera.front.exposure", "camera.front.gain", "camera.frontal"}));
+
+    /* Empty prefix visits all keys, no match visits none */
+    size_t count = 0;
+    ASSERT_TRUE(result.value().scan_prefix("", [&count](const std::string&, const KvsValue&) { ++count; }));
+    EXPECT_EQ(count, 6U);
+    count = 0;
+    ASSERT_TRUE(result.value().scan_prefix("zzz", [&count](const std::string&, const KvsValue&) { ++count; }));
+    EXPECT_EQ(count, 0U);
+
+    /* Mutex locked */
+    std::unique_lock<std::shared_mutex> lock(result.value().kvs_mutex);
+    scan_result = result.value().scan_prefix("camera.", [&count](const std::string&, const KvsValue&) { ++count; });
+    EXPECT_FALSE(scan_result);
+    EXPECT_EQ(static_cast<ErrorCode>(*scan_result.error()), ErrorCode::MutexLockFailed);
+    EXPECT_EQ(count, 0U);
+
+    cleanup_environment();
+}
+
+TEST(kvs_get_value_as, get_value_as_success){
+
+    prepare_environment();
+
+    auto result = Kvs::open(instance_id, OpenNeedDefaults::Required, OpenNeedKvs::Required, std::string(data_dir));
+    ASSERT_TRUE(result);
+
+    /* Stored value */
+    auto get_i32_result = result.value().get_value_as<int32_t>("kvs");
+    ASSERT_TRUE(get_i32_result);
+    EXPECT_EQ(get_i32_result.value(), 2);
+
+    /* Default value */
+    get_i32_result = result.value().get_value_as<int32_t>("default");
+    ASSERT_TRUE(get_i32_result);
+    EXPECT_EQ(get_i32_result.value(), 5);
+
+    /* String value */
+    result.value().kvs.insert_or_assign("string", KvsValue("text"));
+    result.value().rebuild_slots();
+    auto get_string_result = result.value().get_value_as<std::string>("string");
+    ASSERT_TRUE(get_string_result);
+    EXPECT_EQ(get_string_result.value(), "text");
+
+    cleanup_environment();
+}
+
+TEST(kvs_get_value_as, get_value_as_failure){
+
+    prepare_environment();
+
+    auto result = Kvs::open(instance_id, OpenNeedDefaults::Required, OpenNeedKvs::Required, std::string(data_dir));
+    ASSERT_TRUE(result);
+
+    /* Wrong type */
+    auto get_result = result.value().get_value_as<double>("kvs");
+    EXPECT_FALSE(get_result);
+    EXPECT_EQ(get_result.error(), ErrorCode::ConversionFailed);
+
+    /* Non-existing key */
+    get_result = result.value().get_value_as<double>("non_existing_key");
+    EXPECT_FALSE(get_result);
+    EXPECT_EQ(get_result.error(), ErrorCode::KeyNotFound);
+
+    /* Mutex locked */
+    std::unique_lock<std::shared_mutex> lock(result.value().kvs_mutex);
+    auto get_i32_result = result.value().get_value_as<int32_t>("kvs");
+    EXPECT_FALSE(get_i32_result);
+    EXPECT_EQ(static_cast<ErrorCode>(*get_i32_result.error()), ErrorCode::MutexLockFailed);
+
+    cleanup_environment();
+}
+
 TEST(kvs_get_default_value, get_default_value_success){
 
     prepare_environment();
@@ -420,6 +619,7 @@ TEST(kvs_get_default_value, get_default_value_success){
         "kvs",
         KvsValue(default_value)
     );
+    result.value().rebuild_slots();
 
     /* Check if default value is returned */
     auto get_def_value_result = result.value().get_default_value("kvs");
@@ -457,6 +657,7 @@ TEST(kvs_reset_key, reset_key_success){
         "kvs",
         KvsValue(42.0)
     );
+    result.value().rebuild_slots();
     /* Reset a key */
     auto reset_key_result = result.value().reset_key("kvs");
     EXPECT_TRUE(reset_key_result);
@@ -468,6 +669,7 @@ TEST(kvs_reset_key, reset_key_success){
         "default",
         KvsValue(42.0)
     );
+    result.value().rebuild_slots();
     reset_key_result = result.value().reset_key("default");
     EXPECT_TRUE(reset_key_result);
 
@@ -490,6 +692,7 @@ TEST(kvs_reset_key, reset_key_failure){
     result = Kvs::open(instance_id, OpenNeedDefaults::Required, OpenNeedKvs::Required, std::string(data_dir));
     ASSERT_TRUE(result);
     result.value().default_values.clear(); // Clear default values to ensure no default value exists for "kvs"
+    result.value().rebuild_slots();
     reset_key_result = result.value().reset_key("kvs");
     EXPECT_FALSE(reset_key_result);
     EXPECT_EQ(reset_key_result.error(), ErrorCode::KeyDefaultNotFound);
@@ -497,7 +700,7 @@ TEST(kvs_reset_key, reset_key_failure){
     /* Mutex locked */
     result = Kvs::open(instance_id, OpenNeedDefaults::Required, OpenNeedKvs::Required, std::string(data_dir));
     ASSERT_TRUE(result);
-    std::unique_lock<std::mutex> lock(result.value().kvs_mutex);
+    std::unique_lock<std::shared_mutex> lock(result.value().kvs_mutex);
     reset_key_result = result.value().reset_key("kvs");
     EXPECT_FALSE(reset_key_result);
     EXPECT_EQ(static_cast<ErrorCode>(*reset_key_result.error()), ErrorCode::MutexLockFailed);
@@ -517,6 +720,7 @@ TEST(kvs_has_default_value, has_default_value){
         "default",
         KvsValue(42.0)
     );
+    result.value().rebuild_slots();
 
     /* Check if default value exists */
     auto has_default_result = result.value().has_default_value("default");
@@ -561,11 +765,73 @@ TEST(kvs_set_value, set_value_failure){
     auto result = Kvs::open(instance_id, OpenNeedDefaults::Required, OpenNeedKvs::Required, std::string(data_dir));
     ASSERT_TRUE(result);
 
-    std::unique_lock<std::mutex> lock(result.value().kvs_mutex);
+    std::unique_lock<std::shared_mutex> lock(result.value().kvs_mutex);
     auto set_value_result = result.value().set_value("new_key", KvsValue(3.0));
     EXPECT_FALSE(set_value_result);
     EXPECT_EQ(static_cast<ErrorCode>(*set_value_result.error()), ErrorCode::MutexLockFailed);
 
+    /* Moved key and value are left unchanged */
+    std::string key = "moved_key";
+    KvsValue value(std::string("moved_value"));
+    set_value_result = result.value().set_value(std::move(key), std::move(value));
+    EXPECT_EQ(static_cast<ErrorCode>(*set_value_result.error()), ErrorCode::MutexLockFailed);
+    EXPECT_EQ(key, "moved_key");
+    EXPECT_EQ(std::get<std::string>(value.getValue()), "moved_value");
+
+    set_value_result = result.value().emplace_value("new_key", 3.0);
+    EXPECT_FALSE(set_value_result);
+    EXPECT_EQ(static_cast<ErrorCode>(*set_value_result.error()), ErrorCode::MutexLockFailed);
+
+    cleanup_environment();
+}
+
+TEST(kvs_set_value, set_value_move){
+
+    prepare_environment();
+    KvsOptions options;
+    options.flush_mode = KvsFlushMode::Incremental;
+    auto result = Kvs::open(instance_id, OpenNeedDefaults::Required, OpenNeedKvs::Required, std::string(data_dir), options);
+    ASSERT_TRUE(result);
+
+    /* New key: the Array elements are moved into the map */
+    KvsValue::Array array = {std::make_shared<KvsValue>(1), std::make_shared<KvsValue>(2)};
+    KvsValue value(std::move(array));
+    const std::shared_ptr<const KvsValue>* elements = value.getArray().data();
+    std::string key = "moved_key";
+    ASSERT_TRUE(result.value().set_value(std::move(key), std::move(value)));
+    EXPECT_EQ(result.value().kvs.at("moved_key").getArray().data(), elements);
+    EXPECT_TRUE(result.value().dirty_keys.count("moved_key"));
+
+    /* Existing key */
+    ASSERT_TRUE(result.value().set_value(std::string("kvs"), KvsValue(std::string("moved_value"))));
+    EXPECT_EQ(std::get<std::string>(result.value().kvs.at("kvs").getValue()), "moved_value");
+    EXPECT_TRUE(result.value().dirty_keys.count("kvs"));
+
+    cleanup_environment();
+}
+
+TEST(kvs_set_value, emplace_value){
+
+    prepare_environment();
+    KvsOptions options;
+    options.flush_mode = KvsFlushMode::Incremental;
+    auto result = Kvs::open(instance_id, OpenNeedDefaults::Required, OpenNeedKvs::Required, std::string(data_dir), options);
+    ASSERT_TRUE(result);
+
+    /* New key: the value is constructed in the map from the moved Array */
+    KvsValue::Array array = {std::make_shared<KvsValue>(1), std::make_shared<KvsValue>(2)};
+    const std::shared_ptr<const KvsValue>* elements = array.data();
+    ASSERT_TRUE(result.value().emplace_value("emplaced_key", std::move(array)));
+    EXPECT_EQ(result.value().kvs.at("emplaced_key").getType(), KvsValue::Type::Array);
+    EXPECT_EQ(result.value().kvs.at("emplaced_key").getArray().data(), elements);
+    EXPECT_TRUE(result.value().dirty_keys.count("emplaced_key"));
+
+    /* Existing key */
+    ASSERT_TRUE(result.value().emplace_value("kvs", static_cast<int32_t>(7)));
+    EXPECT_EQ(result.value().kvs.at("kvs").getType(), KvsValue::Type::i32);
+    EXPECT_EQ(std::get<int32_t>(result.value().kvs.at("kvs").getValue()), 7);
+    EXPECT_TRUE(result.value().dirty_keys.count("kvs"));
+
     cleanup_environment();
 }
 
@@ -601,7 +867,7 @@ TEST(kvs_remove_key, remove_key_failure){
     /* Mutex locked */
     result = Kvs::open(instance_id, OpenNeedDefaults::Required, OpenNeedKvs::Required, std::string(data_dir));
     ASSERT_TRUE(result);
-    std::unique_lock<std::mutex> lock(result.value().kvs_mutex);
+    std::unique_lock<std::shared_mutex> lock(result.value().kvs_mutex);
     remove_key_result = result.value().remove_key("kvs");
     EXPECT_FALSE(remove_key_result);
     EXPECT_EQ(static_cast<ErrorCode>(*remove_key_result.error()), ErrorCode::MutexLockFailed);
@@ -609,6 +875,81 @@ TEST(kvs_remove_key, remove_key_failure){
     cleanup_environment();
 }
 
+TEST(kvs_write_batch, write_success){
+
+    prepare_environment();
+    KvsOptions options;
+    options.flush_mode = KvsFlushMode::Incremental;
+    auto result = Kvs::open(instance_id, OpenNeedDefaults::Required, OpenNeedKvs::Required, std::string(data_dir), options);
+    ASSERT_TRUE(result);
+    ASSERT_TRUE(result.value().kvs.count("kvs"));
+
+    /* Collect the changes, the KVS is not touched before write() */
+    KvsWriteBatch batch;
+    EXPECT_TRUE(batch.empty());
+    batch.set_value("new_key", KvsValue(3.14));
+    std::string key = "moved_key";
+    KvsValue::Array array = {std::make_shared<KvsValue>(1), std::make_shared<KvsValue>(2)};
+    KvsValue value(std::move(array));
+    const std::shared_ptr<const KvsValue>* elements = value.getArray().data();
+    batch.set_value(std::move(key), std::move(value));
+    batch.remove_key("kvs");
+    batch.remove_key("non_existing_key"); /* Ignored, the batch is still applied */
+    batch.set_value("new_key", KvsValue(2.718)); /* Overrides the first change of the key */
+    EXPECT_EQ(batch.size(), 5U);
+    EXPECT_FALSE(result.value().kvs.count("new_key"));
+
+    ASSERT_TRUE(result.value().write(std::move(batch)));
+    EXPECT_TRUE(batch.empty());
+    EXPECT_DOUBLE_EQ(std::get<double>(result.value().kvs.at("new_key").getValue()), 2.718);
+    EXPECT_FALSE(result.value().kvs.count("kvs"));
+    /* The value is moved through the batch, the Array elements are not copied */
+    EXPECT_EQ(result.value().kvs.at("moved_key").getArray().data(), elements);
+    EXPECT_EQ(result.value().dirty_keys, (std::set<std::string, std::less<>>{"kvs", "moved_key", "new_key"}));
+
+    /* Apply and flush */
+    batch.set_value("flushed_key", KvsValue(true));
+    ASSERT_TRUE(result.value().write(std::move(batch), true));
+    EXPECT_TRUE(result.value().dirty_keys.empty());
+    result = Kvs::open(instance_id, OpenNeedDefaults::Required, OpenNeedKvs::Required, std::string(data_dir), options);
+    ASSERT_TRUE(result);
+    EXPECT_TRUE(result.value().kvs.count("flushed_key"));
+    EXPECT_TRUE(result.value().kvs.count("moved_key"));
+    EXPECT_FALSE(result.value().kvs.count("kvs"));
+
+    cleanup_environment();
+}
+
+TEST(kvs_write_batch, write_failure_mutex){
+
+    prepare_environment();
+    auto result = Kvs::open(instance_id, OpenNeedDefaults::Required, OpenNeedKvs::Required, std::string(data_dir));
+    ASSERT_TRUE(result);
+
+    /* Mutex locked: nothing is applied and the batch can be retried */
+    KvsWriteBatch batch;
+    batch.set_value("new_key", KvsValue(3.0));
+    batch.remove_key("kvs");
+    {
+        std::unique_lock<std::shared_mutex> lock(result.value().kvs_mutex);
+        auto write_result = result.value().write(std::move(batch));
+        EXPECT_FALSE(write_result);
+        EXPECT_EQ(static_cast<ErrorCode>(*write_result.error()), ErrorCode::MutexLockFailed);
+    }
+    EXPECT_EQ(batch.size(), 2U);
+    EXPECT_FALSE(result.value().kvs.count("new_key"));
+    EXPECT_TRUE(result.value().kvs.count("kvs"));
+
+    ASSERT_TRUE(result.value().write(std::move(batch)));
+    EXPECT_TRUE(result.value().kvs.count("new_key"));
+    EXPECT_FALSE(result.value().kvs.count("kvs"));
+
+    batch.clear();
+    EXPECT_TRUE(batch.empty());
+
+    cleanup_environment();
+}
+
 TEST(kvs_write_json_data, write_json_data_success){
 
     prepare_environment();
@@ -668,7 +1009,7 @@ TEST(kvs_write_json_data, write_json_data_filesystem_failure){
     ASSERT_NE(standard_mock, nullptr);
     EXPECT_CALL(*standard_mock, CreateDirectories(::testing::_))
         .WillOnce(::testing::Return(score::ResultBlank(score::MakeUnexpected(score::filesystem::ErrorCode::kCouldNotCreateDirectory))));
-    kvs.value().filesystem = std::make_unique<score::filesystem::Filesystem>(std::move(mock_filesystem));
+    kvs.value().backend = std::make_shared<KvsFileBackend>(std::make_unique<score::filesystem::Filesystem>(std::move(mock_filesystem)));
 
     auto result = kvs->write_json_data(kvs_json);
     EXPECT_FALSE(result);
@@ -736,11 +1077,11 @@ TEST(kvs_snapshot_rotate, snapshot_rotate_success){
     auto rotate_result = result.value().snapshot_rotate();
     ASSERT_TRUE(rotate_result);
 
-    /* Check if the snapshot ids are rotated and no ID 0 exists */
+    /* Check if the snapshot ids are rotated, ID 0 stays (linked into ID 1) until the flush replaces it */
     EXPECT_TRUE(std::filesystem::exists(filename_prefix + "_" + std::to_string(KVS_MAX_SNAPSHOTS) + ".json"));
     EXPECT_TRUE(std::filesystem::exists(filename_prefix + "_" + std::to_string(KVS_MAX_SNAPSHOTS) + ".hash"));
-    EXPECT_FALSE(std::filesystem::exists(filename_prefix + "_" + std::to_string(0) + ".json"));
-    EXPECT_FALSE(std::filesystem::exists(filename_prefix + "_" + std::to_string(0) + ".hash"));
+    EXPECT_TRUE(std::filesystem::exists(filename_prefix + "_" + std::to_string(0) + ".json"));
+    EXPECT_TRUE(std::filesystem::exists(filename_prefix + "_" + std::to_string(0) + ".hash"));
 
     cleanup_environment();
 }
@@ -824,7 +1165,7 @@ TEST(kvs_snapshot_rotate, snapshot_rotate_failure_mutex){
     ASSERT_TRUE(result);
 
     /* Mutex locked */
-    std::unique_lock<std::mutex> lock(result.value().kvs_mutex);
+    std::unique_lock<std::shared_mutex> lock(result.value().kvs_mutex);
     auto rotate_result = result.value().snapshot_rotate();
     EXPECT_FALSE(rotate_result);
     EXPECT_EQ(static_cast<ErrorCode>(*rotate_result.error()), ErrorCode::MutexLockFailed);
@@ -845,6 +1186,7 @@ TEST(kvs_flush, flush_success_data){
     result.value().kvs.clear(); /* Clear KVS to ensure no data is written */
     std::string value = "value1";
     result.value().kvs.insert({"key1", KvsValue(value)});
+    result.value().rebuild_slots();
     auto flush_result = result.value().flush();
     ASSERT_TRUE(flush_result);
 
@@ -888,7 +1230,7 @@ TEST(kvs_flush, flush_failure_mutex){
     auto result = Kvs::open(instance_id, OpenNeedDefaults::Optional, OpenNeedKvs::Optional, std::string(data_dir));
     ASSERT_TRUE(result);
 
-    std::unique_lock<std::mutex> lock(result.value().kvs_mutex);
+    std::unique_lock<std::shared_mutex> lock(result.value().kvs_mutex);
     auto flush_result = result.value().flush();
     EXPECT_FALSE(flush_result);
     EXPECT_EQ(static_cast<ErrorCode>(*flush_result.error()), ErrorCode::MutexLockFailed);
@@ -896,6 +1238,65 @@ TEST(kvs_flush, flush_failure_mutex){
     cleanup_environment();
 }
 
+/* Memory backend that calls a hook when a file is opened for writing (e.g. to change the KVS during a flush) */
+class WriteHookBackend final : public KvsBackend {
+public:
+    std::function<void(const std::string&)> on_open_write;
+
+    score::Result<bool> exists(const std::string& path) override { return files.exists(path); }
+    bool size(const std::string& path, size_t& size) override { return files.size(path, size); }
+    std::unique_ptr<std::istream> open_read(const std::string& path) override { return files.open_read(path); }
+    std::unique_ptr<std::ostream> open_write(const std::string& path) override {
+        if (on_open_write) {
+            on_open_write(path);
+        }
+        return files.open_write(path);
+    }
+    bool write(const std::string& path, std::string_view content, bool sync) override { return files.write(path, content, sync); }
+    bool append(const std::string& path, std::string_view content) override { return files.append(path, content); }
+    bool truncate(const std::string& path, size_t size) override { return files.truncate(path, size); }
+    score::ResultBlank rename(const std::string& from, const std::string& to) override { return files.rename(from, to); }
+    score::ResultBlank link(const std::string& from, const std::string& to) override { return files.link(from, to); }
+    score::ResultBlank remove(const std::string& path) override { return files.remove(path); }
+    bool sync(const std::string& path) override { return files.sync(path); }
+    bool sync_dir(const std::string& path) override { return files.sync_dir(path); }
+    bool create_directories(const std::string& dir) override { return files.create_directories(dir); }
+    bool maps_files() const override { return files.maps_files(); }
+
+private:
+    KvsMemoryBackend files;
+};
+
+TEST(kvs_flush, flush_write_without_lock){
+
+    auto backend = std::make_shared<WriteHookBackend>();
+    KvsOptions options;
+    options.backend = backend;
+    auto result = Kvs::open(instance_id, OpenNeedDefaults::Optional, OpenNeedKvs::Optional, std::string(data_dir), options);
+    ASSERT_TRUE(result);
+    Kvs& kvs = result.value();
+    ASSERT_EQ(kvs.options.lock_mode, KvsLockMode::TryLock);
+    ASSERT_TRUE(kvs.set_value("key", KvsValue(1.0)));
+
+    /* The KVS lock is released before the file is written, writers don't fail with TryLock meanwhile */
+    std::vector<bool> written;
+    backend->on_open_write = [&](const std::string&) {
+        score::ResultBlank set_value_result = score::MakeUnexpected(ErrorCode::UnmappedError);
+        std::thread writer([&]() { set_value_result = kvs.set_value("key", KvsValue(2.0)); });
+        writer.join();
+        written.push_back(static_cast<bool>(set_value_result));
+    };
+    ASSERT_TRUE(kvs.flush());
+    backend->on_open_write = nullptr;
+    EXPECT_EQ(written, std::vector<bool>{true});
+
+    /* The flush wrote the data copied before the write */
+    auto reopened = Kvs::open(instance_id, OpenNeedDefaults::Optional, OpenNeedKvs::Required, std::string(data_dir), options);
+    ASSERT_TRUE(reopened);
+    EXPECT_DOUBLE_EQ(std::get<double>(reopened.value().kvs.at("key").getValue()), 1.0);
+    EXPECT_DOUBLE_EQ(std::get<double>(kvs.kvs.at("key").getValue()), 2.0);
+}
+
 TEST(kvs_flush, flush_failure_rotate_snapshots){
 
     prepare_environment();
@@ -923,6 +1324,7 @@ TEST(kvs_flush, flush_failure_kvsvalue_invalid){
 
     BrokenKvsValue invalid;
     result.value().kvs.insert({"invalid_key", invalid});
+    result.value().rebuild_slots();
 
     auto flush_result_invalid = result.value().flush();
     EXPECT_FALSE(flush_result_invalid);
@@ -931,21 +1333,21 @@ TEST(kvs_flush, flush_failure_kvsvalue_invalid){
     cleanup_environment();
 }
 
-TEST(kvs_flush, flush_failure_json_writer){
+TEST(kvs_flush, flush_failure_json_generator){
 
     prepare_environment();
 
     auto kvs = Kvs::open(instance_id, OpenNeedDefaults::Optional, OpenNeedKvs::Optional, std::string(data_dir));
     ASSERT_TRUE(kvs);
 
-    auto mock_writer = std::make_unique<score::json::IJsonWriterMock>(); /* Force error in writer.ToBuffer */
-    EXPECT_CALL(*mock_writer, ToBuffer(::testing::A<const score::json::Object&>()))
-        .WillOnce(::testing::Return(score::Result<std::string>(score::MakeUnexpected(score::json::Error::kUnknownError))));
-
-    kvs->writer = std::move(mock_writer);
+    /* NaN can't be written as JSON, the current KVS file and the snapshots stay untouched */
+    ASSERT_TRUE(kvs.value().set_value("nan", KvsValue(std::nan(""))));
     auto result = kvs.value().flush();
     EXPECT_FALSE(result);
     EXPECT_EQ(result.error(), ErrorCode::JsonGeneratorError);
+    EXPECT_TRUE(std::filesystem::exists(kvs_prefix + ".json"));
+    EXPECT_FALSE(std::filesystem::exists(kvs_prefix + ".json.tmp"));
+    EXPECT_EQ(kvs.value().snapshot_count().value(), 0);
 
     cleanup_environment();
 }
@@ -985,7 +1387,7 @@ TEST(kvs_snapshot_count, snapshot_count_invalid){
     ASSERT_NE(standard_mock, nullptr);
     EXPECT_CALL(*standard_mock, Exists(::testing::_))
         .WillOnce(::testing::Return(score::Result<bool>(score::MakeUnexpected(score::filesystem::ErrorCode::kCouldNotRetrieveStatus))));
-    kvs.value().filesystem = std::make_unique<score::filesystem::Filesystem>(std::move(mock_filesystem));
+    kvs.value().backend = std::make_shared<KvsFileBackend>(std::make_unique<score::filesystem::Filesystem>(std::move(mock_filesystem)));
 
     auto result = kvs.value().snapshot_count();
     EXPECT_FALSE(result);
@@ -1080,7 +1482,10 @@ TEST(kvs_snapshot_restore, snapshot_restore_failure_mutex){
     auto result = Kvs::open(instance_id, OpenNeedDefaults::Optional, OpenNeedKvs::Optional, std::string(data_dir));
     ASSERT_TRUE(result);
 
-    std::unique_lock<std::mutex> lock(result.value().kvs_mutex);
+    /* The snapshot is read without the lock, only swapping in the data fails */
+    std::filesystem::copy_file(kvs_prefix + ".json", filename_prefix + "_1.json");
+    std::filesystem::copy_file(kvs_prefix + ".hash", filename_prefix + "_1.hash");
+    std::unique_lock<std::shared_mutex> lock(result.value().kvs_mutex);
     auto restore_result = result.value().snapshot_restore(1);
     EXPECT_FALSE(restore_result);
     EXPECT_EQ(static_cast<ErrorCode>(*restore_result.error()), ErrorCode::MutexLockFailed);
@@ -1101,7 +1506,7 @@ TEST(kvs_snapshot_restore, snapshot_restore_failure_snapshot_count){
     ASSERT_NE(standard_mock, nullptr);
     EXPECT_CALL(*standard_mock, Exists(::testing::_))
         .WillOnce(::testing::Return(score::Result<bool>(score::MakeUnexpected(score::filesystem::ErrorCode::kCouldNotRetrieveStatus))));
-    kvs.value().filesystem = std::make_unique<score::filesystem::Filesystem>(std::move(mock_filesystem));
+    kvs.value().backend = std::make_shared<KvsFileBackend>(std::make_unique<score::filesystem::Filesystem>(std::move(mock_filesystem)));
 
     auto result = kvs.value().snapshot_restore(1);
     EXPECT_FALSE(result);
@@ -1160,7 +1565,7 @@ TEST(kvs_get_filename, get_kvs_filename_failure){
     ASSERT_NE(standard_mock, nullptr);
     EXPECT_CALL(*standard_mock, Exists(::testing::_))
         .WillOnce(::testing::Return(score::Result<bool>(score::MakeUnexpected(score::filesystem::ErrorCode::kCouldNotRetrieveStatus))));
-    kvs.value().filesystem = std::make_unique<score::filesystem::Filesystem>(std::move(mock_filesystem));
+    kvs.value().backend = std::make_shared<KvsFileBackend>(std::make_unique<score::filesystem::Filesystem>(std::move(mock_filesystem)));
 
     result = kvs.value().get_kvs_filename(SnapshotId(1));
     EXPECT_FALSE(result);
@@ -1209,10 +1614,2218 @@ TEST(kvs_get_filename, get_hashname_failure){
     ASSERT_NE(standard_mock, nullptr);
     EXPECT_CALL(*standard_mock, Exists(::testing::_))
         .WillOnce(::testing::Return(score::Result<bool>(score::MakeUnexpected(score::filesystem::ErrorCode::kCouldNotRetrieveStatus))));
-    kvs.value().filesystem = std::make_unique<score::filesystem::Filesystem>(std::move(mock_filesystem));
+    kvs.value().backend = std::make_shared<KvsFileBackend>(std::make_unique<score::filesystem::Filesystem>(std::move(mock_filesystem)));
 
     result = kvs.value().get_hash_filename(SnapshotId(1));
     EXPECT_FALSE(result);
 
     cleanup_environment();
 }
+
+TEST(kvs_lock_mode, lock_mode_trylock_shared_readers){
+
+    prepare_environment();
+
+    auto result = Kvs::open(instance_id, OpenNeedDefaults::Required, OpenNeedKvs::Required, std::string(data_dir));
+    ASSERT_TRUE(result);
+    ASSERT_EQ(result.value().options.lock_mode, KvsLockMode::TryLock);
+
+    /* Another reader holds the lock -> readers succeed, writers fail immediately */
+    std::shared_lock<std::shared_mutex> lock(result.value().kvs_mutex);
+    auto get_value_result = result.value().get_value("kvs");
+    EXPECT_TRUE(get_value_result);
+    auto exists_result = result.value().key_exists("kvs");
+    EXPECT_TRUE(exists_result);
+    auto set_value_result = result.value().set_value("kvs", KvsValue(1.0));
+    EXPECT_FALSE(set_value_result);
+    EXPECT_EQ(static_cast<ErrorCode>(*set_value_result.error()), ErrorCode::MutexLockFailed);
+
+    cleanup_environment();
+}
+
+TEST(kvs_lock_mode, lock_mode_blocking_writer_waits){
+
+    prepare_environment();
+
+    KvsOptions options;
+    options.lock_mode = KvsLockMode::Blocking;
+    auto result = Kvs::open(instance_id, OpenNeedDefaults::Required, OpenNeedKvs::Required, std::string(data_dir), options);
+    ASSERT_TRUE(result);
+    Kvs& kvs = result.value();
+
+    /* Writer has to wait until the lock is released instead of failing */
+    std::unique_lock<std::shared_mutex> lock(kvs.kvs_mutex);
+    std::atomic<bool> done{false};
+    score::ResultBlank set_value_result = score::MakeUnexpected(ErrorCode::UnmappedError);
+    std::thread writer([&]() {
+        set_value_result = kvs.set_value("blocking", KvsValue(42.0));
+        done = true;
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    EXPECT_FALSE(done);
+    lock.unlock();
+    writer.join();
+    EXPECT_TRUE(set_value_result);
+    EXPECT_TRUE(kvs.kvs.count("blocking"));
+
+    cleanup_environment();
+}
+
+TEST(kvs_lock_mode, lock_mode_blocking_parallel_access){
+
+    prepare_environment();
+
+    KvsOptions options;
+    options.lock_mode = KvsLockMode::Blocking;
+    auto result = Kvs::open(instance_id, OpenNeedDefaults::Required, OpenNeedKvs::Required, std::string(data_dir), options);
+    ASSERT_TRUE(result);
+    Kvs& kvs = result.value();
+
+    /* Concurrent readers and a writer must never fail */
+    constexpr int32_t iterations = 1000;
+    std::atomic<int32_t> failures{0};
+    std::vector<std::thread> threads;
+    for (int32_t t = 0; t < 4; ++t) {
+        threads.emplace_back([&]() {
+            for (int32_t i = 0; i < iterations; ++i) {
+                if (!kvs.get_value("kvs") || !kvs.key_exists("kvs")) {
+                    ++failures;
+                }
+            }
+        });
+    }
+    threads.emplace_back([&]() {
+        for (int32_t i = 0; i < iterations; ++i) {
+            if (!kvs.set_value("kvs", KvsValue(i))) {
+                ++failures;
+            }
+        }
+    });
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    EXPECT_EQ(failures, 0);
+    EXPECT_EQ(std::get<int32_t>(kvs.kvs.at("kvs").getValue()), iterations - 1);
+
+    cleanup_environment();
+}
+
+TEST(kvs_storage_format, binary_flush_and_open){
+
+    prepare_environment();
+    KvsOptions options;
+    options.format = KvsStorageFormat::Binary;
+
+    auto result = Kvs::open(instance_id, OpenNeedDefaults::Optional, OpenNeedKvs::Optional, std::string(data_dir), options);
+    ASSERT_TRUE(result);
+    KvsValue::Array array;
+    array.push_back(std::make_shared<KvsValue>(std::string("element")));
+    ASSERT_TRUE(result.value().set_value("array", KvsValue(array)));
+    ASSERT_TRUE(result.value().set_value("number", KvsValue(static_cast<uint64_t>(42))));
+    ASSERT_TRUE(result.value().flush());
+
+    /* Binary data and its hash are written, the JSON data is rotated into the first snapshot */
+    EXPECT_TRUE(std::filesystem::exists(kvs_prefix + ".bin"));
+    EXPECT_TRUE(std::filesystem::exists(kvs_prefix + ".hash"));
+    EXPECT_FALSE(std::filesystem::exists(kvs_prefix + ".json"));
+    EXPECT_TRUE(std::filesystem::exists(filename_prefix + "_1.json"));
+    EXPECT_TRUE(std::filesystem::exists(filename_prefix + "_1.hash"));
+    EXPECT_EQ(result.value().get_kvs_filename(0).value().Native(), kvs_prefix + ".bin");
+    EXPECT_EQ(result.value().get_kvs_filename(1).value().Native(), filename_prefix + "_1.json");
+    EXPECT_EQ(result.value().snapshot_count().value(), 1);
+
+    /* Reopen from the binary data */
+    auto reopened = Kvs::open(instance_id, OpenNeedDefaults::Optional, OpenNeedKvs::Required, std::string(data_dir), options);
+    ASSERT_TRUE(reopened);
+    EXPECT_EQ(reopened.value().kvs.size(), 3U);
+    EXPECT_EQ(std::get<int32_t>(reopened.value().kvs.at("kvs").getValue()), 2);
+    EXPECT_EQ(std::get<uint64_t>(reopened.value().kvs.at("number").getValue()), 42U);
+    const auto& arr = reopened.value().kvs.at("array").getArray();
+    ASSERT_EQ(arr.size(), 1U);
+    EXPECT_EQ(std::get<std::string>(arr[0]->getValue()), "element");
+
+    cleanup_environment();
+}
+
+TEST(kvs_storage_format, migration_between_formats){
+
+    prepare_environment();
+    KvsOptions options;
+    options.format = KvsStorageFormat::Binary;
+
+    /* Existing JSON data is read in binary mode */
+    auto result = Kvs::open(instance_id, OpenNeedDefaults::Required, OpenNeedKvs::Required, std::string(data_dir), options);
+    ASSERT_TRUE(result);
+    EXPECT_EQ(std::get<int32_t>(result.value().kvs.at("kvs").getValue()), 2);
+    EXPECT_EQ(std::get<int32_t>(result.value().default_values.at("default").getValue()), 5);
+    ASSERT_TRUE(result.value().flush());
+
+    /* Binary data is read in JSON mode and converted back on the next flush */
+    auto json_result = Kvs::open(instance_id, OpenNeedDefaults::Required, OpenNeedKvs::Required, std::string(data_dir));
+    ASSERT_TRUE(json_result);
+    EXPECT_EQ(std::get<int32_t>(json_result.value().kvs.at("kvs").getValue()), 2);
+    ASSERT_TRUE(json_result.value().flush());
+    EXPECT_TRUE(std::filesystem::exists(kvs_prefix + ".json"));
+    EXPECT_FALSE(std::filesystem::exists(kvs_prefix + ".bin"));
+    EXPECT_TRUE(std::filesystem::exists(filename_prefix + "_1.bin"));
+    EXPECT_TRUE(std::filesystem::exists(filename_prefix + "_2.json"));
+    EXPECT_EQ(json_result.value().snapshot_count().value(), 2);
+
+    /* Snapshots of both formats can be restored */
+    ASSERT_TRUE(json_result.value().set_value("kvs", KvsValue(static_cast<int32_t>(7))));
+    ASSERT_TRUE(json_result.value().snapshot_restore(1));
+    EXPECT_EQ(std::get<int32_t>(json_result.value().kvs.at("kvs").getValue()), 2);
+    ASSERT_TRUE(json_result.value().snapshot_restore(2));
+    EXPECT_EQ(std::get<int32_t>(json_result.value().kvs.at("kvs").getValue()), 2);
+
+    cleanup_environment();
+}
+
+TEST(kvs_storage_format, snapshot_rotate_removes_stale_format){
+
+    prepare_environment();
+    KvsOptions options;
+    options.format = KvsStorageFormat::Binary;
+
+    auto result = Kvs::open(instance_id, OpenNeedDefaults::Optional, OpenNeedKvs::Optional, std::string(data_dir), options);
+    ASSERT_TRUE(result);
+
+    /* The oldest snapshot is JSON, the one rotated onto it is binary */
+    std::ofstream(filename_prefix + "_" + std::to_string(KVS_MAX_SNAPSHOTS) + ".json") << "{}";
+    std::ofstream(filename_prefix + "_" + std::to_string(KVS_MAX_SNAPSHOTS - 1) + ".bin") << "binary";
+    std::ofstream(filename_prefix + "_" + std::to_string(KVS_MAX_SNAPSHOTS - 1) + ".hash") << "hash";
+
+    ASSERT_TRUE(result.value().snapshot_rotate());
+    EXPECT_TRUE(std::filesystem::exists(filename_prefix + "_" + std::to_string(KVS_MAX_SNAPSHOTS) + ".bin"));
+    EXPECT_FALSE(std::filesystem::exists(filename_prefix + "_" + std::to_string(KVS_MAX_SNAPSHOTS) + ".json"));
+
+    cleanup_environment();
+}
+
+TEST(kvs_storage_format, binary_open_failure){
+
+    prepare_environment();
+    KvsOptions options;
+    options.format = KvsStorageFormat::Binary;
+
+    /* Corrupted binary data with a matching hash */
+    std::filesystem::remove(kvs_prefix + ".json");
+    const std::string invalid_data = "KVSB_invalid";
+    std::ofstream(kvs_prefix + ".bin", std::ios::binary) << invalid_data;
+    uint32_t hash = adler32(invalid_data);
+    std::ofstream hash_file(kvs_prefix + ".hash", std::ios::binary);
+    hash_file.put((hash >> 24) & 0xFF);
+    hash_file.put((hash >> 16) & 0xFF);
+    hash_file.put((hash >> 8)  & 0xFF);
+    hash_file.put(hash & 0xFF);
+    hash_file.close();
+
+    auto result = Kvs::open(instance_id, OpenNeedDefaults::Optional, OpenNeedKvs::Required, std::string(data_dir), options);
+    ASSERT_FALSE(result);
+    EXPECT_EQ(static_cast<ErrorCode>(*result.error()), ErrorCode::SerializationFailed);
+
+    /* Hash doesn't match */
+    std::ofstream(kvs_prefix + ".hash", std::ios::binary) << "hash";
+    result = Kvs::open(instance_id, OpenNeedDefaults::Optional, OpenNeedKvs::Required, std::string(data_dir), options);
+    ASSERT_FALSE(result);
+    EXPECT_EQ(static_cast<ErrorCode>(*result.error()), ErrorCode::ValidationFailed);
+
+    cleanup_environment();
+}
+
+TEST(kvs_storage_format, binary_flush_failure_kvsvalue_invalid){
+
+    prepare_environment();
+    KvsOptions options;
+    options.format = KvsStorageFormat::Binary;
+
+    auto result = Kvs::open(instance_id, OpenNeedDefaults::Optional, OpenNeedKvs::Optional, std::string(data_dir), options);
+    ASSERT_TRUE(result);
+
+    BrokenKvsValue invalid;
+    result.value().kvs.insert({"invalid_key", invalid});
+    result.value().rebuild_slots();
+    auto flush_result = result.value().flush();
+    EXPECT_FALSE(flush_result);
+    EXPECT_EQ(flush_result.error(), ErrorCode::InvalidValueType);
+    EXPECT_FALSE(std::filesystem::exists(kvs_prefix + ".bin"));
+
+    /* Lock held by another thread */
+    result.value().kvs.erase("invalid_key");
+    result.value().rebuild_slots();
+    std::unique_lock<std::shared_mutex> lock(result.value().kvs_mutex);
+    flush_result = result.value().flush();
+    EXPECT_FALSE(flush_result);
+    EXPECT_EQ(static_cast<ErrorCode>(*flush_result.error()), ErrorCode::MutexLockFailed);
+
+    cleanup_environment();
+}
+
+TEST(kvs_mapped_defaults, open_builds_and_maps_image){
+
+    prepare_environment();
+    KvsOptions options;
+    options.mapped_defaults = true;
+
+    /* First open parses the JSON defaults and creates the image */
+    auto result = Kvs::open(instance_id, OpenNeedDefaults::Required, OpenNeedKvs::Required, std::string(data_dir), options);
+    ASSERT_TRUE(result);
+    EXPECT_TRUE(std::filesystem::exists(default_prefix + ".img"));
+    EXPECT_EQ(result.value().default_image, nullptr);
+    EXPECT_EQ(result.value().default_values.size(), 1U);
+
+    /* Second open only maps the image */
+    auto mapped = Kvs::open(instance_id, OpenNeedDefaults::Required, OpenNeedKvs::Required, std::string(data_dir), options);
+    ASSERT_TRUE(mapped);
+    Kvs& kvs = mapped.value();
+    ASSERT_NE(kvs.default_image, nullptr);
+    EXPECT_TRUE(kvs.default_values.empty());
+
+    /* Default lookups use the image */
+    EXPECT_EQ(std::get<int32_t>(kvs.get_default_value("default").value().getValue()), 5);
+    EXPECT_EQ(std::get<int32_t>(kvs.get_value("default").value().getValue()), 5);
+    EXPECT_EQ(kvs.get_value_as<int32_t>("default").value(), 5);
+    EXPECT_TRUE(kvs.has_default_value("default").value());
+    EXPECT_FALSE(kvs.has_default_value("kvs").value());
+    EXPECT_EQ(kvs.get_default_value("kvs").error(), ErrorCode::KeyNotFound);
+    EXPECT_EQ(kvs.get_value("unknown").error(), ErrorCode::KeyNotFound);
+
+    /* Written values still take precedence, reset_key falls back to the image */
+    ASSERT_TRUE(kvs.set_value("default", KvsValue(static_cast<int32_t>(7))));
+    EXPECT_EQ(std::get<int32_t>(kvs.get_value("default").value().getValue()), 7);
+    ASSERT_TRUE(kvs.reset_key("default"));
+    EXPECT_EQ(std::get<int32_t>(kvs.get_value("default").value().getValue()), 5);
+    EXPECT_EQ(kvs.reset_key("kvs").error(), ErrorCode::KeyDefaultNotFound);
+
+    /* Image is moved with the KVS */
+    Kvs moved = std::move(kvs);
+    EXPECT_EQ(std::get<int32_t>(moved.get_default_value("default").value().getValue()), 5);
+
+    cleanup_environment();
+}
+
+TEST(kvs_mapped_defaults, stale_image_is_rebuilt){
+
+    prepare_environment();
+    KvsOptions options;
+    options.mapped_defaults = true;
+    ASSERT_TRUE(Kvs::open(instance_id, OpenNeedDefaults::Required, OpenNeedKvs::Optional, std::string(data_dir), options));
+    ASSERT_TRUE(std::filesystem::exists(default_prefix + ".img"));
+
+    /* Change the defaults JSON file (and its hash) */
+    const std::string new_default_json = R"({"default": {"t": "i32", "v": 9}})";
+    std::ofstream(default_prefix + ".json") << new_default_json;
+    uint32_t hash = adler32(new_default_json);
+    std::ofstream hash_file(default_prefix + ".hash", std::ios::binary);
+    hash_file.put((hash >> 24) & 0xFF);
+    hash_file.put((hash >> 16) & 0xFF);
+    hash_file.put((hash >> 8)  & 0xFF);
+    hash_file.put(hash & 0xFF);
+    hash_file.close();
+
+    /* Stale image is ignored and rebuilt */
+    auto result = Kvs::open(instance_id, OpenNeedDefaults::Required, OpenNeedKvs::Optional, std::string(data_dir), options);
+    ASSERT_TRUE(result);
+    EXPECT_EQ(result.value().default_image, nullptr);
+    EXPECT_EQ(std::get<int32_t>(result.value().get_default_value("default").value().getValue()), 9);
+
+    result = Kvs::open(instance_id, OpenNeedDefaults::Required, OpenNeedKvs::Optional, std::string(data_dir), options);
+    ASSERT_TRUE(result);
+    ASSERT_NE(result.value().default_image, nullptr);
+    EXPECT_EQ(std::get<int32_t>(result.value().get_default_value("default").value().getValue()), 9);
+
+    cleanup_environment();
+}
+
+TEST(kvs_mapped_defaults, open_without_defaults){
+
+    prepare_environment();
+    std::filesystem::remove(default_prefix + ".json");
+    std::filesystem::remove(default_prefix + ".hash");
+    KvsOptions options;
+    options.mapped_defaults = true;
+
+    /* Missing defaults behave as without image */
+    auto result = Kvs::open(instance_id, OpenNeedDefaults::Required, OpenNeedKvs::Optional, std::string(data_dir), options);
+    ASSERT_FALSE(result);
+    EXPECT_EQ(static_cast<ErrorCode>(*result.error()), ErrorCode::KvsFileReadError);
+    result = Kvs::open(instance_id, OpenNeedDefaults::Optional, OpenNeedKvs::Optional, std::string(data_dir), options);
+    ASSERT_TRUE(result);
+    EXPECT_EQ(result.value().default_image, nullptr);
+    EXPECT_FALSE(std::filesystem::exists(default_prefix + ".img"));
+    EXPECT_FALSE(result.value().has_default_value("default").value());
+
+    /* Invalid defaults JSON is still reported */
+    std::ofstream(default_prefix + ".json") << default_json;
+    std::ofstream(default_prefix + ".hash") << "hash";
+    result = Kvs::open(instance_id, OpenNeedDefaults::Optional, OpenNeedKvs::Optional, std::string(data_dir), options);
+    ASSERT_FALSE(result);
+    EXPECT_EQ(static_cast<ErrorCode>(*result.error()), ErrorCode::ValidationFailed);
+    EXPECT_FALSE(std::filesystem::exists(default_prefix + ".img"));
+
+    cleanup_environment();
+}
+
+TEST(kvs_incremental_flush, flush_appends_log){
+
+    prepare_environment();
+    KvsOptions options;
+    options.flush_mode = KvsFlushMode::Incremental;
+
+    auto result = Kvs::open(instance_id, OpenNeedDefaults::Optional, OpenNeedKvs::Required, std::string(data_dir), options);
+    ASSERT_TRUE(result);
+    EXPECT_FALSE(result.value().full_flush_required);
+
+    /* Changes are appended to the log, the KVS file and the snapshots stay untouched */
+    ASSERT_TRUE(result.value().set_value("number", KvsValue(static_cast<int32_t>(1))));
+    ASSERT_TRUE(result.value().set_value("kvs", KvsValue(static_cast<int32_t>(3))));
+    EXPECT_EQ(result.value().dirty_keys.size(), 2U);
+    ASSERT_TRUE(result.value().flush());
+    EXPECT_TRUE(result.value().dirty_keys.empty());
+    EXPECT_TRUE(std::filesystem::exists(kvs_prefix + ".log"));
+    EXPECT_EQ(result.value().log_size, std::filesystem::file_size(kvs_prefix + ".log"));
+    std::ifstream in(kvs_prefix + ".json");
+    std::string data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    EXPECT_EQ(data, kvs_json);
+    EXPECT_EQ(result.value().snapshot_count().value(), 0);
+
+    /* Further changes are appended, a flush without changes doesn't write */
+    ASSERT_TRUE(result.value().remove_key("number"));
+    ASSERT_TRUE(result.value().flush());
+    const size_t log_size = result.value().log_size;
+    EXPECT_EQ(log_size, std::filesystem::file_size(kvs_prefix + ".log"));
+    ASSERT_TRUE(result.value().flush());
+    EXPECT_EQ(result.value().log_size, log_size);
+
+    /* The log is replayed when opening, independent of the flush mode */
+    auto reopened = Kvs::open(instance_id, OpenNeedDefaults::Optional, OpenNeedKvs::Required, std::string(data_dir));
+    ASSERT_TRUE(reopened);
+    EXPECT_EQ(reopened.value().kvs.size(), 1U);
+    EXPECT_EQ(std::get<int32_t>(reopened.value().kvs.at("kvs").getValue()), 3);
+    EXPECT_EQ(reopened.value().log_size, log_size);
+
+    /* A full flush includes the log in the KVS file and removes it */
+    ASSERT_TRUE(reopened.value().flush());
+    EXPECT_FALSE(std::filesystem::exists(kvs_prefix + ".log"));
+    EXPECT_EQ(reopened.value().snapshot_count().value(), 1);
+    auto full = Kvs::open(instance_id, OpenNeedDefaults::Optional, OpenNeedKvs::Required, std::string(data_dir), options);
+    ASSERT_TRUE(full);
+    EXPECT_EQ(std::get<int32_t>(full.value().kvs.at("kvs").getValue()), 3);
+    EXPECT_EQ(full.value().log_size, 0U);
+
+    cleanup_environment();
+}
+
+TEST(kvs_incremental_flush, flush_full_required){
+
+    prepare_environment();
+    std::filesystem::remove(kvs_prefix + ".json");
+    std::filesystem::remove(kvs_prefix + ".hash");
+    KvsOptions options;
+    options.flush_mode = KvsFlushMode::Incremental;
+
+    /* Without KVS file the first flush writes it */
+    auto result = Kvs::open(instance_id, OpenNeedDefaults::Optional, OpenNeedKvs::Optional, std::string(data_dir), options);
+    ASSERT_TRUE(result);
+    EXPECT_TRUE(result.value().full_flush_required);
+    ASSERT_TRUE(result.value().set_value("key", KvsValue(true)));
+    ASSERT_TRUE(result.value().flush());
+    EXPECT_TRUE(std::filesystem::exists(kvs_prefix + ".json"));
+    EXPECT_FALSE(std::filesystem::exists(kvs_prefix + ".log"));
+    EXPECT_FALSE(result.value().full_flush_required);
+    EXPECT_EQ(result.value().base_size, std::filesystem::file_size(kvs_prefix + ".json"));
+
+    /* reset() and snapshot_restore() replace the whole data */
+    ASSERT_TRUE(result.value().set_value("key", KvsValue(false)));
+    ASSERT_TRUE(result.value().flush());
+    EXPECT_TRUE(std::filesystem::exists(kvs_prefix + ".log"));
+    ASSERT_TRUE(result.value().reset());
+    EXPECT_TRUE(result.value().full_flush_required);
+    ASSERT_TRUE(result.value().flush());
+    EXPECT_FALSE(std::filesystem::exists(kvs_prefix + ".log"));
+    EXPECT_EQ(result.value().snapshot_count().value(), 1);
+
+    ASSERT_TRUE(result.value().set_value("key", KvsValue(false)));
+    ASSERT_TRUE(result.value().snapshot_restore(1));
+    EXPECT_TRUE(result.value().full_flush_required);
+    EXPECT_TRUE(result.value().dirty_keys.empty());
+    ASSERT_TRUE(result.value().flush());
+    EXPECT_FALSE(std::filesystem::exists(kvs_prefix + ".log"));
+    EXPECT_EQ(result.value().snapshot_count().value(), 2);
+
+    cleanup_environment();
+}
+
+TEST(kvs_incremental_flush, flush_compacts_log){
+
+    prepare_environment();
+    KvsOptions options;
+    options.flush_mode = KvsFlushMode::Incremental;
+
+    auto result = Kvs::open(instance_id, OpenNeedDefaults::Optional, OpenNeedKvs::Required, std::string(data_dir), options);
+    ASSERT_TRUE(result);
+
+    /* The log never grows larger than the KVS file (or the minimum compaction size) */
+    const std::string value(1024, 'x');
+    size_t snapshots = 0;
+    for (int32_t idx = 0; idx < 8; ++idx) {
+        ASSERT_TRUE(result.value().set_value("key", KvsValue(value + std::to_string(idx))));
+        ASSERT_TRUE(result.value().flush());
+        EXPECT_LE(result.value().log_size, std::max(result.value().base_size, KVS_LOG_MIN_COMPACTION_SIZE));
+        snapshots = result.value().snapshot_count().value();
+    }
+    EXPECT_GE(snapshots, 1U);
+
+    auto reopened = Kvs::open(instance_id, OpenNeedDefaults::Optional, OpenNeedKvs::Required, std::string(data_dir), options);
+    ASSERT_TRUE(reopened);
+    EXPECT_EQ(std::get<std::string>(reopened.value().kvs.at("key").getValue()), value + "7");
+
+    cleanup_environment();
+}
+
+TEST(kvs_incremental_flush, concurrent_flush){
+
+    prepare_environment();
+    KvsOptions options;
+    options.flush_mode = KvsFlushMode::Incremental;
+    options.lock_mode = KvsLockMode::Blocking;
+
+    auto result = Kvs::open(instance_id, OpenNeedDefaults::Optional, OpenNeedKvs::Required, std::string(data_dir), options);
+    ASSERT_TRUE(result);
+    Kvs& kvs = result.value();
+
+    /* Concurrent flushes neither truncate the records of each other nor lose them to a compaction */
+    constexpr int32_t iterations = 40;
+    const std::string value(300, 'x');
+    std::atomic<int32_t> failures{0};
+    std::vector<std::thread> threads;
+    for (int32_t t = 0; t < 4; ++t) {
+        threads.emplace_back([&, t]() {
+            for (int32_t i = 0; i < iterations; ++i) {
+                if (!kvs.set_value("key_" + std::to_string(t) + "_" + std::to_string(i), KvsValue(value)) || !kvs.flush()) {
+                    ++failures;
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    EXPECT_EQ(failures, 0);
+    EXPECT_EQ(kvs.log_size, std::filesystem::exists(kvs_prefix + ".log") ? std::filesystem::file_size(kvs_prefix + ".log") : 0U);
+
+    auto reopened = Kvs::open(instance_id, OpenNeedDefaults::Optional, OpenNeedKvs::Required, std::string(data_dir), options);
+    ASSERT_TRUE(reopened);
+    for (int32_t t = 0; t < 4; ++t) {
+        for (int32_t i = 0; i < iterations; ++i) {
+            EXPECT_EQ(reopened.value().kvs.count("key_" + std::to_string(t) + "_" + std::to_string(i)), 1U);
+        }
+    }
+
+    cleanup_environment();
+}
+
+TEST(kvs_incremental_flush, open_invalid_log){
+
+    prepare_environment();
+    KvsOptions options;
+    options.flush_mode = KvsFlushMode::Incremental;
+
+    auto result = Kvs::open(instance_id, OpenNeedDefaults::Optional, OpenNeedKvs::Required, std::string(data_dir), options);
+    ASSERT_TRUE(result);
+    ASSERT_TRUE(result.value().set_value("first", KvsValue(static_cast<int32_t>(1))));
+    ASSERT_TRUE(result.value().flush());
+    const size_t log_size = result.value().log_size;
+    ASSERT_TRUE(result.value().set_value("second", KvsValue(static_cast<int32_t>(2))));
+    ASSERT_TRUE(result.value().flush());
+
+    /* A torn record at the end is cut off */
+    std::filesystem::resize_file(kvs_prefix + ".log", result.value().log_size - 1);
+    auto reopened = Kvs::open(instance_id, OpenNeedDefaults::Optional, OpenNeedKvs::Required, std::string(data_dir), options);
+    ASSERT_TRUE(reopened);
+    EXPECT_EQ(reopened.value().kvs.count("first"), 1U);
+    EXPECT_EQ(reopened.value().kvs.count("second"), 0U);
+    EXPECT_EQ(reopened.value().log_size, log_size);
+    EXPECT_EQ(std::filesystem::file_size(kvs_prefix + ".log"), log_size);
+
+    /* A log of another KVS file is ignored and replaced by the next flush */
+    std::ofstream(kvs_prefix + ".json") << kvs_json << " ";
+    std::ofstream(kvs_prefix + ".hash", std::ios::binary) << std::string(reinterpret_cast<const char*>(get_hash_bytes(kvs_json + " ").data()), 4);
+    reopened = Kvs::open(instance_id, OpenNeedDefaults::Optional, OpenNeedKvs::Required, std::string(data_dir), options);
+    ASSERT_TRUE(reopened);
+    EXPECT_EQ(reopened.value().kvs.count("first"), 0U);
+    EXPECT_EQ(reopened.value().log_size, 0U);
+    ASSERT_TRUE(reopened.value().set_value("third", KvsValue(static_cast<int32_t>(3))));
+    ASSERT_TRUE(reopened.value().flush());
+    auto replayed = Kvs::open(instance_id, OpenNeedDefaults::Optional, OpenNeedKvs::Required, std::string(data_dir), options);
+    ASSERT_TRUE(replayed);
+    EXPECT_EQ(replayed.value().kvs.count("first"), 0U);
+    EXPECT_EQ(replayed.value().kvs.count("third"), 1U);
+
+    /* A log without KVS file is ignored */
+    std::filesystem::remove(kvs_prefix + ".json");
+    std::filesystem::remove(kvs_prefix + ".hash");
+    replayed = Kvs::open(instance_id, OpenNeedDefaults::Optional, OpenNeedKvs::Optional, std::string(data_dir), options);
+    ASSERT_TRUE(replayed);
+    EXPECT_TRUE(replayed.value().kvs.empty());
+    EXPECT_TRUE(replayed.value().full_flush_required);
+
+    cleanup_environment();
+}
+
+TEST(kvs_incremental_flush, flush_failure_kvsvalue_invalid){
+
+    prepare_environment();
+    KvsOptions options;
+    options.flush_mode = KvsFlushMode::Incremental;
+
+    auto result = Kvs::open(instance_id, OpenNeedDefaults::Optional, OpenNeedKvs::Required, std::string(data_dir), options);
+    ASSERT_TRUE(result);
+    ASSERT_TRUE(result.value().set_value("invalid", BrokenKvsValue()));
+    auto flush_res = result.value().flush();
+    ASSERT_FALSE(flush_res);
+    EXPECT_EQ(static_cast<ErrorCode>(*flush_res.error()), ErrorCode::InvalidValueType);
+    EXPECT_EQ(result.value().dirty_keys.count("invalid"), 1U); /* Stays dirty for the next flush */
+    EXPECT_FALSE(std::filesystem::exists(kvs_prefix + ".log"));
+
+    ASSERT_TRUE(result.value().set_value("invalid", KvsValue(true)));
+    ASSERT_TRUE(result.value().flush());
+    EXPECT_TRUE(result.value().dirty_keys.empty());
+
+    cleanup_environment();
+}
+
+TEST(kvs_background_flush, flush_async_writes_data){
+
+    prepare_environment();
+    KvsOptions options;
+    options.background_flush = true;
+
+    auto result = Kvs::open(instance_id, OpenNeedDefaults::Optional, OpenNeedKvs::Required, std::string(data_dir), options);
+    ASSERT_TRUE(result);
+    EXPECT_EQ(result.value().flusher, nullptr); /* Started by the first flush */
+
+    ASSERT_TRUE(result.value().set_value("number", KvsValue(static_cast<int32_t>(1))));
+    bool callback_called = false;
+    auto future = result.value().flush_async([&callback_called](const score::ResultBlank& res) {
+        EXPECT_TRUE(res);
+        callback_called = true;
+    });
+    EXPECT_NE(result.value().flusher, nullptr);
+    EXPECT_TRUE(future.get());
+    EXPECT_TRUE(callback_called);
+    EXPECT_EQ(result.value().snapshot_count().value(), 1);
+
+    /* flush() waits for the background thread */
+    ASSERT_TRUE(result.value().set_value("number", KvsValue(static_cast<int32_t>(2))));
+    ASSERT_TRUE(result.value().flush());
+    EXPECT_EQ(result.value().snapshot_count().value(), 2);
+
+    auto reopened = Kvs::open(instance_id, OpenNeedDefaults::Optional, OpenNeedKvs::Required, std::string(data_dir));
+    ASSERT_TRUE(reopened);
+    EXPECT_EQ(std::get<int32_t>(reopened.value().kvs.at("number").getValue()), 2);
+
+    /* Restoring waits for pending flushes */
+    ASSERT_TRUE(result.value().set_value("number", KvsValue(static_cast<int32_t>(3))));
+    (void)result.value().flush_async();
+    ASSERT_TRUE(result.value().snapshot_restore(1));
+    EXPECT_EQ(result.value().snapshot_count().value(), 3);
+    EXPECT_EQ(std::get<int32_t>(result.value().kvs.at("number").getValue()), 2);
+
+    cleanup_environment();
+}
+
+TEST(kvs_background_flush, flush_async_move_and_destroy){
+
+    prepare_environment();
+    KvsOptions options;
+    options.background_flush = true;
+
+    std::shared_future<score::ResultBlank> future;
+    {
+        auto result = Kvs::open(instance_id, OpenNeedDefaults::Optional, OpenNeedKvs::Required, std::string(data_dir), options);
+        ASSERT_TRUE(result);
+        ASSERT_TRUE(result.value().set_value("number", KvsValue(static_cast<int32_t>(1))));
+        (void)result.value().flush_async();
+
+        /* Moving finishes the pending flush, the moved-to KVS starts its own background thread */
+        Kvs moved(std::move(result.value()));
+        EXPECT_EQ(result.value().flusher, nullptr);
+        EXPECT_EQ(moved.flusher, nullptr);
+        EXPECT_EQ(moved.snapshot_count().value(), 1);
+        ASSERT_TRUE(moved.set_value("number", KvsValue(static_cast<int32_t>(2))));
+        future = moved.flush_async();
+
+        Kvs assigned = std::move(moved);
+        ASSERT_TRUE(assigned.set_value("number", KvsValue(static_cast<int32_t>(3))));
+        (void)assigned.flush_async();
+    }
+    /* Destroying finishes the pending flush */
+    EXPECT_EQ(future.wait_for(std::chrono::seconds(0)), std::future_status::ready);
+    EXPECT_TRUE(future.get());
+    auto reopened = Kvs::open(instance_id, OpenNeedDefaults::Optional, OpenNeedKvs::Required, std::string(data_dir));
+    ASSERT_TRUE(reopened);
+    EXPECT_EQ(std::get<int32_t>(reopened.value().kvs.at("number").getValue()), 3);
+
+    cleanup_environment();
+}
+
+TEST(kvs_background_flush, flush_async_failure){
+
+    prepare_environment();
+    KvsOptions options;
+    options.background_flush = true;
+
+    auto result = Kvs::open(instance_id, OpenNeedDefaults::Optional, OpenNeedKvs::Required, std::string(data_dir), options);
+    ASSERT_TRUE(result);
+    ASSERT_TRUE(result.value().set_value("invalid", BrokenKvsValue()));
+    auto flush_res = result.value().flush_async().get();
+    ASSERT_FALSE(flush_res);
+    EXPECT_EQ(static_cast<ErrorCode>(*flush_res.error()), ErrorCode::InvalidValueType);
+    flush_res = result.value().flush();
+    ASSERT_FALSE(flush_res);
+    EXPECT_EQ(static_cast<ErrorCode>(*flush_res.error()), ErrorCode::InvalidValueType);
+
+    cleanup_environment();
+}
+
+TEST(kvs_background_flush, flush_async_without_background_flush){
+
+    prepare_environment();
+
+    /* The flush is done in the calling thread, the future is ready */
+    auto result = Kvs::open(instance_id, OpenNeedDefaults::Optional, OpenNeedKvs::Required, std::string(data_dir));
+    ASSERT_TRUE(result);
+    bool callback_called = false;
+    auto future = result.value().flush_async([&callback_called](const score::ResultBlank&) { callback_called = true; });
+    EXPECT_TRUE(callback_called);
+    EXPECT_EQ(future.wait_for(std::chrono::seconds(0)), std::future_status::ready);
+    EXPECT_TRUE(future.get());
+    EXPECT_EQ(result.value().flusher, nullptr);
+    EXPECT_EQ(result.value().snapshot_count().value(), 1);
+
+    cleanup_environment();
+}
+
+TEST(kvs_hash_algorithm, flush_crc32c_and_reopen){
+
+    prepare_environment();
+    KvsOptions options;
+    options.hash_algorithm = KvsHashAlgorithm::Crc32c;
+
+    /* The legacy Adler-32 hash file is read, the flush writes a tagged CRC-32C hash file */
+    auto result = Kvs::open(instance_id, OpenNeedDefaults::Optional, OpenNeedKvs::Required, std::string(data_dir), options);
+    ASSERT_TRUE(result);
+    ASSERT_TRUE(result.value().set_value("number", KvsValue(static_cast<int32_t>(7))));
+    ASSERT_TRUE(result.value().flush());
+    EXPECT_EQ(std::filesystem::file_size(kvs_prefix + ".hash"), KVS_HASH_FILE_TAGGED_SIZE);
+    std::ifstream in(kvs_prefix + ".json", std::ios::binary);
+    std::string data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    std::ifstream hin(kvs_prefix + ".hash", std::ios::binary);
+    EXPECT_TRUE(check_hash(data, hin));
+
+    /* Reopening works with any configured algorithm, the next flush writes the configured one */
+    auto reopened = Kvs::open(instance_id, OpenNeedDefaults::Optional, OpenNeedKvs::Required, std::string(data_dir));
+    ASSERT_TRUE(reopened);
+    EXPECT_EQ(std::get<int32_t>(reopened.value().kvs.at("number").getValue()), 7);
+    ASSERT_TRUE(reopened.value().flush());
+    EXPECT_EQ(std::filesystem::file_size(kvs_prefix + ".hash"), KVS_HASH_FILE_LEGACY_SIZE);
+
+    /* The snapshot with the CRC-32C hash file can be restored */
+    ASSERT_TRUE(reopened.value().snapshot_restore(1));
+    EXPECT_EQ(std::get<int32_t>(reopened.value().kvs.at("number").getValue()), 7);
+
+    cleanup_environment();
+}
+
+TEST(kvs_hash_algorithm, open_crc32c_invalid_hash){
+
+    prepare_environment();
+    KvsOptions options;
+    options.hash_algorithm = KvsHashAlgorithm::Crc32c;
+
+    auto result = Kvs::open(instance_id, OpenNeedDefaults::Optional, OpenNeedKvs::Required, std::string(data_dir), options);
+    ASSERT_TRUE(result);
+    ASSERT_TRUE(result.value().flush());
+
+    /* Data that doesn't match the CRC-32C value is rejected */
+    std::ofstream out(kvs_prefix + ".json", std::ios::app);
+    out << " ";
+    out.close();
+    auto reopened = Kvs::open(instance_id, OpenNeedDefaults::Optional, OpenNeedKvs::Required, std::string(data_dir), options);
+    ASSERT_FALSE(reopened);
+    EXPECT_EQ(static_cast<ErrorCode>(*reopened.error()), ErrorCode::ValidationFailed);
+
+    cleanup_environment();
+}
+
+TEST(kvs_hash_algorithm, incremental_flush_crc32c){
+
+    prepare_environment();
+    KvsOptions options;
+    options.hash_algorithm = KvsHashAlgorithm::Crc32c;
+    options.flush_mode = KvsFlushMode::Incremental;
+
+    /* A full flush writes the CRC-32C hash file, the log refers to it */
+    auto result = Kvs::open(instance_id, OpenNeedDefaults::Optional, OpenNeedKvs::Required, std::string(data_dir), options);
+    ASSERT_TRUE(result);
+    ASSERT_TRUE(result.value().set_value("number", KvsValue(static_cast<int32_t>(1))));
+    result.value().full_flush_required = true;
+    ASSERT_TRUE(result.value().flush());
+    ASSERT_TRUE(result.value().set_value("number", KvsValue(static_cast<int32_t>(2))));
+    ASSERT_TRUE(result.value().flush());
+    EXPECT_TRUE(std::filesystem::exists(kvs_prefix + ".log"));
+
+    auto reopened = Kvs::open(instance_id, OpenNeedDefaults::Optional, OpenNeedKvs::Required, std::string(data_dir), options);
+    ASSERT_TRUE(reopened);
+    EXPECT_FALSE(reopened.value().full_flush_required);
+    EXPECT_EQ(std::get<int32_t>(reopened.value().kvs.at("number").getValue()), 2);
+
+    cleanup_environment();
+}
+
+TEST(kvs_snapshot_max_count, snapshot_max_count_option){
+
+    prepare_environment();
+    KvsOptions options;
+    options.snapshot_max_count = 1;
+
+    auto result = Kvs::open(instance_id, OpenNeedDefaults::Optional, OpenNeedKvs::Required, std::string(data_dir), options);
+    ASSERT_TRUE(result);
+    EXPECT_EQ(result.value().snapshot_max_count(), 1U);
+    for (int32_t idx = 0; idx < 3; ++idx) {
+        ASSERT_TRUE(result.value().set_value("number", KvsValue(idx)));
+        ASSERT_TRUE(result.value().flush());
+    }
+    EXPECT_EQ(result.value().snapshot_count().value(), 1U);
+    EXPECT_FALSE(std::filesystem::exists(filename_prefix + "_2.json"));
+
+    /* No snapshots at all */
+    options.snapshot_max_count = 0;
+    auto no_snapshots = Kvs::open(instance_id, OpenNeedDefaults::Optional, OpenNeedKvs::Required, std::string(data_dir), options);
+    ASSERT_TRUE(no_snapshots);
+    ASSERT_TRUE(no_snapshots.value().flush());
+    EXPECT_EQ(no_snapshots.value().snapshot_count().value(), 0U);
+    EXPECT_FALSE(no_snapshots.value().snapshot_restore(1));
+
+    cleanup_environment();
+}
+
+TEST(kvs_snapshot_generations, flush_rotates_by_manifest){
+
+    mkdir(data_dir.c_str(), 0777);
+    KvsOptions options;
+    options.snapshot_layout = KvsSnapshotLayout::Generations;
+
+    auto result = Kvs::open(instance_id, OpenNeedDefaults::Optional, OpenNeedKvs::Optional, std::string(data_dir), options);
+    ASSERT_TRUE(result);
+    EXPECT_EQ(result.value().snapshot_count().value(), 0U);
+    EXPECT_FALSE(result.value().get_kvs_filename(0));
+
+    /* Every flush writes a new generation, the manifest lists the snapshots (newest first) */
+    for (int32_t idx = 0; idx < 5; ++idx) {
+        ASSERT_TRUE(result.value().set_value("number", KvsValue(idx)));
+        ASSERT_TRUE(result.value().flush());
+        EXPECT_EQ(result.value().snapshot_count().value(), std::min<size_t>(idx, KVS_MAX_SNAPSHOTS));
+    }
+    EXPECT_TRUE(std::filesystem::exists(filename_prefix + ".manifest"));
+    EXPECT_FALSE(std::filesystem::exists(kvs_prefix + ".json"));
+    EXPECT_FALSE(std::filesystem::exists(filename_prefix + "_g0.json")); /* Rotated out */
+    EXPECT_FALSE(std::filesystem::exists(filename_prefix + "_g0.hash"));
+    EXPECT_TRUE(std::filesystem::exists(filename_prefix + "_g1.json"));
+    EXPECT_EQ(result.value().get_kvs_filename(0).value().Native(), filename_prefix + "_g4.json");
+    EXPECT_EQ(result.value().get_hash_filename(1).value().Native(), filename_prefix + "_g3.hash");
+    EXPECT_EQ(result.value().get_kvs_filename(3).value().Native(), filename_prefix + "_g1.json");
+    EXPECT_FALSE(result.value().get_kvs_filename(4));
+    EXPECT_FALSE(result.value().get_hash_filename(4));
+
+    /* Restore reads the generation of the snapshot */
+    ASSERT_TRUE(result.value().snapshot_restore(2));
+    EXPECT_EQ(std::get<int32_t>(result.value().kvs.at("number").getValue()), 2);
+    EXPECT_FALSE(result.value().snapshot_restore(4));
+
+    /* Reopen reads the current generation and the cached snapshot count from the manifest */
+    auto reopened = Kvs::open(instance_id, OpenNeedDefaults::Optional, OpenNeedKvs::Required, std::string(data_dir), options);
+    ASSERT_TRUE(reopened);
+    EXPECT_EQ(std::get<int32_t>(reopened.value().kvs.at("number").getValue()), 4);
+    EXPECT_EQ(reopened.value().snapshot_count().value(), KVS_MAX_SNAPSHOTS);
+
+    cleanup_environment();
+}
+
+TEST(kvs_snapshot_generations, take_over_legacy_files){
+
+    prepare_environment();
+    std::filesystem::copy_file(kvs_prefix + ".json", filename_prefix + "_1.json");
+    std::filesystem::copy_file(kvs_prefix + ".hash", filename_prefix + "_1.hash");
+    KvsOptions options;
+    options.snapshot_layout = KvsSnapshotLayout::Generations;
+    options.snapshot_max_count = 1;
+
+    /* Without a manifest the legacy files are used as they are */
+    auto result = Kvs::open(instance_id, OpenNeedDefaults::Optional, OpenNeedKvs::Required, std::string(data_dir), options);
+    ASSERT_TRUE(result);
+    EXPECT_EQ(std::get<int32_t>(result.value().kvs.at("kvs").getValue()), 2);
+    EXPECT_EQ(result.value().snapshot_count().value(), 1U);
+    EXPECT_EQ(result.value().get_kvs_filename(1).value().Native(), filename_prefix + "_1.json");
+    EXPECT_FALSE(std::filesystem::exists(filename_prefix + ".manifest"));
+
+    /* The first flush creates the manifest, the legacy file that is rotated out is removed */
+    ASSERT_TRUE(result.value().set_value("kvs", KvsValue(static_cast<int32_t>(3))));
+    ASSERT_TRUE(result.value().flush());
+    EXPECT_TRUE(std::filesystem::exists(filename_prefix + ".manifest"));
+    EXPECT_EQ(result.value().get_kvs_filename(1).value().Native(), kvs_prefix + ".json");
+    EXPECT_FALSE(std::filesystem::exists(filename_prefix + "_1.json"));
+    EXPECT_FALSE(std::filesystem::exists(filename_prefix + "_1.hash"));
+    ASSERT_TRUE(result.value().flush());
+    EXPECT_FALSE(std::filesystem::exists(kvs_prefix + ".json"));
+    EXPECT_FALSE(std::filesystem::exists(kvs_prefix + ".hash"));
+
+    cleanup_environment();
+}
+
+TEST(kvs_snapshot_generations, open_invalid_manifest){
+
+    prepare_environment();
+    std::ofstream(filename_prefix + ".manifest", std::ios::binary) << "KVSM broken";
+    KvsOptions options;
+    options.snapshot_layout = KvsSnapshotLayout::Generations;
+
+    auto result = Kvs::open(instance_id, OpenNeedDefaults::Optional, OpenNeedKvs::Optional, std::string(data_dir), options);
+    ASSERT_FALSE(result);
+    EXPECT_EQ(static_cast<ErrorCode>(*result.error()), ErrorCode::ValidationFailed);
+
+    cleanup_environment();
+}
+
+TEST(kvs_snapshot_generations, flush_failure_manifest){
+
+    prepare_environment();
+    KvsOptions options;
+    options.snapshot_layout = KvsSnapshotLayout::Generations;
+
+    auto result = Kvs::open(instance_id, OpenNeedDefaults::Optional, OpenNeedKvs::Required, std::string(data_dir), options);
+    ASSERT_TRUE(result);
+
+    /* The manifest can't be replaced: the new generation is removed, the current files stay valid */
+    std::filesystem::create_directory(filename_prefix + ".manifest");
+    std::ofstream(filename_prefix + ".manifest/blocker") << "x";
+    auto flush_res = result.value().flush();
+    ASSERT_FALSE(flush_res);
+    EXPECT_EQ(static_cast<ErrorCode>(*flush_res.error()), ErrorCode::PhysicalStorageFailure);
+    EXPECT_FALSE(std::filesystem::exists(filename_prefix + "_g0.json"));
+    EXPECT_FALSE(std::filesystem::exists(filename_prefix + "_g0.hash"));
+    EXPECT_EQ(result.value().get_kvs_filename(0).value().Native(), kvs_prefix + ".json");
+    EXPECT_EQ(result.value().snapshot_count().value(), 0U);
+
+    std::filesystem::remove_all(filename_prefix + ".manifest");
+    ASSERT_TRUE(result.value().flush());
+    EXPECT_EQ(result.value().snapshot_count().value(), 1U);
+
+    cleanup_environment();
+}
+
+TEST(kvs_snapshot_generations, incremental_flush){
+
+    prepare_environment();
+    KvsOptions options;
+    options.snapshot_layout = KvsSnapshotLayout::Generations;
+    options.flush_mode = KvsFlushMode::Incremental;
+
+    /* The log refers to the current generation */
+    auto result = Kvs::open(instance_id, OpenNeedDefaults::Optional, OpenNeedKvs::Required, std::string(data_dir), options);
+    ASSERT_TRUE(result);
+    result.value().full_flush_required = true;
+    ASSERT_TRUE(result.value().set_value("number", KvsValue(static_cast<int32_t>(1))));
+    ASSERT_TRUE(result.value().flush());
+    ASSERT_TRUE(result.value().set_value("number", KvsValue(static_cast<int32_t>(2))));
+    ASSERT_TRUE(result.value().flush());
+    EXPECT_TRUE(std::filesystem::exists(kvs_prefix + ".log"));
+
+    auto reopened = Kvs::open(instance_id, OpenNeedDefaults::Optional, OpenNeedKvs::Required, std::string(data_dir), options);
+    ASSERT_TRUE(reopened);
+    EXPECT_FALSE(reopened.value().full_flush_required);
+    EXPECT_EQ(std::get<int32_t>(reopened.value().kvs.at("number").getValue()), 2);
+
+    cleanup_environment();
+}
+
+TEST(kvs_durability, flush_keeps_previous_snapshot){
+
+    prepare_environment();
+
+    auto result = Kvs::open(instance_id, OpenNeedDefaults::Optional, OpenNeedKvs::Required, std::string(data_dir));
+    ASSERT_TRUE(result);
+
+    /* The current KVS file is linked into snapshot 1 and replaced by a rename */
+    ASSERT_TRUE(result.value().set_value("number", KvsValue(static_cast<int32_t>(7))));
+    ASSERT_TRUE(result.value().flush());
+    EXPECT_FALSE(std::filesystem::exists(kvs_prefix + ".json.tmp"));
+    EXPECT_FALSE(std::filesystem::exists(kvs_prefix + ".hash.tmp"));
+    std::ifstream snapshot(filename_prefix + "_1.json");
+    std::string snapshot_data((std::istreambuf_iterator<char>(snapshot)), std::istreambuf_iterator<char>());
+    EXPECT_EQ(snapshot_data, kvs_json);
+
+    auto reopened = Kvs::open(instance_id, OpenNeedDefaults::Optional, OpenNeedKvs::Required, std::string(data_dir));
+    ASSERT_TRUE(reopened);
+    EXPECT_EQ(std::get<int32_t>(reopened.value().kvs.at("number").getValue()), 7);
+
+    cleanup_environment();
+}
+
+TEST(kvs_durability, open_completes_interrupted_flush){
+
+    prepare_environment();
+
+    auto result = Kvs::open(instance_id, OpenNeedDefaults::Optional, OpenNeedKvs::Required, std::string(data_dir));
+    ASSERT_TRUE(result);
+    ASSERT_TRUE(result.value().set_value("number", KvsValue(static_cast<int32_t>(7))));
+    ASSERT_TRUE(result.value().flush());
+
+    /* Power loss after the data file was renamed: the hash file is still the previous one */
+    std::filesystem::rename(kvs_prefix + ".hash", kvs_prefix + ".hash.tmp");
+    std::filesystem::copy_file(filename_prefix + "_1.hash", kvs_prefix + ".hash");
+
+    auto reopened = Kvs::open(instance_id, OpenNeedDefaults::Optional, OpenNeedKvs::Required, std::string(data_dir));
+    ASSERT_TRUE(reopened);
+    EXPECT_EQ(std::get<int32_t>(reopened.value().kvs.at("number").getValue()), 7);
+    EXPECT_FALSE(std::filesystem::exists(kvs_prefix + ".hash.tmp"));
+
+    /* A pending hash file that doesn't match the data doesn't hide corrupted data */
+    std::filesystem::copy_file(kvs_prefix + ".hash", kvs_prefix + ".hash.tmp");
+    std::ofstream(kvs_prefix + ".json") << "{}";
+    auto corrupted = Kvs::open(instance_id, OpenNeedDefaults::Optional, OpenNeedKvs::Required, std::string(data_dir));
+    ASSERT_FALSE(corrupted);
+    EXPECT_EQ(static_cast<ErrorCode>(*corrupted.error()), ErrorCode::ValidationFailed);
+
+    cleanup_environment();
+}
+
+TEST(kvs_durability, durability_policies){
+
+    for (const KvsDurability durability : {KvsDurability::Always, KvsDurability::Grouped}) {
+        for (const KvsSnapshotLayout layout : {KvsSnapshotLayout::Legacy, KvsSnapshotLayout::Generations}) {
+            prepare_environment();
+            KvsOptions options;
+            options.durability = durability;
+            options.sync_interval = 2;
+            options.snapshot_layout = layout;
+            options.flush_mode = KvsFlushMode::Incremental;
+
+            auto result = Kvs::open(instance_id, OpenNeedDefaults::Optional, OpenNeedKvs::Required, std::string(data_dir), options);
+            ASSERT_TRUE(result);
+            result.value().full_flush_required = true;
+            for (int32_t i = 0; i < 3; i++) {
+                ASSERT_TRUE(result.value().set_value("number", KvsValue(i)));
+                ASSERT_TRUE(result.value().flush());
+            }
+            /* Grouped: the third flush is the first of the next group */
+            EXPECT_EQ(result.value().unsynced_flushes.load(), (KvsDurability::Grouped == durability) ? 1U : 0U);
+
+            auto reopened = Kvs::open(instance_id, OpenNeedDefaults::Optional, OpenNeedKvs::Required, std::string(data_dir), options);
+            ASSERT_TRUE(reopened);
+            EXPECT_EQ(std::get<int32_t>(reopened.value().kvs.at("number").getValue()), 2);
+
+            cleanup_environment();
+        }
+    }
+}
+
+TEST(kvs_durability, sync){
+
+    prepare_environment();
+    KvsOptions options;
+    options.durability = KvsDurability::Grouped;
+
+    auto result = Kvs::open(instance_id, OpenNeedDefaults::Optional, OpenNeedKvs::Required, std::string(data_dir), options);
+    ASSERT_TRUE(result);
+    ASSERT_TRUE(result.value().flush());
+    EXPECT_EQ(result.value().unsynced_flushes.load(), 1U);
+    ASSERT_TRUE(result.value().sync());
+    EXPECT_EQ(result.value().unsynced_flushes.load(), 0U);
+
+    /* Nothing flushed yet */
+    cleanup_environment();
+    mkdir(data_dir.c_str(), 0777);
+    auto empty = Kvs::open(instance_id, OpenNeedDefaults::Optional, OpenNeedKvs::Optional, std::string(data_dir));
+    ASSERT_TRUE(empty);
+    EXPECT_TRUE(empty.value().sync());
+
+    cleanup_environment();
+}
+
+TEST(kvs_delta_snapshots, flush_stores_deltas){
+
+    prepare_environment();
+    KvsOptions options;
+    options.delta_snapshots = true;
+
+    auto result = Kvs::open(instance_id, OpenNeedDefaults::Optional, OpenNeedKvs::Required, std::string(data_dir), options);
+    ASSERT_TRUE(result);
+    for (int32_t i = 1; i <= 3; i++) {
+        ASSERT_TRUE(result.value().set_value("number", KvsValue(i)));
+        ASSERT_TRUE(result.value().flush());
+    }
+
+    /* The current KVS file is complete, the snapshots are deltas (their hash files stay) */
+    EXPECT_TRUE(std::filesystem::exists(kvs_prefix + ".json"));
+    for (size_t i = 1; i <= 3; i++) {
+        const std::string prefix = filename_prefix + "_" + std::to_string(i);
+        EXPECT_FALSE(std::filesystem::exists(prefix + ".json"));
+        EXPECT_TRUE(std::filesystem::exists(prefix + ".delta"));
+        EXPECT_TRUE(std::filesystem::exists(prefix + ".hash"));
+        EXPECT_EQ(static_cast<ErrorCode>(*result.value().get_kvs_filename(SnapshotId(i)).error()), ErrorCode::FileNotFound);
+    }
+    EXPECT_EQ(result.value().snapshot_count().value(), 3U);
+
+    /* Materialize the oldest snapshot (the initial KVS file) */
+    const std::string materialized = data_dir + "materialized.json";
+    ASSERT_TRUE(result.value().snapshot_materialize(SnapshotId(3), materialized));
+    std::ifstream in(materialized);
+    std::string data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    auto parsed = result.value().parse_json_data(data);
+    ASSERT_TRUE(parsed);
+    auto initial = result.value().parse_json_data(kvs_json);
+    ASSERT_TRUE(initial);
+    EXPECT_EQ(parsed.value(), initial.value());
+    EXPECT_EQ(static_cast<ErrorCode>(*result.value().snapshot_materialize(SnapshotId(4), materialized).error()), ErrorCode::InvalidSnapshotId);
+
+    /* Restore reconstructs the snapshot from the current KVS file */
+    ASSERT_TRUE(result.value().snapshot_restore(SnapshotId(2)));
+    EXPECT_EQ(std::get<int32_t>(result.value().kvs.at("number").getValue()), 1);
+    ASSERT_TRUE(result.value().flush());
+    EXPECT_EQ(result.value().snapshot_count().value(), 3U);
+    ASSERT_TRUE(result.value().snapshot_restore(SnapshotId(1)));
+    EXPECT_EQ(std::get<int32_t>(result.value().kvs.at("number").getValue()), 3);
+    ASSERT_TRUE(result.value().snapshot_restore(SnapshotId(2)));
+    EXPECT_EQ(std::get<int32_t>(result.value().kvs.at("number").getValue()), 2);
+
+    cleanup_environment();
+}
+
+TEST(kvs_delta_snapshots, mixed_and_generations){
+
+    for (const KvsSnapshotLayout layout : {KvsSnapshotLayout::Legacy, KvsSnapshotLayout::Generations}) {
+        prepare_environment();
+        KvsOptions options;
+        options.snapshot_layout = layout;
+
+        /* Complete snapshots written without the option stay readable next to deltas */
+        auto result = Kvs::open(instance_id, OpenNeedDefaults::Optional, OpenNeedKvs::Required, std::string(data_dir), options);
+        ASSERT_TRUE(result);
+        ASSERT_TRUE(result.value().set_value("number", KvsValue(static_cast<int32_t>(1))));
+        ASSERT_TRUE(result.value().flush());
+        options.delta_snapshots = true;
+        result = Kvs::open(instance_id, OpenNeedDefaults::Optional, OpenNeedKvs::Required, std::string(data_dir), options);
+        ASSERT_TRUE(result);
+        for (int32_t i = 2; i <= 3; i++) {
+            ASSERT_TRUE(result.value().set_value("number", KvsValue(i)));
+            ASSERT_TRUE(result.value().flush());
+        }
+        EXPECT_EQ(result.value().snapshot_count().value(), 3U);
+        ASSERT_TRUE(result.value().get_kvs_filename(SnapshotId(3)));
+        EXPECT_FALSE(result.value().get_kvs_filename(SnapshotId(1)));
+
+        ASSERT_TRUE(result.value().snapshot_restore(SnapshotId(2)));
+        EXPECT_EQ(std::get<int32_t>(result.value().kvs.at("number").getValue()), 1);
+        ASSERT_TRUE(result.value().snapshot_restore(SnapshotId(3)));
+        EXPECT_FALSE(result.value().kvs.count("number"));
+
+        cleanup_environment();
+    }
+}
+
+TEST(kvs_delta_snapshots, restore_corrupted_delta){
+
+    prepare_environment();
+    KvsOptions options;
+    options.delta_snapshots = true;
+
+    auto result = Kvs::open(instance_id, OpenNeedDefaults::Optional, OpenNeedKvs::Required, std::string(data_dir), options);
+    ASSERT_TRUE(result);
+    ASSERT_TRUE(result.value().set_value("number", KvsValue(static_cast<int32_t>(1))));
+    ASSERT_TRUE(result.value().flush());
+    ASSERT_TRUE(result.value().set_value("number", KvsValue(static_cast<int32_t>(2))));
+    ASSERT_TRUE(result.value().flush());
+
+    /* A delta of another base can't be applied */
+    std::filesystem::copy_file(filename_prefix + "_2.delta", filename_prefix + "_1.delta", std::filesystem::copy_options::overwrite_existing);
+    auto restore_res = result.value().snapshot_restore(SnapshotId(1));
+    ASSERT_FALSE(restore_res);
+    EXPECT_EQ(static_cast<ErrorCode>(*restore_res.error()), ErrorCode::ValidationFailed);
+    EXPECT_EQ(std::get<int32_t>(result.value().kvs.at("number").getValue()), 2);
+
+    /* Missing base hash of the older delta */
+    std::filesystem::remove(filename_prefix + "_1.delta");
+    std::filesystem::remove(filename_prefix + "_1.hash");
+    std::ofstream(filename_prefix + "_1.delta") << "";
+    restore_res = result.value().snapshot_restore(SnapshotId(2));
+    ASSERT_FALSE(restore_res);
+    EXPECT_EQ(static_cast<ErrorCode>(*restore_res.error()), ErrorCode::ValidationFailed);
+
+    cleanup_environment();
+}
+
+TEST(kvs_snapshot_diff, snapshot_diff){
+
+    for (const bool delta : {false, true}) {
+        prepare_environment();
+        KvsOptions options;
+        options.delta_snapshots = delta;
+
+        auto result = Kvs::open(instance_id, OpenNeedDefaults::Optional, OpenNeedKvs::Required, std::string(data_dir), options);
+        ASSERT_TRUE(result);
+        ASSERT_TRUE(result.value().set_value("a", KvsValue(1.0)));
+        ASSERT_TRUE(result.value().set_value("b", KvsValue("text")));
+        ASSERT_TRUE(result.value().flush());
+        ASSERT_TRUE(result.value().set_value("a", KvsValue(2.0)));
+        ASSERT_TRUE(result.value().set_value("b", KvsValue("text"))); /* Unchanged value */
+        ASSERT_TRUE(result.value().flush());
+        ASSERT_TRUE(result.value().remove_key("b"));
+        ASSERT_TRUE(result.value().set_value("c", KvsValue(std::vector<KvsValue>{KvsValue(true)})));
+        ASSERT_TRUE(result.value().flush());
+        ASSERT_TRUE(result.value().set_value("a", KvsValue(1.0))); /* Not flushed */
+
+        auto diff = result.value().snapshot_diff(0, 1);
+        ASSERT_TRUE(diff);
+        EXPECT_EQ(diff.value(), (std::vector<std::string>{"b", "c"}));
+        diff = result.value().snapshot_diff(2, 1);
+        ASSERT_TRUE(diff);
+        EXPECT_EQ(diff.value(), (std::vector<std::string>{"a"}));
+        diff = result.value().snapshot_diff(0, 2);
+        ASSERT_TRUE(diff);
+        EXPECT_EQ(diff.value(), (std::vector<std::string>{"a", "b", "c"}));
+        diff = result.value().snapshot_diff(1, 1);
+        ASSERT_TRUE(diff);
+        EXPECT_TRUE(diff.value().empty());
+
+        /* Snapshot 3 is the initial KVS file */
+        diff = result.value().snapshot_diff(3, 2);
+        ASSERT_TRUE(diff);
+        EXPECT_EQ(diff.value(), (std::vector<std::string>{"a", "b"}));
+
+        diff = result.value().snapshot_diff(0, 4);
+        ASSERT_FALSE(diff);
+        EXPECT_EQ(static_cast<ErrorCode>(*diff.error()), ErrorCode::InvalidSnapshotId);
+
+        cleanup_environment();
+    }
+}
+
+TEST(kvs_snapshot_diff, snapshot_diff_corrupted_delta){
+
+    prepare_environment();
+    KvsOptions options;
+    options.delta_snapshots = true;
+
+    auto result = Kvs::open(instance_id, OpenNeedDefaults::Optional, OpenNeedKvs::Required, std::string(data_dir), options);
+    ASSERT_TRUE(result);
+    ASSERT_TRUE(result.value().set_value("a", KvsValue(1.0)));
+    ASSERT_TRUE(result.value().flush());
+    ASSERT_TRUE(result.value().set_value("a", KvsValue(2.0)));
+    ASSERT_TRUE(result.value().flush());
+
+    std::filesystem::copy_file(filename_prefix + "_2.delta", filename_prefix + "_1.delta", std::filesystem::copy_options::overwrite_existing);
+    auto diff = result.value().snapshot_diff(0, 1);
+    ASSERT_FALSE(diff);
+    EXPECT_EQ(static_cast<ErrorCode>(*diff.error()), ErrorCode::ValidationFailed);
+
+    cleanup_environment();
+}
+
+TEST(kvs_arena, open_restore_reset){
+
+    for (const KvsStorageFormat format : {KvsStorageFormat::Json, KvsStorageFormat::Binary}) {
+        prepare_environment();
+        KvsOptions options;
+        options.arena = true;
+        options.format = format;
+
+        /* Write the KVS file (and a snapshot) in the format */
+        auto result = Kvs::open(instance_id, OpenNeedDefaults::Optional, OpenNeedKvs::Required, std::string(data_dir), options);
+        ASSERT_TRUE(result);
+        ASSERT_TRUE(result.value().set_value("array", KvsValue(std::vector<KvsValue>{KvsValue(1.0), KvsValue(true)})));
+        ASSERT_TRUE(result.value().flush());
+        ASSERT_TRUE(result.value().set_value("number", KvsValue(2.0)));
+        ASSERT_TRUE(result.value().flush());
+
+        /* The loaded data is allocated from the arena, the arena is sealed afterwards */
+        result = Kvs::open(instance_id, OpenNeedDefaults::Optional, OpenNeedKvs::Required, std::string(data_dir), options);
+        ASSERT_TRUE(result);
+        Kvs& kvs = result.value();
+        std::shared_ptr<KvsArena> loaded_arena = kvs.kvs.get_allocator().arena;
+        ASSERT_NE(loaded_arena, nullptr);
+        EXPECT_TRUE(loaded_arena->sealed);
+        const size_t used = loaded_arena->used();
+        EXPECT_GT(used, 0U);
+        const auto& array = kvs.kvs.at("array").getArray();
+        EXPECT_TRUE(loaded_arena->owns(array[0].get()));
+        ASSERT_TRUE(kvs.set_value("added", KvsValue(3.0)));
+        EXPECT_EQ(loaded_arena->used(), used); /* Changes use the heap */
+        std::weak_ptr<KvsArena> weak_loaded = loaded_arena;
+        loaded_arena.reset();
+
+        /* A restored snapshot gets its own arena, the previous one is released */
+        ASSERT_TRUE(kvs.snapshot_restore(1));
+        EXPECT_FALSE(kvs.kvs.count("number"));
+        EXPECT_TRUE(weak_loaded.expired());
+        ASSERT_NE(kvs.kvs.get_allocator().arena, nullptr);
+
+        /* A copied value keeps its arena alive after reset() */
+        auto value = kvs.get_value("array");
+        ASSERT_TRUE(value);
+        std::weak_ptr<KvsArena> weak_restored = kvs.kvs.get_allocator().arena;
+        ASSERT_TRUE(kvs.reset());
+        EXPECT_EQ(kvs.kvs.get_allocator().arena, nullptr);
+        EXPECT_FALSE(weak_restored.expired());
+        EXPECT_EQ(value.value().getArray().size(), 2U);
+        value = score::MakeUnexpected(ErrorCode::KeyNotFound);
+        EXPECT_TRUE(weak_restored.expired());
+
+        /* Without arena option the heap is used */
+        options.arena = false;
+        result = Kvs::open(instance_id, OpenNeedDefaults::Optional, OpenNeedKvs::Required, std::string(data_dir), options);
+        ASSERT_TRUE(result);
+        EXPECT_EQ(result.value().kvs.get_allocator().arena, nullptr);
+
+        cleanup_environment();
+    }
+}
+
+TEST(kvs_open_workers, parallel_parse){
+
+    prepare_environment();
+    auto result = Kvs::open(instance_id, OpenNeedDefaults::Optional, OpenNeedKvs::Required, std::string(data_dir));
+    ASSERT_TRUE(result);
+    for (int32_t idx = 0; idx < 3000; ++idx) {
+        if (0 == (idx % 3)) {
+            ASSERT_TRUE(result.value().set_value("key_" + std::to_string(idx), KvsValue(std::vector<KvsValue>{KvsValue(idx), KvsValue(true)})));
+        }else{
+            ASSERT_TRUE(result.value().set_value("key_" + std::to_string(idx), KvsValue(idx)));
+        }
+    }
+    ASSERT_TRUE(result.value().flush());
+    const KvsMap expected = result.value().kvs;
+
+    /* The entries are converted by several workers (also with an arena), the result is the same */
+    for (const bool arena : {false, true}) {
+        KvsOptions options;
+        options.open_workers = 4;
+        options.arena = arena;
+        result = Kvs::open(instance_id, OpenNeedDefaults::Required, OpenNeedKvs::Required, std::string(data_dir), options);
+        ASSERT_TRUE(result);
+        EXPECT_EQ(result.value().kvs, expected);
+        EXPECT_FALSE(result.value().default_values.empty()); /* Read concurrently */
+    }
+
+    /* An invalid entry converted by a worker fails the parse */
+    std::string json = "{";
+    for (int32_t idx = 0; idx < 2500; ++idx) {
+        json += "\"key_" + std::to_string(idx) + "\": {\"t\": \"i32\", \"v\": " + std::to_string(idx) + "},";
+    }
+    json += "\"zzz_invalid\": {\"t\": \"unknown\", \"v\": 0}}";
+    result.value().options.open_workers = 2;
+    auto parse_res = result.value().parse_json_data(json);
+    ASSERT_FALSE(parse_res);
+    EXPECT_EQ(static_cast<ErrorCode>(*parse_res.error()), ErrorCode::InvalidValueType);
+
+    cleanup_environment();
+}
+
+TEST(kvs_open_workers, concurrent_defaults_failure){
+
+    prepare_environment();
+    std::filesystem::remove(default_prefix + ".json");
+    KvsOptions options;
+    options.open_workers = 2;
+
+    /* The error of the defaults is reported like in a sequential open */
+    auto result = Kvs::open(instance_id, OpenNeedDefaults::Required, OpenNeedKvs::Required, std::string(data_dir), options);
+    ASSERT_FALSE(result);
+    EXPECT_EQ(static_cast<ErrorCode>(*result.error()), ErrorCode::KvsFileReadError);
+
+    result = Kvs::open(instance_id, OpenNeedDefaults::Optional, OpenNeedKvs::Required, std::string(data_dir), options);
+    ASSERT_TRUE(result);
+    EXPECT_TRUE(result.value().default_values.empty());
+    EXPECT_TRUE(result.value().kvs.count("kvs"));
+
+    cleanup_environment();
+}
+
+TEST(kvs_lazy_values, open_access_flush){
+
+    for (const KvsStorageFormat format : {KvsStorageFormat::Json, KvsStorageFormat::Binary}) {
+        prepare_environment();
+        KvsOptions options;
+        options.format = format;
+        auto result = Kvs::open(instance_id, OpenNeedDefaults::Optional, OpenNeedKvs::Required, std::string(data_dir), options);
+        ASSERT_TRUE(result);
+        ASSERT_TRUE(result.value().set_value("array", KvsValue(std::vector<KvsValue>{KvsValue(1.0), KvsValue("two")})));
+        ASSERT_TRUE(result.value().set_value("number", KvsValue(2.0)));
+        ASSERT_TRUE(result.value().set_value("string", KvsValue("three")));
+        ASSERT_TRUE(result.value().flush());
+
+        /* Open only indexes the keys */
+        options.lazy_values = true;
+        result = Kvs::open(instance_id, OpenNeedDefaults::Optional, OpenNeedKvs::Required, std::string(data_dir), options);
+        ASSERT_TRUE(result);
+        Kvs& kvs = result.value();
+        EXPECT_TRUE(kvs.kvs.empty());
+        ASSERT_EQ(kvs.lazy_kvs.size(), 4U);
+        EXPECT_EQ(kvs.lazy_format, format);
+        for (const auto& [key, entry] : kvs.lazy_kvs) {
+            EXPECT_FALSE(entry.value.has_value());
+        }
+        auto exists = kvs.key_exists("string");
+        ASSERT_TRUE(exists);
+        EXPECT_TRUE(exists.value());
+        auto keys = kvs.get_all_keys();
+        ASSERT_TRUE(keys);
+        EXPECT_EQ(keys.value(), (std::vector<std::string>{"array", "kvs", "number", "string"}));
+
+        /* The first access decodes the value */
+        auto value = kvs.get_value("array");
+        ASSERT_TRUE(value);
+        EXPECT_EQ(value.value(), KvsValue(std::vector<KvsValue>{KvsValue(1.0), KvsValue("two")}));
+        EXPECT_TRUE(kvs.lazy_kvs.at("array").value.has_value());
+        EXPECT_FALSE(kvs.lazy_kvs.at("number").value.has_value());
+        auto values = kvs.get_values({"number", "missing", "default"});
+        ASSERT_TRUE(values);
+        ASSERT_TRUE(values.value()[0]);
+        EXPECT_EQ(values.value()[0].value(), KvsValue(2.0));
+        EXPECT_FALSE(values.value()[1]);
+        ASSERT_TRUE(values.value()[2]);
+
+        /* Replaced and removed keys are dropped from the index without decoding them */
+        ASSERT_TRUE(kvs.set_value("string", KvsValue("replaced")));
+        EXPECT_FALSE(kvs.lazy_kvs.count("string"));
+        ASSERT_TRUE(kvs.remove_key("kvs"));
+        EXPECT_FALSE(kvs.lazy_kvs.count("kvs"));
+        auto removed = kvs.remove_key("kvs");
+        ASSERT_FALSE(removed);
+        EXPECT_EQ(static_cast<ErrorCode>(*removed.error()), ErrorCode::KeyNotFound);
+
+        std::vector<std::string> scanned;
+        ASSERT_TRUE(kvs.scan_prefix("", [&scanned](const std::string& key, const KvsValue&) { scanned.push_back(key); }));
+        EXPECT_EQ(scanned, (std::vector<std::string>{"array", "number", "string"}));
+
+        /* A full flush decodes the remaining values, the data is released */
+        ASSERT_TRUE(kvs.flush());
+        EXPECT_TRUE(kvs.lazy_kvs.empty());
+        EXPECT_EQ(kvs.lazy_data, nullptr);
+        options.lazy_values = false;
+        result = Kvs::open(instance_id, OpenNeedDefaults::Optional, OpenNeedKvs::Required, std::string(data_dir), options);
+        ASSERT_TRUE(result);
+        EXPECT_EQ(result.value().kvs.size(), 3U);
+        EXPECT_EQ(result.value().kvs.at("string"), KvsValue("replaced"));
+        EXPECT_EQ(result.value().kvs.at("number"), KvsValue(2.0));
+
+        cleanup_environment();
+    }
+}
+
+TEST(kvs_lazy_values, concurrent_readers){
+
+    prepare_environment();
+    KvsOptions options;
+    options.lock_mode = KvsLockMode::Blocking;
+    auto result = Kvs::open(instance_id, OpenNeedDefaults::Optional, OpenNeedKvs::Required, std::string(data_dir), options);
+    ASSERT_TRUE(result);
+    for (int32_t idx = 0; idx < 64; ++idx) {
+        ASSERT_TRUE(result.value().set_value("key_" + std::to_string(idx), KvsValue(idx)));
+    }
+    ASSERT_TRUE(result.value().flush());
+
+    /* Readers share the KVS lock, every value is decoded once by the first of them */
+    options.lazy_values = true;
+    result = Kvs::open(instance_id, OpenNeedDefaults::Optional, OpenNeedKvs::Required, std::string(data_dir), options);
+    ASSERT_TRUE(result);
+    Kvs& kvs = result.value();
+    std::atomic<size_t> failures{0};
+    std::vector<std::thread> readers;
+    for (size_t reader = 0; reader < 4U; ++reader) {
+        readers.emplace_back([&kvs, &failures]() {
+            for (int32_t idx = 0; idx < 64; ++idx) {
+                auto value = kvs.get_value("key_" + std::to_string(idx));
+                if ((!value) || (value.value() != KvsValue(idx))) {
+                    ++failures;
+                }
+            }
+        });
+    }
+    for (auto& reader : readers) {
+        reader.join();
+    }
+    EXPECT_EQ(failures.load(), 0U);
+
+    cleanup_environment();
+}
+
+TEST(kvs_lazy_values, log_replay_and_invalid_value){
+
+    prepare_environment();
+    KvsOptions options;
+    auto result = Kvs::open(instance_id, OpenNeedDefaults::Optional, OpenNeedKvs::Required, std::string(data_dir), options);
+    ASSERT_TRUE(result);
+    ASSERT_TRUE(result.value().set_value("kept", KvsValue(1.0)));
+    ASSERT_TRUE(result.value().flush()); /* Full flush */
+    options.flush_mode = KvsFlushMode::Incremental;
+    result = Kvs::open(instance_id, OpenNeedDefaults::Optional, OpenNeedKvs::Required, std::string(data_dir), options);
+    ASSERT_TRUE(result);
+    ASSERT_TRUE(result.value().remove_key("kvs"));
+    ASSERT_TRUE(result.value().set_value("logged", KvsValue(true)));
+    ASSERT_TRUE(result.value().flush()); /* Appended to the log */
+
+    /* The logged keys replace the indexed values */
+    options.lazy_values = true;
+    result = Kvs::open(instance_id, OpenNeedDefaults::Optional, OpenNeedKvs::Required, std::string(data_dir), options);
+    ASSERT_TRUE(result);
+    EXPECT_EQ(result.value().lazy_kvs.size(), 1U);
+    EXPECT_TRUE(result.value().kvs.count("logged"));
+    auto exists = result.value().key_exists("kvs");
+    ASSERT_TRUE(exists);
+    EXPECT_FALSE(exists.value());
+    auto value = result.value().get_value("kept");
+    ASSERT_TRUE(value);
+    EXPECT_EQ(value.value(), KvsValue(1.0));
+
+    /* An invalid value fails its access instead of open */
+    const std::string invalid_json = R"({"valid": {"t": "i32", "v": 1}, "invalid": {"t": "unknown", "v": 0}})";
+    std::ofstream invalid_json_file(kvs_prefix + ".json");
+    invalid_json_file << invalid_json;
+    invalid_json_file.close();
+    uint32_t kvs_hash = adler32(invalid_json);
+    std::ofstream kvs_hash_file(kvs_prefix + ".hash", std::ios::binary);
+    kvs_hash_file.put((kvs_hash >> 24) & 0xFF);
+    kvs_hash_file.put((kvs_hash >> 16) & 0xFF);
+    kvs_hash_file.put((kvs_hash >> 8)  & 0xFF);
+    kvs_hash_file.put(kvs_hash & 0xFF);
+    kvs_hash_file.close();
+    std::filesystem::remove(filename_prefix + "_0.log");
+
+    options.flush_mode = KvsFlushMode::Full;
+    result = Kvs::open(instance_id, OpenNeedDefaults::Optional, OpenNeedKvs::Required, std::string(data_dir), options);
+    ASSERT_TRUE(result);
+    ASSERT_TRUE(result.value().get_value("valid"));
+    value = result.value().get_value("invalid");
+    ASSERT_FALSE(value);
+    EXPECT_EQ(static_cast<ErrorCode>(*value.error()), ErrorCode::InvalidValueType);
+    auto flush_res = result.value().flush();
+    ASSERT_FALSE(flush_res);
+    EXPECT_EQ(static_cast<ErrorCode>(*flush_res.error()), ErrorCode::InvalidValueType);
+
+    /* Without lazy values open fails */
+    options.lazy_values = false;
+    result = Kvs::open(instance_id, OpenNeedDefaults::Optional, OpenNeedKvs::Required, std::string(data_dir), options);
+    ASSERT_FALSE(result);
+
+    cleanup_environment();
+}
+
+TEST(kvs_sharing, owner_and_reader){
+
+    prepare_environment();
+    const std::string segment = SharedStore::segment_name(filename_prefix);
+    ASSERT_TRUE(SharedStore::remove(segment)); /* Segment of a previous test run */
+    KvsOptions options;
+    options.sharing = KvsSharing::Reader;
+    auto no_owner = Kvs::open(instance_id, OpenNeedDefaults::Optional, OpenNeedKvs::Optional, std::string(data_dir), options);
+    ASSERT_FALSE(no_owner);
+    EXPECT_EQ(static_cast<ErrorCode>(*no_owner.error()), ErrorCode::FileNotFound);
+
+    /* Open publishes the data of the owner */
+    options.sharing = KvsSharing::Owner;
+    auto owner = Kvs::open(instance_id, OpenNeedDefaults::Optional, OpenNeedKvs::Required, std::string(data_dir), options);
+    ASSERT_TRUE(owner);
+    auto second_owner = Kvs::open(instance_id, OpenNeedDefaults::Optional, OpenNeedKvs::Required, std::string(data_dir), options);
+    ASSERT_FALSE(second_owner);
+    EXPECT_EQ(static_cast<ErrorCode>(*second_owner.error()), ErrorCode::ResourceBusy);
+
+    options.sharing = KvsSharing::Reader;
+    auto reader_res = Kvs::open(instance_id, OpenNeedDefaults::Optional, OpenNeedKvs::Required, std::string(data_dir), options);
+    ASSERT_TRUE(reader_res);
+    Kvs reader = std::move(reader_res.value());
+    EXPECT_TRUE(reader.kvs.empty()); /* No copy of the data on the heap of the reader */
+    auto keys = reader.get_all_keys();
+    ASSERT_TRUE(keys);
+    EXPECT_EQ(keys.value(), owner.value().get_all_keys().value());
+    auto value = reader.get_value("kvs");
+    ASSERT_TRUE(value);
+    EXPECT_EQ(value.value(), owner.value().get_value("kvs").value());
+    auto default_value = reader.get_value("default"); /* Defaults are looked up in the mapped image by the reader */
+    ASSERT_TRUE(default_value);
+    EXPECT_EQ(default_value.value(), KvsValue(int32_t(5)));
+    EXPECT_TRUE(reader.default_values.empty()); /* No copy of the defaults on the heap of the reader */
+    ASSERT_NE(reader.default_image, nullptr);
+    EXPECT_TRUE(std::filesystem::exists(filename_prefix + "_default.img"));
+    EXPECT_TRUE(reader.is_value_default("default").value());
+    EXPECT_EQ(reader.get_default_value("default").value(), KvsValue(int32_t(5)));
+    auto second_reader = Kvs::open(instance_id, OpenNeedDefaults::Optional, OpenNeedKvs::Required, std::string(data_dir), options);
+    ASSERT_TRUE(second_reader);
+    EXPECT_TRUE(second_reader.value().default_values.empty()); /* Maps the image built by the first reader */
+    ASSERT_NE(second_reader.value().default_image, nullptr);
+    EXPECT_EQ(second_reader.value().get_value("default").value(), KvsValue(int32_t(5)));
+
+    /* Changes are visible after the next publish or flush */
+    ASSERT_TRUE(owner.value().set_value("shared.a", KvsValue(1.0)));
+    EXPECT_FALSE(reader.key_exists("shared.a").value());
+    ASSERT_TRUE(owner.value().publish());
+    EXPECT_TRUE(reader.key_exists("shared.a").value());
+    ASSERT_TRUE(owner.value().set_value("shared.b", KvsValue("two")));
+    ASSERT_TRUE(owner.value().remove_key("kvs"));
+    ASSERT_TRUE(owner.value().flush());
+    EXPECT_FALSE(reader.key_exists("kvs").value());
+    auto string_value = reader.get_value_as<std::string>("shared.b");
+    ASSERT_TRUE(string_value);
+    EXPECT_EQ(string_value.value(), "two");
+    std::vector<std::string> scanned;
+    ASSERT_TRUE(reader.scan_prefix("shared.", [&scanned](const std::string& key, const KvsValue&) { scanned.push_back(key); }));
+    EXPECT_EQ(scanned, (std::vector<std::string>{"shared.a", "shared.b"}));
+
+    /* Writes of a reader fail, they have to be forwarded to the owner */
+    const auto expect_read_only = [](const score::ResultBlank& write_res) {
+        ASSERT_FALSE(write_res);
+        EXPECT_EQ(static_cast<ErrorCode>(*write_res.error()), ErrorCode::ReadOnly);
+    };
+    expect_read_only(reader.set_value("shared.a", KvsValue(2.0)));
+    expect_read_only(reader.emplace_value("shared.a", 2.0));
+    expect_read_only(reader.remove_key("shared.a"));
+    expect_read_only(reader.reset_key("default"));
+    expect_read_only(reader.reset());
+    KvsWriteBatch batch;
+    batch.remove_key("shared.a");
+    expect_read_only(reader.write(std::move(batch)));
+    expect_read_only(reader.flush());
+    expect_read_only(reader.publish());
+    expect_read_only(reader.snapshot_restore(1));
+    EXPECT_EQ(owner.value().get_value("shared.a").value(), KvsValue(1.0));
+
+    /* Private instances publish nothing */
+    options.sharing = KvsSharing::Private;
+    auto private_res = Kvs::open(instance_id, OpenNeedDefaults::Optional, OpenNeedKvs::Required, std::string(data_dir), options);
+    ASSERT_TRUE(private_res);
+    EXPECT_EQ(private_res.value().shared, nullptr);
+    EXPECT_TRUE(private_res.value().publish());
+
+    /* The segment outlives the owner, the attached reader sees the data of the restarted owner */
+    Kvs closed = std::move(owner.value());
+    closed = std::move(private_res.value());
+    EXPECT_TRUE(reader.key_exists("shared.a").value());
+    options.sharing = KvsSharing::Owner;
+    {
+        auto restarted = Kvs::open(instance_id, OpenNeedDefaults::Optional, OpenNeedKvs::Required, std::string(data_dir), options);
+        ASSERT_TRUE(restarted);
+        ASSERT_TRUE(restarted.value().set_value("shared.c", KvsValue(3.0)));
+        ASSERT_TRUE(restarted.value().publish());
+        EXPECT_EQ(reader.get_value("shared.c").value(), KvsValue(3.0));
+    }
+
+    /* A too small segment fails the open of the owner (a removed segment is created with the new size) */
+    ASSERT_TRUE(SharedStore::remove(segment));
+    options.shared_size = 1;
+    auto too_small = Kvs::open(instance_id, OpenNeedDefaults::Optional, OpenNeedKvs::Required, std::string(data_dir), options);
+    ASSERT_FALSE(too_small);
+    EXPECT_EQ(static_cast<ErrorCode>(*too_small.error()), ErrorCode::OutOfStorageSpace);
+
+    EXPECT_TRUE(SharedStore::remove(segment));
+    cleanup_environment();
+}
+
+TEST(kvs_sharing, flush_publish_failure){
+
+    prepare_environment();
+    const std::string segment = SharedStore::segment_name(filename_prefix);
+    ASSERT_TRUE(SharedStore::remove(segment));
+    KvsOptions options;
+    options.sharing = KvsSharing::Owner;
+    options.shared_size = 4096;
+    auto owner = Kvs::open(instance_id, OpenNeedDefaults::Optional, OpenNeedKvs::Required, std::string(data_dir), options);
+    ASSERT_TRUE(owner);
+
+    /* Data larger than the segment is still flushed, only the publish fails */
+    ASSERT_TRUE(owner.value().set_value("large", KvsValue(std::string(8192, 'x'))));
+    ASSERT_TRUE(owner.value().flush());
+    auto reopened = Kvs::open(instance_id, OpenNeedDefaults::Optional, OpenNeedKvs::Required, std::string(data_dir));
+    ASSERT_TRUE(reopened);
+    EXPECT_TRUE(reopened.value().key_exists("large").value());
+    if constexpr (KVS_STATS_ENABLED) {
+        EXPECT_EQ(owner.value().stats().counter(KvsCounter::PublishFailure), 1U);
+        EXPECT_EQ(owner.value().stats().counter(KvsCounter::FlushFailure), 0U);
+    }
+    auto publish_res = owner.value().publish();
+    ASSERT_FALSE(publish_res);
+    EXPECT_EQ(static_cast<ErrorCode>(*publish_res.error()), ErrorCode::OutOfStorageSpace);
+
+    EXPECT_TRUE(SharedStore::remove(segment));
+    cleanup_environment();
+}
+
+TEST(kvs_subscribe, notified_changes){
+
+    prepare_environment();
+    auto result = Kvs::open(instance_id, OpenNeedDefaults::Optional, OpenNeedKvs::Required, std::string(data_dir), KvsOptions());
+    ASSERT_TRUE(result);
+    Kvs& kvs = result.value();
+
+    std::mutex changes_mutex;
+    std::vector<std::pair<std::string, std::optional<KvsValue>>> key_changes;
+    std::vector<std::string> prefix_changes;
+    auto key_id = kvs.subscribe("default", [&](const std::vector<KvsChange>& changes) {
+        std::lock_guard<std::mutex> lock(changes_mutex);
+        for (const auto& change : changes) {
+            key_changes.emplace_back(change.key, change.value);
+        }
+    });
+    ASSERT_TRUE(key_id);
+    auto prefix_id = kvs.subscribe_prefix("cal.", [&](const std::vector<KvsChange>& changes) {
+        std::lock_guard<std::mutex> lock(changes_mutex);
+        for (const auto& change : changes) {
+            prefix_changes.push_back(change.key);
+        }
+    });
+    ASSERT_TRUE(prefix_id);
+    auto no_callback = kvs.subscribe("default", nullptr);
+    ASSERT_FALSE(no_callback);
+    EXPECT_EQ(static_cast<ErrorCode>(*no_callback.error()), ErrorCode::ValidationFailed);
+
+    /* Every writer notifies its changes, unrelated keys are not delivered */
+    ASSERT_TRUE(kvs.set_value("default", KvsValue(7.0)));
+    ASSERT_TRUE(kvs.set_value(std::string("cal.a"), KvsValue(1.0)));
+    ASSERT_TRUE(kvs.emplace_value("cal.b", 2.0));
+    ASSERT_TRUE(kvs.set_value("other", KvsValue(3.0)));
+    ASSERT_TRUE(kvs.reset_key("default"));
+    ASSERT_TRUE(kvs.remove_key("cal.a"));
+    KvsWriteBatch batch;
+    batch.set_value("cal.c", KvsValue(4.0));
+    batch.remove_key("cal.b");
+    ASSERT_TRUE(kvs.write(std::move(batch)));
+    kvs.wait_notifications();
+    {
+        std::lock_guard<std::mutex> lock(changes_mutex);
+        ASSERT_EQ(key_changes.size(), 2U);
+        EXPECT_EQ(key_changes[0].second, std::optional<KvsValue>(KvsValue(7.0)));
+        EXPECT_FALSE(key_changes[1].second.has_value()); /* Reset to the default */
+        EXPECT_EQ(prefix_changes, (std::vector<std::string>{"cal.a", "cal.b", "cal.a", "cal.c", "cal.b"}));
+        prefix_changes.clear();
+    }
+
+    /* A restore only notifies the keys that differ from the snapshot */
+    ASSERT_TRUE(kvs.flush());
+    ASSERT_TRUE(kvs.set_value("cal.c", KvsValue(5.0)));
+    ASSERT_TRUE(kvs.set_value("cal.d", KvsValue(6.0)));
+    ASSERT_TRUE(kvs.flush());
+    kvs.wait_notifications();
+    prefix_changes.clear();
+    ASSERT_TRUE(kvs.snapshot_restore(1));
+    kvs.wait_notifications();
+    {
+        std::lock_guard<std::mutex> lock(changes_mutex);
+        EXPECT_EQ(prefix_changes, (std::vector<std::string>{"cal.d", "cal.c"}));
+        prefix_changes.clear();
+    }
+
+    /* Reset removes all keys, removed subscriptions aren't called anymore */
+    ASSERT_TRUE(kvs.unsubscribe(key_id.value()));
+    auto unknown = kvs.unsubscribe(key_id.value());
+    ASSERT_FALSE(unknown);
+    EXPECT_EQ(static_cast<ErrorCode>(*unknown.error()), ErrorCode::KeyNotFound);
+    ASSERT_TRUE(kvs.set_value("default", KvsValue(8.0)));
+    ASSERT_TRUE(kvs.reset());
+    kvs.wait_notifications();
+    {
+        std::lock_guard<std::mutex> lock(changes_mutex);
+        EXPECT_EQ(key_changes.size(), 2U);
+        EXPECT_EQ(prefix_changes, (std::vector<std::string>{"cal.c"}));
+    }
+
+    cleanup_environment();
+}
+
+TEST(kvs_backend, memory_backend_kvs){
+
+    cleanup_environment();
+    auto backend = std::make_shared<KvsMemoryBackend>();
+    ASSERT_TRUE(backend->write(default_prefix + ".json", default_json, false));
+    ASSERT_TRUE(backend->write(default_prefix + ".hash",
+                               get_hash_file_content(KvsHashAlgorithm::Adler32, calculate_hash_adler32(default_json)), false));
+
+    /* Defaults, flushes and snapshots only use the files of the backend (no defaults image without mapped files) */
+    {
+        auto result = KvsBuilder(instance_id).dir(std::string(data_dir)).need_defaults_flag(true)
+                          .mapped_defaults_flag(true).backend(backend).build();
+        ASSERT_TRUE(result);
+        Kvs& kvs = result.value();
+        auto default_res = kvs.get_default_value("default");
+        ASSERT_TRUE(default_res);
+        EXPECT_EQ(std::get<int32_t>(default_res.value().getValue()), 5);
+        ASSERT_TRUE(kvs.set_value("key", KvsValue(1.0)));
+        ASSERT_TRUE(kvs.flush());
+        ASSERT_TRUE(kvs.set_value("key", KvsValue(2.0)));
+        ASSERT_TRUE(kvs.flush());
+        auto count_res = kvs.snapshot_count();
+        ASSERT_TRUE(count_res);
+        EXPECT_EQ(count_res.value(), 1U);
+        EXPECT_TRUE(kvs.sync());
+    }
+    EXPECT_TRUE(backend->exists(kvs_prefix + ".json").value());
+    EXPECT_TRUE(backend->exists(filename_prefix + "_1.json").value());
+    EXPECT_FALSE(backend->exists(default_prefix + ".img").value());
+    EXPECT_FALSE(std::filesystem::exists(data_dir));
+
+    /* Reopened from the same backend, the incremental flush appends to the log of the backend */
+    {
+        auto result = KvsBuilder(instance_id).dir(std::string(data_dir)).need_kvs_flag(true)
+                          .flush_mode(KvsFlushMode::Incremental).backend(backend).build();
+        ASSERT_TRUE(result);
+        Kvs& kvs = result.value();
+        auto value_res = kvs.get_value("key");
+        ASSERT_TRUE(value_res);
+        EXPECT_EQ(std::get<double>(value_res.value().getValue()), 2.0);
+        ASSERT_TRUE(kvs.set_value("logged", KvsValue(3.0)));
+        ASSERT_TRUE(kvs.flush());
+        EXPECT_TRUE(backend->exists(filename_prefix + "_0.log").value());
+    }
+    {
+        auto result = KvsBuilder(instance_id).dir(std::string(data_dir)).need_kvs_flag(true).backend(backend).build();
+        ASSERT_TRUE(result);
+        Kvs& kvs = result.value();
+        auto value_res = kvs.get_value("logged");
+        ASSERT_TRUE(value_res);
+        EXPECT_EQ(std::get<double>(value_res.value().getValue()), 3.0);
+        ASSERT_TRUE(kvs.snapshot_restore(1));
+        value_res = kvs.get_value("key");
+        ASSERT_TRUE(value_res);
+        EXPECT_EQ(std::get<double>(value_res.value().getValue()), 1.0);
+    }
+    EXPECT_FALSE(std::filesystem::exists(data_dir));
+}
+
+TEST(kvs_stats, operations_recorded){
+
+    prepare_environment();
+    std::mutex traced_mutex;
+    std::vector<KvsOperation> traced;
+    auto result = KvsBuilder(instance_id).dir(std::string(data_dir)).need_kvs_flag(true)
+                      .trace_hook([&](KvsOperation operation, std::chrono::steady_clock::time_point, std::chrono::nanoseconds) {
+                          std::lock_guard<std::mutex> lock(traced_mutex);
+                          traced.push_back(operation);
+                      }).build();
+    ASSERT_TRUE(result);
+    Kvs& kvs = result.value();
+
+    /* Open read and parsed the defaults and the KVS file */
+    KvsStats stats = kvs.stats();
+    const uint64_t expected_open = KVS_STATS_ENABLED ? 1U : 0U;
+    EXPECT_EQ(stats.latency(KvsOperation::Open).count, expected_open);
+    EXPECT_EQ(stats.latency(KvsOperation::HashVerify).count, 2U * expected_open);
+    EXPECT_EQ(stats.latency(KvsOperation::Parse).count, 2U * expected_open);
+    EXPECT_EQ(stats.latency(KvsOperation::Flush).count, 0U);
+
+    ASSERT_TRUE(kvs.set_value("key", KvsValue(1.0)));
+    ASSERT_TRUE(kvs.flush());
+    ASSERT_TRUE(kvs.flush());
+    ASSERT_TRUE(kvs.snapshot_restore(1));
+    {
+        /* A failed lock attempt is counted */
+        std::unique_lock<std::shared_mutex> lock(kvs.kvs_mutex);
+        auto get_res = kvs.get_value("key");
+        ASSERT_FALSE(get_res);
+        EXPECT_EQ(static_cast<ErrorCode>(*get_res.error()), ErrorCode::MutexLockFailed);
+    }
+    stats = kvs.stats();
+    EXPECT_EQ(stats.latency(KvsOperation::Flush).count, 2U * expected_open);
+    EXPECT_EQ(stats.latency(KvsOperation::SnapshotRotate).count, 2U * expected_open);
+    EXPECT_EQ(stats.latency(KvsOperation::SnapshotRestore).count, expected_open);
+    EXPECT_GE(stats.latency(KvsOperation::Flush).max_ns, stats.latency(KvsOperation::SnapshotRotate).max_ns);
+    EXPECT_EQ(stats.counter(KvsCounter::LockFailure), expected_open);
+    EXPECT_EQ(stats.counter(KvsCounter::FlushFailure), 0U);
+    {
+        std::lock_guard<std::mutex> lock(traced_mutex);
+        const size_t operations = KVS_STATS_ENABLED ? 12U : 0U; /* 5 (open) + 2 * 2 (flush) + 3 (restore reads snapshot 1) */
+        EXPECT_EQ(traced.size(), operations);
+    }
+
+    /* Corrupted KVS file */
+    system(("echo '{}' > " + kvs_prefix + ".json").c_str());
+    kvs.reset_stats();
+    EXPECT_EQ(kvs.stats().latency(KvsOperation::Flush).count, 0U);
+    auto corrupt_res = kvs.open_json(score::filesystem::Path(kvs_prefix), OpenJsonNeedFile::Required);
+    EXPECT_FALSE(corrupt_res);
+    EXPECT_EQ(kvs.stats().counter(KvsCounter::ValidationFailure), expected_open);
+
+    cleanup_environment();
+}
+
+TEST(kvs_key_handle, get_set_and_invalidation){
+
+    prepare_environment();
+    auto result = KvsBuilder(instance_id).dir(std::string(data_dir)).need_kvs_flag(true).build();
+    ASSERT_TRUE(result);
+    Kvs& kvs = result.value();
+
+    KeyHandle written = kvs.resolve("kvs");
+    KeyHandle with_default = kvs.resolve("default");
+    KeyHandle missing = kvs.resolve("new");
+    EXPECT_EQ(missing.key(), "new");
+    auto value_res = kvs.get_value(written);
+    ASSERT_TRUE(value_res);
+    EXPECT_EQ(std::get<int32_t>(value_res.value().getValue()), 2);
+    value_res = kvs.get_value(with_default);
+    ASSERT_TRUE(value_res);
+    EXPECT_EQ(std::get<int32_t>(value_res.value().getValue()), 5);
+    value_res = kvs.get_value(missing);
+    ASSERT_FALSE(value_res);
+    EXPECT_EQ(static_cast<ErrorCode>(*value_res.error()), ErrorCode::KeyNotFound);
+
+    /* Overwriting a key keeps all handles valid, adding a key only updates the handle used */
+    const uint64_t generation = kvs.key_generation;
+    ASSERT_TRUE(kvs.set_value(written, KvsValue(static_cast<int32_t>(3))));
+    EXPECT_EQ(kvs.key_generation, generation);
+    ASSERT_TRUE(kvs.set_value(missing, KvsValue(1.0)));
+    EXPECT_NE(kvs.key_generation, generation);
+    EXPECT_EQ(missing.generation, kvs.key_generation);
+    EXPECT_NE(written.generation, kvs.key_generation);
+    value_res = kvs.get_value("new");
+    ASSERT_TRUE(value_res);
+    EXPECT_EQ(std::get<double>(value_res.value().getValue()), 1.0);
+    auto typed_res = kvs.get_value_as<int32_t>(written);
+    ASSERT_TRUE(typed_res);
+    EXPECT_EQ(typed_res.value(), 3);
+    EXPECT_EQ(written.generation, kvs.key_generation);
+    auto double_res = kvs.get_value_as<double>(missing);
+    ASSERT_TRUE(double_res);
+    EXPECT_EQ(double_res.value(), 1.0);
+    auto conversion_res = kvs.get_value_as<int32_t>(missing);
+    ASSERT_FALSE(conversion_res);
+    EXPECT_EQ(static_cast<ErrorCode>(*conversion_res.error()), ErrorCode::ConversionFailed);
+
+    /* Removed keys are looked up again */
+    ASSERT_TRUE(kvs.remove_key("new"));
+    value_res = kvs.get_value(missing);
+    ASSERT_FALSE(value_res);
+    EXPECT_EQ(static_cast<ErrorCode>(*value_res.error()), ErrorCode::KeyNotFound);
+    ASSERT_TRUE(kvs.set_value(with_default, KvsValue(static_cast<int32_t>(7))));
+    bool visited = false;
+    ASSERT_TRUE(kvs.visit_value(with_default, [&visited](const KvsValue& value) {
+        visited = (7 == std::get<int32_t>(value.getValue()));
+    }));
+    EXPECT_TRUE(visited);
+    ASSERT_TRUE(kvs.reset_key("default"));
+    value_res = kvs.get_value(with_default);
+    ASSERT_TRUE(value_res);
+    EXPECT_EQ(std::get<int32_t>(value_res.value().getValue()), 5);
+    ASSERT_TRUE(kvs.reset());
+    value_res = kvs.get_value(written);
+    ASSERT_FALSE(value_res);
+    EXPECT_EQ(static_cast<ErrorCode>(*value_res.error()), ErrorCode::KeyNotFound);
+
+    {
+        std::unique_lock<std::shared_mutex> lock(kvs.kvs_mutex);
+        value_res = kvs.get_value(with_default);
+        ASSERT_FALSE(value_res);
+        EXPECT_EQ(static_cast<ErrorCode>(*value_res.error()), ErrorCode::MutexLockFailed);
+        auto set_res = kvs.set_value(with_default, KvsValue(1.0));
+        ASSERT_FALSE(set_res);
+        EXPECT_EQ(static_cast<ErrorCode>(*set_res.error()), ErrorCode::MutexLockFailed);
+    }
+
+    /* Handles of a moved KVS are looked up in the KVS they are used with */
+    ASSERT_TRUE(kvs.set_value(written, KvsValue(static_cast<int32_t>(4))));
+    Kvs moved = std::move(kvs);
+    value_res = moved.get_value(written);
+    ASSERT_TRUE(value_res);
+    EXPECT_EQ(std::get<int32_t>(value_res.value().getValue()), 4);
+    EXPECT_EQ(written.owner, &moved);
+    value_res = kvs.get_value(written);
+    ASSERT_FALSE(value_res);
+    EXPECT_EQ(written.owner, &kvs);
+
+    cleanup_environment();
+}
+
+TEST(kvs_key_handle, new_kvs_at_same_address){
+
+    prepare_environment();
+    std::optional<Kvs> kvs;
+    auto result = KvsBuilder(instance_id).dir(std::string(data_dir)).need_kvs_flag(true).build();
+    ASSERT_TRUE(result);
+    kvs.emplace(std::move(result.value()));
+    const Kvs* address = &kvs.value();
+    KeyHandle handle = kvs.value().resolve("kvs");
+    auto value_res = kvs.value().get_value(handle);
+    ASSERT_TRUE(value_res);
+    EXPECT_EQ(std::get<int32_t>(value_res.value().getValue()), 2);
+
+    /* A KVS opened the same way at the same address doesn't take over the entries of the destroyed one */
+    kvs.reset();
+    result = KvsBuilder(instance_id).dir(std::string(data_dir)).need_kvs_flag(true).build();
+    ASSERT_TRUE(result);
+    kvs.emplace(std::move(result.value()));
+    ASSERT_EQ(&kvs.value(), address);
+    ASSERT_TRUE(kvs.value().set_value("kvs", KvsValue(static_cast<int32_t>(9))));
+    EXPECT_NE(handle.generation, kvs.value().key_generation);
+    value_res = kvs.value().get_value(handle);
+    ASSERT_TRUE(value_res);
+    EXPECT_EQ(std::get<int32_t>(value_res.value().getValue()), 9);
+    ASSERT_NE(handle.slot, kvs.value().slots.end());
+    ASSERT_TRUE(handle.slot->second.value.has_value());
+    EXPECT_EQ(handle.slot->second.value.value(), kvs.value().kvs.find("kvs"));
+
+    cleanup_environment();
+}
+
+TEST(kvs_key_handle, lazy_values){
+
+    prepare_environment();
+    KvsOptions options;
+    auto result = Kvs::open(instance_id, OpenNeedDefaults::Optional, OpenNeedKvs::Required, std::string(data_dir), options);
+    ASSERT_TRUE(result);
+    ASSERT_TRUE(result.value().set_value("number", KvsValue(2.0)));
+    ASSERT_TRUE(result.value().flush());
+
+    options.lazy_values = true;
+    result = Kvs::open(instance_id, OpenNeedDefaults::Optional, OpenNeedKvs::Required, std::string(data_dir), options);
+    ASSERT_TRUE(result);
+    Kvs& kvs = result.value();
+    KeyHandle handle = kvs.resolve("number");
+    ASSERT_EQ(kvs.lazy_kvs.size(), 2U);
+
+    /* The indexed value is decoded by the first access through the handle, a write replaces it */
+    auto value_res = kvs.get_value(handle);
+    ASSERT_TRUE(value_res);
+    EXPECT_EQ(std::get<double>(value_res.value().getValue()), 2.0);
+    EXPECT_TRUE(kvs.lazy_kvs.at("number").value.has_value());
+    ASSERT_TRUE(kvs.set_value(handle, KvsValue(3.0)));
+    EXPECT_EQ(kvs.lazy_kvs.count("number"), 0U);
+    EXPECT_EQ(kvs.kvs.count("number"), 1U);
+    value_res = kvs.get_value(handle);
+    ASSERT_TRUE(value_res);
+    EXPECT_EQ(std::get<double>(value_res.value().getValue()), 3.0);
+
+    /* The full flush moves the remaining indexed values into the map */
+    KeyHandle indexed = kvs.resolve("kvs");
+    ASSERT_TRUE(kvs.flush());
+    EXPECT_TRUE(kvs.lazy_kvs.empty());
+    value_res = kvs.get_value(indexed);
+    ASSERT_TRUE(value_res);
+    EXPECT_EQ(std::get<int32_t>(value_res.value().getValue()), 2);
+    ASSERT_NE(indexed.slot, kvs.slots.end());
+    ASSERT_TRUE(indexed.slot->second.value.has_value());
+    EXPECT_FALSE(indexed.slot->second.lazy.has_value());
+    EXPECT_EQ(indexed.slot->second.value.value(), kvs.kvs.find("kvs"));
+
+    cleanup_environment();
+}
+
+TEST(kvs_is_value_default, written_default_and_missing){
+
+    prepare_environment();
+    auto result = KvsBuilder(instance_id).dir(std::string(data_dir)).need_kvs_flag(true).build();
+    ASSERT_TRUE(result);
+    Kvs& kvs = result.value();
+
+    auto default_res = kvs.is_value_default("default");
+    ASSERT_TRUE(default_res);
+    EXPECT_TRUE(default_res.value());
+    default_res = kvs.is_value_default("kvs");
+    ASSERT_TRUE(default_res);
+    EXPECT_FALSE(default_res.value());
+    default_res = kvs.is_value_default("missing");
+    ASSERT_FALSE(default_res);
+    EXPECT_EQ(static_cast<ErrorCode>(*default_res.error()), ErrorCode::KeyNotFound);
+
+    /* Written over the default and reset through a handle */
+    KeyHandle handle = kvs.resolve("default");
+    ASSERT_TRUE(kvs.set_value("default", KvsValue(static_cast<int32_t>(6))));
+    default_res = kvs.is_value_default(handle);
+    ASSERT_TRUE(default_res);
+    EXPECT_FALSE(default_res.value());
+    ASSERT_TRUE(kvs.reset_key(handle));
+    EXPECT_EQ(kvs.kvs.count("default"), 0U);
+    default_res = kvs.is_value_default("default");
+    ASSERT_TRUE(default_res);
+    EXPECT_TRUE(default_res.value());
+    ASSERT_TRUE(kvs.reset_key(handle)); /* Not written, nothing to reset */
+    auto value_res = kvs.get_value(handle);
+    ASSERT_TRUE(value_res);
+    EXPECT_EQ(std::get<int32_t>(value_res.value().getValue()), 5);
+
+    KeyHandle without_default = kvs.resolve("kvs");
+    auto reset_res = kvs.reset_key(without_default);
+    ASSERT_FALSE(reset_res);
+    EXPECT_EQ(static_cast<ErrorCode>(*reset_res.error()), ErrorCode::KeyDefaultNotFound);
+    EXPECT_EQ(kvs.kvs.count("kvs"), 1U);
+    KeyHandle missing = kvs.resolve("missing");
+    default_res = kvs.is_value_default(missing);
+    ASSERT_FALSE(default_res);
+    EXPECT_EQ(static_cast<ErrorCode>(*default_res.error()), ErrorCode::KeyNotFound);
+
+    {
+        std::unique_lock<std::shared_mutex> lock(kvs.kvs_mutex);
+        default_res = kvs.is_value_default("default");
+        ASSERT_FALSE(default_res);
+        EXPECT_EQ(static_cast<ErrorCode>(*default_res.error()), ErrorCode::MutexLockFailed);
+        reset_res = kvs.reset_key(handle);
+        ASSERT_FALSE(reset_res);
+        EXPECT_EQ(static_cast<ErrorCode>(*reset_res.error()), ErrorCode::MutexLockFailed);
+    }
+
+    cleanup_environment();
+}
+
+TEST(kvs_slots, written_and_default_entries){
+
+    prepare_environment();
+    auto result = KvsBuilder(instance_id).dir(std::string(data_dir)).need_kvs_flag(true).build();
+    ASSERT_TRUE(result);
+    Kvs& kvs = result.value();
+
+    /* One slot per key, it refers to the key string of the default or of the written value */
+    ASSERT_EQ(kvs.slots.size(), 2U);
+    auto slot = kvs.slots.find("default");
+    ASSERT_NE(slot, kvs.slots.end());
+    EXPECT_EQ(slot->first.data(), kvs.default_values.find("default")->first.data());
+    EXPECT_EQ(slot->second.default_value, &kvs.default_values.at("default"));
+    EXPECT_FALSE(slot->second.value.has_value());
+    slot = kvs.slots.find("kvs");
+    ASSERT_NE(slot, kvs.slots.end());
+    EXPECT_EQ(slot->first.data(), kvs.kvs.find("kvs")->first.data());
+    EXPECT_EQ(slot->second.default_value, nullptr);
+
+    /* A written default shares the slot (and the key string) of the default */
+    ASSERT_TRUE(kvs.set_value("default", KvsValue(static_cast<int32_t>(6))));
+    ASSERT_EQ(kvs.slots.size(), 2U);
+    slot = kvs.slots.find("default");
+    ASSERT_TRUE(slot->second.value.has_value());
+    EXPECT_EQ(slot->second.value.value(), kvs.kvs.find("default"));
+    EXPECT_EQ(slot->first.data(), kvs.default_values.find("default")->first.data());
+    auto value_res = kvs.get_value("default");
+    ASSERT_TRUE(value_res);
+    EXPECT_EQ(std::get<int32_t>(value_res.value().getValue()), 6);
+
+    /* Removing the written value keeps the slot of a default, a key without default loses its slot */
+    ASSERT_TRUE(kvs.remove_key("default"));
+    slot = kvs.slots.find("default");
+    ASSERT_NE(slot, kvs.slots.end());
+    EXPECT_FALSE(slot->second.value.has_value());
+    value_res = kvs.get_value("default");
+    ASSERT_TRUE(value_res);
+    EXPECT_EQ(std::get<int32_t>(value_res.value().getValue()), 5);
+    ASSERT_TRUE(kvs.set_value(std::string("new"), KvsValue(1.0)));
+    EXPECT_EQ(kvs.slots.find("new")->first.data(), kvs.kvs.find("new")->first.data());
+    ASSERT_TRUE(kvs.remove_key("new"));
+    ASSERT_TRUE(kvs.remove_key("kvs"));
+    EXPECT_EQ(kvs.slots.count("new"), 0U);
+    EXPECT_EQ(kvs.slots.count("kvs"), 0U);
+
+    /* Batches, reset() and snapshot_restore() keep the slots in line with the maps */
+    KvsWriteBatch batch;
+    batch.set_value("batch", KvsValue(2.0));
+    batch.remove_key("default");
+    ASSERT_TRUE(kvs.write(std::move(batch)));
+    ASSERT_EQ(kvs.slots.size(), 2U);
+    EXPECT_TRUE(kvs.slots.at("batch").value.has_value());
+    ASSERT_TRUE(kvs.flush());
+    ASSERT_TRUE(kvs.reset());
+    ASSERT_EQ(kvs.slots.size(), 1U);
+    EXPECT_NE(kvs.slots.at("default").default_value, nullptr);
+    ASSERT_TRUE(kvs.flush());
+    ASSERT_TRUE(kvs.snapshot_restore(SnapshotId(1)));
+    ASSERT_EQ(kvs.slots.size(), 2U);
+    value_res = kvs.get_value("batch");
+    ASSERT_TRUE(value_res);
+    EXPECT_EQ(std::get<double>(value_res.value().getValue()), 2.0);
+
+    /* The move takes the slots along, they still refer to the moved entries */
+    Kvs moved(std::move(kvs));
+    EXPECT_TRUE(kvs.slots.empty());
+    ASSERT_EQ(moved.slots.size(), 2U);
+    EXPECT_EQ(moved.slots.at("batch").value.value(), moved.kvs.find("batch"));
+    auto default_res = moved.is_value_default("default");
+    ASSERT_TRUE(default_res);
+    EXPECT_TRUE(default_res.value());
+
+    cleanup_environment();
+}
+
+/* First bytes of a KVS file (to check whether it is compressed) */
+static std::string read_file_head(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    std::string head(4, '\0');
+    in.read(&head[0], static_cast<std::streamsize>(head.size()));
+    head.resize(static_cast<size_t>(in.gcount()));
+    return head;
+}
+
+TEST(kvs_compression, flush_open_and_restore){
+
+    prepare_environment();
+    std::string large(10000, 'c');
+    auto result = KvsBuilder(instance_id).dir(std::string(data_dir)).need_kvs_flag(true).compression(KvsCompression::Lz4).build();
+    ASSERT_TRUE(result);
+    Kvs& kvs = result.value();
+    ASSERT_TRUE(kvs.set_value("large", KvsValue(large)));
+    ASSERT_TRUE(kvs.flush());
+    ASSERT_TRUE(kvs.set_value("kvs", KvsValue(static_cast<int32_t>(3))));
+    ASSERT_TRUE(kvs.flush());
+
+    /* The KVS file and the new snapshot are compressed under their usual names, the old snapshot isn't */
+    EXPECT_EQ(read_file_head(kvs_prefix + ".json"), "KVSZ");
+    EXPECT_EQ(read_file_head(filename_prefix + "_1.json"), "KVSZ");
+    EXPECT_EQ(read_file_head(filename_prefix + "_2.json").substr(0, 1), "{");
+    EXPECT_LT(std::filesystem::file_size(kvs_prefix + ".json"), large.size());
+
+    /* Compressed files are read without the option */
+    auto reopened = KvsBuilder(instance_id).dir(std::string(data_dir)).need_kvs_flag(true).build();
+    ASSERT_TRUE(reopened);
+    EXPECT_EQ(std::get<int32_t>(reopened.value().kvs.at("kvs").getValue()), 3);
+    EXPECT_EQ(std::get<std::string>(reopened.value().kvs.at("large").getValue()), large);
+
+    /* Restore of the compressed snapshot */
+    ASSERT_TRUE(kvs.snapshot_restore(1));
+    EXPECT_EQ(std::get<int32_t>(kvs.kvs.at("kvs").getValue()), 2);
+    EXPECT_EQ(std::get<std::string>(kvs.kvs.at("large").getValue()), large);
+
+    /* Lazy values are indexed in the decompressed data */
+    auto lazy = KvsBuilder(instance_id).dir(std::string(data_dir)).need_kvs_flag(true).lazy_values_flag(true).build();
+    ASSERT_TRUE(lazy);
+    auto value_res = lazy.value().get_value("large");
+    ASSERT_TRUE(value_res);
+    EXPECT_EQ(std::get<std::string>(value_res.value().getValue()), large);
+
+    /* Binary data is compressed the same way */
+    auto binary = KvsBuilder(instance_id).dir(std::string(data_dir)).need_kvs_flag(true)
+                      .storage_format(KvsStorageFormat::Binary).compression(KvsCompression::Lz4).build();
+    ASSERT_TRUE(binary);
+    ASSERT_TRUE(binary.value().flush());
+    EXPECT_EQ(read_file_head(kvs_prefix + ".bin"), "KVSZ");
+    auto binary_reopened = KvsBuilder(instance_id).dir(std::string(data_dir)).need_kvs_flag(true).build();
+    ASSERT_TRUE(binary_reopened);
+    EXPECT_EQ(std::get<std::string>(binary_reopened.value().kvs.at("large").getValue()), large);
+
+    cleanup_environment();
+}
+
+TEST(kvs_compression, malformed_compressed_file){
+
+    prepare_environment();
+    auto result = KvsBuilder(instance_id).dir(std::string(data_dir)).need_kvs_flag(true).build();
+    ASSERT_TRUE(result);
+
+    /* Valid hash, but the compressed data is truncated */
+    const std::string compressed = compress_data("{\"kvs\":{\"t\":\"i32\",\"v\":2}}", KvsCompression::Lz4);
+    ASSERT_TRUE(result.value().write_json_data(compressed.substr(0, compressed.size() - 4U)));
+    auto reopened = KvsBuilder(instance_id).dir(std::string(data_dir)).need_kvs_flag(true).build();
+    ASSERT_FALSE(reopened);
+    EXPECT_EQ(static_cast<ErrorCode>(*reopened.error()), ErrorCode::IntegrityCorrupted);
+
+    /* write_data compresses with the option */
+    result.value().options.compression = KvsCompression::Lz4;
+    ASSERT_TRUE(result.value().write_json_data("{\"kvs\":{\"t\":\"i32\",\"v\":4}}"));
+    EXPECT_EQ(read_file_head(kvs_prefix + ".json"), "KVSZ");
+    reopened = KvsBuilder(instance_id).dir(std::string(data_dir)).need_kvs_flag(true).build();
+    ASSERT_TRUE(reopened);
+    EXPECT_EQ(std::get<int32_t>(reopened.value().kvs.at("kvs").getValue()), 4);
+
+    cleanup_environment();
+}
@@ -0,0 +1,140 @@
+/********************************************************************************
+* Copyright (c) 2025 Contributors to the Eclipse Foundation
+*
+* See the NOTICE file(s) distributed with this work for additional
+* information regarding copyright ownership.
+*
+* This program and the accompanying materials are made available under the
+* terms of the Apache License Version 2.0 which is available at
+* https://www.apache.org/licenses/LICENSE-2.0
+*
+* SPDX-License-Identifier: Apache-2.0
+********************************************************************************/
+#include "test_kvs_general.hpp"
+
+/* Read a complete file of a backend */
+static std::string backend_read(KvsBackend& backend, const std::string& path) {
+    std::string data;
+    auto in = backend.open_read(path);
+    EXPECT_NE(in, nullptr);
+    if (nullptr != in) {
+        EXPECT_TRUE(read_stream(*in, data));
+    }
+    return data;
+}
+
+/* Operations every backend provides in the same way */
+static void check_backend_files(KvsBackend& backend, const std::string& dir) {
+    const std::string file = dir + "file";
+    const std::string renamed = dir + "renamed";
+    const std::string linked = dir + "linked";
+    ASSERT_TRUE(backend.create_directories(dir));
+    EXPECT_FALSE(backend.exists(file).value());
+    EXPECT_EQ(backend.open_read(file), nullptr);
+
+    ASSERT_TRUE(backend.write(file, "content", false));
+    EXPECT_TRUE(backend.exists(file).value());
+    EXPECT_EQ(backend_read(backend, file), "content");
+    ASSERT_TRUE(backend.append(file, "_appended"));
+    ASSERT_TRUE(backend.write(file + ".tmp", "synced", true));
+    EXPECT_TRUE(backend.sync(file));
+    EXPECT_TRUE(backend.sync_dir(file));
+    size_t size = 0;
+    ASSERT_TRUE(backend.size(file, size));
+    EXPECT_EQ(size, 16U);
+    ASSERT_TRUE(backend.truncate(file, 7));
+    EXPECT_EQ(backend_read(backend, file), "content");
+
+    /* Streams */
+    {
+        auto out = backend.open_write(renamed);
+        ASSERT_NE(out, nullptr);
+        *out << "stream";
+        out->write("ed", 2);
+    }
+    EXPECT_EQ(backend_read(backend, renamed), "streamed");
+
+    /* Rename replaces, link keeps the file */
+    ASSERT_TRUE(backend.rename(file, renamed));
+    EXPECT_FALSE(backend.exists(file).value());
+    EXPECT_EQ(backend_read(backend, renamed), "content");
+    ASSERT_TRUE(backend.link(renamed, linked));
+    EXPECT_EQ(backend_read(backend, renamed), "content");
+    EXPECT_EQ(backend_read(backend, linked), "content");
+
+    /* Missing files fail with ErrorCode::FileNotFound */
+    const auto expect_not_found = [](const score::ResultBlank& file_res) {
+        ASSERT_FALSE(file_res);
+        EXPECT_EQ(static_cast<ErrorCode>(*file_res.error()), ErrorCode::FileNotFound);
+    };
+    expect_not_found(backend.rename(file, renamed));
+    expect_not_found(backend.link(file, linked));
+    ASSERT_TRUE(backend.remove(renamed));
+    expect_not_found(backend.remove(renamed));
+    EXPECT_FALSE(backend.size(renamed, size));
+    EXPECT_FALSE(backend.truncate(renamed, 0));
+    EXPECT_TRUE(backend.remove(linked));
+    EXPECT_TRUE(backend.remove(file + ".tmp"));
+}
+
+TEST(kvs_backend, file_backend){
+    const std::string dir = data_dir + "backend/";
+    std::filesystem::remove_all(dir);
+    KvsFileBackend backend;
+    check_backend_files(backend, dir);
+    EXPECT_TRUE(backend.maps_files());
+    EXPECT_TRUE(std::filesystem::is_empty(dir));
+
+    /* A missing directory of the new name is a failure, not a missing file */
+    ASSERT_TRUE(backend.write(dir + "file", "content", false));
+    auto rename_res = backend.rename(dir + "file", dir + "missing/file");
+    ASSERT_FALSE(rename_res);
+    EXPECT_EQ(static_cast<ErrorCode>(*rename_res.error()), ErrorCode::PhysicalStorageFailure);
+    auto link_res = backend.link(dir + "file", dir + "missing/file");
+    ASSERT_FALSE(link_res);
+    EXPECT_EQ(static_cast<ErrorCode>(*link_res.error()), ErrorCode::PhysicalStorageFailure);
+    std::filesystem::remove_all(dir);
+}
+
+TEST(kvs_backend, memory_backend){
+    KvsMemoryBackend backend;
+    check_backend_files(backend, "memory/");
+    EXPECT_FALSE(backend.maps_files());
+    EXPECT_EQ(backend.file_count(), 0U);
+    EXPECT_FALSE(std::filesystem::exists("memory/"));
+}
+
+TEST(kvs_backend, memory_backend_shared_content){
+    KvsMemoryBackend backend;
+    ASSERT_TRUE(backend.write("file", "0123456789", false));
+
+    /* An opened file keeps its content, later changes replace the content of the file */
+    auto in = backend.open_read("file");
+    ASSERT_NE(in, nullptr);
+    ASSERT_TRUE(backend.append("file", "abc"));
+    ASSERT_TRUE(backend.link("file", "linked"));
+    ASSERT_TRUE(backend.truncate("linked", 2));
+    ASSERT_TRUE(backend.write("file", "replaced", false));
+    EXPECT_EQ(backend_read(backend, "linked"), "01");
+
+    /* Seekable, read_stream knows the size before reading */
+    in->seekg(4, std::ios::beg);
+    EXPECT_EQ(in->tellg(), std::streampos(4));
+    in->seekg(-2, std::ios::end);
+    EXPECT_EQ(in->tellg(), std::streampos(8));
+    in->seekg(0, std::ios::beg);
+    std::string data;
+    ASSERT_TRUE(read_stream(*in, data));
+    EXPECT_EQ(data, "0123456789");
+    EXPECT_EQ(backend_read(backend, "file"), "replaced");
+
+    /* A written stream creates the file immediately, the content replaces it when the stream is closed */
+    auto out = backend.open_write("created");
+    ASSERT_NE(out, nullptr);
+    *out << "content";
+    EXPECT_TRUE(backend.exists("created").value());
+    EXPECT_EQ(backend_read(backend, "created"), "");
+    out.reset();
+    EXPECT_EQ(backend_read(backend, "created"), "content");
+    EXPECT_EQ(backend.file_count(), 3U);
+}
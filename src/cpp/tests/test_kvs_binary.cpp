@@ -0,0 +1,209 @@
+/********************************************************************************
+* Copyright (c) 2025 Contributors to the Eclipse Foundation
+*
+* See the NOTICE file(s) distributed with this work for additional
+* information regarding copyright ownership.
+*
+* This program and the accompanying materials are made available under the
+* terms of the Apache License Version 2.0 which is available at
+* https://www.apache.org/licenses/LICENSE-2.0
+*
+* SPDX-License-Identifier: Apache-2.0
+********************************************************************************/
+#include "test_kvs_general.hpp"
+
+TEST(kvs_binary_encode, binary_encode_value_little_endian) {
+    /* Scalars are written as type tag + little-endian payload */
+    std::string out;
+    ASSERT_TRUE(binary_encode_value(KvsValue(static_cast<int32_t>(0x01020304)), out));
+    EXPECT_EQ(out, std::string("\x00\x04\x03\x02\x01", 5));
+
+    out.clear();
+    ASSERT_TRUE(binary_encode_value(KvsValue(static_cast<uint64_t>(0x0102030405060708)), out));
+    EXPECT_EQ(out, std::string("\x03\x08\x07\x06\x05\x04\x03\x02\x01", 9));
+
+    out.clear();
+    ASSERT_TRUE(binary_encode_value(KvsValue(std::string("abc")), out));
+    EXPECT_EQ(out, std::string("\x06\x03\x00\x00\x00" "abc", 8));
+
+    out.clear();
+    ASSERT_TRUE(binary_encode_value(KvsValue(nullptr), out));
+    EXPECT_EQ(out, std::string("\x07", 1));
+}
+
+TEST(kvs_binary_encode, binary_encode_map_header) {
+    KvsMap map;
+    map.emplace("key", KvsValue(true));
+    auto result = binary_encode_map(map);
+    ASSERT_TRUE(result);
+    EXPECT_EQ(result.value(), std::string("KVSB\x01\x00\x00\x00\x01\x00\x00\x00"
+                                          "\x03\x00\x00\x00" "key" "\x05\x01", 21));
+}
+
+TEST(kvs_binary_encode, binary_encode_invalid_type) {
+    BrokenKvsValue invalid;
+    std::string out;
+    auto result = binary_encode_value(invalid, out);
+    EXPECT_FALSE(result);
+    EXPECT_EQ(result.error(), ErrorCode::InvalidValueType);
+
+    /* Invalid values in array and object */
+    KvsValue::Array array;
+    array.push_back(std::make_shared<KvsValue>(42.0));
+    array.push_back(std::make_shared<KvsValue>(invalid));
+    KvsMap map;
+    map.emplace("array", KvsValue(array));
+    auto map_result = binary_encode_map(map);
+    EXPECT_FALSE(map_result);
+    EXPECT_EQ(map_result.error(), ErrorCode::InvalidValueType);
+
+    KvsValue::Object obj;
+    obj.emplace("invalid", std::make_shared<KvsValue>(invalid));
+    map.clear();
+    map.emplace("object", KvsValue(obj));
+    map_result = binary_encode_map(map);
+    EXPECT_FALSE(map_result);
+    EXPECT_EQ(map_result.error(), ErrorCode::InvalidValueType);
+}
+
+TEST(kvs_binary_decode, binary_roundtrip_all_types) {
+    KvsValue::Object inner;
+    inner.emplace("flag", std::make_shared<KvsValue>(false));
+    inner.emplace("name", std::make_shared<KvsValue>(std::string("inner")));
+    KvsValue::Array array;
+    array.push_back(std::make_shared<KvsValue>(static_cast<int32_t>(-1)));
+    array.push_back(std::make_shared<KvsValue>(KvsValue(inner)));
+    array.push_back(std::make_shared<KvsValue>(nullptr));
+
+    KvsMap map;
+    map.emplace("i32", KvsValue(std::numeric_limits<int32_t>::min()));
+    map.emplace("u32", KvsValue(std::numeric_limits<uint32_t>::max()));
+    map.emplace("i64", KvsValue(std::numeric_limits<int64_t>::min()));
+    map.emplace("u64", KvsValue(std::numeric_limits<uint64_t>::max()));
+    map.emplace("f64", KvsValue(-3.25));
+    map.emplace("bool", KvsValue(true));
+    map.emplace("str", KvsValue(std::string("binary\0data", 11)));
+    map.emplace("null", KvsValue(nullptr));
+    map.emplace("arr", KvsValue(array));
+    map.emplace("obj", KvsValue(inner));
+    map.emplace("", KvsValue(std::string("")));
+
+    auto encoded = binary_encode_map(map);
+    ASSERT_TRUE(encoded);
+    auto decoded = binary_decode_map(encoded.value());
+    ASSERT_TRUE(decoded);
+    ASSERT_EQ(decoded.value().size(), map.size());
+
+    const KvsMap& result = decoded.value();
+    EXPECT_EQ(std::get<int32_t>(result.at("i32").getValue()), std::numeric_limits<int32_t>::min());
+    EXPECT_EQ(std::get<uint32_t>(result.at("u32").getValue()), std::numeric_limits<uint32_t>::max());
+    EXPECT_EQ(std::get<int64_t>(result.at("i64").getValue()), std::numeric_limits<int64_t>::min());
+    EXPECT_EQ(std::get<uint64_t>(result.at("u64").getValue()), std::numeric_limits<uint64_t>::max());
+    EXPECT_EQ(std::get<double>(result.at("f64").getValue()), -3.25);
+    EXPECT_EQ(std::get<bool>(result.at("bool").getValue()), true);
+    EXPECT_EQ(std::get<std::string>(result.at("str").getValue()), std::string("binary\0data", 11));
+    EXPECT_EQ(result.at("null").getType(), KvsValue::Type::Null);
+    EXPECT_EQ(std::get<std::string>(result.at("").getValue()), "");
+
+    const auto& arr = result.at("arr").getArray();
+    ASSERT_EQ(arr.size(), 3U);
+    EXPECT_EQ(std::get<int32_t>(arr[0]->getValue()), -1);
+    const auto& arr_obj = arr[1]->getObject();
+    EXPECT_EQ(std::get<bool>(arr_obj.at("flag")->getValue()), false);
+    EXPECT_EQ(std::get<std::string>(arr_obj.at("name")->getValue()), "inner");
+    EXPECT_EQ(arr[2]->getType(), KvsValue::Type::Null);
+
+    const auto& obj = result.at("obj").getObject();
+    ASSERT_EQ(obj.size(), 2U);
+    EXPECT_EQ(std::get<std::string>(obj.at("name")->getValue()), "inner");
+}
+
+TEST(kvs_binary_decode, binary_decode_empty_map) {
+    auto encoded = binary_encode_map(KvsMap{});
+    ASSERT_TRUE(encoded);
+    EXPECT_EQ(encoded.value().size(), 12U);
+    auto decoded = binary_decode_map(encoded.value());
+    ASSERT_TRUE(decoded);
+    EXPECT_TRUE(decoded.value().empty());
+}
+
+TEST(kvs_binary_decode, binary_decode_invalid_header) {
+    /* Too short */
+    auto result = binary_decode_map(std::string("KVSB", 4));
+    EXPECT_FALSE(result);
+    EXPECT_EQ(result.error(), ErrorCode::SerializationFailed);
+
+    /* Wrong magic (e.g. a JSON file) */
+    result = binary_decode_map(kvs_json);
+    EXPECT_FALSE(result);
+    EXPECT_EQ(result.error(), ErrorCode::SerializationFailed);
+
+    /* Unsupported version */
+    result = binary_decode_map(std::string("KVSB\x02\x00\x00\x00\x00\x00\x00\x00", 12));
+    EXPECT_FALSE(result);
+    EXPECT_EQ(result.error(), ErrorCode::SerializationFailed);
+}
+
+TEST(kvs_binary_decode, binary_decode_truncated) {
+    KvsValue::Array array;
+    array.push_back(std::make_shared<KvsValue>(std::string("element")));
+    KvsMap map;
+    map.emplace("array", KvsValue(array));
+    map.emplace("number", KvsValue(1.5));
+    auto encoded = binary_encode_map(map);
+    ASSERT_TRUE(encoded);
+
+    /* Every truncation of the data must be detected */
+    for (size_t len = 0; len < encoded.value().size(); ++len) {
+        auto result = binary_decode_map(std::string_view(encoded.value()).substr(0, len));
+        EXPECT_FALSE(result) << "length " << len;
+    }
+
+    /* Trailing bytes */
+    auto result = binary_decode_map(encoded.value() + "x");
+    EXPECT_FALSE(result);
+    EXPECT_EQ(result.error(), ErrorCode::SerializationFailed);
+
+    /* Element count larger than the remaining data */
+    result = binary_decode_map(std::string("KVSB\x01\x00\x00\x00\x01\x00\x00\x00"
+                                           "\x01\x00\x00\x00" "a" "\x08\xFF\xFF\xFF\xFF", 22));
+    EXPECT_FALSE(result);
+    EXPECT_EQ(result.error(), ErrorCode::SerializationFailed);
+}
+
+TEST(kvs_binary_decode, binary_decode_invalid_value) {
+    /* Unknown type tag */
+    std::string data("\x0A", 1);
+    size_t offset = 0;
+    auto result = binary_decode_value(data, offset);
+    EXPECT_FALSE(result);
+    EXPECT_EQ(result.error(), ErrorCode::InvalidValueType);
+
+    /* Boolean other than 0 or 1 */
+    data = std::string("\x05\x02", 2);
+    offset = 0;
+    result = binary_decode_value(data, offset);
+    EXPECT_FALSE(result);
+    EXPECT_EQ(result.error(), ErrorCode::InvalidValueType);
+
+    /* Invalid element in array and object */
+    data = std::string("\x08\x01\x00\x00\x00\x0A", 6);
+    offset = 0;
+    result = binary_decode_value(data, offset);
+    EXPECT_FALSE(result);
+    EXPECT_EQ(result.error(), ErrorCode::InvalidValueType);
+
+    data = std::string("\x09\x01\x00\x00\x00\x01\x00\x00\x00" "k" "\x0A", 11);
+    offset = 0;
+    result = binary_decode_value(data, offset);
+    EXPECT_FALSE(result);
+    EXPECT_EQ(result.error(), ErrorCode::InvalidValueType);
+
+    /* Offset is advanced behind the decoded value */
+    data = std::string("\x01\x2A\x00\x00\x00\x07", 6);
+    offset = 0;
+    result = binary_decode_value(data, offset);
+    ASSERT_TRUE(result);
+    EXPECT_EQ(std::get<uint32_t>(result.value().getValue()), 42U);
+    EXPECT_EQ(offset, 5U);
+}
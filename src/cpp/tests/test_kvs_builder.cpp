@@ -21,6 +21,23 @@ TEST(kvs_kvsbuilder, kvsbuilder_build) {
     EXPECT_EQ(builder.instance_id.id, instance_id.id);
     EXPECT_EQ(builder.need_defaults, false);
     EXPECT_EQ(builder.need_kvs, false);
+    EXPECT_EQ(builder.options.lock_mode, KvsLockMode::TryLock);
+    EXPECT_EQ(builder.options.format, KvsStorageFormat::Json);
+    EXPECT_EQ(builder.options.mapped_defaults, false);
+    EXPECT_EQ(builder.options.flush_mode, KvsFlushMode::Full);
+    EXPECT_EQ(builder.options.background_flush, false);
+    EXPECT_EQ(builder.options.hash_algorithm, KvsHashAlgorithm::Adler32);
+    EXPECT_EQ(builder.options.snapshot_max_count, KVS_MAX_SNAPSHOTS);
+    EXPECT_EQ(builder.options.snapshot_layout, KvsSnapshotLayout::Legacy);
+    EXPECT_EQ(builder.options.durability, KvsDurability::Deferred);
+    EXPECT_EQ(builder.options.sync_interval, 8U);
+    EXPECT_EQ(builder.options.delta_snapshots, false);
+    EXPECT_EQ(builder.options.arena, false);
+    EXPECT_EQ(builder.options.open_workers, 1U);
+    EXPECT_EQ(builder.options.lazy_values, false);
+    EXPECT_EQ(builder.options.sharing, KvsSharing::Private);
+    EXPECT_EQ(builder.options.shared_size, 1024U * 1024U);
+    EXPECT_EQ(builder.options.compression, KvsCompression::None);
 
     /* Test the KvsBuilder methods */
     builder.need_defaults_flag(true);
@@ -29,6 +46,40 @@ TEST(kvs_kvsbuilder, kvsbuilder_build) {
     EXPECT_EQ(builder.need_kvs, true);
     builder.dir("./kvsbuilder/");
     EXPECT_EQ(builder.directory, "./kvsbuilder/");
+    builder.lock_mode(KvsLockMode::Blocking);
+    EXPECT_EQ(builder.options.lock_mode, KvsLockMode::Blocking);
+    builder.storage_format(KvsStorageFormat::Binary);
+    EXPECT_EQ(builder.options.format, KvsStorageFormat::Binary);
+    builder.mapped_defaults_flag(true);
+    EXPECT_EQ(builder.options.mapped_defaults, true);
+    builder.flush_mode(KvsFlushMode::Incremental);
+    EXPECT_EQ(builder.options.flush_mode, KvsFlushMode::Incremental);
+    builder.background_flush_flag(true);
+    EXPECT_EQ(builder.options.background_flush, true);
+    builder.hash_algorithm(KvsHashAlgorithm::Crc32c);
+    EXPECT_EQ(builder.options.hash_algorithm, KvsHashAlgorithm::Crc32c);
+    builder.snapshot_max_count(7);
+    EXPECT_EQ(builder.options.snapshot_max_count, 7U);
+    builder.snapshot_layout(KvsSnapshotLayout::Generations);
+    EXPECT_EQ(builder.options.snapshot_layout, KvsSnapshotLayout::Generations);
+    builder.durability(KvsDurability::Grouped);
+    EXPECT_EQ(builder.options.durability, KvsDurability::Grouped);
+    builder.sync_interval(3);
+    EXPECT_EQ(builder.options.sync_interval, 3U);
+    builder.delta_snapshots_flag(true);
+    EXPECT_EQ(builder.options.delta_snapshots, true);
+    builder.arena_flag(true);
+    EXPECT_EQ(builder.options.arena, true);
+    builder.open_workers(4);
+    EXPECT_EQ(builder.options.open_workers, 4U);
+    builder.lazy_values_flag(true);
+    EXPECT_EQ(builder.options.lazy_values, true);
+    builder.compression(KvsCompression::Lz4);
+    EXPECT_EQ(builder.options.compression, KvsCompression::Lz4);
+    builder.sharing(KvsSharing::Owner);
+    EXPECT_EQ(builder.options.sharing, KvsSharing::Owner);
+    builder.shared_size(4096);
+    EXPECT_EQ(builder.options.shared_size, 4096U);
 
     /* Test the KvsBuilder build method */
     /* We want to check, if OpenNeedDefaults::Required and OpenNeedKvs::Required is passed correctly
@@ -44,6 +95,11 @@ TEST(kvs_kvsbuilder, kvsbuilder_build) {
     result_build = builder.build();
     EXPECT_TRUE(result_build);
     EXPECT_EQ(result_build.value().filename_prefix.CStr(), "./kvsbuilder/kvs_"+std::to_string(instance_id.id));
+    EXPECT_EQ(result_build.value().options.lock_mode, KvsLockMode::Blocking); /* Options are passed to the KVS */
+    EXPECT_EQ(result_build.value().options.format, KvsStorageFormat::Binary);
+    EXPECT_EQ(result_build.value().options.flush_mode, KvsFlushMode::Incremental);
+    EXPECT_EQ(result_build.value().options.background_flush, true);
+    EXPECT_TRUE(SharedStore::remove(SharedStore::segment_name(result_build.value().filename_prefix.Native())));
 }
 
 TEST(kvs_kvsbuilder, kvsbuilder_directory_check) {
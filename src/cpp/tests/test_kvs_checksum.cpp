@@ -0,0 +1,119 @@
+/********************************************************************************
+* Copyright (c) 2025 Contributors to the Eclipse Foundation
+*
+* See the NOTICE file(s) distributed with this work for additional
+* information regarding copyright ownership.
+*
+* This program and the accompanying materials are made available under the
+* terms of the Apache License Version 2.0 which is available at
+* https://www.apache.org/licenses/LICENSE-2.0
+*
+* SPDX-License-Identifier: Apache-2.0
+********************************************************************************/
+#include <cstring>
+#include <random>
+#include "test_kvs_general.hpp"
+
+using ChecksumUpdate = uint32_t (*)(uint32_t, const char*, size_t);
+
+/* Pseudo random test data, the same on every run */
+static std::string random_data(size_t len) {
+    std::mt19937 gen(42);
+    std::string data(len, '\0');
+    for (char& byte : data) {
+        byte = static_cast<char>(gen() & 0xFF);
+    }
+    return data;
+}
+
+/* Lengths around the vector widths and the Adler-32 modulo interval (NMAX = 5552) */
+static const size_t test_lengths[] = {0U, 1U, 15U, 16U, 17U, 31U, 32U, 33U, 63U, 64U, 100U,
+                                      5551U, 5552U, 5553U, 5552U * 3U + 7U, 65536U, 100003U};
+
+/* Compare an implementation with the scalar one over all test lengths and rolling chunks */
+static void expect_equal_to_scalar(ChecksumUpdate update, ChecksumUpdate scalar, uint32_t init) {
+    const std::string data = random_data(200000);
+    for (size_t len : test_lengths) {
+        EXPECT_EQ(update(init, data.data(), len), scalar(init, data.data(), len)) << len;
+        /* Unaligned start address */
+        EXPECT_EQ(update(init, data.data() + 3, len), scalar(init, data.data() + 3, len)) << len;
+    }
+    for (size_t chunk : {1U, 7U, 32U, 1000U, 5552U, 70000U}) {
+        uint32_t hash = init;
+        for (size_t offset = 0; offset < data.size(); offset += chunk) {
+            hash = update(hash, data.data() + offset, std::min(chunk, data.size() - offset));
+        }
+        EXPECT_EQ(hash, scalar(init, data.data(), data.size())) << chunk;
+    }
+
+    /* All bytes 0xFF is the worst case for the sum overflow */
+    const std::string ones(5552U * 4U + 31U, '\xFF');
+    EXPECT_EQ(update(init, ones.data(), ones.size()), scalar(init, ones.data(), ones.size()));
+}
+
+TEST(kvs_checksum, adler32_scalar) {
+    const std::string data = random_data(20000);
+    EXPECT_EQ(adler32_update_scalar(KVS_HASH_ADLER32_INIT, data.data(), data.size()), adler32(data));
+    EXPECT_EQ(adler32_update_scalar(KVS_HASH_ADLER32_INIT, nullptr, 0), 1U);
+}
+
+TEST(kvs_checksum, crc32c_scalar) {
+    /* Check value of the CRC-32C (Castagnoli) specification */
+    const char check[] = "123456789";
+    EXPECT_EQ(crc32c_update_scalar(hash_init(KvsHashAlgorithm::Crc32c), check, strlen(check)), 0xE3069283U);
+    EXPECT_EQ(crc32c_update_scalar(hash_init(KvsHashAlgorithm::Crc32c), nullptr, 0), 0U);
+
+    /* Rolling over two chunks equals one call */
+    uint32_t hash = crc32c_update_scalar(hash_init(KvsHashAlgorithm::Crc32c), check, 4);
+    EXPECT_EQ(crc32c_update_scalar(hash, check + 4, 5), 0xE3069283U);
+}
+
+TEST(kvs_checksum, hash_update_dispatch) {
+    const std::string data = random_data(30000);
+    EXPECT_EQ(hash_init(KvsHashAlgorithm::Adler32), KVS_HASH_ADLER32_INIT);
+    EXPECT_EQ(hash_update(KvsHashAlgorithm::Adler32, KVS_HASH_ADLER32_INIT, data.data(), data.size()),
+              adler32(data));
+    EXPECT_EQ(hash_update(KvsHashAlgorithm::Crc32c, hash_init(KvsHashAlgorithm::Crc32c), data.data(), data.size()),
+              crc32c_update_scalar(hash_init(KvsHashAlgorithm::Crc32c), data.data(), data.size()));
+    EXPECT_EQ(hash_update(KvsHashAlgorithm::Crc32c, 0, "123456789", 9), 0xE3069283U);
+}
+
+TEST(kvs_checksum, hash_implementation) {
+    const std::string adler = hash_implementation(KvsHashAlgorithm::Adler32);
+    const std::string crc = hash_implementation(KvsHashAlgorithm::Crc32c);
+    EXPECT_TRUE(adler == "avx2" || adler == "ssse3" || adler == "scalar") << adler;
+    EXPECT_TRUE(crc == "sse4.2" || crc == "scalar") << crc;
+#ifdef KVS_CHECKSUM_X86
+    EXPECT_EQ(crc == "sse4.2", checksum_cpu_supports("sse4.2"));
+    if (checksum_cpu_supports("avx2")) {
+        EXPECT_EQ(adler, "avx2");
+    }
+#endif
+}
+
+#ifdef KVS_CHECKSUM_X86
+TEST(kvs_checksum, adler32_ssse3) {
+    if (!checksum_cpu_supports("ssse3")) {
+        GTEST_SKIP() << "SSSE3 not supported";
+    }
+    expect_equal_to_scalar(adler32_update_ssse3, adler32_update_scalar, KVS_HASH_ADLER32_INIT);
+    expect_equal_to_scalar(adler32_update_ssse3, adler32_update_scalar, (65520U << 16) | 65520U);
+}
+
+TEST(kvs_checksum, adler32_avx2) {
+    if (!checksum_cpu_supports("avx2")) {
+        GTEST_SKIP() << "AVX2 not supported";
+    }
+    expect_equal_to_scalar(adler32_update_avx2, adler32_update_scalar, KVS_HASH_ADLER32_INIT);
+    expect_equal_to_scalar(adler32_update_avx2, adler32_update_scalar, (65520U << 16) | 65520U);
+}
+
+TEST(kvs_checksum, crc32c_sse42) {
+    if (!checksum_cpu_supports("sse4.2")) {
+        GTEST_SKIP() << "SSE4.2 not supported";
+    }
+    EXPECT_EQ(crc32c_update_sse42(0, "123456789", 9), 0xE3069283U);
+    expect_equal_to_scalar(crc32c_update_sse42, crc32c_update_scalar, 0);
+    expect_equal_to_scalar(crc32c_update_sse42, crc32c_update_scalar, 0xDEADBEEFU);
+}
+#endif
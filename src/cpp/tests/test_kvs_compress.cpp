@@ -0,0 +1,157 @@
+/********************************************************************************
+* Copyright (c) 2025 Contributors to the Eclipse Foundation
+*
+* See the NOTICE file(s) distributed with this work for additional
+* information regarding copyright ownership.
+*
+* This program and the accompanying materials are made available under the
+* terms of the Apache License Version 2.0 which is available at
+* https://www.apache.org/licenses/LICENSE-2.0
+*
+* SPDX-License-Identifier: Apache-2.0
+********************************************************************************/
+#include <random>
+#include <sstream>
+#include "test_kvs_general.hpp"
+
+/* Pseudo random (incompressible) test data, the same on every run */
+static std::string compress_random_data(size_t len) {
+    std::mt19937 gen(7);
+    std::string data(len, '\0');
+    for (char& byte : data) {
+        byte = static_cast<char>(gen() & 0xFF);
+    }
+    return data;
+}
+
+/* JSON-like test data with repeated keys */
+static std::string compress_json_data(size_t count) {
+    std::string data = "{";
+    for (size_t idx = 0; idx < count; ++idx) {
+        data += "\"key_" + std::to_string(idx) + "\":{\"t\":\"i32\",\"v\":" + std::to_string(idx * 3U) + "},";
+    }
+    data += "}";
+    return data;
+}
+
+static std::string lz4_round_trip(const std::string& data) {
+    std::string block;
+    lz4_compress_block(data, block);
+    std::string result(data.size(), '\0');
+    EXPECT_TRUE(lz4_decompress_block(block, &result[0], result.size()));
+    return result;
+}
+
+TEST(kvs_compress, lz4_block_round_trip) {
+    for (size_t len : {0U, 1U, 5U, 12U, 13U, 100U, 4096U, 65536U}) {
+        const std::string random = compress_random_data(len);
+        EXPECT_EQ(lz4_round_trip(random), random) << len;
+        const std::string repeated(len, 'a');
+        EXPECT_EQ(lz4_round_trip(repeated), repeated) << len;
+    }
+    /* Long literal runs and matches use the length extensions of the token */
+    const std::string mixed = compress_random_data(1000) + std::string(1000, 'x') + compress_random_data(300);
+    EXPECT_EQ(lz4_round_trip(mixed), mixed);
+
+    const std::string json = compress_json_data(1000);
+    std::string block;
+    lz4_compress_block(json, block);
+    EXPECT_LT(block.size(), json.size() / 2U);
+}
+
+TEST(kvs_compress, lz4_block_malformed) {
+    const std::string data = compress_json_data(100);
+    std::string block;
+    lz4_compress_block(data, block);
+    std::string out(data.size(), '\0');
+
+    /* Wrong size of the result */
+    EXPECT_FALSE(lz4_decompress_block(block, &out[0], data.size() - 1U));
+    std::string larger(data.size() + 1U, '\0');
+    EXPECT_FALSE(lz4_decompress_block(block, &larger[0], larger.size()));
+
+    /* Truncated blocks never read or write out of bounds */
+    for (size_t len = 0; len < block.size(); ++len) {
+        EXPECT_FALSE(lz4_decompress_block(std::string_view(block).substr(0, len), &out[0], out.size())) << len;
+    }
+
+    /* Offset before the start of the data */
+    const std::string bad_offset("\x04" "abcd" "\x10\x00", 7);
+    std::string small(8U, '\0');
+    EXPECT_FALSE(lz4_decompress_block(bad_offset, &small[0], small.size()));
+    const std::string zero_offset("\x04" "abcd" "\x00\x00", 7);
+    EXPECT_FALSE(lz4_decompress_block(zero_offset, &small[0], small.size()));
+}
+
+TEST(kvs_compress, compress_data_round_trip) {
+    EXPECT_EQ(compress_data("{}", KvsCompression::None), "{}");
+    EXPECT_FALSE(is_compressed("{}"));
+
+    for (const std::string& data : {std::string{}, compress_json_data(10), compress_json_data(20000),
+                                    compress_random_data(3U * KVS_COMPRESS_BLOCK_SIZE + 17U)}) {
+        const std::string compressed = compress_data(data, KvsCompression::Lz4);
+        EXPECT_TRUE(is_compressed(compressed));
+        auto res = decompress_data(compressed);
+        ASSERT_TRUE(res);
+        EXPECT_EQ(res.value(), data);
+    }
+
+    /* Incompressible blocks are stored with only the block header as overhead */
+    const std::string random = compress_random_data(2U * KVS_COMPRESS_BLOCK_SIZE);
+    EXPECT_EQ(compress_data(random, KvsCompression::Lz4).size(), random.size() + 8U + 2U * 8U + 4U);
+    const std::string json = compress_json_data(20000);
+    EXPECT_LT(compress_data(json, KvsCompression::Lz4).size(), json.size() / 2U);
+}
+
+TEST(kvs_compress, decompress_data_malformed) {
+    const std::string compressed = compress_data(compress_json_data(5000), KvsCompression::Lz4);
+    for (size_t len : std::initializer_list<size_t>{0U, 4U, 8U, 11U, 12U, 100U, compressed.size() - 1U}) {
+        auto res = decompress_data(std::string_view(compressed).substr(0, len));
+        ASSERT_FALSE(res) << len;
+        EXPECT_EQ(static_cast<ErrorCode>(*res.error()), ErrorCode::IntegrityCorrupted);
+    }
+
+    /* Trailing data, unknown version and codec */
+    EXPECT_FALSE(decompress_data(compressed + "x"));
+    std::string version = compressed;
+    version[4] = 2;
+    EXPECT_FALSE(decompress_data(version));
+    std::string codec = compressed;
+    codec[5] = 9;
+    EXPECT_FALSE(decompress_data(codec));
+
+    /* Corrupted block data */
+    std::string corrupted = compressed;
+    corrupted[20] = static_cast<char>(corrupted[20] ^ 0x7F);
+    corrupted[21] = static_cast<char>(corrupted[21] ^ 0x7F);
+    auto res = decompress_data(corrupted);
+    if (res) {
+        EXPECT_NE(res.value(), compress_json_data(5000));
+    }
+}
+
+TEST(kvs_compress, buffer_hash_and_size) {
+    /* Written in small pieces through an ostream, the result equals compress_data in one piece */
+    const std::string data = compress_json_data(20000);
+    for (KvsHashAlgorithm algorithm : {KvsHashAlgorithm::Adler32, KvsHashAlgorithm::Crc32c}) {
+        std::ostringstream out;
+        KvsCompressBuffer buffer(out, KvsCompression::Lz4, algorithm);
+        std::ostream stream(&buffer);
+        for (size_t offset = 0; offset < data.size(); offset += 1000U) {
+            stream << data.substr(offset, 1000U);
+        }
+        stream.put('!');
+        EXPECT_TRUE(buffer.finish());
+        const std::string file = out.str();
+        EXPECT_EQ(file, compress_data(data + "!", KvsCompression::Lz4));
+        EXPECT_EQ(buffer.size(), file.size());
+        EXPECT_EQ(buffer.hash(), calculate_hash(algorithm, file));
+    }
+
+    /* A failed stream is reported by finish */
+    std::ostringstream failing;
+    failing.setstate(std::ios::badbit);
+    KvsCompressBuffer buffer(failing, KvsCompression::Lz4);
+    (void)buffer.sputn(data.data(), static_cast<std::streamsize>(data.size()));
+    EXPECT_FALSE(buffer.finish());
+}
@@ -0,0 +1,148 @@
+/********************************************************************************
+* Copyright (c) 2025 Contributors to the Eclipse Foundation
+*
+* See the NOTICE file(s) distributed with this work for additional
+* information regarding copyright ownership.
+*
+* This program and the accompanying materials are made available under the
+* terms of the Apache License Version 2.0 which is available at
+* https://www.apache.org/licenses/LICENSE-2.0
+*
+* SPDX-License-Identifier: Apache-2.0
+********************************************************************************/
+#include "test_kvs_general.hpp"
+
+const std::string image_file = data_dir + "defaults_image_test.img";
+
+TEST(kvs_defaults_image, write_and_find) {
+    mkdir(data_dir.c_str(), 0777);
+    KvsValue::Array array;
+    array.push_back(std::make_shared<KvsValue>(std::string("element")));
+    KvsMap defaults;
+    defaults.emplace("number", KvsValue(static_cast<int32_t>(5)));
+    defaults.emplace("array", KvsValue(array));
+    defaults.emplace("string", KvsValue(std::string("value")));
+    for (int32_t idx = 0; idx < 100; ++idx) {
+        defaults.emplace("key_" + std::to_string(idx), KvsValue(static_cast<double>(idx)));
+    }
+    ASSERT_TRUE(DefaultsImage::write(image_file, defaults, 0x12345678));
+    EXPECT_FALSE(std::filesystem::exists(image_file + ".tmp" + std::to_string(getpid())));
+
+    auto image = DefaultsImage::open(image_file, 0x12345678);
+    ASSERT_TRUE(image);
+    EXPECT_EQ(image.value()->size(), defaults.size());
+
+    /* Every key is found, unknown keys are not */
+    for (const auto& [key, value] : defaults) {
+        EXPECT_TRUE(image.value()->contains(key)) << key;
+        auto find_res = image.value()->find(key);
+        ASSERT_TRUE(find_res) << key;
+        EXPECT_EQ(find_res.value().getType(), value.getType());
+    }
+    EXPECT_EQ(std::get<int32_t>(image.value()->find("number").value().getValue()), 5);
+    EXPECT_EQ(std::get<std::string>(image.value()->find("string").value().getValue()), "value");
+    EXPECT_EQ(std::get<double>(image.value()->find("key_42").value().getValue()), 42.0);
+    const auto arr = image.value()->find("array").value().getArray();
+    ASSERT_EQ(arr.size(), 1U);
+    EXPECT_EQ(std::get<std::string>(arr[0]->getValue()), "element");
+
+    EXPECT_FALSE(image.value()->contains("unknown"));
+    EXPECT_FALSE(image.value()->contains(""));
+    EXPECT_FALSE(image.value()->contains("key_"));
+    auto find_res = image.value()->find("unknown");
+    EXPECT_FALSE(find_res);
+    EXPECT_EQ(find_res.error(), ErrorCode::KeyNotFound);
+
+    std::filesystem::remove_all(data_dir);
+}
+
+TEST(kvs_defaults_image, empty_defaults) {
+    mkdir(data_dir.c_str(), 0777);
+    ASSERT_TRUE(DefaultsImage::write(image_file, KvsMap{}, 0));
+    auto image = DefaultsImage::open(image_file, 0);
+    ASSERT_TRUE(image);
+    EXPECT_EQ(image.value()->size(), 0U);
+    EXPECT_FALSE(image.value()->contains("key"));
+
+    std::filesystem::remove_all(data_dir);
+}
+
+TEST(kvs_defaults_image, open_failure) {
+    mkdir(data_dir.c_str(), 0777);
+
+    /* File not available */
+    auto image = DefaultsImage::open(image_file, 0);
+    ASSERT_FALSE(image);
+    EXPECT_EQ(image.error(), ErrorCode::FileNotFound);
+
+    /* Source hash doesn't match (defaults JSON changed) */
+    KvsMap defaults;
+    defaults.emplace("number", KvsValue(static_cast<int32_t>(5)));
+    ASSERT_TRUE(DefaultsImage::write(image_file, defaults, 1));
+    image = DefaultsImage::open(image_file, 2);
+    ASSERT_FALSE(image);
+    EXPECT_EQ(image.error(), ErrorCode::ValidationFailed);
+
+    /* Invalid header */
+    std::ofstream(image_file, std::ios::binary) << "KVSD";
+    image = DefaultsImage::open(image_file, 0);
+    ASSERT_FALSE(image);
+    EXPECT_EQ(image.error(), ErrorCode::SerializationFailed);
+    std::ofstream(image_file, std::ios::binary) << default_json;
+    image = DefaultsImage::open(image_file, 0);
+    ASSERT_FALSE(image);
+    EXPECT_EQ(image.error(), ErrorCode::SerializationFailed);
+
+    /* Entry count larger than the index */
+    std::ofstream(image_file, std::ios::binary) << std::string("KVSD\x01\x00\x00\x00\x00\x00\x00\x00\x02\x00\x00\x00", 16);
+    image = DefaultsImage::open(image_file, 0);
+    ASSERT_FALSE(image);
+    EXPECT_EQ(image.error(), ErrorCode::SerializationFailed);
+
+    std::filesystem::remove_all(data_dir);
+}
+
+TEST(kvs_defaults_image, corrupted_entry) {
+    mkdir(data_dir.c_str(), 0777);
+
+    /* Index entry points behind the end of the file */
+    std::ofstream(image_file, std::ios::binary) << std::string("KVSD\x01\x00\x00\x00\x00\x00\x00\x00\x01\x00\x00\x00"
+                                                               "\xFF\x00\x00\x00\x01\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00", 32);
+    auto image = DefaultsImage::open(image_file, 0);
+    ASSERT_TRUE(image);
+    EXPECT_FALSE(image.value()->contains("a"));
+    auto find_res = image.value()->find("a");
+    EXPECT_FALSE(find_res);
+    EXPECT_EQ(find_res.error(), ErrorCode::SerializationFailed);
+
+    /* Invalid value encoding */
+    std::ofstream(image_file, std::ios::binary) << std::string("KVSD\x01\x00\x00\x00\x00\x00\x00\x00\x01\x00\x00\x00"
+                                                               "\x20\x00\x00\x00\x01\x00\x00\x00\x21\x00\x00\x00\x01\x00\x00\x00"
+                                                               "a\x0A", 34);
+    image = DefaultsImage::open(image_file, 0);
+    ASSERT_TRUE(image);
+    EXPECT_TRUE(image.value()->contains("a"));
+    find_res = image.value()->find("a");
+    EXPECT_FALSE(find_res);
+    EXPECT_EQ(find_res.error(), ErrorCode::InvalidValueType);
+
+    std::filesystem::remove_all(data_dir);
+}
+
+TEST(kvs_defaults_image, write_failure) {
+    /* Invalid value */
+    mkdir(data_dir.c_str(), 0777);
+    KvsMap defaults;
+    defaults.emplace("invalid", BrokenKvsValue());
+    auto result = DefaultsImage::write(image_file, defaults, 0);
+    EXPECT_FALSE(result);
+    EXPECT_EQ(result.error(), ErrorCode::InvalidValueType);
+    EXPECT_FALSE(std::filesystem::exists(image_file));
+
+    /* Directory not available */
+    result = DefaultsImage::write(data_dir + "missing/defaults.img", KvsMap{}, 0);
+    EXPECT_FALSE(result);
+    EXPECT_EQ(result.error(), ErrorCode::PhysicalStorageFailure);
+
+    std::filesystem::remove_all(data_dir);
+}
@@ -0,0 +1,126 @@
+/********************************************************************************
+* Copyright (c) 2025 Contributors to the Eclipse Foundation
+*
+* See the NOTICE file(s) distributed with this work for additional
+* information regarding copyright ownership.
+*
+* This program and the accompanying materials are made available under the
+* terms of the Apache License Version 2.0 which is available at
+* https://www.apache.org/licenses/LICENSE-2.0
+*
+* SPDX-License-Identifier: Apache-2.0
+********************************************************************************/
+#include "test_kvs_general.hpp"
+
+TEST(kvs_delta, encode_apply) {
+    KvsMap base;
+    base.emplace("kept", KvsValue(1.0));
+    base.emplace("changed", KvsValue("old"));
+    base.emplace("removed", KvsValue(true));
+    KvsMap target;
+    target.emplace("kept", KvsValue(1.0));
+    target.emplace("changed", KvsValue("new"));
+    target.emplace("added", KvsValue(std::vector<KvsValue>{KvsValue(2.0)}));
+
+    auto delta = delta_encode(base, target, 0x12345678);
+    ASSERT_TRUE(delta);
+
+    KvsMap applied = base;
+    ASSERT_TRUE(delta_apply(delta.value(), 0x12345678, applied));
+    ASSERT_EQ(applied.size(), target.size());
+    for (const auto& [key, value] : target) {
+        ASSERT_NE(applied.find(key), applied.end());
+        EXPECT_EQ(applied.at(key), value);
+    }
+
+    /* Unchanged keys are not part of the delta */
+    std::string records;
+    ASSERT_TRUE(log_encode_set(records, "changed", KvsValue("new")));
+    ASSERT_TRUE(log_encode_remove(records, "removed"));
+    ASSERT_TRUE(log_encode_set(records, "added", KvsValue(std::vector<KvsValue>{KvsValue(2.0)})));
+    EXPECT_EQ(delta.value().size(), KVS_LOG_HEADER_SIZE + records.size());
+}
+
+TEST(kvs_delta, encode_identical) {
+    KvsMap map;
+    map.emplace("key", KvsValue(1.0));
+    auto delta = delta_encode(map, map, 1);
+    ASSERT_TRUE(delta);
+    EXPECT_EQ(delta.value(), log_encode_header(1));
+    KvsMap applied = map;
+    EXPECT_TRUE(delta_apply(delta.value(), 1, applied));
+    EXPECT_EQ(applied.size(), 1U);
+}
+
+TEST(kvs_delta, apply_invalid) {
+    KvsMap base;
+    KvsMap target;
+    target.emplace("key", KvsValue("value"));
+    auto delta = delta_encode(base, target, 7);
+    ASSERT_TRUE(delta);
+
+    /* Delta of another base */
+    KvsMap applied;
+    auto apply_res = delta_apply(delta.value(), 8, applied);
+    ASSERT_FALSE(apply_res);
+    EXPECT_EQ(static_cast<ErrorCode>(*apply_res.error()), ErrorCode::ValidationFailed);
+
+    /* Torn or corrupted record */
+    apply_res = delta_apply(delta.value().substr(0, delta.value().size() - 1), 7, applied);
+    ASSERT_FALSE(apply_res);
+    EXPECT_EQ(static_cast<ErrorCode>(*apply_res.error()), ErrorCode::ValidationFailed);
+    std::string corrupted = delta.value();
+    corrupted[KVS_LOG_HEADER_SIZE + 6] ^= 0x01;
+    apply_res = delta_apply(corrupted, 7, applied);
+    ASSERT_FALSE(apply_res);
+    EXPECT_EQ(static_cast<ErrorCode>(*apply_res.error()), ErrorCode::ValidationFailed);
+
+    /* No log header */
+    apply_res = delta_apply("KVS", 7, applied);
+    ASSERT_FALSE(apply_res);
+    EXPECT_EQ(static_cast<ErrorCode>(*apply_res.error()), ErrorCode::ValidationFailed);
+}
+
+TEST(kvs_delta, changes) {
+    KvsMap base;
+    base.emplace("changed", KvsValue("old"));
+    base.emplace("removed", KvsValue(true));
+    KvsMap target;
+    target.emplace("changed", KvsValue("new"));
+    target.emplace("added", KvsValue(1.0));
+    auto delta = delta_encode(base, target, 5);
+    ASSERT_TRUE(delta);
+
+    KvsChanges changes;
+    ASSERT_TRUE(delta_changes(delta.value(), 5, changes));
+    ASSERT_EQ(changes.size(), 3U);
+    EXPECT_EQ(changes.at("changed").value(), KvsValue("new"));
+    EXPECT_EQ(changes.at("added").value(), KvsValue(1.0));
+    EXPECT_FALSE(changes.at("removed").has_value());
+
+    auto changes_res = delta_changes(delta.value().substr(0, delta.value().size() - 2), 5, changes);
+    ASSERT_FALSE(changes_res);
+    EXPECT_EQ(static_cast<ErrorCode>(*changes_res.error()), ErrorCode::ValidationFailed);
+}
+
+TEST(kvs_delta, update) {
+    KvsMap map;
+    map.emplace("kept", KvsValue(1.0));
+    map.emplace("changed", KvsValue("old"));
+    map.emplace("removed", KvsValue(true));
+    KvsMap source;
+    source.emplace("added", KvsValue(2.0));
+    source.emplace("changed", KvsValue("new"));
+    source.emplace("kept", KvsValue(1.0));
+    source.emplace("last", KvsValue(nullptr));
+
+    delta_update(map, source);
+    ASSERT_EQ(map.size(), source.size());
+    for (const auto& [key, value] : source) {
+        ASSERT_NE(map.find(key), map.end());
+        EXPECT_EQ(map.at(key), value);
+    }
+
+    delta_update(map, KvsMap{});
+    EXPECT_TRUE(map.empty());
+}
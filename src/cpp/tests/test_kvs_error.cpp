@@ -39,6 +39,7 @@ TEST(kvs_MessageFor, MessageFor) {
         {ErrorCode::ConversionFailed,       "Conversion failed"},
         {ErrorCode::MutexLockFailed,        "Mutex failed"},
         {ErrorCode::InvalidValueType,       "Invalid value type"},
+        {ErrorCode::ReadOnly,               "KVS instance is read-only"},
     };
     for (const auto& test : test_cases) {
         SCOPED_TRACE(static_cast<int>(test.code));
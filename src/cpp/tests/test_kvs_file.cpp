@@ -0,0 +1,75 @@
+/********************************************************************************
+* Copyright (c) 2025 Contributors to the Eclipse Foundation
+*
+* See the NOTICE file(s) distributed with this work for additional
+* information regarding copyright ownership.
+*
+* This program and the accompanying materials are made available under the
+* terms of the Apache License Version 2.0 which is available at
+* https://www.apache.org/licenses/LICENSE-2.0
+*
+* SPDX-License-Identifier: Apache-2.0
+********************************************************************************/
+#include "test_kvs_general.hpp"
+
+static std::string read_file(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    return std::string((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+}
+
+TEST(kvs_file, file_write) {
+    prepare_environment();
+    const std::string path = data_dir + "write_test";
+
+    EXPECT_TRUE(file_write(path, "first content", false));
+    EXPECT_EQ(read_file(path), "first content");
+
+    /* An existing file is truncated */
+    EXPECT_TRUE(file_write(path, "second", true));
+    EXPECT_EQ(read_file(path), "second");
+    EXPECT_TRUE(file_write(path, "", true));
+    EXPECT_EQ(read_file(path), "");
+
+    EXPECT_FALSE(file_write(data_dir + "missing_dir/write_test", "content", false));
+
+    cleanup_environment();
+}
+
+TEST(kvs_file, file_sync_dir_sync) {
+    prepare_environment();
+
+    EXPECT_TRUE(file_sync(kvs_prefix + ".json"));
+    EXPECT_FALSE(file_sync(kvs_prefix + ".missing"));
+    EXPECT_TRUE(dir_sync(kvs_prefix + ".json"));
+    EXPECT_TRUE(dir_sync("file_in_working_directory"));
+    EXPECT_FALSE(dir_sync(data_dir + "missing_dir/file"));
+
+    cleanup_environment();
+}
+
+TEST(kvs_file, file_link) {
+    prepare_environment();
+    const std::string from = data_dir + "link_from";
+    const std::string to = data_dir + "link_to";
+    std::ofstream(from) << "linked";
+
+    /* The file stays available under both names */
+    EXPECT_TRUE(file_link(from, to));
+    EXPECT_EQ(read_file(from), "linked");
+    EXPECT_EQ(read_file(to), "linked");
+
+    /* An existing file is replaced */
+    std::ofstream(from) << "replaced";
+    const std::string other = data_dir + "link_other";
+    std::ofstream(other) << "other";
+    EXPECT_TRUE(file_link(other, to));
+    EXPECT_EQ(read_file(to), "other");
+
+    /* Missing file: the target is kept and errno is ENOENT */
+    errno = 0;
+    EXPECT_FALSE(file_link(data_dir + "link_missing", to));
+    EXPECT_EQ(errno, ENOENT);
+    EXPECT_EQ(read_file(to), "other");
+
+    cleanup_environment();
+}
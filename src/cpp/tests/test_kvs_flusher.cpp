@@ -0,0 +1,102 @@
+/********************************************************************************
+* Copyright (c) 2025 Contributors to the Eclipse Foundation
+*
+* See the NOTICE file(s) distributed with this work for additional
+* information regarding copyright ownership.
+*
+* This program and the accompanying materials are made available under the
+* terms of the Apache License Version 2.0 which is available at
+* https://www.apache.org/licenses/LICENSE-2.0
+*
+* SPDX-License-Identifier: Apache-2.0
+********************************************************************************/
+#include <atomic>
+#include <chrono>
+#include "test_kvs_general.hpp"
+
+TEST(kvs_flusher, request_runs_job) {
+    std::atomic<int32_t> runs{0};
+    KvsFlusher flusher([&runs]() {
+        ++runs;
+        return score::ResultBlank{};
+    });
+
+    auto future = flusher.request();
+    EXPECT_TRUE(future.get());
+    EXPECT_EQ(runs, 1);
+
+    /* Every request after a finished run starts a new run */
+    EXPECT_TRUE(flusher.request().get());
+    EXPECT_EQ(runs, 2);
+}
+
+TEST(kvs_flusher, request_coalesced) {
+    std::atomic<int32_t> runs{0};
+    std::promise<void> started;
+    std::promise<void> release;
+    std::shared_future<void> release_future = release.get_future().share();
+    KvsFlusher flusher([&]() {
+        if (0 == runs++) {
+            started.set_value();
+            release_future.wait();
+        }
+        return score::ResultBlank{};
+    });
+
+    /* The first run blocks, all requests made meanwhile share the next run */
+    auto first = flusher.request();
+    started.get_future().wait();
+    std::atomic<int32_t> callbacks{0};
+    auto second = flusher.request([&callbacks](const score::ResultBlank& result) {
+        EXPECT_TRUE(result);
+        ++callbacks;
+    });
+    auto third = flusher.request([&callbacks](const score::ResultBlank&) { ++callbacks; });
+    auto fourth = flusher.request();
+
+    release.set_value();
+    EXPECT_TRUE(first.get());
+    EXPECT_TRUE(second.get());
+    EXPECT_TRUE(third.get());
+    EXPECT_TRUE(fourth.get());
+    EXPECT_EQ(runs, 2); /* One run for the first and one shared by all other requests */
+    EXPECT_EQ(callbacks, 2); /* Callbacks are called before the future is ready */
+}
+
+TEST(kvs_flusher, request_failure) {
+    KvsFlusher flusher([]() -> score::ResultBlank {
+        return score::MakeUnexpected(ErrorCode::PhysicalStorageFailure);
+    });
+    score::ResultBlank callback_result = score::ResultBlank{};
+    auto result = flusher.request([&callback_result](const score::ResultBlank& res) { callback_result = res; }).get();
+    ASSERT_FALSE(result);
+    EXPECT_EQ(static_cast<ErrorCode>(*result.error()), ErrorCode::PhysicalStorageFailure);
+    ASSERT_FALSE(callback_result);
+    EXPECT_EQ(static_cast<ErrorCode>(*callback_result.error()), ErrorCode::PhysicalStorageFailure);
+}
+
+TEST(kvs_flusher, wait_and_destructor_drain) {
+    std::atomic<int32_t> runs{0};
+    auto job = [&runs]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        ++runs;
+        return score::ResultBlank{};
+    };
+
+    /* wait() returns once the requested run is finished */
+    KvsFlusher flusher(job);
+    flusher.wait(); /* Nothing pending */
+    (void)flusher.request();
+    flusher.wait();
+    EXPECT_EQ(runs, 1);
+
+    /* A pending request is finished by the destructor */
+    std::shared_future<score::ResultBlank> future;
+    {
+        KvsFlusher drained(job);
+        future = drained.request();
+    }
+    EXPECT_EQ(runs, 2);
+    EXPECT_EQ(future.wait_for(std::chrono::seconds(0)), std::future_status::ready);
+    EXPECT_TRUE(future.get());
+}
@@ -15,13 +15,18 @@
 /* The test_kvs_general files provide configuration data and methods needed for KVS tests */
 ////////////////////////////////////////////////////////////////////////////////
 
+#include <atomic>
+#include <climits>
 #include <cstdio>
 #include <cstdlib>
+#include <fcntl.h>
 #include <filesystem>
 #include <fstream>
 #include <gtest/gtest.h>
 #include <gmock/gmock.h>
 #include <string>
+#include <sys/mman.h>
+#include <thread>
 #include <unistd.h>
 
 /* Change Private Members and final to public to allow access to member variables (kvs and kvsbuilder) and derive from kvsvalue in unittests*/
@@ -30,9 +35,22 @@
 #include "kvsbuilder.hpp"
 #undef private
 #undef final
+#include "internal/kvs_binary.hpp"
+#include "internal/kvs_checksum.hpp"
+#include "internal/kvs_compress.hpp"
+#include "internal/kvs_defaults_image.hpp"
+#include "internal/kvs_delta.hpp"
+#include "internal/kvs_file.hpp"
+#include "internal/kvs_flusher.hpp"
 #include "internal/kvs_helper.hpp"
+#include "internal/kvs_json_stream.hpp"
+#include "internal/kvs_lazy.hpp"
+#include "internal/kvs_log.hpp"
+#include "internal/kvs_manifest.hpp"
+#include "internal/kvs_notifier.hpp"
+#include "internal/kvs_shared.hpp"
+#include "internal/kvs_stats.hpp"
 #include "score/json/i_json_parser_mock.h"
-#include "score/json/i_json_writer_mock.h"
 #include "score/filesystem/filesystem_mock.h"
 using namespace score::mw::per::kvs;
 
@@ -76,8 +94,9 @@ const std::string kvs_json = R"({
 class BrokenKvsValue : public KvsValue {
 public:
     BrokenKvsValue() : KvsValue(nullptr) {
-        /* Intentionally break the type by assigning an invalid value */
-        *(Type*)&this->type = static_cast<Type>(999);
+        /* Intentionally break the value: the constructors never store a nullptr container (the
+           alternatives are never valueless), the conversions reject a nullptr container as invalid type */
+        this->value = SharedObject();
     }
 };
 
@@ -43,6 +43,22 @@ TEST(kvs_calculate_hash_adler32, calculate_hash_adler32_large_data) {
     EXPECT_EQ(adler32(large_data), hash);
 }
 
+TEST(kvs_calculate_hash_adler32, update_hash_adler32_chunks) {
+    /* Rolling checksum over chunks of any size equals the checksum of the complete data */
+    std::string data;
+    for (int32_t idx = 0; idx < 12000; ++idx) {
+        data.push_back(static_cast<char>(idx * 7));
+    }
+    for (size_t chunk : {1U, 13U, 5552U, 6000U}) {
+        uint32_t hash = KVS_HASH_ADLER32_INIT;
+        for (size_t offset = 0; offset < data.size(); offset += chunk) {
+            hash = update_hash_adler32(hash, data.data() + offset, std::min(chunk, data.size() - offset));
+        }
+        EXPECT_EQ(hash, adler32(data)) << chunk;
+    }
+    EXPECT_EQ(update_hash_adler32(KVS_HASH_ADLER32_INIT, nullptr, 0), calculate_hash_adler32(""));
+}
+
 TEST(kvs_check_hash, check_hash_valid) {
 
     std::string test_data = "Hello, World!";
@@ -77,6 +93,110 @@ TEST(kvs_check_hash, check_hash_invalid) {
     EXPECT_FALSE(check_hash(test_data_invalid, hash_stream));
 }
 
+TEST(kvs_check_hash, check_hash_tagged_crc32c) {
+    std::string test_data = "Hello, World!";
+    std::istringstream hash_stream(get_hash_file_content(KvsHashAlgorithm::Crc32c, calculate_hash(KvsHashAlgorithm::Crc32c, test_data)));
+    EXPECT_TRUE(check_hash(test_data, hash_stream));
+
+    std::istringstream hash_stream_invalid(get_hash_file_content(KvsHashAlgorithm::Crc32c, calculate_hash(KvsHashAlgorithm::Crc32c, test_data)));
+    EXPECT_FALSE(check_hash("Hello, invalid World!", hash_stream_invalid));
+}
+
+TEST(kvs_hash_file, get_hash_file_content) {
+    /* Adler-32 keeps the legacy format */
+    std::string legacy = get_hash_file_content(KvsHashAlgorithm::Adler32, 0x01020304U);
+    EXPECT_EQ(legacy, std::string("\x01\x02\x03\x04", KVS_HASH_FILE_LEGACY_SIZE));
+
+    std::string tagged = get_hash_file_content(KvsHashAlgorithm::Crc32c, 0x01020304U);
+    EXPECT_EQ(tagged, std::string("\x01\x01\x02\x03\x04", KVS_HASH_FILE_TAGGED_SIZE));
+}
+
+TEST(kvs_hash_file, parse_hash_file) {
+    KvsHashAlgorithm algorithm = KvsHashAlgorithm::Crc32c;
+    uint32_t hash = 0;
+
+    std::istringstream legacy(std::string("\x01\x02\x03\x04", 4));
+    EXPECT_TRUE(parse_hash_file(legacy, algorithm, hash));
+    EXPECT_EQ(algorithm, KvsHashAlgorithm::Adler32);
+    EXPECT_EQ(hash, 0x01020304U);
+
+    std::istringstream tagged(std::string("\x01\x0A\x0B\x0C\x0D", 5));
+    EXPECT_TRUE(parse_hash_file(tagged, algorithm, hash));
+    EXPECT_EQ(algorithm, KvsHashAlgorithm::Crc32c);
+    EXPECT_EQ(hash, 0x0A0B0C0DU);
+
+    /* Invalid sizes and tags */
+    std::istringstream too_short(std::string("\x01\x02\x03", 3));
+    EXPECT_FALSE(parse_hash_file(too_short, algorithm, hash));
+    std::istringstream too_long(std::string("\x01\x02\x03\x04\x05\x06", 6));
+    EXPECT_FALSE(parse_hash_file(too_long, algorithm, hash));
+    std::istringstream invalid_tag(std::string("\x07\x02\x03\x04\x05", 5));
+    EXPECT_FALSE(parse_hash_file(invalid_tag, algorithm, hash));
+
+    /* Tagged Adler-32 is accepted as well */
+    std::istringstream adler_tag(std::string("\x00\x02\x03\x04\x05", 5));
+    EXPECT_TRUE(parse_hash_file(adler_tag, algorithm, hash));
+    EXPECT_EQ(algorithm, KvsHashAlgorithm::Adler32);
+    EXPECT_EQ(hash, 0x02030405U);
+}
+
+TEST(kvs_read_stream, read_stream_hashed) {
+    /* Sizes below, at and above the chunk size */
+    for (size_t size : {0U, 1U, 1000U, 65536U, 200001U}) {
+        std::string content(size, '\0');
+        for (size_t idx = 0; idx < size; ++idx) {
+            content[idx] = static_cast<char>(idx * 13);
+        }
+        for (KvsHashAlgorithm algorithm : {KvsHashAlgorithm::Adler32, KvsHashAlgorithm::Crc32c}) {
+            std::istringstream in(content);
+            std::string data;
+            uint32_t hash = 0;
+            EXPECT_TRUE(read_stream_hashed(in, algorithm, data, hash)) << size;
+            EXPECT_EQ(data, content);
+            EXPECT_EQ(hash, calculate_hash(algorithm, content)) << size;
+        }
+
+        std::istringstream in(content);
+        std::string data;
+        EXPECT_TRUE(read_stream(in, data));
+        EXPECT_EQ(data, content);
+    }
+}
+
+TEST(kvs_read_stream, read_stream_from_position) {
+    /* Only the remaining stream is read */
+    std::istringstream in("header:data");
+    in.ignore(7);
+    std::string data;
+    uint32_t hash = 0;
+    EXPECT_TRUE(read_stream_hashed(in, KvsHashAlgorithm::Adler32, data, hash));
+    EXPECT_EQ(data, "data");
+    EXPECT_EQ(hash, adler32("data"));
+}
+
+TEST(kvs_read_stream, read_stream_file) {
+    const std::string content(100000, 'x');
+    const std::string path = "./read_stream_test.json";
+    std::ofstream(path, std::ios::binary) << content;
+
+    std::ifstream in(path, std::ios::binary);
+    std::string data;
+    uint32_t hash = 0;
+    EXPECT_TRUE(read_stream_hashed(in, KvsHashAlgorithm::Adler32, data, hash));
+    EXPECT_EQ(data.size(), content.size());
+    EXPECT_LT(data.capacity(), content.size() + KVS_READ_CHUNK_SIZE); /* Pre-sized, no growth by a chunk */
+    EXPECT_EQ(hash, adler32(content));
+    std::remove(path.c_str());
+}
+
+TEST(kvs_read_stream, read_stream_failure) {
+    std::istringstream in("data");
+    in.setstate(std::ios::badbit);
+    std::string data;
+    uint32_t hash = 0;
+    EXPECT_FALSE(read_stream_hashed(in, KvsHashAlgorithm::Adler32, data, hash));
+}
+
 TEST(kvs_any_to_kvsvalue, any_to_kvsvalue_bool) {
     score::json::Object obj;
     obj.emplace("t", score::json::Any(std::string("bool")));
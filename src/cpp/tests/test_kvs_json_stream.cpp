@@ -0,0 +1,194 @@
+/********************************************************************************
+* Copyright (c) 2025 Contributors to the Eclipse Foundation
+*
+* See the NOTICE file(s) distributed with this work for additional
+* information regarding copyright ownership.
+*
+* This program and the accompanying materials are made available under the
+* terms of the Apache License Version 2.0 which is available at
+* https://www.apache.org/licenses/LICENSE-2.0
+*
+* SPDX-License-Identifier: Apache-2.0
+********************************************************************************/
+#include <clocale>
+#include <cmath>
+#include <limits>
+#include <sstream>
+#include "test_kvs_general.hpp"
+
+/* Stream a map into a string with the given chunk size */
+static score::Result<std::string> stream_map(const KvsMap& map, size_t chunk_size = KVS_STREAM_CHUNK_SIZE) {
+    score::Result<std::string> result = score::MakeUnexpected(ErrorCode::UnmappedError);
+    std::ostringstream out;
+    KvsStreamSink sink(out, chunk_size);
+    auto stream_res = json_stream_map(map, sink);
+    if (!stream_res) {
+        result = score::MakeUnexpected(static_cast<ErrorCode>(*stream_res.error()));
+    }else if (!sink.finish()) {
+        result = score::MakeUnexpected(ErrorCode::PhysicalStorageFailure);
+    }else{
+        EXPECT_EQ(sink.size(), out.str().size());
+        EXPECT_EQ(sink.hash(), calculate_hash_adler32(out.str()));
+        result = out.str();
+    }
+
+    return result;
+}
+
+/* Parse streamed JSON with the JSON parser used by open */
+static KvsMap parse_map(const std::string& data) {
+    KvsMap map;
+    score::json::JsonParser parser;
+    auto any_res = parser.FromBuffer(data);
+    EXPECT_TRUE(any_res);
+    auto obj = any_res.value().As<score::json::Object>();
+    EXPECT_TRUE(obj.has_value());
+    for (const auto& element : obj.value().get()) {
+        auto conv = any_to_kvsvalue(element.second);
+        EXPECT_TRUE(conv);
+        auto sv = element.first.GetAsStringView();
+        map.emplace(std::string(sv.data(), sv.size()), conv.value());
+    }
+
+    return map;
+}
+
+TEST(kvs_json_stream, json_stream_map_format) {
+    /* Same layout as the typed JSON files */
+    KvsMap map;
+    map.emplace("kvs", KvsValue(static_cast<int32_t>(2)));
+    auto result = stream_map(map);
+    ASSERT_TRUE(result);
+    EXPECT_EQ(result.value(), kvs_json);
+
+    result = stream_map(KvsMap{});
+    ASSERT_TRUE(result);
+    EXPECT_EQ(result.value(), "{}");
+}
+
+TEST(kvs_json_stream, json_stream_map_roundtrip) {
+    KvsValue::Array array;
+    array.push_back(std::make_shared<KvsValue>(static_cast<int32_t>(-1)));
+    array.push_back(std::make_shared<KvsValue>(std::string("element")));
+    KvsValue::Object object;
+    object.emplace("inner", std::make_shared<KvsValue>(KvsValue(array)));
+    object.emplace("flag", std::make_shared<KvsValue>(false));
+
+    KvsMap map;
+    map.emplace("i32", KvsValue(std::numeric_limits<int32_t>::min()));
+    map.emplace("u32", KvsValue(std::numeric_limits<uint32_t>::max()));
+    map.emplace("i64", KvsValue(std::numeric_limits<int64_t>::min()));
+    map.emplace("u64", KvsValue(std::numeric_limits<uint64_t>::max()));
+    map.emplace("f64", KvsValue(0.1));
+    map.emplace("f64_exp", KvsValue(-1.5e-300));
+    map.emplace("bool", KvsValue(true));
+    map.emplace("str", KvsValue(std::string("quote \" backslash \\ newline \n tab \t ctrl \x01 utf8 \xC3\xA4")));
+    map.emplace("esc \"key\"", KvsValue(nullptr));
+    map.emplace("arr", KvsValue(array));
+    map.emplace("empty_arr", KvsValue(KvsValue::Array{}));
+    map.emplace("obj", KvsValue(object));
+    map.emplace("empty_obj", KvsValue(KvsValue::Object{}));
+
+    auto result = stream_map(map);
+    ASSERT_TRUE(result);
+    const KvsMap parsed = parse_map(result.value());
+    ASSERT_EQ(parsed.size(), map.size());
+    EXPECT_EQ(std::get<int32_t>(parsed.at("i32").getValue()), std::numeric_limits<int32_t>::min());
+    EXPECT_EQ(std::get<uint32_t>(parsed.at("u32").getValue()), std::numeric_limits<uint32_t>::max());
+    EXPECT_EQ(std::get<int64_t>(parsed.at("i64").getValue()), std::numeric_limits<int64_t>::min());
+    EXPECT_EQ(std::get<uint64_t>(parsed.at("u64").getValue()), std::numeric_limits<uint64_t>::max());
+    EXPECT_EQ(std::get<double>(parsed.at("f64").getValue()), 0.1);
+    EXPECT_EQ(std::get<double>(parsed.at("f64_exp").getValue()), -1.5e-300);
+    EXPECT_EQ(std::get<bool>(parsed.at("bool").getValue()), true);
+    EXPECT_EQ(std::get<std::string>(parsed.at("str").getValue()), std::get<std::string>(map.at("str").getValue()));
+    EXPECT_EQ(parsed.at("esc \"key\"").getType(), KvsValue::Type::Null);
+    const auto& arr = parsed.at("arr").getArray();
+    ASSERT_EQ(arr.size(), 2U);
+    EXPECT_EQ(std::get<int32_t>(arr[0]->getValue()), -1);
+    EXPECT_EQ(std::get<std::string>(arr[1]->getValue()), "element");
+    EXPECT_TRUE(parsed.at("empty_arr").getArray().empty());
+    const auto& obj = parsed.at("obj").getObject();
+    ASSERT_EQ(obj.size(), 2U);
+    EXPECT_EQ(std::get<bool>(obj.at("flag")->getValue()), false);
+    EXPECT_EQ(obj.at("inner")->getArray().size(), 2U);
+    EXPECT_TRUE(parsed.at("empty_obj").getObject().empty());
+}
+
+TEST(kvs_json_stream, json_stream_map_locale) {
+    /* Doubles are written with '.' under a locale with a decimal comma (skipped if none is installed) */
+    const char* locale = nullptr;
+    for (const char* name : {"de_DE.UTF-8", "de_DE.utf8", "de_DE", "fr_FR.UTF-8", "fr_FR.utf8", "fr_FR"}) {
+        if (nullptr != std::setlocale(LC_NUMERIC, name)) {
+            locale = name;
+            break;
+        }
+    }
+    if (nullptr == locale) {
+        GTEST_SKIP() << "no locale with a decimal comma installed";
+    }
+    ASSERT_EQ(std::string(std::localeconv()->decimal_point), ",");
+
+    KvsMap map;
+    map.emplace("f64", KvsValue(0.1));
+    map.emplace("f64_exp", KvsValue(-1.5e-300));
+    auto result = stream_map(map);
+    (void)std::setlocale(LC_NUMERIC, "C");
+    ASSERT_TRUE(result);
+    EXPECT_NE(result.value().find("\"v\": 0.1\n"), std::string::npos) << locale;
+    EXPECT_NE(result.value().find("\"v\": -1.5e-300\n"), std::string::npos) << locale;
+    const KvsMap parsed = parse_map(result.value());
+    EXPECT_EQ(std::get<double>(parsed.at("f64").getValue()), 0.1);
+    EXPECT_EQ(std::get<double>(parsed.at("f64_exp").getValue()), -1.5e-300);
+}
+
+TEST(kvs_json_stream, json_stream_map_chunks) {
+    /* Output and checksum don't depend on the chunk size */
+    KvsMap map;
+    for (int32_t idx = 0; idx < 500; ++idx) {
+        map.emplace("key_" + std::to_string(idx), KvsValue(std::string(static_cast<size_t>(idx), 'x')));
+    }
+    auto expected = stream_map(map);
+    ASSERT_TRUE(expected);
+    for (size_t chunk_size : {1U, 7U, 4096U}) {
+        auto result = stream_map(map, chunk_size);
+        ASSERT_TRUE(result) << chunk_size;
+        EXPECT_EQ(result.value(), expected.value()) << chunk_size;
+    }
+}
+
+TEST(kvs_json_stream, json_stream_map_failure) {
+    /* Invalid value */
+    KvsMap map;
+    map.emplace("invalid", BrokenKvsValue());
+    auto result = stream_map(map);
+    ASSERT_FALSE(result);
+    EXPECT_EQ(result.error(), ErrorCode::InvalidValueType);
+
+    /* Invalid value inside an array */
+    KvsValue::Array array;
+    array.push_back(std::make_shared<BrokenKvsValue>());
+    map.clear();
+    map.emplace("array", KvsValue(array));
+    result = stream_map(map);
+    ASSERT_FALSE(result);
+    EXPECT_EQ(result.error(), ErrorCode::InvalidValueType);
+
+    /* JSON has no NaN and Infinity */
+    map.clear();
+    map.emplace("nan", KvsValue(std::nan("")));
+    result = stream_map(map);
+    ASSERT_FALSE(result);
+    EXPECT_EQ(result.error(), ErrorCode::JsonGeneratorError);
+    map.clear();
+    map.emplace("inf", KvsValue(std::numeric_limits<double>::infinity()));
+    result = stream_map(map);
+    ASSERT_FALSE(result);
+    EXPECT_EQ(result.error(), ErrorCode::JsonGeneratorError);
+
+    /* Write failure of the stream */
+    std::ofstream closed;
+    KvsStreamSink sink(closed, 4);
+    sink.append("data that doesn't fit into one chunk");
+    EXPECT_FALSE(sink.finish());
+    EXPECT_EQ(sink.size(), 36U);
+}
@@ -0,0 +1,85 @@
+/********************************************************************************
+* Copyright (c) 2025 Contributors to the Eclipse Foundation
+*
+* See the NOTICE file(s) distributed with this work for additional
+* information regarding copyright ownership.
+*
+* This program and the accompanying materials are made available under the
+* terms of the Apache License Version 2.0 which is available at
+* https://www.apache.org/licenses/LICENSE-2.0
+*
+* SPDX-License-Identifier: Apache-2.0
+********************************************************************************/
+#include "test_kvs_general.hpp"
+
+TEST(kvs_lazy_index, json_index_map) {
+    const std::string data = " {\n"
+                             "  \"number\": {\"t\": \"f64\", \"v\": 1.5},\n"
+                             "  \"esc\\\"aped\\u00e4\\ud83d\\ude00\" : {\"t\":\"str\",\"v\":\"}]\\\"{\"},\n"
+                             "  \"nested\": {\"t\": \"arr\", \"v\": [{\"t\": \"bool\", \"v\": true}, {\"t\": \"null\", \"v\": null}]},\n"
+                             "  \"scalar\": 42\n"
+                             "}\n";
+    auto index = json_index_map(data);
+    ASSERT_TRUE(index);
+    ASSERT_EQ(index.value().size(), 4U);
+    EXPECT_EQ(index.value().at("number").data, "{\"t\": \"f64\", \"v\": 1.5}");
+    EXPECT_EQ(index.value().at("esc\"aped\xC3\xA4\xF0\x9F\x98\x80").data, "{\"t\":\"str\",\"v\":\"}]\\\"{\"}");
+    EXPECT_EQ(index.value().at("nested").data,
+              "{\"t\": \"arr\", \"v\": [{\"t\": \"bool\", \"v\": true}, {\"t\": \"null\", \"v\": null}]}");
+    EXPECT_EQ(index.value().at("scalar").data, "42"); /* Checked by the parser on access */
+    EXPECT_FALSE(index.value().at("number").value.has_value());
+
+    /* The ranges point into the data */
+    const std::string_view number = index.value().at("number").data;
+    EXPECT_GE(number.data(), data.data());
+    EXPECT_LE(number.data() + number.size(), data.data() + data.size());
+
+    auto empty = json_index_map(" { } ");
+    ASSERT_TRUE(empty);
+    EXPECT_TRUE(empty.value().empty());
+}
+
+TEST(kvs_lazy_index, json_index_map_invalid) {
+    for (const std::string data : {"", "[]", "{", "{\"key\"}", "{\"key\": }", "{\"key\": {\"t\": \"i32\"}",
+                                   "{\"key\": [1}]}", "{\"key\": 1,}", "{\"key\": 1} trailing", "{\"k\\x\": 1}",
+                                   "{\"\\ud83d\": 1}", "{\"key\": \"open}", "{key: 1}"}) {
+        auto index = json_index_map(data);
+        ASSERT_FALSE(index) << data;
+        EXPECT_EQ(static_cast<ErrorCode>(*index.error()), ErrorCode::JsonParserError);
+    }
+}
+
+TEST(kvs_lazy_index, binary_index_map) {
+    KvsMap map;
+    map.emplace("array", KvsValue(std::vector<KvsValue>{KvsValue(1), KvsValue("two"), KvsValue(nullptr)}));
+    KvsValue::Object obj;
+    obj.emplace("inner", std::make_shared<KvsValue>(KvsValue(uint64_t(3))));
+    map.emplace("object", KvsValue(std::move(obj)));
+    map.emplace("bool", KvsValue(true));
+    map.emplace("double", KvsValue(2.5));
+    auto encoded = binary_encode_map(map);
+    ASSERT_TRUE(encoded);
+
+    auto index = binary_index_map(encoded.value());
+    ASSERT_TRUE(index);
+    ASSERT_EQ(index.value().size(), map.size());
+    for (const auto& [key, value] : map) {
+        /* Every range holds exactly one encoded value */
+        const std::string_view data = index.value().at(key).data;
+        size_t offset = 0;
+        auto decoded = binary_decode_value(data, offset);
+        ASSERT_TRUE(decoded);
+        EXPECT_EQ(offset, data.size());
+        EXPECT_EQ(decoded.value(), value);
+    }
+
+    /* Truncated data and trailing bytes are rejected like by binary_decode_map */
+    const std::string truncated = encoded.value().substr(0, encoded.value().size() - 1);
+    EXPECT_FALSE(binary_index_map(truncated));
+    EXPECT_FALSE(binary_index_map(encoded.value() + "x"));
+    EXPECT_FALSE(binary_index_map("KVSB"));
+
+    std::string invalid_tag(1, static_cast<char>(42));
+    size_t offset = 0;
+    EXPECT_FALSE(binary_skip_value(invalid_tag, offset));
+}
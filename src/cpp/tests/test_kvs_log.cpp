@@ -0,0 +1,147 @@
+/********************************************************************************
+* Copyright (c) 2025 Contributors to the Eclipse Foundation
+*
+* See the NOTICE file(s) distributed with this work for additional
+* information regarding copyright ownership.
+*
+* This program and the accompanying materials are made available under the
+* terms of the Apache License Version 2.0 which is available at
+* https://www.apache.org/licenses/LICENSE-2.0
+*
+* SPDX-License-Identifier: Apache-2.0
+********************************************************************************/
+#include "test_kvs_general.hpp"
+
+TEST(kvs_log, log_encode_header) {
+    EXPECT_EQ(log_encode_header(0x12345678), std::string("KVSL\x01\x00\x00\x00\x78\x56\x34\x12", 12));
+    EXPECT_EQ(log_encode_header(0).size(), KVS_LOG_HEADER_SIZE);
+}
+
+TEST(kvs_log, log_encode_record) {
+    /* Length, op, key, value, checksum of the payload */
+    std::string out;
+    ASSERT_TRUE(log_encode_set(out, "k", KvsValue(true)));
+    const std::string payload("\x01\x01\x00\x00\x00" "k" "\x05\x01", 8);
+    EXPECT_EQ(out.substr(0, 4), std::string("\x08\x00\x00\x00", 4));
+    EXPECT_EQ(out.substr(4, 8), payload);
+    std::string checksum;
+    binary_put_u32(checksum, calculate_hash_adler32(payload));
+    EXPECT_EQ(out.substr(12), checksum);
+
+    /* Remove records have no value */
+    out.clear();
+    ASSERT_TRUE(log_encode_remove(out, "k"));
+    EXPECT_EQ(out.size(), 4U + 6U + 4U);
+    EXPECT_EQ(out[4], static_cast<char>(LogOp::Remove));
+
+    /* Invalid values can't be logged */
+    out.clear();
+    auto result = log_encode_set(out, "invalid", BrokenKvsValue());
+    EXPECT_FALSE(result);
+    EXPECT_EQ(result.error(), ErrorCode::InvalidValueType);
+}
+
+TEST(kvs_log, log_replay_set_and_remove) {
+    std::string log = log_encode_header(42);
+    ASSERT_TRUE(log_encode_set(log, "number", KvsValue(static_cast<int32_t>(1))));
+    ASSERT_TRUE(log_encode_set(log, "string", KvsValue(std::string("value"))));
+    ASSERT_TRUE(log_encode_set(log, "number", KvsValue(static_cast<int32_t>(2))));
+    ASSERT_TRUE(log_encode_remove(log, "base"));
+    ASSERT_TRUE(log_encode_remove(log, "unknown"));
+
+    KvsMap map;
+    map.emplace("base", KvsValue(nullptr));
+    auto result = log_replay(log, 42, map);
+    ASSERT_TRUE(result);
+    EXPECT_EQ(result.value(), log.size());
+    EXPECT_EQ(map.size(), 2U);
+    EXPECT_EQ(std::get<int32_t>(map.at("number").getValue()), 2);
+    EXPECT_EQ(std::get<std::string>(map.at("string").getValue()), "value");
+
+    /* A log without records is valid */
+    KvsMap empty;
+    result = log_replay(log_encode_header(42), 42, empty);
+    ASSERT_TRUE(result);
+    EXPECT_EQ(result.value(), KVS_LOG_HEADER_SIZE);
+    EXPECT_TRUE(empty.empty());
+}
+
+TEST(kvs_log, log_replay_changes) {
+    std::string log = log_encode_header(42);
+    ASSERT_TRUE(log_encode_set(log, "number", KvsValue(static_cast<int32_t>(1))));
+    ASSERT_TRUE(log_encode_remove(log, "removed"));
+    ASSERT_TRUE(log_encode_set(log, "number", KvsValue(static_cast<int32_t>(2))));
+    ASSERT_TRUE(log_encode_remove(log, "number_removed"));
+
+    /* The last record of a key wins, removed keys have no value */
+    KvsChanges changes;
+    changes.emplace("removed", KvsValue(true));
+    auto result = log_replay_changes(log, 42, changes);
+    ASSERT_TRUE(result);
+    EXPECT_EQ(result.value(), log.size());
+    ASSERT_EQ(changes.size(), 3U);
+    EXPECT_EQ(std::get<int32_t>(changes.at("number").value().getValue()), 2);
+    EXPECT_FALSE(changes.at("removed").has_value());
+    EXPECT_FALSE(changes.at("number_removed").has_value());
+
+    result = log_replay_changes(log, 43, changes);
+    ASSERT_FALSE(result);
+    EXPECT_EQ(static_cast<ErrorCode>(*result.error()), ErrorCode::ValidationFailed);
+}
+
+TEST(kvs_log, log_replay_torn_tail) {
+    std::string log = log_encode_header(0);
+    ASSERT_TRUE(log_encode_set(log, "first", KvsValue(static_cast<int32_t>(1))));
+    const size_t valid_size = log.size();
+    ASSERT_TRUE(log_encode_set(log, "second", KvsValue(static_cast<int32_t>(2))));
+
+    /* Every cut inside the last record keeps the first record */
+    for (size_t size = valid_size; size < log.size(); ++size) {
+        KvsMap map;
+        auto result = log_replay(std::string_view(log).substr(0, size), 0, map);
+        ASSERT_TRUE(result) << size;
+        EXPECT_EQ(result.value(), valid_size) << size;
+        EXPECT_EQ(map.size(), 1U) << size;
+        EXPECT_EQ(map.count("first"), 1U) << size;
+    }
+}
+
+TEST(kvs_log, log_replay_corrupted_record) {
+    std::string log = log_encode_header(0);
+    ASSERT_TRUE(log_encode_set(log, "first", KvsValue(static_cast<int32_t>(1))));
+    const size_t valid_size = log.size();
+    ASSERT_TRUE(log_encode_set(log, "second", KvsValue(static_cast<int32_t>(2))));
+    ASSERT_TRUE(log_encode_set(log, "third", KvsValue(static_cast<int32_t>(3))));
+
+    /* Flipped bit in the second record ends the replay there */
+    log[valid_size + 8] ^= 0x01;
+    KvsMap map;
+    auto result = log_replay(log, 0, map);
+    ASSERT_TRUE(result);
+    EXPECT_EQ(result.value(), valid_size);
+    EXPECT_EQ(map.size(), 1U);
+    EXPECT_EQ(map.count("first"), 1U);
+}
+
+TEST(kvs_log, log_replay_failure) {
+    KvsMap map;
+
+    /* Log of another KVS file */
+    std::string log = log_encode_header(1);
+    ASSERT_TRUE(log_encode_set(log, "key", KvsValue(true)));
+    auto result = log_replay(log, 2, map);
+    ASSERT_FALSE(result);
+    EXPECT_EQ(result.error(), ErrorCode::ValidationFailed);
+    EXPECT_TRUE(map.empty());
+
+    /* Invalid header */
+    result = log_replay("KVSL", 0, map);
+    ASSERT_FALSE(result);
+    EXPECT_EQ(result.error(), ErrorCode::SerializationFailed);
+    result = log_replay(std::string("KVSB\x01\x00\x00\x00\x00\x00\x00\x00", 12), 0, map);
+    ASSERT_FALSE(result);
+    EXPECT_EQ(result.error(), ErrorCode::SerializationFailed);
+    result = log_replay(std::string("KVSL\x02\x00\x00\x00\x00\x00\x00\x00", 12), 0, map);
+    ASSERT_FALSE(result);
+    EXPECT_EQ(result.error(), ErrorCode::SerializationFailed);
+}
@@ -0,0 +1,94 @@
+/********************************************************************************
+* Copyright (c) 2025 Contributors to the Eclipse Foundation
+*
+* See the NOTICE file(s) distributed with this work for additional
+* information regarding copyright ownership.
+*
+* This program and the accompanying materials are made available under the
+* terms of the Apache License Version 2.0 which is available at
+* https://www.apache.org/licenses/LICENSE-2.0
+*
+* SPDX-License-Identifier: Apache-2.0
+********************************************************************************/
+#include "test_kvs_general.hpp"
+
+TEST(kvs_manifest, encode_decode) {
+    KvsManifest manifest;
+    manifest.next_generation = 42;
+    manifest.entries = {41, 40, KVS_MANIFEST_LEGACY_ENTRY | 1U};
+
+    const std::string data = manifest_encode(manifest);
+    EXPECT_EQ(data.substr(0, 4), "KVSM");
+    EXPECT_EQ(data.size(), 8U + 8U + 3U * 4U + 4U);
+
+    KvsManifest decoded;
+    ASSERT_TRUE(manifest_decode(data, decoded));
+    EXPECT_EQ(decoded.next_generation, 42U);
+    EXPECT_EQ(decoded.entries, manifest.entries);
+
+    /* Empty manifest */
+    ASSERT_TRUE(manifest_decode(manifest_encode(KvsManifest{}), decoded));
+    EXPECT_EQ(decoded.next_generation, 0U);
+    EXPECT_TRUE(decoded.entries.empty());
+}
+
+TEST(kvs_manifest, decode_invalid) {
+    KvsManifest manifest;
+    manifest.next_generation = 3;
+    manifest.entries = {2, 1, 0};
+    const std::string data = manifest_encode(manifest);
+
+    KvsManifest decoded;
+    decoded.next_generation = 7;
+    EXPECT_FALSE(manifest_decode("", decoded));
+    EXPECT_FALSE(manifest_decode(data.substr(0, data.size() - 1), decoded)); /* Truncated */
+    EXPECT_FALSE(manifest_decode(data + std::string(4, '\0'), decoded)); /* Trailing data */
+
+    std::string corrupted = data;
+    corrupted[0] = 'X'; /* Magic */
+    EXPECT_FALSE(manifest_decode(corrupted, decoded));
+    corrupted = data;
+    corrupted[4] = static_cast<char>(KVS_MANIFEST_VERSION + 1); /* Version */
+    EXPECT_FALSE(manifest_decode(corrupted, decoded));
+    corrupted = data;
+    corrupted[16] ^= 0x01; /* Entry, detected by the checksum */
+    EXPECT_FALSE(manifest_decode(corrupted, decoded));
+    corrupted = data;
+    corrupted[12] = static_cast<char>(0xFF); /* Count */
+    EXPECT_FALSE(manifest_decode(corrupted, decoded));
+
+    /* A failed decode doesn't change the manifest */
+    EXPECT_EQ(decoded.next_generation, 7U);
+    EXPECT_TRUE(decoded.entries.empty());
+}
+
+TEST(kvs_manifest, entry_suffix) {
+    EXPECT_EQ(manifest_entry_suffix(0), "_g0");
+    EXPECT_EQ(manifest_entry_suffix(12345), "_g12345");
+    EXPECT_EQ(manifest_entry_suffix(KVS_MANIFEST_LEGACY_ENTRY | 0U), "_0");
+    EXPECT_EQ(manifest_entry_suffix(KVS_MANIFEST_LEGACY_ENTRY | 3U), "_3");
+}
+
+TEST(kvs_manifest, rotate) {
+    KvsManifest manifest;
+    manifest.entries = {KVS_MANIFEST_LEGACY_ENTRY | 0U, KVS_MANIFEST_LEGACY_ENTRY | 1U};
+
+    /* New generations are added in front until the maximum count is reached */
+    EXPECT_TRUE(manifest_rotate(manifest, 3).empty());
+    EXPECT_EQ(manifest.entries, (std::vector<uint32_t>{0, KVS_MANIFEST_LEGACY_ENTRY | 0U, KVS_MANIFEST_LEGACY_ENTRY | 1U}));
+    EXPECT_EQ(manifest.next_generation, 1U);
+    EXPECT_TRUE(manifest_rotate(manifest, 3).empty());
+    auto dropped = manifest_rotate(manifest, 3);
+    EXPECT_EQ(dropped, (std::vector<uint32_t>{KVS_MANIFEST_LEGACY_ENTRY | 1U}));
+    EXPECT_EQ(manifest.entries, (std::vector<uint32_t>{2, 1, 0, KVS_MANIFEST_LEGACY_ENTRY | 0U}));
+
+    /* A smaller maximum drops all older entries at once */
+    dropped = manifest_rotate(manifest, 0);
+    EXPECT_EQ(dropped, (std::vector<uint32_t>{2, 1, 0, KVS_MANIFEST_LEGACY_ENTRY | 0U}));
+    EXPECT_EQ(manifest.entries, (std::vector<uint32_t>{3}));
+
+    /* The generation number never collides with legacy entries */
+    manifest.next_generation = KVS_MANIFEST_LEGACY_ENTRY - 1U;
+    (void)manifest_rotate(manifest, 0);
+    EXPECT_EQ(manifest.next_generation, 0U);
+}
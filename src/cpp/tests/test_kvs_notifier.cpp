@@ -0,0 +1,108 @@
+/********************************************************************************
+* Copyright (c) 2025 Contributors to the Eclipse Foundation
+*
+* See the NOTICE file(s) distributed with this work for additional
+* information regarding copyright ownership.
+*
+* This program and the accompanying materials are made available under the
+* terms of the Apache License Version 2.0 which is available at
+* https://www.apache.org/licenses/LICENSE-2.0
+*
+* SPDX-License-Identifier: Apache-2.0
+********************************************************************************/
+#include <future>
+#include "test_kvs_general.hpp"
+
+TEST(kvs_notifier, subscribe_and_match) {
+    KvsNotifier notifier;
+    EXPECT_FALSE(notifier.active());
+    notifier.wait(); /* Returns immediately without subscribers */
+
+    std::vector<std::string> key_changes;
+    std::vector<std::string> prefix_changes;
+    const KvsSubscriptionId key_id = notifier.subscribe("cfg.a", false, [&key_changes](const std::vector<KvsChange>& changes) {
+        for (const auto& change : changes) {
+            key_changes.push_back(change.key);
+        }
+    });
+    const KvsSubscriptionId prefix_id = notifier.subscribe("cfg.", true, [&prefix_changes](const std::vector<KvsChange>& changes) {
+        for (const auto& change : changes) {
+            prefix_changes.push_back(change.key);
+        }
+    });
+    EXPECT_NE(key_id, prefix_id);
+    EXPECT_TRUE(notifier.active());
+
+    notifier.post(KvsChange{"cfg.a", KvsValue(1.0)});
+    notifier.post(KvsChange{"cfg.ab", KvsValue(2.0)}); /* Matches only the prefix */
+    notifier.post(std::vector<KvsChange>{KvsChange{"other", std::nullopt}, KvsChange{"cfg.a", std::nullopt}});
+    notifier.wait();
+    EXPECT_EQ(key_changes, (std::vector<std::string>{"cfg.a", "cfg.a"}));
+    EXPECT_EQ(prefix_changes, (std::vector<std::string>{"cfg.a", "cfg.ab", "cfg.a"}));
+
+    /* Removed subscribers aren't called anymore */
+    EXPECT_TRUE(notifier.unsubscribe(key_id));
+    EXPECT_FALSE(notifier.unsubscribe(key_id));
+    notifier.post(KvsChange{"cfg.a", KvsValue(3.0)});
+    notifier.wait();
+    EXPECT_EQ(key_changes.size(), 2U);
+    EXPECT_EQ(prefix_changes.size(), 4U);
+    EXPECT_TRUE(notifier.unsubscribe(prefix_id));
+    EXPECT_FALSE(notifier.active());
+}
+
+TEST(kvs_notifier, batched_delivery) {
+    KvsNotifier notifier;
+    std::promise<void> started;
+    std::promise<void> release;
+    std::shared_future<void> release_future = release.get_future().share();
+    std::vector<size_t> batch_sizes;
+    bool first = true;
+    (void)notifier.subscribe("", true, [&](const std::vector<KvsChange>& changes) {
+        batch_sizes.push_back(changes.size());
+        if (first) {
+            first = false;
+            started.set_value();
+            release_future.wait();
+        }
+    });
+
+    /* While the first batch is delivered, the changes are collected in the next batch */
+    notifier.post(KvsChange{"key_0", KvsValue(0)});
+    started.get_future().wait();
+    for (int32_t idx = 1; idx <= 10; ++idx) {
+        notifier.post(KvsChange{"key_" + std::to_string(idx), KvsValue(idx)});
+    }
+    release.set_value();
+    notifier.wait();
+    EXPECT_EQ(batch_sizes, (std::vector<size_t>{1U, 10U}));
+}
+
+TEST(kvs_notifier, unsubscribe_in_callback_and_destructor_drain) {
+    std::atomic<int32_t> calls{0};
+    {
+        KvsNotifier notifier;
+        KvsSubscriptionId self_id = 0;
+        self_id = notifier.subscribe("key", false, [&notifier, &self_id, &calls](const std::vector<KvsChange>&) {
+            ++calls;
+            EXPECT_TRUE(notifier.unsubscribe(self_id)); /* Doesn't wait for its own delivery */
+        });
+        /* A subscriber removed by an earlier callback of the same batch is skipped */
+        KvsSubscriptionId later_id = 0;
+        (void)notifier.subscribe("key", false, [&notifier, &later_id](const std::vector<KvsChange>&) {
+            EXPECT_TRUE(notifier.unsubscribe(later_id));
+        });
+        later_id = notifier.subscribe("key", false, [&calls](const std::vector<KvsChange>&) { calls += 100; });
+        notifier.post(KvsChange{"key", KvsValue(true)});
+        notifier.wait();
+        EXPECT_EQ(calls, 1);
+
+        /* The destructor delivers the queued changes */
+        (void)notifier.subscribe("drain", false, [&calls](const std::vector<KvsChange>& changes) {
+            calls += static_cast<int32_t>(changes.size());
+        });
+        notifier.post(KvsChange{"drain", KvsValue(1)});
+        notifier.post(KvsChange{"drain", KvsValue(2)});
+    }
+    EXPECT_EQ(calls, 3);
+}
@@ -0,0 +1,239 @@
+/********************************************************************************
+* Copyright (c) 2025 Contributors to the Eclipse Foundation
+*
+* See the NOTICE file(s) distributed with this work for additional
+* information regarding copyright ownership.
+*
+* This program and the accompanying materials are made available under the
+* terms of the Apache License Version 2.0 which is available at
+* https://www.apache.org/licenses/LICENSE-2.0
+*
+* SPDX-License-Identifier: Apache-2.0
+********************************************************************************/
+#include "test_kvs_general.hpp"
+
+/* Unique name of the segment of a test (tests of other processes must not collide) */
+static std::string shared_test_name(const std::string& test) {
+    return "/kvs_test_" + test + "_" + std::to_string(getpid());
+}
+
+/* Image with the given entries */
+static std::string shared_test_image(const KvsMap& map) {
+    auto image = image_encode(map, 0U);
+    EXPECT_TRUE(image);
+    return image.value();
+}
+
+TEST(kvs_shared, segment_name) {
+    const std::string name = SharedStore::segment_name("./kvs_7");
+    EXPECT_EQ(name.rfind("/kvs_7_", 0), 0U);
+    EXPECT_EQ(name.size(), std::string("/kvs_7_").size() + 8U);
+    EXPECT_EQ(name.find('/', 1), std::string::npos);
+
+    /* The same file in another notation has the same segment, other directories get their own */
+    char cwd[PATH_MAX];
+    ASSERT_NE(getcwd(cwd, sizeof(cwd)), nullptr);
+    EXPECT_EQ(SharedStore::segment_name(std::string(cwd) + "/kvs_7"), name);
+    EXPECT_NE(SharedStore::segment_name("/tmp/kvs_7"), SharedStore::segment_name("/"));
+}
+
+TEST(kvs_shared, publish_find_scan) {
+    const std::string name = shared_test_name("publish");
+    auto owner = SharedStore::create(name, 4096);
+    ASSERT_TRUE(owner);
+    EXPECT_GE(owner.value()->capacity(), 4096U);
+    const uint64_t created = owner.value()->sequence();
+    EXPECT_EQ(created % 2U, 0U);
+
+    auto reader = SharedStore::attach(name);
+    ASSERT_TRUE(reader);
+
+    /* Nothing is published yet */
+    auto missing = reader.value()->find("key");
+    ASSERT_TRUE(missing);
+    EXPECT_FALSE(missing.value().has_value());
+
+    KvsMap map;
+    map.emplace("cfg.a", KvsValue(1.5));
+    map.emplace("cfg.b", KvsValue(std::string("text")));
+    map.emplace("other", KvsValue(true));
+    ASSERT_TRUE(owner.value()->publish(shared_test_image(map)));
+    EXPECT_EQ(reader.value()->sequence(), created + 2U);
+
+    auto found = reader.value()->find("cfg.b");
+    ASSERT_TRUE(found);
+    ASSERT_TRUE(found.value().has_value());
+    EXPECT_EQ(std::get<std::string>(found.value().value().getValue()), "text");
+
+    auto scanned = reader.value()->scan("cfg.");
+    ASSERT_TRUE(scanned);
+    ASSERT_EQ(scanned.value().size(), 2U);
+    EXPECT_EQ(scanned.value()[0].first, "cfg.a");
+    EXPECT_EQ(std::get<double>(scanned.value()[0].second.getValue()), 1.5);
+    EXPECT_EQ(scanned.value()[1].first, "cfg.b");
+
+    /* A new image replaces the previous one */
+    map.erase("cfg.b");
+    ASSERT_TRUE(owner.value()->publish(shared_test_image(map)));
+    auto removed = reader.value()->find("cfg.b");
+    ASSERT_TRUE(removed);
+    EXPECT_FALSE(removed.value().has_value());
+
+    /* Readers can't publish, images larger than the segment are rejected */
+    auto read_only = reader.value()->publish(shared_test_image(map));
+    ASSERT_FALSE(read_only);
+    EXPECT_EQ(static_cast<ErrorCode>(*read_only.error()), ErrorCode::ReadOnly);
+    auto too_large = owner.value()->publish(std::string(owner.value()->capacity() + 1U, '\0'));
+    ASSERT_FALSE(too_large);
+    EXPECT_EQ(static_cast<ErrorCode>(*too_large.error()), ErrorCode::OutOfStorageSpace);
+    EXPECT_TRUE(SharedStore::remove(name));
+}
+
+TEST(kvs_shared, owner_and_attach_errors) {
+    const std::string name = shared_test_name("owner");
+    auto no_owner = SharedStore::attach(name);
+    ASSERT_FALSE(no_owner);
+    EXPECT_EQ(static_cast<ErrorCode>(*no_owner.error()), ErrorCode::FileNotFound);
+
+    {
+        auto owner = SharedStore::create(name, 1024);
+        ASSERT_TRUE(owner);
+
+        /* Only one owner per segment */
+        auto second = SharedStore::create(name, 1024);
+        ASSERT_FALSE(second);
+        EXPECT_EQ(static_cast<ErrorCode>(*second.error()), ErrorCode::ResourceBusy);
+    }
+
+    /* The segment outlives the owner until it is removed */
+    EXPECT_TRUE(SharedStore::attach(name));
+    EXPECT_TRUE(SharedStore::remove(name));
+    EXPECT_TRUE(SharedStore::remove(name)); /* Already removed */
+    auto removed = SharedStore::attach(name);
+    ASSERT_FALSE(removed);
+    EXPECT_EQ(static_cast<ErrorCode>(*removed.error()), ErrorCode::FileNotFound);
+
+    /* A segment without the magic can't be attached */
+    int fd = shm_open(name.c_str(), O_RDWR | O_CREAT, 0600);
+    ASSERT_GE(fd, 0);
+    ASSERT_EQ(ftruncate(fd, 4096), 0);
+    close(fd);
+    auto invalid = SharedStore::attach(name);
+    ASSERT_FALSE(invalid);
+    EXPECT_EQ(static_cast<ErrorCode>(*invalid.error()), ErrorCode::SerializationFailed);
+    shm_unlink(name.c_str());
+}
+
+TEST(kvs_shared, owner_restart) {
+    const std::string name = shared_test_name("restart");
+    KvsMap map;
+    map.emplace("key", KvsValue(1.0));
+    auto owner = SharedStore::create(name, 1024);
+    ASSERT_TRUE(owner);
+    ASSERT_TRUE(owner.value()->publish(shared_test_image(map)));
+    auto reader = SharedStore::attach(name);
+    ASSERT_TRUE(reader);
+
+    /* The reader keeps the last image while no owner runs and sees the images of the next owner */
+    owner.value().reset();
+    auto kept = reader.value()->find("key");
+    ASSERT_TRUE(kept);
+    EXPECT_TRUE(kept.value().has_value());
+    auto restarted = SharedStore::create(name, 1024);
+    ASSERT_TRUE(restarted);
+    map.emplace("restarted", KvsValue(true));
+    ASSERT_TRUE(restarted.value()->publish(shared_test_image(map)));
+    auto found = reader.value()->find("restarted");
+    ASSERT_TRUE(found);
+    EXPECT_TRUE(found.value().has_value());
+
+    /* An owner with a larger capacity grows the segment, images beyond the mapping of the reader fail */
+    restarted.value().reset();
+    auto grown = SharedStore::create(name, 8192);
+    ASSERT_TRUE(grown);
+    map.emplace("large", KvsValue(std::string(4096, 'x')));
+    ASSERT_TRUE(grown.value()->publish(shared_test_image(map)));
+    auto too_large = reader.value()->find("key");
+    ASSERT_FALSE(too_large);
+    EXPECT_EQ(static_cast<ErrorCode>(*too_large.error()), ErrorCode::OutOfStorageSpace);
+    auto attached = SharedStore::attach(name);
+    ASSERT_TRUE(attached);
+    EXPECT_TRUE(attached.value()->find("large").value().has_value());
+
+    EXPECT_TRUE(SharedStore::remove(name));
+}
+
+TEST(kvs_shared, read_while_publishing) {
+    const std::string name = shared_test_name("seqlock");
+    auto owner = SharedStore::create(name, 4096);
+    ASSERT_TRUE(owner);
+    KvsMap map;
+    map.emplace("key", KvsValue(7.0));
+    ASSERT_TRUE(owner.value()->publish(shared_test_image(map)));
+    auto reader = SharedStore::attach(name);
+    ASSERT_TRUE(reader);
+
+    /* An odd sequence (after magic and version) marks an unfinished publish, readers give up after their retries */
+    int fd = shm_open(name.c_str(), O_RDWR, 0);
+    ASSERT_GE(fd, 0);
+    void* mapping = mmap(nullptr, KVS_SHARED_HEADER_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    ASSERT_NE(mapping, MAP_FAILED);
+    auto* sequence = reinterpret_cast<std::atomic<uint64_t>*>(static_cast<char*>(mapping) + 8);
+    EXPECT_EQ(sequence->load(), reader.value()->sequence());
+    sequence->store(sequence->load() | 1U);
+    munmap(mapping, KVS_SHARED_HEADER_SIZE);
+    auto busy = reader.value()->find("key");
+    ASSERT_FALSE(busy);
+    EXPECT_EQ(static_cast<ErrorCode>(*busy.error()), ErrorCode::ResourceBusy);
+
+    /* The next publish completes the sequence again (e.g. after the previous owner died while publishing) */
+    ASSERT_TRUE(owner.value()->publish(shared_test_image(map)));
+    EXPECT_EQ(reader.value()->sequence() % 2U, 0U);
+    auto found = reader.value()->find("key");
+    ASSERT_TRUE(found);
+    ASSERT_TRUE(found.value().has_value());
+    EXPECT_EQ(std::get<double>(found.value().value().getValue()), 7.0);
+    EXPECT_TRUE(SharedStore::remove(name));
+}
+
+TEST(kvs_shared, concurrent_publish_and_read) {
+    const std::string name = shared_test_name("concurrent");
+    auto owner = SharedStore::create(name, 64 * 1024);
+    ASSERT_TRUE(owner);
+    auto reader = SharedStore::attach(name);
+    ASSERT_TRUE(reader);
+
+    /* Every image has consistent values, a reader must never see a mix of two images.
+       The publisher keeps publishing until the reader has checked an image, so at least one scan
+       runs concurrently to the publishing (e.g. on a single CPU the publisher could finish first). */
+    std::atomic<bool> done(false);
+    std::atomic<size_t> checked(0);
+    std::thread publisher([&owner, &done, &checked]() {
+        for (int32_t round = 0; (round < 200) || (0U == checked); ++round) {
+            KvsMap map;
+            for (int32_t key = 0; key < 20; ++key) {
+                map.emplace("key_" + std::to_string(key), KvsValue(round));
+            }
+            EXPECT_TRUE(owner.value()->publish(image_encode(map, 0U).value()));
+            if (round >= 200) {
+                std::this_thread::yield();
+            }
+        }
+        done = true;
+    });
+    while (!done) {
+        auto scanned = reader.value()->scan("key_");
+        if (scanned && (!scanned.value().empty())) {
+            ASSERT_EQ(scanned.value().size(), 20U);
+            const int32_t round = std::get<int32_t>(scanned.value().front().second.getValue());
+            for (const auto& [key, value] : scanned.value()) {
+                EXPECT_EQ(std::get<int32_t>(value.getValue()), round) << key;
+            }
+            ++checked;
+        }
+    }
+    publisher.join();
+    EXPECT_GT(checked, 0U);
+    EXPECT_TRUE(SharedStore::remove(name));
+}
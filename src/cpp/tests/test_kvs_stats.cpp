@@ -0,0 +1,90 @@
+/********************************************************************************
+* Copyright (c) 2025 Contributors to the Eclipse Foundation
+*
+* See the NOTICE file(s) distributed with this work for additional
+* information regarding copyright ownership.
+*
+* This program and the accompanying materials are made available under the
+* terms of the Apache License Version 2.0 which is available at
+* https://www.apache.org/licenses/LICENSE-2.0
+*
+* SPDX-License-Identifier: Apache-2.0
+********************************************************************************/
+#include "test_kvs_general.hpp"
+
+TEST(kvs_stats, record_and_reset){
+    KvsStatsRecorder recorder;
+    const auto start = std::chrono::steady_clock::now();
+    recorder.record(KvsOperation::Flush, start, std::chrono::nanoseconds(0));
+    recorder.record(KvsOperation::Flush, start, std::chrono::nanoseconds(1000));
+    recorder.record(KvsOperation::Flush, start, std::chrono::nanoseconds(1500));
+    recorder.record(KvsOperation::Flush, start, std::chrono::nanoseconds(100000));
+    recorder.record(KvsOperation::Open, start);
+    recorder.count(KvsCounter::LockFailure);
+    recorder.count(KvsCounter::LockFailure);
+
+    const KvsStats stats = recorder.stats();
+    const KvsLatencyStats& flush = stats.latency(KvsOperation::Flush);
+    if constexpr (KVS_STATS_ENABLED) {
+        EXPECT_EQ(flush.count, 4U);
+        EXPECT_EQ(flush.total_ns, 102500U);
+        EXPECT_EQ(flush.max_ns, 100000U);
+        EXPECT_EQ(flush.buckets[0], 1U);
+        EXPECT_EQ(flush.buckets[9], 1U);  /* 512-1023 ns */
+        EXPECT_EQ(flush.buckets[10], 1U); /* 1024-2047 ns */
+        EXPECT_EQ(flush.buckets[16], 1U); /* 65536-131071 ns */
+        EXPECT_EQ(stats.latency(KvsOperation::Open).count, 1U);
+        EXPECT_EQ(stats.counter(KvsCounter::LockFailure), 2U);
+    }else{
+        EXPECT_EQ(flush.count, 0U);
+        EXPECT_EQ(stats.counter(KvsCounter::LockFailure), 0U);
+    }
+    EXPECT_EQ(stats.latency(KvsOperation::Parse).count, 0U);
+    EXPECT_EQ(stats.counter(KvsCounter::FlushFailure), 0U);
+
+    recorder.reset();
+    EXPECT_EQ(recorder.stats().latency(KvsOperation::Flush).count, 0U);
+    EXPECT_EQ(recorder.stats().latency(KvsOperation::Flush).buckets[10], 0U);
+    EXPECT_EQ(recorder.stats().counter(KvsCounter::LockFailure), 0U);
+}
+
+TEST(kvs_stats, percentile){
+    KvsLatencyStats latency;
+    EXPECT_EQ(latency.percentile_ns(0.5), 0U);
+
+    /* 90 fast operations (bucket 4: 16-31 ns) and 10 slow ones (bucket 20 and the maximum) */
+    latency.count = 100;
+    latency.buckets[4] = 90;
+    latency.buckets[20] = 10;
+    latency.max_ns = 1500000;
+    EXPECT_EQ(latency.percentile_ns(0.0), 31U);
+    EXPECT_EQ(latency.percentile_ns(0.5), 31U);
+    EXPECT_EQ(latency.percentile_ns(0.9), 31U);
+    EXPECT_EQ(latency.percentile_ns(0.99), 1500000U); /* Bucket bound above the maximum */
+    EXPECT_EQ(latency.percentile_ns(1.0), 1500000U);
+}
+
+TEST(kvs_stats, timer_and_trace_hook){
+    KvsStatsRecorder recorder;
+    std::vector<KvsOperation> traced;
+    std::chrono::nanoseconds traced_duration{0};
+    recorder.trace_hook = [&](KvsOperation operation, std::chrono::steady_clock::time_point, std::chrono::nanoseconds duration) {
+        traced.push_back(operation);
+        traced_duration = duration;
+    };
+    {
+        const KvsStatsTimer timer(recorder, KvsOperation::SnapshotRotate);
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    const KvsStats stats = recorder.stats();
+    const KvsLatencyStats& rotate = stats.latency(KvsOperation::SnapshotRotate);
+    if constexpr (KVS_STATS_ENABLED) {
+        EXPECT_EQ(rotate.count, 1U);
+        EXPECT_GE(rotate.max_ns, 1000000U);
+        EXPECT_EQ(traced, std::vector<KvsOperation>{KvsOperation::SnapshotRotate});
+        EXPECT_EQ(static_cast<uint64_t>(traced_duration.count()), rotate.max_ns);
+    }else{
+        EXPECT_EQ(rotate.count, 0U);
+        EXPECT_TRUE(traced.empty());
+    }
+}
@@ -0,0 +1,212 @@
+/********************************************************************************
+* Copyright (c) 2025 Contributors to the Eclipse Foundation
+*
+* See the NOTICE file(s) distributed with this work for additional
+* information regarding copyright ownership.
+*
+* This program and the accompanying materials are made available under the
+* terms of the Apache License Version 2.0 which is available at
+* https://www.apache.org/licenses/LICENSE-2.0
+*
+* SPDX-License-Identifier: Apache-2.0
+********************************************************************************/
+#include "test_kvs_general.hpp"
+
+TEST(kvs_kvsvalue, kvsvalue_copy_shares_array_elements) {
+
+    KvsValue::Array array;
+    array.push_back(std::make_shared<KvsValue>(42.0));
+    array.push_back(std::make_shared<KvsValue>(std::vector<KvsValue>{KvsValue(1.0), KvsValue(true)}));
+    KvsValue original(std::move(array));
+
+    /* Copy constructor shares the container and the elements */
+    KvsValue copy(original);
+    const auto& original_array = original.getArray();
+    const auto& copied_array = copy.getArray();
+    EXPECT_EQ(&copied_array, &original_array);
+    EXPECT_EQ(std::get<KvsValue::SharedArray>(original.getValue()).use_count(), 2);
+    ASSERT_EQ(copied_array.size(), 2U);
+    EXPECT_EQ(copy.getType(), KvsValue::Type::Array);
+    EXPECT_EQ(copied_array[0].get(), original_array[0].get());
+    EXPECT_EQ(copied_array[1].get(), original_array[1].get());
+
+    /* Copy assignment shares the elements */
+    KvsValue assigned(nullptr);
+    assigned = original;
+    const auto& assigned_array = assigned.getArray();
+    EXPECT_EQ(&assigned_array, &original_array);
+    EXPECT_EQ(assigned.getType(), KvsValue::Type::Array);
+    EXPECT_EQ(assigned_array[1].get(), original_array[1].get());
+}
+
+TEST(kvs_kvsvalue, kvsvalue_copy_shares_object_elements) {
+
+    KvsValue::Object object;
+    object.emplace("number", std::make_shared<KvsValue>(42.0));
+    object.emplace("nested", std::make_shared<KvsValue>(std::unordered_map<std::string, KvsValue>{{"flag", KvsValue(true)}}));
+    KvsValue original(object);
+
+    /* Constructing from an Object shares the elements */
+    EXPECT_EQ(original.getObject().at("nested").get(), object.at("nested").get());
+
+    KvsValue copy(original);
+    const auto& copied_object = copy.getObject();
+    EXPECT_EQ(&copied_object, &original.getObject());
+    EXPECT_EQ(copy.getType(), KvsValue::Type::Object);
+    EXPECT_EQ(copied_object.at("number").get(), object.at("number").get());
+    EXPECT_EQ(copied_object.at("nested").get(), object.at("nested").get());
+}
+
+TEST(kvs_kvsvalue, kvsvalue_former_container_types) {
+
+    /* Containers of mutable elements (the former Array and Object types) are accepted, the elements are shared */
+    const auto number = std::make_shared<KvsValue>(42.0);
+    const std::vector<std::shared_ptr<KvsValue>> array{number, std::make_shared<KvsValue>(true)};
+    const KvsValue array_value(array);
+    EXPECT_EQ(array_value.getType(), KvsValue::Type::Array);
+    ASSERT_EQ(array_value.getArray().size(), 2U);
+    EXPECT_EQ(array_value.getArray()[0].get(), number.get());
+
+    const std::unordered_map<std::string, std::shared_ptr<KvsValue>> object{{"number", number}};
+    const KvsValue object_value(object);
+    EXPECT_EQ(object_value.getType(), KvsValue::Type::Object);
+    ASSERT_NE(object_value.getIf<KvsValue::Object>(), nullptr);
+    EXPECT_EQ(object_value.getObject().at("number").get(), number.get());
+}
+
+TEST(kvs_kvsvalue, kvsvalue_copy_on_write) {
+
+    KvsValue::Array array;
+    array.push_back(std::make_shared<KvsValue>(1.0));
+    array.push_back(std::make_shared<KvsValue>(2.0));
+    KvsValue original(array);
+
+    /* Modify a copy by building a new value, the original value is unchanged */
+    KvsValue::Array modified_array = original.getArray();
+    modified_array[1] = std::make_shared<KvsValue>(3.0);
+    KvsValue modified(std::move(modified_array));
+
+    const auto& original_elements = original.getArray();
+    const auto& modified_elements = modified.getArray();
+    EXPECT_EQ(std::get<double>(original_elements[1]->getValue()), 2.0);
+    EXPECT_EQ(std::get<double>(modified_elements[1]->getValue()), 3.0);
+    EXPECT_NE(&original_elements, &modified_elements);
+    EXPECT_EQ(original_elements[0].get(), modified_elements[0].get()); /* Unchanged element is shared */
+}
+
+TEST(kvs_kvsvalue, kvsvalue_get_value_shares_elements) {
+
+    prepare_environment();
+
+    auto result = Kvs::open(instance_id, OpenNeedDefaults::Required, OpenNeedKvs::Required, std::string(data_dir));
+    ASSERT_TRUE(result);
+
+    /* Values read from the KVS and written to another key share the stored elements */
+    auto set_result = result.value().set_value("array", KvsValue(std::vector<KvsValue>{KvsValue(1.0), KvsValue("text")}));
+    ASSERT_TRUE(set_result);
+    auto get_result = result.value().get_value("array");
+    ASSERT_TRUE(get_result);
+    set_result = result.value().set_value("array_copy", get_result.value());
+    ASSERT_TRUE(set_result);
+
+    const auto& stored = result.value().kvs.at("array").getArray();
+    const auto& stored_copy = result.value().kvs.at("array_copy").getArray();
+    const auto& read = get_result.value().getArray();
+    EXPECT_EQ(stored[1].get(), read[1].get());
+    EXPECT_EQ(stored[1].get(), stored_copy[1].get());
+
+    cleanup_environment();
+}
+
+TEST(kvs_kvsvalue, kvsvalue_compare) {
+    EXPECT_EQ(KvsValue(1.0), KvsValue(1.0));
+    EXPECT_NE(KvsValue(1.0), KvsValue(2.0));
+    EXPECT_NE(KvsValue(static_cast<int32_t>(1)), KvsValue(static_cast<uint32_t>(1))); /* Type differs */
+    EXPECT_EQ(KvsValue("text"), KvsValue(std::string("text")));
+    EXPECT_EQ(KvsValue(nullptr), KvsValue(nullptr));
+
+    /* Arrays and Objects are compared by their elements */
+    const KvsValue array(std::vector<KvsValue>{KvsValue(1.0), KvsValue("text")});
+    EXPECT_EQ(array, KvsValue(std::vector<KvsValue>{KvsValue(1.0), KvsValue("text")}));
+    EXPECT_EQ(array, KvsValue(array));
+    EXPECT_NE(array, KvsValue(std::vector<KvsValue>{KvsValue(1.0)}));
+    EXPECT_NE(array, KvsValue(std::vector<KvsValue>{KvsValue(1.0), KvsValue("other")}));
+
+    const KvsValue object(std::unordered_map<std::string, KvsValue>{{"a", KvsValue(true)}, {"b", array}});
+    EXPECT_EQ(object, KvsValue(std::unordered_map<std::string, KvsValue>{{"b", array}, {"a", KvsValue(true)}}));
+    EXPECT_NE(object, KvsValue(std::unordered_map<std::string, KvsValue>{{"a", KvsValue(true)}, {"c", array}}));
+    EXPECT_NE(object, KvsValue(std::unordered_map<std::string, KvsValue>{{"a", KvsValue(false)}, {"b", array}}));
+}
+
+TEST(kvs_kvsvalue, kvsvalue_type_from_variant_index) {
+
+    /* The type is the index of the variant, there is no separate type member to keep in sync */
+    EXPECT_EQ(KvsValue(static_cast<int32_t>(1)).getType(), KvsValue::Type::i32);
+    EXPECT_EQ(KvsValue(static_cast<uint32_t>(1)).getType(), KvsValue::Type::u32);
+    EXPECT_EQ(KvsValue(static_cast<int64_t>(1)).getType(), KvsValue::Type::i64);
+    EXPECT_EQ(KvsValue(static_cast<uint64_t>(1)).getType(), KvsValue::Type::u64);
+    EXPECT_EQ(KvsValue(1.0).getType(), KvsValue::Type::f64);
+    EXPECT_EQ(KvsValue(true).getType(), KvsValue::Type::Boolean);
+    EXPECT_EQ(KvsValue("text").getType(), KvsValue::Type::String);
+    EXPECT_EQ(KvsValue(nullptr).getType(), KvsValue::Type::Null);
+    EXPECT_EQ(KvsValue(std::vector<KvsValue>{KvsValue(1.0)}).getType(), KvsValue::Type::Array);
+    EXPECT_EQ(KvsValue(std::unordered_map<std::string, KvsValue>{{"a", KvsValue(1.0)}}).getType(), KvsValue::Type::Object);
+
+    /* Assignments change the type together with the value */
+    KvsValue value(1.0);
+    value = KvsValue("text");
+    EXPECT_EQ(value.getType(), KvsValue::Type::String);
+    const KvsValue array(KvsValue::Array{});
+    value = array;
+    EXPECT_EQ(value.getType(), KvsValue::Type::Array);
+
+    /* The value is not larger than its largest alternative plus the variant index */
+    EXPECT_LE(sizeof(KvsValue), sizeof(KvsValue::Object) + sizeof(size_t));
+    EXPECT_LT(sizeof(KvsValue::Object), sizeof(std::unordered_map<std::string, std::shared_ptr<const KvsValue>>));
+}
+
+TEST(kvs_kvsvalue, kvsarena_allocate) {
+
+    auto arena = std::make_shared<KvsArena>();
+    EXPECT_EQ(arena->used(), 0U);
+
+    /* Allocations are aligned and handed out from the chunks */
+    void* first = arena->allocate(3, 1);
+    void* second = arena->allocate(sizeof(double), alignof(double));
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(second) % alignof(double), 0U);
+    EXPECT_TRUE(arena->owns(first));
+    EXPECT_TRUE(arena->owns(second));
+    EXPECT_EQ(arena->used(), 3U + sizeof(double));
+
+    /* Requests larger than a chunk get their own chunk */
+    void* large = arena->allocate(1U << 21, alignof(std::max_align_t));
+    EXPECT_TRUE(arena->owns(large));
+    arena->deallocate(large, 1U << 21, alignof(std::max_align_t)); /* Released with the arena */
+
+    /* A sealed arena allocates from the heap */
+    arena->seal();
+    void* heap = arena->allocate(16, alignof(std::max_align_t));
+    EXPECT_FALSE(arena->owns(heap));
+    arena->deallocate(heap, 16, alignof(std::max_align_t));
+    EXPECT_EQ(arena->used(), 3U + sizeof(double) + (1U << 21));
+
+    /* Elements and map nodes keep the arena alive */
+    auto element_arena = std::make_shared<KvsArena>();
+    std::shared_ptr<const KvsValue> element = std::allocate_shared<KvsValue>(KvsElementAllocator(element_arena), 42.0);
+    KvsMap map{KvsMap::allocator_type(element_arena)};
+    map.emplace("key", KvsValue(1.0));
+    EXPECT_GT(element_arena->used(), 0U);
+    std::weak_ptr<KvsArena> weak_arena = element_arena;
+    element_arena.reset();
+
+    /* Copies of a map use the heap, moves take the arena along */
+    KvsMap copy(map);
+    EXPECT_EQ(copy.get_allocator().arena, nullptr);
+    KvsMap moved(std::move(map));
+    EXPECT_EQ(moved.get_allocator().arena, weak_arena.lock());
+    KvsMap().swap(moved);
+    EXPECT_FALSE(weak_arena.expired()); /* Still referenced by the element */
+    EXPECT_DOUBLE_EQ(std::get<double>(element->getValue()), 42.0);
+    element.reset();
+    EXPECT_TRUE(weak_arena.expired());
+}
@@ -0,0 +1,138 @@
+#!/usr/bin/env python3
+
+# *******************************************************************************
+# Copyright (c) 2025 Contributors to the Eclipse Foundation
+#
+# See the NOTICE file(s) distributed with this work for additional
+# information regarding copyright ownership.
+#
+# This program and the accompanying materials are made available under the
+# terms of the Apache License Version 2.0 which is available at
+# https://www.apache.org/licenses/LICENSE-2.0
+#
+# SPDX-License-Identifier: Apache-2.0
+# *******************************************************************************
+
+"""Compare a bm_kvs_cpp result file against the checked-in baseline.
+
+Both files are Google Benchmark JSON output (--benchmark_out=<file> --benchmark_out_format=json).
+Benchmarks that only exist in one of the files are listed but do not fail the comparison. The exit
+code is 1 if at least one benchmark is slower than the baseline by more than the threshold.
+
+The baseline (src/cpp/tests/bm_kvs_baseline.json) is regenerated with an optimized build:
+
+    bm_kvs_cpp --benchmark_filter="$(python3 tools/bm_compare.py --print-filter)" \\
+        --benchmark_min_time=0.1 --benchmark_out=bm_kvs_baseline.json --benchmark_out_format=json
+
+Absolute timings depend on the machine, compare results of the same machine (or use a large threshold).
+The CI compares a pull request with its base commit, both measured on the same runner (the checked-in
+baseline is only used for local comparisons). The thread scaling benchmarks (BM_get_value_parallel,
+BM_mixed_contention) are not part of the comparison, their results depend on the number of CPUs.
+"""
+
+import argparse
+import json
+import re
+import sys
+
+# Benchmarks of the baseline (the long running storage and the multi-threaded benchmarks are left out)
+BASELINE_FILTER = (
+    "BM_(get_hash_bytes|flush|open|value_copy|kvsvalue_to_any|any_to_kvsvalue"
+    "|get_value_store_size|set_value_store_size|snapshot_restore)/"
+)
+
+TIME_UNIT_NS = {"ns": 1.0, "us": 1e3, "ms": 1e6, "s": 1e9}
+
+
+def eprint(*args, **kwargs):
+    print(*args, file=sys.stderr, **kwargs)
+
+
+def load_times(path, name_filter):
+    """Real time in ns per benchmark name (the median if the file contains repetitions)."""
+    with open(path, encoding="utf-8") as file:
+        data = json.load(file)
+    times = {}
+    medians = {}
+    for entry in data.get("benchmarks", []):
+        if entry.get("error_occurred"):
+            continue
+        name = entry.get("run_name", entry["name"])
+        if name_filter and not name_filter.search(name):
+            continue
+        time_ns = entry["real_time"] * TIME_UNIT_NS[entry.get("time_unit", "ns")]
+        if entry.get("run_type") == "aggregate":
+            if entry.get("aggregate_name") == "median":
+                medians[name] = time_ns
+        elif name not in times:
+            times[name] = time_ns
+    times.update(medians)
+    return times
+
+
+def write_markdown(path, rows, regressions, threshold):
+    """Append the comparison as markdown table, regressions are listed first."""
+    with open(path, "a", encoding="utf-8") as file:
+        if regressions:
+            file.write(f"### :x: {len(regressions)} benchmark(s) slower than the baseline by more than {threshold:.0%}\n\n")
+        else:
+            file.write(f"### :white_check_mark: No benchmark slower than the baseline by more than {threshold:.0%}\n\n")
+        file.write("| Benchmark | Baseline | Current | Change |\n|---|---:|---:|---:|\n")
+        for name, base_ns, cur_ns, change, marker in sorted(rows, key=lambda row: not row[4]):
+            flag = " :x:" if marker else ""
+            file.write(f"| `{name}` | {base_ns:.1f} ns | {cur_ns:.1f} ns | {change:+.1%}{flag} |\n")
+        file.write("\n")
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Report bm_kvs_cpp benchmarks slower than the baseline")
+    parser.add_argument("baseline", nargs="?", help="baseline result file (JSON)")
+    parser.add_argument("current", nargs="?", help="current result file (JSON)")
+    parser.add_argument("--threshold", type=float, default=0.25, help="allowed slowdown (0.25 = 25 %%)")
+    parser.add_argument("--filter", default=None, help="only compare benchmarks matching this regex")
+    parser.add_argument("--print-filter", action="store_true", help="print the filter of the baseline and exit")
+    parser.add_argument("--markdown", default=None, help="append the comparison as markdown table (e.g. $GITHUB_STEP_SUMMARY)")
+    args = parser.parse_args()
+
+    if args.print_filter:
+        print(BASELINE_FILTER)
+        return 0
+    if args.baseline is None or args.current is None:
+        parser.error("baseline and current result file are required")
+
+    name_filter = re.compile(args.filter) if args.filter else None
+    baseline = load_times(args.baseline, name_filter)
+    current = load_times(args.current, name_filter)
+
+    regressions = []
+    rows = []
+    width = max((len(name) for name in baseline), default=10)
+    print(f"{'Benchmark':<{width}} {'Baseline':>14} {'Current':>14} {'Change':>9}")
+    for name, base_ns in baseline.items():
+        if name not in current:
+            continue
+        cur_ns = current[name]
+        change = (cur_ns / base_ns - 1.0) if base_ns > 0.0 else 0.0
+        marker = ""
+        if change > args.threshold:
+            marker = "  REGRESSION"
+            regressions.append(name)
+        rows.append((name, base_ns, cur_ns, change, marker))
+        print(f"{name:<{width}} {base_ns:>12.1f}ns {cur_ns:>12.1f}ns {change:>+8.1%}{marker}")
+
+    if args.markdown:
+        write_markdown(args.markdown, rows, regressions, args.threshold)
+
+    for name in sorted(set(baseline) - set(current)):
+        eprint(f"missing in current results: {name}")
+    for name in sorted(set(current) - set(baseline)):
+        eprint(f"not in baseline: {name}")
+
+    if regressions:
+        eprint(f"{len(regressions)} benchmark(s) slower than the baseline by more than {args.threshold:.0%}")
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())